@@ -0,0 +1,110 @@
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "bvh.hpp"
+#include "thread_pool.hpp"
+
+// Build, refit and query times of the BVH over a million randomly scattered static objects.
+
+using Clock = std::chrono::steady_clock;
+
+template<typename F>
+static double time_best_of(int runs, F&& function)
+{
+    double best = 1e30;
+    for (int i = 0; i < runs; i += 1) {
+        auto start = Clock::now();
+        function();
+        best = std::min(best, std::chrono::duration<double>(Clock::now() - start).count());
+    }
+    return best;
+}
+
+static void report(char const* name, double seconds, size_t operations = 0)
+{
+    if (operations > 0)
+        std::printf("%-28s %9.3f ms %10.3f us/op\n", name, seconds * 1e3, seconds * 1e6 / operations);
+    else
+        std::printf("%-28s %9.3f ms\n", name, seconds * 1e3);
+}
+
+int main()
+{
+    size_t const object_count = 1'000'000;
+    size_t const query_count = 1000;
+
+    std::mt19937 random(1234);
+    std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+    std::uniform_real_distribution<float> size(0.05f, 1.0f);
+
+    std::vector<HB::Bounds> bounds(object_count);
+    for (auto& object : bounds) {
+        glm::vec3 center = { position(random), position(random), position(random) };
+        glm::vec3 half = glm::vec3(size(random)) * 0.5f;
+        object = { center - half, center + half };
+    }
+
+    HB::ThreadPool pool;
+    HB::Bvh bvh;
+    std::printf("objects: %zu, worker threads: %u\n", object_count, pool.worker_count());
+
+    report("build (serial)", time_best_of(3, [&] { bvh.build(bounds); }));
+    report("build (parallel)", time_best_of(3, [&] { bvh.build(bounds, &pool); }));
+    std::printf("%-28s %zu nodes, cost %.1f\n", "tree", bvh.node_count(), bvh.cost());
+
+    std::uniform_real_distribution<float> jitter(-0.5f, 0.5f);
+    report("update + refit", time_best_of(3, [&] {
+        for (uint32_t object = 0; object < object_count; object += 1) {
+            glm::vec3 offset = { jitter(random), jitter(random), jitter(random) };
+            bvh.update(object, { bounds[object].min + offset, bounds[object].max + offset });
+        }
+        bvh.refit();
+    }));
+    std::printf("%-28s cost %.1f, needs rebuild: %s\n", "after refit", bvh.cost(), bvh.needs_rebuild() ? "yes" : "no");
+    bvh.build(bounds, &pool);
+
+    glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 100.0f);
+    size_t visible = 0;
+    report("frustum query", time_best_of(5, [&] {
+        visible = 0;
+        for (size_t i = 0; i < query_count; i += 1) {
+            float angle = 6.2831853f * i / query_count;
+            glm::mat4 view = glm::lookAt({ 0.0f, 0.0f, 0.0f }, { std::cos(angle), 0.0f, std::sin(angle) }, { 0.0f, 1.0f, 0.0f });
+            HB::Frustum frustum = HB::Frustum::from_matrix(projection * view);
+            bvh.query_frustum(frustum, [&](uint32_t, uint32_t count) { visible += count; });
+        }
+    }), query_count);
+    std::printf("%-28s %zu objects per query\n", "", visible / query_count);
+
+    size_t flat_visible = 0;
+    HB::Frustum frustum = HB::Frustum::from_matrix(projection * glm::lookAt({ 0.0f, 0.0f, 0.0f }, { 1.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f }));
+    report("flat frustum culling", time_best_of(3, [&] {
+        flat_visible = 0;
+        for (auto const& object : bounds)
+            flat_visible += frustum.classify(object) != HB::Containment::OUTSIDE;
+    }), 1);
+
+    size_t hits = 0;
+    report("ray pick", time_best_of(5, [&] {
+        hits = 0;
+        for (size_t i = 0; i < query_count; i += 1) {
+            HB::Ray ray = { { position(random), position(random), -150.0f }, { 0.0f, 0.0f, 1.0f } };
+            hits += bvh.raycast(ray).object != HB::Bvh::NO_OBJECT;
+        }
+    }), query_count);
+    std::printf("%-28s %zu of %zu rays hit\n", "", hits, query_count);
+
+    size_t found = 0;
+    report("range query", time_best_of(5, [&] {
+        found = 0;
+        for (size_t i = 0; i < query_count; i += 1) {
+            glm::vec3 center = { position(random), position(random), position(random) };
+            bvh.query_range({ center - 5.0f, center + 5.0f }, [&](uint32_t, uint32_t count) { found += count; });
+        }
+    }), query_count);
+    std::printf("%-28s %zu objects per query\n", "", found / query_count);
+
+    return 0;
+}
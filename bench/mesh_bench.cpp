@@ -0,0 +1,104 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "mesh_data.hpp"
+
+// Loading, vertex cache/fetch optimization and LOD generation for a bumpy sphere written out as
+// OBJ, its triangles shuffled first like a mesh from an exporter that doesn't care about order.
+
+using Clock = std::chrono::steady_clock;
+
+template<typename F>
+static double time_best_of(int runs, F&& function)
+{
+    double best = 1e30;
+    for (int i = 0; i < runs; i += 1) {
+        auto start = Clock::now();
+        function();
+        best = std::min(best, std::chrono::duration<double>(Clock::now() - start).count());
+    }
+    return best;
+}
+
+static void report(char const* name, double seconds, size_t operations = 0)
+{
+    if (operations > 0)
+        std::printf("%-28s %9.3f ms %10.3f ns/op\n", name, seconds * 1e3, seconds * 1e9 / operations);
+    else
+        std::printf("%-28s %9.3f ms\n", name, seconds * 1e3);
+}
+
+// rings x segments quads, with a seam where the texture coordinates wrap around
+static void write_sphere(std::string const& path, uint32_t rings, uint32_t segments)
+{
+    std::ofstream file(path);
+    float const pi = 3.14159265f;
+    for (uint32_t ring = 0; ring <= rings; ring += 1) {
+        for (uint32_t segment = 0; segment <= segments; segment += 1) {
+            float theta = pi * float(ring) / float(rings);
+            float phi = 2.0f * pi * float(segment % segments) / float(segments);
+            float bump = 1.0f + 0.05f * std::sin(theta * 12.0f) * std::sin(phi * 9.0f);
+            file << "v " << bump * std::sin(theta) * std::cos(phi) << " " << bump * std::cos(theta) << " " << bump * std::sin(theta) * std::sin(phi) << "\n";
+            file << "vt " << float(segment) / float(segments) << " " << float(ring) / float(rings) << "\n";
+        }
+    }
+
+    std::vector<std::string> faces;
+    for (uint32_t ring = 0; ring < rings; ring += 1) {
+        for (uint32_t segment = 0; segment < segments; segment += 1) {
+            uint32_t a = ring * (segments + 1) + segment + 1;
+            uint32_t b = a + segments + 1;
+            faces.push_back("f " + std::to_string(a) + "/" + std::to_string(a) + " " + std::to_string(b) + "/" + std::to_string(b) + " " + std::to_string(a + 1) + "/" + std::to_string(a + 1));
+            faces.push_back("f " + std::to_string(a + 1) + "/" + std::to_string(a + 1) + " " + std::to_string(b) + "/" + std::to_string(b) + " " + std::to_string(b + 1) + "/" + std::to_string(b + 1));
+        }
+    }
+    std::shuffle(faces.begin(), faces.end(), std::mt19937(42));
+    for (std::string const& face : faces)
+        file << face << "\n";
+}
+
+int main()
+{
+    std::filesystem::path directory = std::filesystem::temp_directory_path() / "hummingbird_mesh_bench";
+    std::filesystem::create_directories(directory);
+    std::string path = (directory / "sphere.obj").string();
+    write_sphere(path, 256, 512);
+
+    HB::MeshData mesh;
+    double load_seconds = time_best_of(3, [&] { mesh = HB::load_obj(path); });
+    report("load obj", load_seconds, mesh.indices.size() / 3);
+    std::printf("vertices: %zu, triangles: %zu\n", mesh.vertices.size(), mesh.indices.size() / 3);
+
+    std::printf("acmr (16 entry fifo) before: %.3f\n", HB::average_cache_miss_ratio(mesh.indices, mesh.vertices.size()));
+    std::vector<uint32_t> optimized;
+    double optimize_seconds = time_best_of(3, [&] {
+        optimized = mesh.indices;
+        HB::optimize_vertex_cache(optimized, mesh.vertices.size());
+    });
+    report("optimize vertex cache", optimize_seconds, optimized.size() / 3);
+    std::printf("acmr (16 entry fifo) after: %.3f\n", HB::average_cache_miss_ratio(optimized, mesh.vertices.size()));
+
+    HB::LodChain chain;
+    report("build lods", time_best_of(1, [&] { chain = HB::build_lods(mesh); }), mesh.indices.size() / 3);
+    for (size_t i = 0; i < chain.lods.size(); i += 1) {
+        HB::MeshLod const& lod = chain.lods[i];
+        std::vector<uint32_t> indices(chain.mesh.indices.begin() + lod.first_index, chain.mesh.indices.begin() + lod.first_index + lod.index_count);
+        std::printf("lod %zu: %8u triangles, error %.5f, acmr %.3f\n", i, lod.index_count / 3, lod.error, HB::average_cache_miss_ratio(indices, chain.mesh.vertices.size()));
+    }
+
+    // triangles per meshlet show how often the vertex limit cut one short
+    HB::MeshLod const& full = chain.lods.front();
+    std::vector<HB::Meshlet> meshlets;
+    report("build meshlets", time_best_of(3, [&] { meshlets = HB::build_meshlets(chain.mesh.vertices, chain.mesh.indices, full.first_index, full.index_count); }), full.index_count / 3);
+    uint32_t cullable = 0;
+    for (HB::Meshlet const& meshlet : meshlets)
+        cullable += meshlet.cone_cutoff < 1.0f;
+    std::printf("meshlets: %zu, %.1f triangles each, %u with a normal cone\n", meshlets.size(), float(full.index_count / 3) / float(meshlets.size()), cullable);
+}
@@ -0,0 +1,610 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "app.hpp"
+
+// Fixed, deterministic scenes rendered headless for a set number of frames. The results go to
+// stdout as JSON, every metric is lower-is-better so render_bench.py can hold them against a
+// baseline. Progress and errors go to stderr.
+
+using Clock = std::chrono::steady_clock;
+
+constexpr uint32_t const WIDTH = 1280;
+constexpr uint32_t const HEIGHT = 720;
+constexpr uint32_t const WARMUP_FRAMES = 20;
+constexpr uint32_t const FRAMES = 200;
+
+struct Result {
+    std::string name;
+    std::vector<std::pair<char const*, double>> metrics;
+};
+
+static double milliseconds_since(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+static HB::AppInfo bench_app_info()
+{
+    HB::AppInfo app_info {};
+    app_info.width = WIDTH;
+    app_info.height = HEIGHT;
+    app_info.name = "render_bench";
+    app_info.version = "0";
+    app_info.headless = true;
+    return app_info;
+}
+
+// a square grid of triangles covering the view
+static void populate(HB::App& app, uint32_t count)
+{
+    uint32_t side = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<double>(count))));
+    float cell = 1.9f / static_cast<float>(side);
+    float half = cell * 0.4f;
+    for (uint32_t i = 0; i < count; i += 1) {
+        float x = -0.95f + (static_cast<float>(i % side) + 0.5f) * cell;
+        float y = -0.95f + (static_cast<float>(i / side) + 0.5f) * cell;
+        HB::Transform transform { { x, y, 0.0f }, { cell * 0.8f, cell * 0.8f, 1.0f } };
+        HB::Bounds bounds { { x - half, y - half, 0.0f }, { x + half, y + half, 0.0f } };
+        HB::Renderable renderable { 0, { 1.0f, 1.0f, 1.0f } };
+        app.scene().create(transform, bounds, renderable);
+    }
+}
+
+// renders FRAMES frames after a warm-up, the counters are the same every frame in these scenes
+static Result measure(std::string name, HB::App& app)
+{
+    // resolution scaling would make the GPU numbers depend on the previous frames
+    app.set_target_frame_time(1e9f);
+    app.run_frames(WARMUP_FRAMES);
+    app.wait_idle();
+
+    double gpu_ms = 0.0;
+    double record_ms = 0.0;
+    auto start = Clock::now();
+    for (uint32_t i = 0; i < FRAMES; i += 1) {
+        app.run_frames(1);
+        gpu_ms += app.frame_stats().gpu_ms;
+        record_ms += app.frame_stats().record_ms;
+    }
+    app.wait_idle();
+    double cpu_ms = milliseconds_since(start) / FRAMES;
+
+    HB::FrameStats const& stats = app.frame_stats();
+    return { std::move(name), {
+        { "frame_ms", cpu_ms },
+        { "gpu_ms", gpu_ms / FRAMES },
+        { "record_ms", record_ms / FRAMES },
+        { "draw_calls", static_cast<double>(stats[HB::Counter::DRAW_CALLS]) },
+        { "pipeline_binds", static_cast<double>(stats[HB::Counter::PIPELINE_BINDS]) },
+        { "bytes_uploaded", static_cast<double>(stats[HB::Counter::BYTES_UPLOADED]) },
+        { "objects_created", static_cast<double>(stats[HB::Counter::OBJECTS_CREATED]) },
+    } };
+}
+
+static Result triangle_scaling(uint32_t count)
+{
+    HB::App app { bench_app_info() };
+    populate(app, count);
+    return measure("triangles_" + std::to_string(count), app);
+}
+
+static Result draw_call_scaling(uint32_t draws)
+{
+    uint32_t const INSTANCES = 10000;
+    HB::App app { bench_app_info() };
+    populate(app, INSTANCES);
+    app.set_max_instances_per_draw((INSTANCES + draws - 1) / draws);
+    return measure("draw_calls_" + std::to_string(draws), app);
+}
+
+// the same scene shown by several windows, offscreen since the bench is headless, so the
+// difference to windows_1 is the CPU cost of every extra view
+static Result window_scaling(uint32_t windows)
+{
+    HB::App app { bench_app_info() };
+    populate(app, 10000);
+    for (uint32_t i = 1; i < windows; i += 1)
+        app.add_window(640, 360, "bench");
+    return measure("windows_" + std::to_string(windows), app);
+}
+
+// An update that takes UPDATE_MS and moves everything, once through the single threaded loop and
+// once with simulation and rendering on their own threads. frame_ms is the time per rendered
+// frame, latency_ms how old the drawn state was at submit, sampled at the end of every chunk
+// since the threads only stop in between.
+static Result slow_update(bool threaded)
+{
+    double const UPDATE_MS = 4.0;
+    uint32_t const CHUNKS = 10;
+
+    HB::AppInfo app_info = bench_app_info();
+    app_info.threaded = threaded;
+    HB::App app { app_info };
+    populate(app, 10000);
+    app.set_target_frame_time(1e9f);
+    app.set_simulation_rate(120.0f);
+    uint32_t steps = 0;
+    app.set_update([&app, &steps, UPDATE_MS](HB::Scene& scene, float) {
+        auto start = Clock::now();
+        float offset = 0.001f * (steps % 2 == 0 ? 1.0f : -1.0f);
+        steps += 1;
+        scene.each<HB::Transform, HB::Bounds>([offset](HB::Transform& transform, HB::Bounds& bounds) {
+            transform.position.x += offset;
+            bounds.min.x += offset;
+            bounds.max.x += offset;
+        });
+        app.scene_moved();
+        while (milliseconds_since(start) < UPDATE_MS) { }
+    });
+    app.run_frames(WARMUP_FRAMES);
+    app.wait_idle();
+
+    double latency_ms = 0.0;
+    auto start = Clock::now();
+    for (uint32_t i = 0; i < CHUNKS; i += 1) {
+        app.run_frames(FRAMES / CHUNKS);
+        latency_ms += app.frame_stats().latency_ms;
+    }
+    app.wait_idle();
+    double frame_ms = milliseconds_since(start) / FRAMES;
+
+    return { threaded ? "slow_update_threaded" : "slow_update", {
+        { "frame_ms", frame_ms },
+        { "latency_ms", latency_ms / CHUNKS },
+    } };
+}
+
+// 100k glyphs over the grid, the same labels every frame so layout comes from the cache
+static Result text_scaling()
+{
+    uint32_t const LABELS = 100000 / 12;
+    HB::App app { bench_app_info() };
+    populate(app, 1000);
+    std::vector<std::string> labels(LABELS);
+    for (uint32_t i = 0; i < LABELS; i += 1)
+        labels[i] = "entity " + std::to_string(100000 + i);
+    app.set_update([&app, &labels](HB::Scene&, float) {
+        for (uint32_t i = 0; i < labels.size(); i += 1) {
+            float x = static_cast<float>(i % 64) / 32.0f - 1.0f;
+            float y = static_cast<float>(i / 64) / 64.0f - 1.0f;
+            app.draw_text(labels[i], { x, y, 0.0f }, 0.012f);
+        }
+    });
+    return measure("text_100k", app);
+}
+
+// A series of `samples` values filled through append() and uploaded, then plotted full width
+// while STREAMED new samples come in every frame. The append and upload costs are per sample.
+static Result series_scaling(std::string name, uint32_t samples)
+{
+    uint32_t const CHUNK = 1 << 20;
+    uint32_t const STREAMED = 10000;
+
+    HB::App app { bench_app_info() };
+    HB::SeriesView view {};
+    view.value_range = { -1.5f, 1.5f };
+    uint32_t series = app.series().create(samples, view);
+
+    std::vector<float> values(CHUNK);
+    for (uint32_t i = 0; i < CHUNK; i += 1)
+        values[i] = std::sin(static_cast<float>(i) * 0.001f) + 0.25f * std::sin(static_cast<float>(i) * 0.37f);
+
+    auto start = Clock::now();
+    for (uint32_t appended = 0; appended < samples; appended += CHUNK)
+        app.series().append(series, values.data(), std::min(CHUNK, samples - appended));
+    double append_ns = milliseconds_since(start) * 1e6 / samples;
+
+    start = Clock::now();
+    while (app.series().pending_samples() > 0)
+        app.run_frames(1);
+    app.wait_idle();
+    double upload_ns = milliseconds_since(start) * 1e6 / samples;
+
+    uint32_t offset = 0;
+    app.set_update([&app, &values, &offset, series](HB::Scene&, float) {
+        app.series().append(series, values.data() + offset, STREAMED);
+        offset = (offset + STREAMED) % (CHUNK - STREAMED);
+    });
+    Result result = measure(std::move(name), app);
+    result.metrics.push_back({ "append_ns_per_sample", append_ns });
+    result.metrics.push_back({ "upload_ns_per_sample", upload_ns });
+    return result;
+}
+
+// rings x segments quads around the unit sphere
+static void write_sphere(std::string const& path, uint32_t rings, uint32_t segments)
+{
+    std::ofstream file(path);
+    float const pi = 3.14159265f;
+    for (uint32_t ring = 0; ring <= rings; ring += 1) {
+        for (uint32_t segment = 0; segment < segments; segment += 1) {
+            float theta = pi * static_cast<float>(ring) / static_cast<float>(rings);
+            float phi = 2.0f * pi * static_cast<float>(segment) / static_cast<float>(segments);
+            file << "v " << 0.5f * std::sin(theta) * std::cos(phi) << " " << 0.5f * std::cos(theta) << " " << 0.5f * std::sin(theta) * std::sin(phi) << "\n";
+        }
+    }
+    for (uint32_t ring = 0; ring < rings; ring += 1) {
+        for (uint32_t segment = 0; segment < segments; segment += 1) {
+            uint32_t a = ring * segments + segment + 1;
+            uint32_t b = ring * segments + (segment + 1) % segments + 1;
+            file << "f " << a << " " << a + segments << " " << b << "\n";
+            file << "f " << b << " " << a + segments << " " << b + segments << "\n";
+        }
+    }
+}
+
+// A grid of 8k triangle spheres, each a few pixels across, with LOD selection on or off.
+// triangles is what the scene pass drew per frame, so meshlets are drawn whole.
+static Result mesh_lods(bool lods)
+{
+    uint32_t const COUNT = 4096;
+
+    HB::App app { bench_app_info() };
+    app.set_meshlet_culling(false);
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "hummingbird_render_bench_sphere.obj";
+    write_sphere(path.string(), 64, 64);
+    uint32_t sphere = app.meshes().load_obj(path.string());
+    if (!lods)
+        app.meshes().set_lod_threshold(0.0f);
+
+    uint32_t side = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<double>(COUNT))));
+    float cell = 1.9f / static_cast<float>(side);
+    float half = cell * 0.4f;
+    for (uint32_t i = 0; i < COUNT; i += 1) {
+        float x = -0.95f + (static_cast<float>(i % side) + 0.5f) * cell;
+        float y = -0.95f + (static_cast<float>(i / side) + 0.5f) * cell;
+        HB::Transform transform { { x, y, 0.5f }, { cell * 0.8f, cell * 0.8f, cell * 0.8f } };
+        HB::Bounds bounds { { x - half, y - half, 0.5f - half }, { x + half, y + half, 0.5f + half } };
+        HB::Renderable renderable { sphere, { 1.0f, 1.0f, 1.0f } };
+        app.scene().create(transform, bounds, renderable);
+    }
+
+    Result result = measure(lods ? "mesh_lods_on" : "mesh_lods_off", app);
+    result.metrics.push_back({ "triangles", static_cast<double>(app.frame_stats()[HB::Counter::VERTICES] / 3) });
+    return result;
+}
+
+// 16 spheres of 130k triangles at full detail, the outer ones half off screen, drawn whole or
+// with their meshlets culled on the GPU. Half of every sphere faces away. triangles is what the
+// input assembler was given, from the pipeline statistics, 0 without them.
+static Result meshlet_culling(bool culled)
+{
+    uint32_t const SIDE = 4;
+
+    HB::App app { bench_app_info() };
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "hummingbird_render_bench_dense_sphere.obj";
+    write_sphere(path.string(), 256, 256);
+    uint32_t sphere = app.meshes().load_obj(path.string());
+    app.meshes().set_lod_threshold(0.0f);
+    app.set_meshlet_culling(culled);
+
+    float const SPACING = 0.6f;
+    float const SCALE = 0.55f;
+    for (uint32_t i = 0; i < SIDE * SIDE; i += 1) {
+        float x = (static_cast<float>(i % SIDE) - 1.5f) * SPACING;
+        float y = (static_cast<float>(i / SIDE) - 1.5f) * SPACING;
+        float half = SCALE * 0.5f;
+        HB::Transform transform { { x, y, 0.5f }, glm::vec3(SCALE) };
+        HB::Bounds bounds { { x - half, y - half, 0.5f - half }, { x + half, y + half, 0.5f + half } };
+        HB::Renderable renderable { sphere, { 1.0f, 1.0f, 1.0f } };
+        app.scene().create(transform, bounds, renderable);
+    }
+
+    Result result = measure(culled ? "meshlets_culled" : "meshlets_whole", app);
+    HB::FrameStats const& stats = app.frame_stats();
+    result.metrics.push_back({ "triangles", static_cast<double>(stats[HB::PipelineStatistic::INPUT_PRIMITIVES]) });
+    result.metrics.push_back({ "meshlets", static_cast<double>(stats[HB::Counter::MESHLETS]) });
+    return result;
+}
+
+// 10k triangles, each with one of 64 materials picked at random (4 pipeline variants x 16
+// textures), submitted in culling order or sorted by state
+static Result draw_sorting(bool sorted)
+{
+    uint32_t const COUNT = 10000;
+    uint32_t const TEXTURES = 16;
+
+    HB::App app { bench_app_info() };
+    std::vector<uint32_t> materials;
+    for (uint32_t variant = 0; variant < 4; variant += 1) {
+        HB::PipelineDesc desc {};
+        desc.cull_mode = variant % 2 == 0 ? VK_CULL_MODE_BACK_BIT : VK_CULL_MODE_NONE;
+        desc.blend = variant / 2 == 0 ? HB::BlendMode::NONE : HB::BlendMode::ALPHA;
+        for (uint32_t texture = 0; texture < TEXTURES; texture += 1) {
+            uint32_t pixel = 0xFF000000u | (texture * 0x10u) << 8 | (255 - texture * 0x10u);
+            materials.push_back(app.create_material(desc, app.textures().create_rgba8(1, 1, &pixel)));
+        }
+    }
+    app.set_draw_sorting(sorted);
+
+    populate(app, COUNT);
+    std::mt19937 random(42);
+    std::uniform_int_distribution<size_t> pick(0, materials.size() - 1);
+    app.scene().each<HB::Renderable>([&](HB::Renderable& renderable) { renderable.material = materials[pick(random)]; });
+
+    Result result = measure(sorted ? "draw_sorting_on" : "draw_sorting_off", app);
+    result.metrics.push_back({ "descriptor_binds", static_cast<double>(app.frame_stats()[HB::Counter::DESCRIPTOR_BINDS]) });
+    return result;
+}
+
+// 64 strips of triangles, each with its own 512x512 texture, and a view panning back and forth
+// across them that shows 8 at a time. Limited, the device local budget is cut to what a quarter
+// of the textures need on top of everything else, so the ones panned away from are evicted and
+// restored when they come back into view.
+static Result memory_pressure(bool limited)
+{
+    uint32_t const STRIPS = 64;
+    uint32_t const SIZE = 512;
+    uint32_t const ROWS = 8;
+    float const STRIP = 0.25f;
+    uint32_t const PERIOD = 200;
+
+    HB::App app { bench_app_info() };
+    std::vector<uint32_t> texels(SIZE * SIZE);
+    for (uint32_t strip = 0; strip < STRIPS; strip += 1) {
+        for (uint32_t i = 0; i < texels.size(); i += 1)
+            texels[i] = 0xFF000000u | (strip * 4u) << 8 | ((i / SIZE + strip) & 0xFFu);
+        uint32_t material = app.create_material({}, app.textures().create_rgba8(SIZE, SIZE, texels.data()));
+
+        float x = -1.0f + static_cast<float>(strip) * STRIP;
+        float cell = 2.0f / static_cast<float>(ROWS);
+        for (uint32_t row = 0; row < ROWS; row += 1) {
+            float y = -1.0f + (static_cast<float>(row) + 0.5f) * cell;
+            float center = x + STRIP * 0.5f;
+            HB::Transform transform { { center, y, 0.0f }, { STRIP * 0.8f, cell * 0.8f, 1.0f } };
+            HB::Bounds bounds { { center - STRIP * 0.4f, y - cell * 0.4f, 0.0f }, { center + STRIP * 0.4f, y + cell * 0.4f, 0.0f } };
+            HB::Renderable renderable { 0, { 1.0f, 1.0f, 1.0f } };
+            renderable.material = material;
+            app.scene().create(transform, bounds, renderable);
+        }
+    }
+
+    if (limited) {
+        HB::ResidencyManager& residency = app.residency();
+        residency.update();
+        VkDeviceSize usage = 0;
+        for (uint32_t i = 0; i < residency.heap_count(); i += 1) {
+            if (residency.heap(i).device_local)
+                usage = std::max(usage, residency.heap(i).usage);
+        }
+        residency.set_budget_limit(usage - app.textures().memory_size() * 3 / 4);
+    }
+
+    uint32_t step = 0;
+    float const SPAN = static_cast<float>(STRIPS) * STRIP - 2.0f;
+    app.set_update([&app, &step, SPAN, PERIOD](HB::Scene&, float) {
+        float t = static_cast<float>(step % PERIOD) / static_cast<float>(PERIOD / 2);
+        step += 1;
+        glm::mat4 view_projection(1.0f);
+        view_projection[3].x = -SPAN * (t < 1.0f ? t : 2.0f - t);
+        app.set_view_projection(view_projection);
+    });
+    app.set_target_frame_time(1e9f);
+    app.run_frames(WARMUP_FRAMES);
+    app.wait_idle();
+
+    uint64_t evictions = 0;
+    uint64_t restores = 0;
+    float over_budget_mb = 0.0f;
+    auto start = Clock::now();
+    for (uint32_t i = 0; i < FRAMES; i += 1) {
+        app.run_frames(1);
+        HB::FrameStats const& stats = app.frame_stats();
+        evictions += stats[HB::Counter::EVICTIONS];
+        restores += stats[HB::Counter::RESTORES];
+        over_budget_mb = std::max(over_budget_mb, -stats.memory_headroom_mb);
+    }
+    app.wait_idle();
+    double cpu_ms = milliseconds_since(start) / FRAMES;
+
+    return { limited ? "memory_pressure_limited" : "memory_pressure_unlimited", {
+        { "frame_ms", cpu_ms },
+        { "evictions", static_cast<double>(evictions) / FRAMES },
+        { "restores", static_cast<double>(restores) / FRAMES },
+        { "over_budget_mb", over_budget_mb },
+        { "texture_mb", static_cast<double>(app.textures().resident_size()) / (1024.0 * 1024.0) },
+    } };
+}
+
+// Bloom and tonemapping on a full scene, fused composites and tonemaps in one pass where
+// unfused reads and writes the scene once more. post_ms is the GPU time of the chain alone.
+static Result post_processing(bool fused)
+{
+    HB::App app { bench_app_info() };
+    populate(app, 10000);
+    HB::PostSettings settings {};
+    settings.fuse = fused;
+    app.set_post_chain({ HB::PostEffect::BLOOM, HB::PostEffect::TONEMAP }, settings);
+
+    Result result = measure(fused ? "post_fused" : "post_unfused", app);
+    HB::FrameStats const& stats = app.frame_stats();
+    result.metrics.push_back({ "post_ms", stats.post_ms });
+    result.metrics.push_back({ "dispatches", static_cast<double>(stats[HB::Counter::DISPATCHES]) });
+    return result;
+}
+
+// 10k instances in 1000 draws, all still or MOVING of them moving every frame, with the scene
+// draws recorded every frame or kept from the last time the frame slot came around. Moving
+// instances change the instance data but not the draws, so the recorded commands stay valid.
+static Result command_caching(bool cached, bool moving)
+{
+    uint32_t const INSTANCES = 10000;
+    uint32_t const DRAWS = 1000;
+    uint32_t const MOVING = 100;
+
+    HB::App app { bench_app_info() };
+    populate(app, INSTANCES);
+    app.set_max_instances_per_draw(INSTANCES / DRAWS);
+    app.set_command_buffer_caching(cached);
+    uint32_t steps = 0;
+    if (moving) {
+        app.set_update([&app, &steps, MOVING](HB::Scene& scene, float) {
+            float offset = 0.001f * (steps % 2 == 0 ? 1.0f : -1.0f);
+            steps += 1;
+            uint32_t moved = 0;
+            scene.each<HB::Transform, HB::Bounds>([&moved, offset, MOVING](HB::Transform& transform, HB::Bounds& bounds) {
+                if (moved == MOVING)
+                    return;
+                transform.position.x += offset;
+                bounds.min.x += offset;
+                bounds.max.x += offset;
+                moved += 1;
+            });
+            app.scene_moved();
+        });
+    }
+    return measure(std::string(cached ? "commands_cached" : "commands_recorded") + (moving ? "_moving" : "_static"), app);
+}
+
+static Result resize_storm()
+{
+    uint32_t const RESIZES = 100;
+    std::pair<uint32_t, uint32_t> const SIZES[] = { { 1280, 720 }, { 640, 360 }, { 1920, 1080 }, { 800, 600 } };
+
+    HB::App app { bench_app_info() };
+    populate(app, 1000);
+    app.run_frames(WARMUP_FRAMES);
+    app.wait_idle();
+
+    // objects recreated by a resize are counted in the frame that follows it
+    uint64_t objects_created = 0;
+    auto start = Clock::now();
+    for (uint32_t i = 0; i < RESIZES; i += 1) {
+        auto [width, height] = SIZES[i % std::size(SIZES)];
+        app.resize(width, height);
+        app.run_frames(1);
+        objects_created += app.frame_stats()[HB::Counter::OBJECTS_CREATED];
+    }
+    app.wait_idle();
+    double resize_ms = milliseconds_since(start) / RESIZES;
+
+    return { "resize_storm", {
+        { "resize_ms", resize_ms },
+        { "objects_created", static_cast<double>(objects_created) / RESIZES },
+    } };
+}
+
+// App construction up to the first finished frame, shaders included, and the construction alone
+static Result startup(std::string name, bool serial = false)
+{
+    uint32_t const RUNS = 3;
+    double best = 1e30;
+    double init_ms = 1e30;
+    double shader_ms = 1e30;
+    for (uint32_t i = 0; i < RUNS; i += 1) {
+        HB::AppInfo app_info = bench_app_info();
+        app_info.serial_startup = serial;
+        auto start = Clock::now();
+        HB::App app { app_info };
+        app.run_frames(1);
+        app.wait_idle();
+        best = std::min(best, milliseconds_since(start));
+        double initialized = 0.0;
+        for (HB::StartupTiming const& timing : app.startup_timings())
+            initialized = std::max(initialized, timing.start_ms + timing.duration_ms);
+        init_ms = std::min(init_ms, initialized);
+        shader_ms = std::min(shader_ms, app.pipelines().stats().shader_ms);
+    }
+    return { std::move(name), { { "first_frame_ms", best }, { "init_ms", init_ms }, { "shader_ms", shader_ms } } };
+}
+
+static void print_json(std::vector<Result> const& results)
+{
+    std::printf("{\n  \"benchmarks\": {\n");
+    for (size_t i = 0; i < results.size(); i += 1) {
+        std::printf("    \"%s\": {", results[i].name.c_str());
+        for (size_t j = 0; j < results[i].metrics.size(); j += 1)
+            std::printf("%s\"%s\": %.6g", j == 0 ? " " : ", ", results[i].metrics[j].first, results[i].metrics[j].second);
+        std::printf(" }%s\n", i + 1 < results.size() ? "," : "");
+    }
+    std::printf("  }\n}\n");
+}
+
+int main()
+{
+    try {
+        std::vector<Result> results;
+        results.push_back(startup("startup"));
+        // the initialization steps one after the other, what overlapping them saves
+        results.push_back(startup("startup_serial", true));
+        // the same with the shaders read from the build directory, what embedding them saves
+        if (std::filesystem::exists("vert.spv")) {
+            setenv("HB_SHADER_DIR", ".", 1);
+            results.push_back(startup("startup_from_disk"));
+            unsetenv("HB_SHADER_DIR");
+        }
+        for (uint32_t count : { 1000u, 10000u, 100000u }) {
+            std::fprintf(stderr, "triangles %u\n", count);
+            results.push_back(triangle_scaling(count));
+        }
+        for (uint32_t draws : { 1u, 10u, 100u, 1000u }) {
+            std::fprintf(stderr, "draw calls %u\n", draws);
+            results.push_back(draw_call_scaling(draws));
+        }
+        for (uint32_t windows : { 1u, 2u, 4u }) {
+            std::fprintf(stderr, "windows %u\n", windows);
+            results.push_back(window_scaling(windows));
+        }
+        std::fprintf(stderr, "text\n");
+        results.push_back(text_scaling());
+        std::fprintf(stderr, "series 10M\n");
+        results.push_back(series_scaling("series_10M", 10000000));
+        // 400 MB on the GPU and as much again queued on the CPU, skipped where that doesn't fit
+        std::fprintf(stderr, "series 100M\n");
+        try {
+            results.push_back(series_scaling("series_100M", 100000000));
+        } catch (std::exception const& e) {
+            std::fprintf(stderr, "series 100M skipped: %s\n", e.what());
+        }
+        for (bool lods : { false, true }) {
+            std::fprintf(stderr, "mesh lods %s\n", lods ? "on" : "off");
+            results.push_back(mesh_lods(lods));
+        }
+        for (bool culled : { false, true }) {
+            std::fprintf(stderr, "meshlets %s\n", culled ? "culled" : "whole");
+            results.push_back(meshlet_culling(culled));
+        }
+        for (bool sorted : { false, true }) {
+            std::fprintf(stderr, "draw sorting %s\n", sorted ? "on" : "off");
+            results.push_back(draw_sorting(sorted));
+        }
+        for (bool threaded : { false, true }) {
+            std::fprintf(stderr, "slow update%s\n", threaded ? ", threaded" : "");
+            results.push_back(slow_update(threaded));
+        }
+        for (bool limited : { false, true }) {
+            std::fprintf(stderr, "memory pressure%s\n", limited ? ", limited" : "");
+            results.push_back(memory_pressure(limited));
+        }
+        for (bool fused : { true, false }) {
+            std::fprintf(stderr, "post-processing%s\n", fused ? ", fused" : "");
+            results.push_back(post_processing(fused));
+        }
+        for (bool moving : { false, true }) {
+            for (bool cached : { false, true }) {
+                std::fprintf(stderr, "command buffers, %s, %s\n", moving ? "moving" : "static", cached ? "cached" : "recorded");
+                results.push_back(command_caching(cached, moving));
+            }
+        }
+        std::fprintf(stderr, "resize storm\n");
+        results.push_back(resize_storm());
+
+        print_json(results);
+    } catch (std::exception const& e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+
+    return 0;
+}
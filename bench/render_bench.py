@@ -0,0 +1,80 @@
+#!/usr/bin/env python3
+"""Runs render_bench and holds its results against a stored baseline.
+
+Every metric is lower-is-better. A metric regresses when it exceeds its baseline by more than the
+threshold (in percent, 10 is 10%). A run with --update records the results as the new baseline
+instead of comparing against it. Exits non-zero on a regression, and when there is no baseline to
+compare against, so a missing one can't pass for a clean run.
+"""
+
+import argparse
+import json
+import os
+import subprocess
+import sys
+
+
+def run(executable):
+    completed = subprocess.run([executable], stdout=subprocess.PIPE, check=True)
+    return json.loads(completed.stdout)["benchmarks"]
+
+
+def compare(baseline, results, threshold):
+    regressions = []
+    for name, metrics in sorted(baseline.items()):
+        if name not in results:
+            regressions.append(f"{name}: missing from the results")
+            continue
+        for metric, expected in sorted(metrics.items()):
+            actual = results[name].get(metric)
+            if actual is None:
+                regressions.append(f"{name}.{metric}: missing from the results")
+                continue
+            limit = expected * (1.0 + threshold)
+            change = (actual - expected) / expected * 100.0 if expected > 0 else 0.0
+            status = "REGRESSED" if actual > limit else "ok"
+            print(f"{name + '.' + metric:40} {expected:14.6g} -> {actual:14.6g} {change:+7.1f}%  {status}")
+            if actual > limit:
+                regressions.append(f"{name}.{metric}: {expected:.6g} -> {actual:.6g}")
+    for name in sorted(set(results) - set(baseline)):
+        print(f"{name}: new, not in the baseline")
+    return regressions
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("executable")
+    parser.add_argument("--baseline", required=True)
+    parser.add_argument("--threshold", type=float, default=10.0, help="allowed regression in percent")
+    parser.add_argument("--output", default="render_bench.json", help="where to write this run's results")
+    parser.add_argument("--update", action="store_true", help="record this run as the baseline")
+    args = parser.parse_args()
+
+    results = run(args.executable)
+    with open(args.output, "w") as file:
+        json.dump({"benchmarks": results}, file, indent=2)
+
+    if args.update:
+        with open(args.baseline, "w") as file:
+            json.dump({"benchmarks": results}, file, indent=2)
+        print(f"recorded baseline {args.baseline}")
+        return 0
+    if not os.path.exists(args.baseline):
+        print(f"no baseline at {args.baseline}, nothing was compared. This run's results are in {args.output},", file=sys.stderr)
+        print("copy them there or run again with --update to record one.", file=sys.stderr)
+        return 1
+
+    with open(args.baseline) as file:
+        baseline = json.load(file)["benchmarks"]
+
+    regressions = compare(baseline, results, args.threshold / 100.0)
+    if regressions:
+        print(f"{len(regressions)} regression(s) beyond {args.threshold}%:")
+        for regression in regressions:
+            print("  " + regression)
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
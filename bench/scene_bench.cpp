@@ -0,0 +1,107 @@
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+#include "scene.hpp"
+#include "thread_pool.hpp"
+
+// Iteration throughput of the scene store with millions of entities, the numbers to watch are
+// entities per second for the serial and the chunk-parallel passes.
+
+using Clock = std::chrono::steady_clock;
+
+struct Velocity {
+    glm::vec3 value;
+};
+
+struct InstanceData {
+    glm::vec3 position;
+    glm::vec3 scale;
+    glm::vec3 color;
+};
+
+template<typename F>
+static double time_best_of(int runs, F&& function)
+{
+    double best = 1e30;
+    for (int i = 0; i < runs; i += 1) {
+        auto start = Clock::now();
+        function();
+        best = std::min(best, std::chrono::duration<double>(Clock::now() - start).count());
+    }
+    return best;
+}
+
+static void report(char const* name, size_t entities, double seconds)
+{
+    std::printf("%-28s %10zu entities %9.3f ms %8.1f M entities/s\n", name, entities, seconds * 1e3, entities / seconds / 1e6);
+}
+
+static void run(HB::ThreadPool& pool, size_t entity_count)
+{
+    HB::Scene scene;
+
+    auto start = Clock::now();
+    for (size_t i = 0; i < entity_count; i += 1) {
+        float x = static_cast<float>(i % 1024) / 512.0f - 1.0f;
+        float y = static_cast<float>(i / 1024 % 1024) / 512.0f - 1.0f;
+        HB::Transform transform { { x, y, 0.0f }, { 0.01f, 0.01f, 1.0f } };
+        HB::Bounds bounds { { x - 0.01f, y - 0.01f, 0.0f }, { x + 0.01f, y + 0.01f, 0.0f } };
+        HB::Renderable renderable { 0, { 1.0f, 1.0f, 1.0f } };
+        // every fourth entity moves, which splits the scene into two archetypes
+        if (i % 4 == 0)
+            scene.create(transform, bounds, renderable, Velocity { { 0.001f, 0.0f, 0.0f } });
+        else
+            scene.create(transform, bounds, renderable);
+    }
+    report("create", entity_count, std::chrono::duration<double>(Clock::now() - start).count());
+
+    auto update_bounds = [](size_t, size_t count, HB::Transform* transforms, HB::Bounds* bounds) {
+        for (size_t i = 0; i < count; i += 1) {
+            glm::vec3 half = transforms[i].scale * 0.5f;
+            bounds[i].min = transforms[i].position - half;
+            bounds[i].max = transforms[i].position + half;
+        }
+    };
+    report("bounds update (serial)", entity_count, time_best_of(5, [&] {
+        scene.each_chunk<HB::Transform, HB::Bounds>(update_bounds);
+    }));
+    report("bounds update (parallel)", entity_count, time_best_of(5, [&] {
+        scene.parallel_each_chunk<HB::Transform, HB::Bounds>(pool, update_bounds);
+    }));
+
+    size_t moving = scene.count<HB::Transform, Velocity>();
+    report("integrate (parallel)", moving, time_best_of(5, [&] {
+        scene.parallel_each_chunk<HB::Transform, Velocity>(pool, [](size_t, size_t count, HB::Transform* transforms, Velocity* velocities) {
+            for (size_t i = 0; i < count; i += 1)
+                transforms[i].position += velocities[i].value;
+        });
+    }));
+
+    std::vector<InstanceData> instances(scene.count<HB::Transform, HB::Renderable>());
+    report("instance list (parallel)", instances.size(), time_best_of(5, [&] {
+        scene.parallel_each_chunk<HB::Transform, HB::Renderable>(pool, [&instances](size_t base, size_t count, HB::Transform* transforms, HB::Renderable* renderables) {
+            for (size_t i = 0; i < count; i += 1)
+                instances[base + i] = { transforms[i].position, transforms[i].scale, renderables[i].color };
+        });
+    }));
+
+    start = Clock::now();
+    size_t destroyed = 0;
+    for (uint32_t i = 0; i < entity_count; i += 2) {
+        scene.destroy({ i, 0 });
+        destroyed += 1;
+    }
+    report("destroy", destroyed, std::chrono::duration<double>(Clock::now() - start).count());
+}
+
+int main()
+{
+    HB::ThreadPool pool;
+    std::printf("worker threads: %u\n", pool.worker_count());
+
+    for (size_t entity_count : { 1'000'000, 4'000'000 })
+        run(pool, entity_count);
+
+    return 0;
+}
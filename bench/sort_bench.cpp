@@ -0,0 +1,86 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "frame_arena.hpp"
+#include "render_queue.hpp"
+#include "thread_pool.hpp"
+
+// Sorting a frame's draw packets: std::sort against the radix sort on one thread and on the
+// pool, for keys like a scene with a few pipelines, many materials and random depths makes.
+
+using Clock = std::chrono::steady_clock;
+
+template<typename F>
+static double time_best_of(int runs, F&& function)
+{
+    double best = 1e30;
+    for (int i = 0; i < runs; i += 1) {
+        auto start = Clock::now();
+        function();
+        best = std::min(best, std::chrono::duration<double>(Clock::now() - start).count());
+    }
+    return best;
+}
+
+static void report(char const* name, double seconds, size_t operations = 0)
+{
+    if (operations > 0)
+        std::printf("%-28s %9.3f ms %10.3f ns/op\n", name, seconds * 1e3, seconds * 1e9 / operations);
+    else
+        std::printf("%-28s %9.3f ms\n", name, seconds * 1e3);
+}
+
+static std::vector<HB::DrawPacket> packets(size_t count)
+{
+    std::mt19937 random(42);
+    std::uniform_int_distribution<uint32_t> pipeline(0, 3);
+    std::uniform_int_distribution<uint32_t> material(0, 255);
+    std::uniform_int_distribution<uint32_t> lod(0, 31);
+    std::uniform_real_distribution<float> depth(0.1f, 100.0f);
+    std::vector<HB::DrawPacket> result(count);
+    for (size_t i = 0; i < count; i += 1) {
+        HB::DrawState state { 0, pipeline(random), material(random), lod(random) };
+        result[i] = { HB::SortKey::make(state, HB::SortKey::depth_bucket(depth(random))), static_cast<uint32_t>(i) };
+    }
+    return result;
+}
+
+int main()
+{
+    HB::ThreadPool pool;
+    HB::FrameArena arena;
+
+    for (size_t count : { 10000u, 100000u, 1000000u }) {
+        std::vector<HB::DrawPacket> input = packets(count);
+        std::vector<HB::DrawPacket> expected = input;
+        std::stable_sort(expected.begin(), expected.end(), [](HB::DrawPacket const& a, HB::DrawPacket const& b) { return a.key < b.key; });
+        std::printf("%zu packets\n", count);
+
+        std::vector<HB::DrawPacket> work;
+        report("  std::sort", time_best_of(5, [&] {
+            work = input;
+            std::sort(work.begin(), work.end(), [](HB::DrawPacket const& a, HB::DrawPacket const& b) { return a.key < b.key; });
+        }), count);
+
+        for (HB::ThreadPool* threads : { static_cast<HB::ThreadPool*>(nullptr), &pool }) {
+            HB::DrawPacket* sorted = nullptr;
+            double seconds = time_best_of(5, [&] {
+                work = input;
+                arena.reset();
+                sorted = HB::radix_sort(work.data(), count, arena, threads);
+            });
+            report(threads ? "  radix sort (pool)" : "  radix sort", seconds, count);
+            for (size_t i = 0; i < count; i += 1) {
+                if (sorted[i].key != expected[i].key || sorted[i].instance != expected[i].instance) {
+                    std::printf("radix sort result differs at %zu!\n", i);
+                    return 1;
+                }
+            }
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,88 @@
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "text.hpp"
+#include "thread_pool.hpp"
+
+// Atlas generation vs loading it from the cache, and laying out + writing 100k glyphs a frame,
+// with labels that repeat every frame (layout cache hits) and with labels that all change.
+
+using Clock = std::chrono::steady_clock;
+
+template<typename F>
+static double time_best_of(int runs, F&& function)
+{
+    double best = 1e30;
+    for (int i = 0; i < runs; i += 1) {
+        auto start = Clock::now();
+        function();
+        best = std::min(best, std::chrono::duration<double>(Clock::now() - start).count());
+    }
+    return best;
+}
+
+static void report(char const* name, double seconds, size_t operations = 0)
+{
+    if (operations > 0)
+        std::printf("%-28s %9.3f ms %10.3f ns/op\n", name, seconds * 1e3, seconds * 1e9 / operations);
+    else
+        std::printf("%-28s %9.3f ms\n", name, seconds * 1e3);
+}
+
+// "id 000000 42.0 ms" style labels, `frame` changes the numbers
+static void fill(HB::TextBatch& batch, uint32_t label_count, uint32_t frame)
+{
+    char text[32];
+    batch.clear();
+    for (uint32_t i = 0; i < label_count; i += 1) {
+        int length = std::snprintf(text, sizeof(text), "id %06u %4.1f", i, static_cast<float>((i + frame) % 1000) / 10.0f);
+        float x = static_cast<float>(i % 100) * 0.02f - 1.0f;
+        float y = static_cast<float>(i / 100) * 0.02f - 1.0f;
+        batch.add({ text, static_cast<size_t>(length) }, { x, y, 0.0f }, 0.01f, glm::vec4(1.0f));
+    }
+}
+
+int main()
+{
+    HB::ThreadPool pool;
+    std::string cache_path = (std::filesystem::temp_directory_path() / "hummingbird_text_bench" / "glyph_atlas.bin").string();
+    std::filesystem::remove(cache_path);
+
+    report("atlas (generate)", time_best_of(1, [&] { HB::GlyphAtlas atlas(cache_path, &pool); }));
+    report("atlas (from cache)", time_best_of(3, [&] { HB::GlyphAtlas atlas(cache_path, &pool); }));
+
+    HB::GlyphAtlas atlas(cache_path, &pool);
+    HB::TextBuilder builder(atlas);
+    HB::TextBatch batch;
+    // 14 characters, 12 of them ink
+    uint32_t const label_count = 100000 / 12;
+    fill(batch, label_count, 0);
+    uint32_t glyph_count = builder.prepare(batch);
+    std::vector<HB::GlyphInstance> glyphs(glyph_count);
+    std::printf("labels: %u, glyphs: %u, worker threads: %u\n", label_count, glyph_count, pool.worker_count());
+
+    report("repeating (serial)", time_best_of(10, [&] {
+        builder.prepare(batch);
+        builder.write(batch, glyphs.data());
+    }), glyph_count);
+    report("repeating (parallel)", time_best_of(10, [&] {
+        builder.prepare(batch);
+        builder.write(batch, glyphs.data(), &pool);
+    }), glyph_count);
+
+    uint32_t frame = 1;
+    report("all changing (parallel)", time_best_of(10, [&] {
+        fill(batch, label_count, frame);
+        frame += 1;
+        glyphs.resize(builder.prepare(batch));
+        builder.write(batch, glyphs.data(), &pool);
+    }), glyph_count);
+
+    HB::TextLayoutStats stats = builder.stats();
+    std::printf("%-28s %.1f%% hits, %zu strings cached, %llu evictions\n", "layout cache", stats.hit_rate() * 100.0, stats.cached_strings, static_cast<unsigned long long>(stats.evictions));
+
+    return 0;
+}
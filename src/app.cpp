@@ -1,24 +1,184 @@
+#include <algorithm>
 #include <cstring>
+#include <exception>
+#include <filesystem>
 #include <iostream>
 #include <optional>
 #include <set>
 #include <stdexcept>
+#include <thread>
 
 #include "app.hpp"
 #include "config.hpp"
-#include "util.hpp"
 
 namespace HB {
 
+struct App::QueueFamilyIndices {
+    std::optional<uint32_t> graphics_family;
+    std::optional<uint32_t> present_family;
+
+    bool complete()
+    {
+        return graphics_family.has_value() && present_family.has_value();
+    }
+};
+
+struct App::SwapChainSupportDetails {
+    VkSurfaceCapabilitiesKHR capabilities;
+    std::vector<VkSurfaceFormatKHR> formats;
+    std::vector<VkPresentModeKHR> present_modes;
+};
+
 void App::run()
 {
-    loop();
+    // there is no window to close, nothing would ever end the loop
+    if (m_app_info.headless)
+        throw std::runtime_error("headless apps are driven with run_frames()!");
+    if (m_app_info.threaded)
+        loop_threaded(0);
+    else
+        loop();
 }
 
-struct Vertex {
-    glm::vec2 pos;
-    glm::vec3 color;
+void App::run_frames(uint32_t count)
+{
+    if (m_app_info.threaded) {
+        loop_threaded(count);
+        return;
+    }
+
+    for (uint32_t i = 0; i < count; i += 1) {
+        if (!m_app_info.headless)
+            glfwPollEvents();
+        step();
+    }
+}
+
+void App::wait_idle()
+{
+    vkDeviceWaitIdle(m_device);
+}
+
+void App::resize(uint32_t width, uint32_t height, uint32_t window)
+{
+    if (window >= m_windows.size() || !m_windows[window])
+        return;
+    if (window == 0) {
+        m_app_info.width = width;
+        m_app_info.height = height;
+    }
+
+    Window& target = *m_windows[window];
+    if (target.handle == nullptr) {
+        target.width = width;
+        target.height = height;
+        recreate_swap_chain(target);
+    } else {
+        glfwSetWindowSize(target.handle, static_cast<int>(width), static_cast<int>(height));
+    }
+}
+
+void App::set_scene_pipeline(PipelineDesc const& desc)
+{
+    uint32_t slot = m_materials[0].pipeline;
+    bool shared = std::any_of(m_materials.begin() + 1, m_materials.end(), [slot](Material const& material) { return material.pipeline == slot; });
+    // the materials sharing its slot keep their pipeline, material 0 moves to the new one's
+    if (shared) {
+        m_materials[0].pipeline = scene_pipeline_slot(desc);
+    } else {
+        m_scene_pipelines[slot] = m_pipelines->get(desc);
+        m_scene_pipeline_descs[slot] = desc;
+    }
+    m_layer_version += 1;
+    m_materials[0].pass = desc.blend != BlendMode::NONE ? SortKey::TRANSLUCENT : 0;
+    if (m_capture)
+        m_capture->scene_pipeline(desc);
+}
+
+uint32_t App::scene_pipeline_slot(PipelineDesc const& desc)
+{
+    VkPipeline pipeline = m_pipelines->get(desc);
+    auto found = std::find(m_scene_pipelines.begin(), m_scene_pipelines.end(), pipeline);
+    if (found == m_scene_pipelines.end()) {
+        if (m_scene_pipelines.size() >= (1u << 8))
+            throw std::runtime_error("failed to add scene pipeline, there are too many!");
+        found = m_scene_pipelines.insert(m_scene_pipelines.end(), pipeline);
+        m_scene_pipeline_descs.push_back(desc);
+    }
+    return static_cast<uint32_t>(found - m_scene_pipelines.begin());
+}
+
+uint32_t App::create_material(PipelineDesc const& desc, uint32_t texture)
+{
+    // the sort key has 8 bits for the pipeline and 14 for the material
+    if (m_materials.size() >= (1u << 14))
+        throw std::runtime_error("failed to create material, there are too many!");
+    Material material {};
+    material.pass = desc.blend != BlendMode::NONE ? SortKey::TRANSLUCENT : 0;
+    material.pipeline = scene_pipeline_slot(desc);
+    material.texture = texture;
+    m_materials.push_back(material);
+    if (m_capture)
+        m_capture->material(desc, texture);
+    return static_cast<uint32_t>(m_materials.size() - 1);
+}
+
+void App::warm_pipelines(std::vector<PipelineDesc> const& descs)
+{
+    for (PipelineDesc const& desc : descs)
+        m_warming_pipelines.push_back(m_thread_pool.submit([this, desc] { return m_pipelines->get(desc); }));
+}
+
+void App::set_post_chain(std::vector<PostEffect> const& chain, PostSettings const& settings)
+{
+    m_post->set_chain(chain, settings);
+    if (m_capture)
+        m_capture->post_chain(chain, settings);
+    // the scratch images don't depend on the chain, windows only need them the first time
+    for (auto& window : m_windows) {
+        if (window && !m_post->empty() && window->targets.post.frames.empty())
+            window->targets.post = m_post->create_targets(window->targets.extent, window->targets.scene_image_views.data());
+    }
+}
+
+void App::set_view_projection(glm::mat4 const& view_projection, uint32_t window)
+{
+    if (window < m_view_projections.size())
+        m_view_projections[window] = view_projection;
+}
+
+uint32_t App::add_window(uint32_t width, uint32_t height, char const* title)
+{
+    auto window = std::make_unique<Window>();
+    window->width = width;
+    window->height = height;
+
+    if (!m_app_info.headless) {
+        create_glfw_window(*window, title);
+        create_surface(*window);
+
+        // everything is presented from one queue, in one call
+        VkBool32 present_support = VK_FALSE;
+        vkGetPhysicalDeviceSurfaceSupportKHR(m_physical_device, m_present_family, window->surface, &present_support);
+        if (!present_support)
+            throw std::runtime_error("new window can't be presented to from the present queue!");
+
+        SwapChainSupportDetails swap_chain_support = query_swap_chain_support(m_physical_device, window->surface);
+        window->surface_format = choose_swap_surface_format(swap_chain_support.formats);
+        window->present_mode = choose_swap_present_mode(swap_chain_support.present_modes);
+    }
 
+    create_window_targets(*window, VK_NULL_HANDLE);
+    create_window_semaphores(*window);
+    create_window_command_buffers(*window);
+
+    m_windows.push_back(std::move(window));
+    m_view_projections.push_back(glm::mat4(1.0f));
+    return static_cast<uint32_t>(m_windows.size() - 1);
+}
+
+// Vertex itself is in mesh_data.hpp, which stays free of Vulkan for the tools and benchmarks
+struct VertexLayout {
     static VkVertexInputBindingDescription get_binding_description()
     {
         VkVertexInputBindingDescription binding_description {};
@@ -29,60 +189,169 @@ struct Vertex {
         return binding_description;
     }
 
-    static std::array<VkVertexInputAttributeDescription, 2> get_attribute_descriptions()
+    static std::array<VkVertexInputAttributeDescription, 3> get_attribute_descriptions()
     {
-        std::array<VkVertexInputAttributeDescription, 2> attribute_descriptions {};
+        std::array<VkVertexInputAttributeDescription, 3> attribute_descriptions {};
         attribute_descriptions[0].binding = 0;
         attribute_descriptions[0].location = 0;
-        attribute_descriptions[0].format = VK_FORMAT_R32G32_SFLOAT;
+        attribute_descriptions[0].format = VK_FORMAT_R32G32B32_SFLOAT;
         attribute_descriptions[0].offset = offsetof(Vertex, pos);
         attribute_descriptions[1].binding = 0;
         attribute_descriptions[1].location = 1;
         attribute_descriptions[1].format = VK_FORMAT_R32G32B32_SFLOAT;
         attribute_descriptions[1].offset = offsetof(Vertex, color);
+        // after the instance attributes so they keep their locations
+        attribute_descriptions[2].binding = 0;
+        attribute_descriptions[2].location = 5;
+        attribute_descriptions[2].format = VK_FORMAT_R32G32_SFLOAT;
+        attribute_descriptions[2].offset = offsetof(Vertex, uv);
 
         return attribute_descriptions;
     }
 };
 
-const std::vector<Vertex> vertices = {
-    { { 0.0f, -0.5f }, { 1.0f, 0.0f, 0.0f } },
-    { { 0.5f, 0.5f }, { 0.0f, 1.0f, 0.0f } },
-    { { -0.5f, 0.5f }, { 0.0f, 0.0f, 1.0f } }
+struct Instance {
+    glm::vec3 position;
+    glm::vec3 scale;
+    glm::vec3 color;
+
+    static VkVertexInputBindingDescription get_binding_description()
+    {
+        VkVertexInputBindingDescription binding_description {};
+        binding_description.binding = 1;
+        binding_description.stride = sizeof(Instance);
+        binding_description.inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+
+        return binding_description;
+    }
+
+    static std::array<VkVertexInputAttributeDescription, 3> get_attribute_descriptions()
+    {
+        std::array<VkVertexInputAttributeDescription, 3> attribute_descriptions {};
+        attribute_descriptions[0].binding = 1;
+        attribute_descriptions[0].location = 2;
+        attribute_descriptions[0].format = VK_FORMAT_R32G32B32_SFLOAT;
+        attribute_descriptions[0].offset = offsetof(Instance, position);
+        attribute_descriptions[1].binding = 1;
+        attribute_descriptions[1].location = 3;
+        attribute_descriptions[1].format = VK_FORMAT_R32G32B32_SFLOAT;
+        attribute_descriptions[1].offset = offsetof(Instance, scale);
+        attribute_descriptions[2].binding = 1;
+        attribute_descriptions[2].location = 4;
+        attribute_descriptions[2].format = VK_FORMAT_R32G32B32_SFLOAT;
+        attribute_descriptions[2].offset = offsetof(Instance, color);
+
+        return attribute_descriptions;
+    }
 };
 
+// instances the per-frame buffers start out with, they grow on demand
+constexpr size_t const INITIAL_INSTANCE_CAPACITY = 1024;
+
 App::App(AppInfo app_info)
     : m_app_info(app_info)
 {
-    init_window();
+    m_construction_start = Clock::now();
+    auto window = std::make_unique<Window>();
+    window->width = m_app_info.width;
+    window->height = m_app_info.height;
+
+    // the GLFW window itself is made along with the instance, in init_vulkan()
+    if (m_app_info.headless)
+        m_device_extensions.clear();
+    else
+        init_window();
+    m_windows.push_back(std::move(window));
+    m_view_projections.push_back(glm::mat4(1.0f));
+
     init_vulkan();
+    // after the built-in texture and mesh, replay starts out with them too
+    if (m_app_info.capture) {
+        m_capture = std::make_unique<CaptureWriter>(m_app_info.capture, m_app_info.width, m_app_info.height);
+        m_capture_start = Clock::now();
+        m_textures->set_capture(m_capture.get());
+        m_meshes->set_capture(m_capture.get());
+    }
+    m_last_step = Clock::now();
 }
 
-void App::destruct_swap_chain()
+void App::destroy_window_targets(WindowTargets& targets)
 {
-    for (auto framebuffer : m_swap_chain_framebuffers)
-        vkDestroyFramebuffer(m_device, framebuffer, nullptr);
-    vkDestroyPipeline(m_device, m_graphics_pipeline, nullptr);
-    vkDestroyPipelineLayout(m_device, m_pipeline_layout, nullptr);
-    vkDestroyRenderPass(m_device, m_render_pass, nullptr);
-    for (auto image_view : m_swap_chain_image_views)
-        vkDestroyImageView(m_device, image_view, nullptr);
-    vkDestroySwapchainKHR(m_device, m_swap_chain, nullptr);
+    for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+        vkDestroyFramebuffer(m_device, targets.scene_framebuffers[i], nullptr);
+        Gpu::destroy_image_view(m_gpu, targets.scene_image_views[i]);
+        Gpu::destroy_image(m_gpu, targets.scene_images[i], targets.scene_images_memory[i]);
+    }
+    m_post->destroy_targets(targets.post);
+    if (targets.swap_chain != VK_NULL_HANDLE)
+        vkDestroySwapchainKHR(m_device, targets.swap_chain, nullptr);
+}
+
+void App::retire_window_targets(WindowTargets& targets)
+{
+    for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+        m_deletion_queue->retire_framebuffer(targets.scene_framebuffers[i]);
+        m_deletion_queue->retire_image_view(targets.scene_image_views[i]);
+        m_deletion_queue->retire_image(targets.scene_images[i], targets.scene_images_memory[i]);
+    }
+    m_post->retire_targets(targets.post);
+    if (targets.swap_chain != VK_NULL_HANDLE)
+        m_deletion_queue->retire_swap_chain(targets.swap_chain);
+    targets = {};
+}
+
+void App::destroy_window(Window& window)
+{
+    destroy_window_targets(window.targets);
+    for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+        vkDestroySemaphore(m_device, window.image_available_semaphores[i], nullptr);
+        vkDestroySemaphore(m_device, window.render_finished_semaphores[i], nullptr);
+        vkFreeCommandBuffers(m_device, m_command_pool, 1, &window.scene_layers[i].commands);
+    }
+    vkFreeCommandBuffers(m_device, m_command_pool, MAX_FRAMES_IN_FLIGHT, window.overlay_commands.data());
+    if (window.surface != VK_NULL_HANDLE)
+        vkDestroySurfaceKHR(m_instance, window.surface, nullptr);
+    if (window.handle != nullptr)
+        glfwDestroyWindow(window.handle);
+}
+
+void App::close_window(uint32_t index)
+{
+    // the frames in flight may still draw to it, so it only disappears from the screen for now
+    glfwHideWindow(m_windows[index]->handle);
+    std::shared_ptr<Window> window = std::move(m_windows[index]);
+    m_deletion_queue->retire([this, window] { destroy_window(*window); });
 }
 
 App::~App()
 {
-    destruct_swap_chain();
-    vkDestroyBuffer(m_device, m_vertex_buffer, nullptr);
-    vkFreeMemory(m_device, m_vertex_buffer_memory, nullptr);
-    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
-        vkDestroySemaphore(m_device, m_image_available_semaphores[i], nullptr);
-        vkDestroySemaphore(m_device, m_render_finished_semaphores[i], nullptr);
-        vkDestroyFence(m_device, m_in_flight_fences[i], nullptr);
+    for (auto& window : m_windows) {
+        if (window)
+            destroy_window(*window);
     }
+    m_deletion_queue->flush();
+    m_post.reset();
+    m_meshlet_culler.reset();
+    m_series.reset();
+    m_text.reset();
+    for (auto& pipeline : m_warming_pipelines)
+        pipeline.wait();
+    m_pipelines.reset();
+    vkDestroyPipelineLayout(m_device, m_pipeline_layout, nullptr);
+    vkDestroyRenderPass(m_device, m_render_pass, nullptr);
+    for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+        destroy_instance_buffer(i);
+    m_meshes.reset();
+    m_textures.reset();
+    m_deletion_queue.reset();
+    m_residency.reset();
+    vkDestroyQueryPool(m_device, m_timestamp_query_pool, nullptr);
+    if (m_statistics_query_pool != VK_NULL_HANDLE)
+        vkDestroyQueryPool(m_device, m_statistics_query_pool, nullptr);
+    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+        vkDestroyFence(m_device, m_in_flight_fences[i], nullptr);
     vkDestroyCommandPool(m_device, m_command_pool, nullptr);
     vkDestroyDevice(m_device, nullptr);
-    vkDestroySurfaceKHR(m_instance, m_surface, nullptr);
     if (m_enable_validation_layers) {
         auto func = (PFN_vkDestroyDebugUtilsMessengerEXT)vkGetInstanceProcAddr(m_instance, "vkDestroyDebugUtilsMessengerEXT");
         if (func != nullptr)
@@ -90,8 +359,17 @@ App::~App()
     }
     vkDestroyInstance(m_instance, nullptr);
 
-    glfwDestroyWindow(m_window);
-    glfwTerminate();
+    if (!m_app_info.headless)
+        glfwTerminate();
+}
+
+static bool contains_extensions(std::vector<VkExtensionProperties> const& available, std::vector<char const*> const& required)
+{
+    return std::all_of(required.begin(), required.end(), [&](char const* name) {
+        return std::any_of(available.begin(), available.end(), [name](VkExtensionProperties const& extension) {
+            return strcmp(extension.extensionName, name) == 0;
+        });
+    });
 }
 
 bool App::check_validation_layer_support() const
@@ -102,12 +380,11 @@ bool App::check_validation_layer_support() const
     std::vector<VkLayerProperties> available_layers(layer_count);
     vkEnumerateInstanceLayerProperties(&layer_count, available_layers.data());
 
-    std::set<std::string> required_layers(m_validation_layers.begin(), m_validation_layers.end());
-
-    for (auto const& layer : available_layers)
-        required_layers.erase(layer.layerName);
-
-    return required_layers.empty();
+    return std::all_of(m_validation_layers.begin(), m_validation_layers.end(), [&](char const* required) {
+        return std::any_of(available_layers.begin(), available_layers.end(), [required](VkLayerProperties const& layer) {
+            return strcmp(layer.layerName, required) == 0;
+        });
+    });
 }
 
 void App::init_window()
@@ -119,26 +396,39 @@ void App::init_window()
 
     if (glfwVulkanSupported() != GLFW_TRUE)
         throw std::runtime_error("no vulkan support found!");
+}
 
-    m_window = glfwCreateWindow(
-        m_app_info.width, m_app_info.height,
-        (std::string(m_app_info.name) + " @ " + std::string(m_app_info.version)).c_str(),
-        nullptr, nullptr);
-    if (m_window == NULL)
+void App::create_glfw_window(Window& window, std::string const& title)
+{
+    window.handle = glfwCreateWindow(window.width, window.height, title.c_str(), nullptr, nullptr);
+    if (window.handle == NULL)
         throw std::runtime_error("Failed to create a window!");
 
-    glfwSetWindowUserPointer(m_window, this);
-    glfwSetFramebufferSizeCallback(m_window, framebuffer_resize_callback);
+    int width = 0, height = 0;
+    glfwGetFramebufferSize(window.handle, &width, &height);
+    window.width = static_cast<uint32_t>(width);
+    window.height = static_cast<uint32_t>(height);
+
+    glfwSetWindowUserPointer(window.handle, &window);
+    glfwSetFramebufferSizeCallback(window.handle, framebuffer_resize_callback);
 }
 
-void App::framebuffer_resize_callback(GLFWwindow* window, int, int)
+void App::framebuffer_resize_callback(GLFWwindow* handle, int width, int height)
 {
-    auto app = reinterpret_cast<App*>(glfwGetWindowUserPointer(window));
-    app->m_framebuffer_resized = true;
+    auto window = reinterpret_cast<Window*>(glfwGetWindowUserPointer(handle));
+    window->width = static_cast<uint32_t>(width);
+    window->height = static_cast<uint32_t>(height);
+    window->resized = true;
 }
 
 void App::set_required_instance_extensions()
 {
+    if (m_app_info.headless) {
+        if (m_enable_validation_layers)
+            m_instance_extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
+        return;
+    }
+
     uint32_t glfw_extension_count = 0;
     char const** glfw_extensions;
     glfw_extensions = glfwGetRequiredInstanceExtensions(&glfw_extension_count);
@@ -163,12 +453,7 @@ bool App::check_instance_extension_support() const
     std::vector<VkExtensionProperties> available_extensions(extension_count);
     vkEnumerateInstanceExtensionProperties(nullptr, &extension_count, available_extensions.data());
 
-    std::set<std::string> required_extensions(m_instance_extensions.begin(), m_instance_extensions.end());
-
-    for (auto const& extension : available_extensions)
-        required_extensions.erase(extension.extensionName);
-
-    return required_extensions.empty();
+    return contains_extensions(available_extensions, m_instance_extensions);
 }
 
 void App::create_instance()
@@ -193,6 +478,14 @@ void App::create_instance()
     set_required_instance_extensions();
     if (!check_instance_extension_support())
         throw std::runtime_error("failed to get required instance extensions!");
+    // optional, VK_EXT_memory_budget is queried through it, the device has to have it too
+    uint32_t extension_count;
+    vkEnumerateInstanceExtensionProperties(nullptr, &extension_count, nullptr);
+    std::vector<VkExtensionProperties> available_extensions(extension_count);
+    vkEnumerateInstanceExtensionProperties(nullptr, &extension_count, available_extensions.data());
+    m_memory_budget = contains_extensions(available_extensions, { VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME });
+    if (m_memory_budget)
+        m_instance_extensions.push_back(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
     create_info.enabledExtensionCount = m_instance_extensions.size();
     create_info.ppEnabledExtensionNames = m_instance_extensions.data();
 
@@ -250,28 +543,89 @@ void App::setup_debug_messenger()
         throw std::runtime_error("failed to set up debug messenger!");
 }
 
-void App::create_surface()
+void App::create_surface(Window& window)
 {
-    if (glfwCreateWindowSurface(m_instance, m_window, nullptr, &m_surface) != VK_SUCCESS)
+    if (window.handle == nullptr)
+        return;
+
+    if (glfwCreateWindowSurface(m_instance, window.handle, nullptr, &window.surface) != VK_SUCCESS)
         throw std::runtime_error("failed to create window surface!");
 }
 
+// Every step starts as soon as what it needs is done, so the window is opened while the instance
+// is created, and the pipelines are compiled while the swap chain and other frame resources are.
+// The graphics queue and the command pool may only be used by one thread at a time, so the steps
+// uploading through them or allocating from them follow each other.
 void App::init_vulkan()
 {
-    create_instance();
-    setup_debug_messenger();
-    create_surface();
-    pick_physical_device();
-    create_logical_device();
-    create_swap_chain();
-    create_image_views();
-    create_render_pass();
-    create_graphics_pipeline();
-    create_framebuffers();
-    create_command_pool();
-    create_vertex_buffer();
-    create_command_buffers();
-    create_sync_objects();
+    using Step = StartupGraph::Step;
+    Window& window = *m_windows.front();
+    StartupGraph graph;
+
+    Step glfw_window = graph.add("window", {}, [this, &window] {
+        if (!m_app_info.headless)
+            create_glfw_window(window, std::string(m_app_info.name) + " @ " + std::string(m_app_info.version));
+    }, true);
+    Step instance = graph.add("instance", {}, [this] {
+        create_instance();
+        setup_debug_messenger();
+    });
+    Step surface = graph.add("surface", { instance, glfw_window }, [this, &window] { create_surface(window); });
+    Step device = graph.add("device", { surface }, [this] {
+        pick_physical_device();
+        create_logical_device();
+        create_command_pool();
+        // before anything allocates, and before the deletion queue takes its copy of m_gpu
+        PFN_vkGetPhysicalDeviceMemoryProperties2KHR get_memory_properties = nullptr;
+        if (m_memory_budget)
+            get_memory_properties = (PFN_vkGetPhysicalDeviceMemoryProperties2KHR)vkGetInstanceProcAddr(m_instance, "vkGetPhysicalDeviceMemoryProperties2KHR");
+        m_residency = std::make_unique<ResidencyManager>(m_gpu, get_memory_properties);
+        m_gpu.residency = m_residency.get();
+        m_deletion_queue = std::make_unique<DeletionQueue>(m_gpu);
+        m_gpu.deletion_queue = m_deletion_queue.get();
+    });
+
+    // the pipeline layout needs the texture descriptor set layout
+    Step textures = graph.add("textures", { device }, [this] { m_textures = std::make_unique<TextureManager>(m_gpu); });
+    Step meshes = graph.add("meshes", { textures }, [this] { m_meshes = std::make_unique<MeshManager>(m_gpu); });
+    // the scene pass always targets the same format, so it and its pipelines outlive swap chain
+    // recreation and are shared by all windows
+    Step render_pass = graph.add("render pass", { device }, [this] { create_render_pass(); });
+    Step pipelines = graph.add("scene pipeline", { textures, render_pass }, [this] { create_graphics_pipeline(); });
+    Step text = graph.add("text", { meshes, pipelines }, [this] { create_text_renderer(); });
+    graph.add("series", { render_pass }, [this] { m_series = std::make_unique<SeriesRenderer>(m_gpu, m_render_pass, MAX_FRAMES_IN_FLIGHT); });
+    Step post = graph.add("post", { device }, [this] { m_post = std::make_unique<PostProcessor>(m_gpu, MAX_FRAMES_IN_FLIGHT); });
+    graph.add("meshlet culler", { meshes }, [this] {
+        m_meshlet_culler = std::make_unique<MeshletCuller>(m_gpu, *m_meshes, m_draw_indirect_count, MAX_FRAMES_IN_FLIGHT);
+    });
+
+    // create_window_targets() in two, the swap chain doesn't need the render pass or post-processor
+    Step swap_chain = graph.add("swap chain", { device }, [this, &window] { create_swap_chain(window, VK_NULL_HANDLE); });
+    graph.add("window targets", { swap_chain, render_pass, post }, [this, &window] {
+        create_scene_targets(window);
+        create_framebuffers(window);
+        create_window_semaphores(window);
+    });
+    graph.add("instance buffers", { device }, [this] {
+        for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+            create_instance_buffer(i, INITIAL_INSTANCE_CAPACITY);
+    });
+    graph.add("command buffers", { text }, [this, &window] {
+        create_command_buffers();
+        create_window_command_buffers(window);
+    });
+    graph.add("queries and fences", { device }, [this] {
+        create_query_pools();
+        m_layer_caching_supported = m_statistics_query_pool == VK_NULL_HANDLE || m_gpu.enabled_features.inheritedQueries;
+        create_sync_objects();
+    });
+
+    // relative to the constructor instead of the graph
+    double offset = std::chrono::duration<double, std::milli>(Clock::now() - m_construction_start).count();
+    graph.run(m_app_info.serial_startup ? nullptr : &m_thread_pool);
+    m_startup_timings = graph.timings();
+    for (StartupTiming& timing : m_startup_timings)
+        timing.start_ms += offset;
 }
 
 void App::pick_physical_device()
@@ -294,17 +648,20 @@ void App::pick_physical_device()
 
     if (m_physical_device == VK_NULL_HANDLE)
         throw std::runtime_error("failed to find a suitable GPU!");
-}
 
-struct App::QueueFamilyIndices {
-    std::optional<uint32_t> graphics_family;
-    std::optional<uint32_t> present_family;
-
-    bool complete()
-    {
-        return graphics_family.has_value() && present_family.has_value();
+    // none of this changes for the lifetime of the device and surface, only the surface
+    // capabilities do (the current extent), so those get queried on every swap chain creation
+    QueueFamilyIndices indices = find_queue_families(m_physical_device);
+    m_graphics_family = indices.graphics_family.value();
+    m_present_family = indices.present_family.value();
+
+    Window& window = *m_windows.front();
+    if (!m_app_info.headless) {
+        SwapChainSupportDetails swap_chain_support = query_swap_chain_support(m_physical_device, window.surface);
+        window.surface_format = choose_swap_surface_format(swap_chain_support.formats);
+        window.present_mode = choose_swap_present_mode(swap_chain_support.present_modes);
     }
-};
+}
 
 App::QueueFamilyIndices App::find_queue_families(VkPhysicalDevice const& device) const
 {
@@ -321,8 +678,12 @@ App::QueueFamilyIndices App::find_queue_families(VkPhysicalDevice const& device)
         if (queue_family.queueFlags & VK_QUEUE_GRAPHICS_BIT)
             indices.graphics_family = i;
 
+        // nothing gets presented without a surface, the graphics queue stands in
         VkBool32 present_support = false;
-        vkGetPhysicalDeviceSurfaceSupportKHR(device, i, m_surface, &present_support);
+        if (m_app_info.headless)
+            present_support = indices.graphics_family == i;
+        else
+            vkGetPhysicalDeviceSurfaceSupportKHR(device, i, m_windows.front()->surface, &present_support);
         if (present_support)
             indices.present_family = i;
 
@@ -343,40 +704,29 @@ bool App::check_device_extension_support(VkPhysicalDevice const& device) const
     std::vector<VkExtensionProperties> available_extensions(extension_count);
     vkEnumerateDeviceExtensionProperties(device, nullptr, &extension_count, available_extensions.data());
 
-    std::set<std::string> required_extensions(m_device_extensions.begin(), m_device_extensions.end());
-
-    for (auto const& extension : available_extensions)
-        required_extensions.erase(extension.extensionName);
-
-    return required_extensions.empty();
+    return contains_extensions(available_extensions, m_device_extensions);
 }
 
-struct App::SwapChainSupportDetails {
-    VkSurfaceCapabilitiesKHR capabilities;
-    std::vector<VkSurfaceFormatKHR> formats;
-    std::vector<VkPresentModeKHR> present_modes;
-};
-
-App::SwapChainSupportDetails App::query_swap_chain_support(VkPhysicalDevice const& device) const
+App::SwapChainSupportDetails App::query_swap_chain_support(VkPhysicalDevice const& device, VkSurfaceKHR surface) const
 {
     SwapChainSupportDetails details;
 
-    vkGetPhysicalDeviceSurfaceCapabilitiesKHR(device, m_surface, &details.capabilities);
+    vkGetPhysicalDeviceSurfaceCapabilitiesKHR(device, surface, &details.capabilities);
 
     uint32_t format_count;
-    vkGetPhysicalDeviceSurfaceFormatsKHR(device, m_surface, &format_count, nullptr);
+    vkGetPhysicalDeviceSurfaceFormatsKHR(device, surface, &format_count, nullptr);
 
     if (format_count != 0) {
         details.formats.resize(format_count);
-        vkGetPhysicalDeviceSurfaceFormatsKHR(device, m_surface, &format_count, details.formats.data());
+        vkGetPhysicalDeviceSurfaceFormatsKHR(device, surface, &format_count, details.formats.data());
     }
 
     uint32_t present_mode_count;
-    vkGetPhysicalDeviceSurfacePresentModesKHR(device, m_surface, &present_mode_count, nullptr);
+    vkGetPhysicalDeviceSurfacePresentModesKHR(device, surface, &present_mode_count, nullptr);
 
     if (present_mode_count != 0) {
         details.present_modes.resize(present_mode_count);
-        vkGetPhysicalDeviceSurfacePresentModesKHR(device, m_surface, &present_mode_count, details.present_modes.data());
+        vkGetPhysicalDeviceSurfacePresentModesKHR(device, surface, &present_mode_count, details.present_modes.data());
     }
 
     return details;
@@ -404,18 +754,12 @@ VkPresentModeKHR App::choose_swap_present_mode(std::vector<VkPresentModeKHR> con
     return VK_PRESENT_MODE_FIFO_KHR;
 }
 
-VkExtent2D App::choose_swap_extent(VkSurfaceCapabilitiesKHR const& capabilities) const
+VkExtent2D App::choose_swap_extent(VkSurfaceCapabilitiesKHR const& capabilities, Window const& window) const
 {
     if (capabilities.currentExtent.width != UINT32_MAX) {
         return capabilities.currentExtent;
     } else {
-        int width, height;
-        glfwGetFramebufferSize(m_window, &width, &height);
-
-        VkExtent2D actual_extent = {
-            static_cast<uint32_t>(width),
-            static_cast<uint32_t>(height)
-        };
+        VkExtent2D actual_extent = { window.width, window.height };
 
         actual_extent.width = std::clamp(actual_extent.width, capabilities.minImageExtent.width, capabilities.maxImageExtent.width);
         actual_extent.height = std::clamp(actual_extent.height, capabilities.minImageExtent.height, capabilities.maxImageExtent.height);
@@ -437,10 +781,15 @@ bool App::is_device_suitable(VkPhysicalDevice const& device) const
 
     bool extensions_supported = check_device_extension_support(device);
 
-    bool swap_chain_adequate = false;
-    if (extensions_supported) {
-        SwapChainSupportDetails swap_chain_support = query_swap_chain_support(device);
-        swap_chain_adequate = !swap_chain_support.formats.empty() && !swap_chain_support.present_modes.empty();
+    // the scene gets blitted into swap chain images, so they have to be transfer destinations
+    bool swap_chain_adequate = m_app_info.headless;
+    if (extensions_supported && !m_app_info.headless) {
+        SwapChainSupportDetails swap_chain_support = query_swap_chain_support(device, m_windows.front()->surface);
+        // clang-format off
+        swap_chain_adequate = !swap_chain_support.formats.empty()
+            && !swap_chain_support.present_modes.empty()
+            && (swap_chain_support.capabilities.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_DST_BIT);
+        // clang-format on
     }
 
     return indices.complete() && extensions_supported && swap_chain_adequate;
@@ -448,10 +797,8 @@ bool App::is_device_suitable(VkPhysicalDevice const& device) const
 
 void App::create_logical_device()
 {
-    QueueFamilyIndices indices = find_queue_families(m_physical_device);
-
     std::vector<VkDeviceQueueCreateInfo> queue_create_infos;
-    std::set<uint32_t> unique_queue_families = { indices.graphics_family.value(), indices.present_family.value() };
+    std::set<uint32_t> unique_queue_families = { m_graphics_family, m_present_family };
 
     float queue_priority = 1.0f;
     for (uint32_t queue_family : unique_queue_families) {
@@ -463,7 +810,29 @@ void App::create_logical_device()
         queue_create_infos.push_back(queue_create_info);
     }
 
+    // Optional. Without them stats go without pipeline statistics, BC compressed textures are
+    // rejected (TextureManager::supports() says which load), sampling is plain trilinear,
+    // meshlets aren't culled and scene draws aren't cached while pipeline statistics are queried.
+    VkPhysicalDeviceFeatures supported_features;
+    vkGetPhysicalDeviceFeatures(m_physical_device, &supported_features);
     VkPhysicalDeviceFeatures device_features {};
+    device_features.textureCompressionBC = supported_features.textureCompressionBC;
+    device_features.samplerAnisotropy = supported_features.samplerAnisotropy;
+    device_features.pipelineStatisticsQuery = supported_features.pipelineStatisticsQuery;
+    device_features.multiDrawIndirect = supported_features.multiDrawIndirect;
+    device_features.drawIndirectFirstInstance = supported_features.drawIndirectFirstInstance;
+    device_features.inheritedQueries = supported_features.inheritedQueries;
+
+    uint32_t extension_count;
+    vkEnumerateDeviceExtensionProperties(m_physical_device, nullptr, &extension_count, nullptr);
+    std::vector<VkExtensionProperties> available_extensions(extension_count);
+    vkEnumerateDeviceExtensionProperties(m_physical_device, nullptr, &extension_count, available_extensions.data());
+    m_memory_budget = m_memory_budget && contains_extensions(available_extensions, { VK_EXT_MEMORY_BUDGET_EXTENSION_NAME });
+    if (m_memory_budget)
+        m_device_extensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+    m_draw_indirect_count = contains_extensions(available_extensions, { VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME });
+    if (m_draw_indirect_count)
+        m_device_extensions.push_back(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
 
     VkDeviceCreateInfo create_info {};
     create_info.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
@@ -486,37 +855,46 @@ void App::create_logical_device()
     if (vkCreateDevice(m_physical_device, &create_info, nullptr, &m_device) != VK_SUCCESS)
         throw std::runtime_error("failed to create logical device!");
 
-    vkGetDeviceQueue(m_device, indices.graphics_family.value(), 0, &m_graphics_queue);
-    vkGetDeviceQueue(m_device, indices.present_family.value(), 0, &m_present_queue);
+    vkGetDeviceQueue(m_device, m_graphics_family, 0, &m_graphics_queue);
+    vkGetDeviceQueue(m_device, m_present_family, 0, &m_present_queue);
+
+    m_gpu.physical_device = m_physical_device;
+    m_gpu.device = m_device;
+    m_gpu.graphics_queue = m_graphics_queue;
+    m_gpu.graphics_family = m_graphics_family;
+    m_gpu.enabled_features = device_features;
 }
 
-void App::create_swap_chain()
+void App::create_swap_chain(Window& window, VkSwapchainKHR old_swap_chain)
 {
-    SwapChainSupportDetails swap_chain_support = query_swap_chain_support(m_physical_device);
+    WindowTargets& targets = window.targets;
+    if (window.handle == nullptr) {
+        targets.extent = { window.width, window.height };
+        return;
+    }
+
+    VkSurfaceCapabilitiesKHR capabilities;
+    vkGetPhysicalDeviceSurfaceCapabilitiesKHR(m_physical_device, window.surface, &capabilities);
 
-    VkSurfaceFormatKHR surface_format = choose_swap_surface_format(swap_chain_support.formats);
-    m_swap_chain_image_format = surface_format.format;
-    VkPresentModeKHR present_mode = choose_swap_present_mode(swap_chain_support.present_modes);
-    m_swap_chain_extent = choose_swap_extent(swap_chain_support.capabilities);
+    targets.extent = choose_swap_extent(capabilities, window);
 
-    uint32_t image_count = swap_chain_support.capabilities.minImageCount + 1;
-    if (swap_chain_support.capabilities.maxImageCount > 0 && image_count > swap_chain_support.capabilities.maxImageCount)
-        image_count = swap_chain_support.capabilities.maxImageCount;
+    uint32_t image_count = capabilities.minImageCount + 1;
+    if (capabilities.maxImageCount > 0 && image_count > capabilities.maxImageCount)
+        image_count = capabilities.maxImageCount;
 
     VkSwapchainCreateInfoKHR create_info {};
     create_info.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
-    create_info.surface = m_surface;
+    create_info.surface = window.surface;
     create_info.minImageCount = image_count;
-    create_info.imageFormat = surface_format.format;
-    create_info.imageColorSpace = surface_format.colorSpace;
-    create_info.imageExtent = m_swap_chain_extent;
+    create_info.imageFormat = window.surface_format.format;
+    create_info.imageColorSpace = window.surface_format.colorSpace;
+    create_info.imageExtent = targets.extent;
     create_info.imageArrayLayers = 1;
-    create_info.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+    create_info.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
 
-    QueueFamilyIndices indices = find_queue_families(m_physical_device);
-    uint32_t queue_family_indices[] = { indices.graphics_family.value(), indices.present_family.value() };
+    uint32_t queue_family_indices[] = { m_graphics_family, m_present_family };
 
-    if (indices.graphics_family != indices.present_family) {
+    if (m_graphics_family != m_present_family) {
         create_info.imageSharingMode = VK_SHARING_MODE_CONCURRENT;
         create_info.queueFamilyIndexCount = 2;
         create_info.pQueueFamilyIndices = queue_family_indices;
@@ -524,70 +902,63 @@ void App::create_swap_chain()
         create_info.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
     }
 
-    create_info.preTransform = swap_chain_support.capabilities.currentTransform;
+    create_info.preTransform = capabilities.currentTransform;
     create_info.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
-    create_info.presentMode = present_mode;
+    create_info.presentMode = window.present_mode;
     create_info.clipped = VK_TRUE;
-    create_info.oldSwapchain = VK_NULL_HANDLE;
+    create_info.oldSwapchain = old_swap_chain;
 
-    if (vkCreateSwapchainKHR(m_device, &create_info, nullptr, &m_swap_chain) != VK_SUCCESS)
+    if (vkCreateSwapchainKHR(m_device, &create_info, nullptr, &targets.swap_chain) != VK_SUCCESS)
         throw std::runtime_error("failed to create swap chain!");
 
-    vkGetSwapchainImagesKHR(m_device, m_swap_chain, &image_count, nullptr);
-    m_swap_chain_images.resize(image_count);
-    vkGetSwapchainImagesKHR(m_device, m_swap_chain, &image_count, m_swap_chain_images.data());
+    vkGetSwapchainImagesKHR(m_device, targets.swap_chain, &image_count, nullptr);
+    targets.swap_chain_images.resize(image_count);
+    vkGetSwapchainImagesKHR(m_device, targets.swap_chain, &image_count, targets.swap_chain_images.data());
 }
 
-void App::create_image_views()
+void App::create_scene_targets(Window& window)
 {
-    m_swap_chain_image_views.resize(m_swap_chain_images.size());
-
-    for (size_t i = 0; i < m_swap_chain_images.size(); i++) {
-        VkImageViewCreateInfo create_info {};
-        create_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
-        create_info.image = m_swap_chain_images[i];
-        create_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
-        create_info.format = m_swap_chain_image_format;
-        create_info.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
-        create_info.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
-        create_info.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
-        create_info.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
-        create_info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-        create_info.subresourceRange.baseMipLevel = 0;
-        create_info.subresourceRange.levelCount = 1;
-        create_info.subresourceRange.baseArrayLayer = 0;
-        create_info.subresourceRange.layerCount = 1;
-
-        if (vkCreateImageView(m_device, &create_info, nullptr, &m_swap_chain_image_views[i]) != VK_SUCCESS)
-            throw std::runtime_error("failed to create image views!");
+    VkFormatProperties format_properties;
+    vkGetPhysicalDeviceFormatProperties(m_physical_device, m_scene_format, &format_properties);
+    VkFormatFeatureFlags required = VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BIT | VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT | VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT;
+    if ((format_properties.optimalTilingFeatures & required) != required)
+        throw std::runtime_error("scene format can't be used for a scaled and post-processed scene target!");
+
+    WindowTargets& targets = window.targets;
+    for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+        VkImageCreateInfo image_info {};
+        image_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        image_info.imageType = VK_IMAGE_TYPE_2D;
+        image_info.format = m_scene_format;
+        image_info.extent = { targets.extent.width, targets.extent.height, 1 };
+        image_info.mipLevels = 1;
+        image_info.arrayLayers = 1;
+        image_info.samples = VK_SAMPLE_COUNT_1_BIT;
+        image_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+        image_info.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_STORAGE_BIT;
+        image_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        image_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+        Gpu::create_image(m_gpu, image_info, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, targets.scene_images[i], targets.scene_images_memory[i], MemoryClass::RENDER_TARGET);
+        targets.scene_image_views[i] = Gpu::create_image_view(m_gpu, targets.scene_images[i], m_scene_format, VK_IMAGE_ASPECT_COLOR_BIT, 1);
     }
-}
-
-VkShaderModule App::create_shader_module(std::vector<char> const& source) const
-{
-    VkShaderModuleCreateInfo create_info {};
-    create_info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-    create_info.codeSize = source.size();
-    create_info.pCode = reinterpret_cast<uint32_t const*>(source.data());
-
-    VkShaderModule shader_module;
-    if (vkCreateShaderModule(m_device, &create_info, nullptr, &shader_module) != VK_SUCCESS)
-        throw std::runtime_error("failed to create shader module!");
+    if (!m_post->empty())
+        targets.post = m_post->create_targets(targets.extent, targets.scene_image_views.data());
 
-    return shader_module;
+    update_render_extent(window);
 }
 
 void App::create_render_pass()
 {
     VkAttachmentDescription color_attachment {};
-    color_attachment.format = m_swap_chain_image_format;
+    color_attachment.format = m_scene_format;
     color_attachment.samples = VK_SAMPLE_COUNT_1_BIT;
     color_attachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
     color_attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
     color_attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
     color_attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
     color_attachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    color_attachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    color_attachment.finalLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
 
     VkAttachmentReference color_attachment_ref {};
     color_attachment_ref.attachment = 0;
@@ -606,14 +977,25 @@ void App::create_render_pass()
     dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
     dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
 
+    // the blit that reads the scene target has to wait for the pass to finish writing it
+    VkSubpassDependency blit_dependency {};
+    blit_dependency.srcSubpass = 0;
+    blit_dependency.dstSubpass = VK_SUBPASS_EXTERNAL;
+    blit_dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    blit_dependency.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    blit_dependency.dstStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
+    blit_dependency.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+    std::array<VkSubpassDependency, 2> dependencies = { dependency, blit_dependency };
+
     VkRenderPassCreateInfo render_pass_info {};
     render_pass_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
     render_pass_info.attachmentCount = 1;
     render_pass_info.pAttachments = &color_attachment;
     render_pass_info.subpassCount = 1;
     render_pass_info.pSubpasses = &subpass;
-    render_pass_info.dependencyCount = 1;
-    render_pass_info.pDependencies = &dependency;
+    render_pass_info.dependencyCount = static_cast<uint32_t>(dependencies.size());
+    render_pass_info.pDependencies = dependencies.data();
 
     if (vkCreateRenderPass(m_device, &render_pass_info, nullptr, &m_render_pass) != VK_SUCCESS)
         throw std::runtime_error("failed to create render pass!");
@@ -621,140 +1003,52 @@ void App::create_render_pass()
 
 void App::create_graphics_pipeline()
 {
-    auto vertex_shader_source = Util::read_file("shaders/vert.spv");
-    VkShaderModule vertex_shader_module = create_shader_module(vertex_shader_source);
-    VkPipelineShaderStageCreateInfo vertex_shader_stage_info {};
-    vertex_shader_stage_info.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-    vertex_shader_stage_info.stage = VK_SHADER_STAGE_VERTEX_BIT;
-    vertex_shader_stage_info.module = vertex_shader_module;
-    vertex_shader_stage_info.pName = "main";
-
-    auto fragment_shader_source = Util::read_file("shaders/frag.spv");
-    VkShaderModule fragment_shader_module = create_shader_module(fragment_shader_source);
-    VkPipelineShaderStageCreateInfo fragment_shader_stage_info {};
-    fragment_shader_stage_info.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-    fragment_shader_stage_info.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
-    fragment_shader_stage_info.module = fragment_shader_module;
-    fragment_shader_stage_info.pName = "main";
-
-    VkPipelineShaderStageCreateInfo shader_stages[] = { vertex_shader_stage_info, fragment_shader_stage_info };
-
-    VkPipelineVertexInputStateCreateInfo vertex_input_info {};
-    vertex_input_info.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-    auto binding_description = Vertex::get_binding_description();
-    vertex_input_info.vertexBindingDescriptionCount = 1;
-    vertex_input_info.pVertexBindingDescriptions = &binding_description;
-    auto attribute_descriptions = Vertex::get_attribute_descriptions();
-    vertex_input_info.vertexAttributeDescriptionCount = static_cast<uint32_t>(attribute_descriptions.size());
-    vertex_input_info.pVertexAttributeDescriptions = attribute_descriptions.data();
-
-    VkPipelineInputAssemblyStateCreateInfo input_assembly {};
-    input_assembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
-    input_assembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
-    input_assembly.primitiveRestartEnable = VK_FALSE;
-
-    VkViewport viewport {};
-    viewport.x = 0.0f;
-    viewport.y = 0.0f;
-    viewport.width = (float)m_swap_chain_extent.width;
-    viewport.height = (float)m_swap_chain_extent.height;
-    viewport.minDepth = 0.0f;
-    viewport.maxDepth = 1.0f;
+    VkPushConstantRange push_constant_range {};
+    push_constant_range.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+    push_constant_range.offset = 0;
+    push_constant_range.size = sizeof(glm::mat4);
 
-    VkRect2D scissor {};
-    scissor.offset = { 0, 0 };
-    scissor.extent = m_swap_chain_extent;
-
-    VkPipelineViewportStateCreateInfo viewport_state {};
-    viewport_state.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
-    viewport_state.viewportCount = 1;
-    viewport_state.pViewports = &viewport;
-    viewport_state.scissorCount = 1;
-    viewport_state.pScissors = &scissor;
-
-    VkPipelineRasterizationStateCreateInfo rasterizer {};
-    rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
-    rasterizer.depthClampEnable = VK_FALSE;
-    rasterizer.rasterizerDiscardEnable = VK_FALSE;
-    rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
-    rasterizer.lineWidth = 1.0f;
-    rasterizer.cullMode = VK_CULL_MODE_BACK_BIT;
-    rasterizer.frontFace = VK_FRONT_FACE_CLOCKWISE;
-    rasterizer.depthBiasEnable = VK_FALSE;
-
-    VkPipelineMultisampleStateCreateInfo multisampling {};
-    multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
-    multisampling.sampleShadingEnable = VK_FALSE;
-    multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
-
-    VkPipelineColorBlendAttachmentState color_blend_attachment {};
-    color_blend_attachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
-    color_blend_attachment.blendEnable = VK_FALSE;
-    // Alpha blending
-    // color_blend_attachment.blendEnable = VK_TRUE;
-    // color_blend_attachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
-    // color_blend_attachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
-    // color_blend_attachment.colorBlendOp = VK_BLEND_OP_ADD;
-    // color_blend_attachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
-    // color_blend_attachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
-    // color_blend_attachment.alphaBlendOp = VK_BLEND_OP_ADD;
-
-    VkPipelineColorBlendStateCreateInfo color_blending {};
-    color_blending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
-    color_blending.logicOpEnable = VK_FALSE;
-    color_blending.attachmentCount = 1;
-    color_blending.pAttachments = &color_blend_attachment;
-
-    // Dynamically change viewport size
-    // std::vector<VkDynamicState> dynamic_states = {
-    //     VK_DYNAMIC_STATE_VIEWPORT,
-    // };
-    // VkPipelineDynamicStateCreateInfo dynamic_state {};
-    // dynamic_state.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
-    // dynamic_state.dynamicStateCount = static_cast<uint32_t>(dynamic_states.size());
-    // dynamic_state.pDynamicStates = dynamic_states.data();
+    VkDescriptorSetLayout set_layout = m_textures->descriptor_set_layout();
 
     VkPipelineLayoutCreateInfo pipeline_layout_info {};
     pipeline_layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-    // pipeline_layout_info.setLayoutCount = 0;
-    // pipeline_layout_info.pSetLayouts = nullptr;
-    // pipeline_layout_info.pushConstantRangeCount = 0;
-    // pipeline_layout_info.pPushConstantRanges = nullptr;
+    pipeline_layout_info.setLayoutCount = 1;
+    pipeline_layout_info.pSetLayouts = &set_layout;
+    pipeline_layout_info.pushConstantRangeCount = 1;
+    pipeline_layout_info.pPushConstantRanges = &push_constant_range;
 
     if (vkCreatePipelineLayout(m_device, &pipeline_layout_info, nullptr, &m_pipeline_layout) != VK_SUCCESS)
         throw std::runtime_error("failed to create pipeline layout!");
 
-    VkGraphicsPipelineCreateInfo pipeline_info {};
-    pipeline_info.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-    pipeline_info.stageCount = 2;
-    pipeline_info.pStages = shader_stages;
-    pipeline_info.pVertexInputState = &vertex_input_info;
-    pipeline_info.pInputAssemblyState = &input_assembly;
-    pipeline_info.pViewportState = &viewport_state;
-    pipeline_info.pRasterizationState = &rasterizer;
-    pipeline_info.pMultisampleState = &multisampling;
-    pipeline_info.pColorBlendState = &color_blending;
-    // pipeline_info.pDynamicState = nullptr;
-    pipeline_info.layout = m_pipeline_layout;
-    pipeline_info.renderPass = m_render_pass;
-    pipeline_info.subpass = 0;
-    // pipeline_info.basePipelineHandle = VK_NULL_HANDLE;
-    // pipeline_info.basePipelineIndex = -1;
-
-    if (vkCreateGraphicsPipelines(m_device, VK_NULL_HANDLE, 1, &pipeline_info, nullptr, &m_graphics_pipeline) != VK_SUCCESS)
-        throw std::runtime_error("failed to create graphics pipeline!");
-
-    vkDestroyShaderModule(m_device, vertex_shader_module, nullptr);
-    vkDestroyShaderModule(m_device, fragment_shader_module, nullptr);
+    std::vector<VkVertexInputBindingDescription> binding_descriptions = {
+        VertexLayout::get_binding_description(),
+        Instance::get_binding_description()
+    };
+    auto vertex_attribute_descriptions = VertexLayout::get_attribute_descriptions();
+    auto instance_attribute_descriptions = Instance::get_attribute_descriptions();
+    std::vector<VkVertexInputAttributeDescription> attribute_descriptions(vertex_attribute_descriptions.begin(), vertex_attribute_descriptions.end());
+    attribute_descriptions.insert(attribute_descriptions.end(), instance_attribute_descriptions.begin(), instance_attribute_descriptions.end());
+
+    m_pipelines = std::make_unique<PipelineCache>(m_gpu, m_pipeline_layout, m_render_pass, std::move(binding_descriptions), std::move(attribute_descriptions));
+    m_scene_pipelines = { m_pipelines->get(PipelineDesc {}) };
+    m_scene_pipeline_descs = { PipelineDesc {} };
+    m_materials = { Material { 0, 0, TextureManager::WHITE } };
 }
 
-void App::create_framebuffers()
+void App::create_text_renderer()
 {
-    m_swap_chain_framebuffers.resize(m_swap_chain_image_views.size());
+    std::filesystem::path directory = m_app_info.cache_directory
+        ? std::filesystem::path(m_app_info.cache_directory)
+        : std::filesystem::temp_directory_path() / "hummingbird";
+    m_text = std::make_unique<TextRenderer>(m_gpu, *m_textures, m_thread_pool, m_pipeline_layout, m_render_pass, MAX_FRAMES_IN_FLIGHT, (directory / "glyph_atlas.bin").string());
+}
 
-    for (size_t i = 0; i < m_swap_chain_image_views.size(); i++) {
+void App::create_framebuffers(Window& window)
+{
+    WindowTargets& targets = window.targets;
+    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
         VkImageView attachments[] = {
-            m_swap_chain_image_views[i]
+            targets.scene_image_views[i]
         };
 
         VkFramebufferCreateInfo framebuffer_info {};
@@ -762,98 +1056,353 @@ void App::create_framebuffers()
         framebuffer_info.renderPass = m_render_pass;
         framebuffer_info.attachmentCount = 1;
         framebuffer_info.pAttachments = attachments;
-        framebuffer_info.width = m_swap_chain_extent.width;
-        framebuffer_info.height = m_swap_chain_extent.height;
+        framebuffer_info.width = targets.extent.width;
+        framebuffer_info.height = targets.extent.height;
         framebuffer_info.layers = 1;
 
-        if (vkCreateFramebuffer(m_device, &framebuffer_info, nullptr, &m_swap_chain_framebuffers[i]) != VK_SUCCESS)
+        if (vkCreateFramebuffer(m_device, &framebuffer_info, nullptr, &targets.scene_framebuffers[i]) != VK_SUCCESS)
             throw std::runtime_error("failed to create framebuffer!");
     }
 }
 
-void App::recreate_swap_chain()
+void App::create_window_semaphores(Window& window)
 {
-    // TODO: Refactor swap chain and direct dependants into its own class, this enables a way
-    //       cleaner API here, just swap_chain.recreate(), ~swap_chain() etc.
+    VkSemaphoreCreateInfo semaphore_info {};
+    semaphore_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
 
-    int width = 0, height = 0;
-    glfwGetFramebufferSize(m_window, &width, &height);
-    while (width == 0 || height == 0) {
-        glfwGetFramebufferSize(m_window, &width, &height);
-        glfwWaitEvents();
+    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i += 1) {
+        // clang-format off
+        if (
+            vkCreateSemaphore(m_device, &semaphore_info, nullptr, &window.image_available_semaphores[i]) != VK_SUCCESS
+            || vkCreateSemaphore(m_device, &semaphore_info, nullptr, &window.render_finished_semaphores[i]) != VK_SUCCESS
+        ) {
+            // clang-format on
+            throw std::runtime_error("failed to create sync objects for a window!");
+        }
     }
+}
 
-    vkDeviceWaitIdle(m_device);
+void App::create_window_command_buffers(Window& window)
+{
+    VkCommandBufferAllocateInfo alloc_info {};
+    alloc_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    alloc_info.commandPool = m_command_pool;
+    alloc_info.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+    alloc_info.commandBufferCount = MAX_FRAMES_IN_FLIGHT;
+
+    std::array<VkCommandBuffer, MAX_FRAMES_IN_FLIGHT> scene_commands;
+    // clang-format off
+    if (
+        vkAllocateCommandBuffers(m_device, &alloc_info, scene_commands.data()) != VK_SUCCESS
+        || vkAllocateCommandBuffers(m_device, &alloc_info, window.overlay_commands.data()) != VK_SUCCESS
+    ) {
+        // clang-format on
+        throw std::runtime_error("failed to allocate command buffers for a window!");
+    }
+    for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i += 1)
+        window.scene_layers[i].commands = scene_commands[i];
+}
 
-    destruct_swap_chain();
+void App::create_window_targets(Window& window, VkSwapchainKHR old_swap_chain)
+{
+    create_swap_chain(window, old_swap_chain);
+    create_scene_targets(window);
+    create_framebuffers(window);
+    m_layer_version += 1;
+}
+
+void App::recreate_swap_chain(Window& window)
+{
+    // a minimized window has nothing to present to, it stays resized and sits frames out until
+    // it comes back
+    window.resized = false;
+    if (window.handle != nullptr && (window.width == 0 || window.height == 0)) {
+        window.resized = true;
+        return;
+    }
 
-    create_swap_chain();
-    create_image_views();
-    create_render_pass();
-    create_graphics_pipeline();
-    create_framebuffers();
+    // the frames in flight may still use the old targets, they get destroyed once those are done
+    // instead of waiting for the device, so the other windows keep going
+    WindowTargets old_targets = std::move(window.targets);
+    window.targets = {};
+    create_window_targets(window, old_targets.swap_chain);
+    retire_window_targets(old_targets);
 }
 
 void App::create_command_pool()
 {
-    QueueFamilyIndices queue_family_indices = find_queue_families(m_physical_device);
-
     VkCommandPoolCreateInfo pool_info {};
     pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
     pool_info.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
-    pool_info.queueFamilyIndex = queue_family_indices.graphics_family.value();
+    pool_info.queueFamilyIndex = m_graphics_family;
 
     if (vkCreateCommandPool(m_device, &pool_info, nullptr, &m_command_pool) != VK_SUCCESS)
         throw std::runtime_error("failed to create command pool!");
+
+    m_gpu.command_pool = m_command_pool;
 }
 
-uint32_t App::find_memory_type(uint32_t const type_filter, VkMemoryPropertyFlags const& properties) const
+void App::create_instance_buffer(uint32_t const frame, size_t const capacity)
 {
-    VkPhysicalDeviceMemoryProperties mem_properties;
-    vkGetPhysicalDeviceMemoryProperties(m_physical_device, &mem_properties);
+    VkDeviceSize buffer_size = sizeof(Instance) * capacity;
+    // meshlet culling reads them too
+    Gpu::create_buffer(m_gpu, buffer_size, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, m_instance_buffers[frame], m_instance_buffers_memory[frame], MemoryClass::FRAME);
+    vkMapMemory(m_device, m_instance_buffers_memory[frame], 0, buffer_size, 0, &m_instance_buffers_mapped[frame]);
+    m_instance_capacities[frame] = capacity;
+    m_layer_version += 1;
+}
 
-    for (uint32_t i = 0; i < mem_properties.memoryTypeCount; i += 1) {
-        // clang-format off
-        if (
-            type_filter & (1 << i)
-            && (mem_properties.memoryTypes[i].propertyFlags & properties) == properties
-        ) {
-            // clang-format on
-            return i;
+void App::destroy_instance_buffer(uint32_t const frame)
+{
+    vkUnmapMemory(m_device, m_instance_buffers_memory[frame]);
+    Gpu::destroy_buffer(m_gpu, m_instance_buffers[frame], m_instance_buffers_memory[frame]);
+}
+
+void App::simulate(float dt)
+{
+    if (m_update)
+        m_update(m_scene, dt);
+
+    gather_snapshot(m_snapshots.write_buffer());
+    m_snapshots.publish();
+}
+
+void App::gather_snapshot(FrameSnapshot& snapshot)
+{
+    m_snapshot_sequence += 1;
+    snapshot.sequence = m_snapshot_sequence;
+    snapshot.produced = Clock::now();
+    snapshot.view_projections = m_view_projections;
+    snapshot.text = m_text_batch;
+    m_text_batch.clear();
+
+    // the buffer coming back may hold an older scene, it only has to be copied again if so
+    bool structure_changed = snapshot.structure_version != m_scene.structure_version();
+    if (!structure_changed && snapshot.transform_version == m_transform_version)
+        return;
+
+    size_t count = m_scene.count<Transform, Bounds, Renderable>();
+    snapshot.entities.resize(count);
+    snapshot.bounds.resize(count);
+    snapshot.instances.resize(count);
+    snapshot.meshes.resize(count);
+    snapshot.materials.resize(count);
+    m_scene.parallel_each_chunk<Entity, Transform, Bounds, Renderable>(m_thread_pool, [&snapshot](size_t base, size_t count, Entity const* entities, Transform* transforms, Bounds* bounds, Renderable* renderables) {
+        for (size_t i = 0; i < count; i += 1) {
+            snapshot.entities[base + i] = entities[i];
+            snapshot.bounds[base + i] = bounds[i];
+            snapshot.instances[base + i] = { transforms[i].position, transforms[i].scale, renderables[i].color };
+            snapshot.meshes[base + i] = renderables[i].mesh;
+            snapshot.materials[base + i] = renderables[i].material;
+        }
+    });
+
+    snapshot.structure_version = m_scene.structure_version();
+    snapshot.transform_version = m_transform_version;
+}
+
+void App::capture_frame(FrameSnapshot const& snapshot)
+{
+    bool structure_changed = snapshot.structure_version != m_captured_structure_version;
+    if (structure_changed || snapshot.transform_version != m_captured_transform_version) {
+        m_captured_entities.resize(snapshot.instances.size());
+        for (size_t i = 0; i < snapshot.instances.size(); i += 1) {
+            Instance const& instance = snapshot.instances[i];
+            m_captured_entities[i] = { { instance.position, instance.scale }, snapshot.bounds[i], { snapshot.meshes[i], instance.color, snapshot.materials[i] } };
         }
+        m_capture->scene(structure_changed, m_captured_entities);
+        m_captured_structure_version = snapshot.structure_version;
+        m_captured_transform_version = snapshot.transform_version;
+    }
+
+    CapturedFrame& frame = m_captured_frame;
+    frame.seconds = std::chrono::duration<double>(Clock::now() - m_capture_start).count();
+    frame.sort_draws = m_sort_draws;
+    frame.meshlet_culling = m_meshlet_culling;
+    frame.cache_command_buffers = m_cache_layers;
+    frame.max_instances_per_draw = m_max_instances_per_draw;
+    frame.lod_threshold = m_meshes->lod_threshold();
+    frame.views.clear();
+    for (auto const& window : m_windows) {
+        if (window)
+            frame.views.push_back({ window->targets.extent.width, window->targets.extent.height, window->view_projection });
+        else
+            frame.views.push_back({ 0, 0, glm::mat4(1.0f) });
+    }
+    frame.text = snapshot.text;
+    m_capture->frame(frame);
+}
+
+void App::update_culling(FrameSnapshot const& snapshot)
+{
+    // snapshots may have been skipped, but every one holds the whole scene, so comparing versions
+    // catches everything that happened in between
+    bool structure_changed = snapshot.structure_version != m_culled_structure_version;
+    if (!structure_changed && snapshot.transform_version == m_culled_transform_version)
+        return;
+
+    // static scenes build once, moving objects only refit until the tree gets too loose
+    size_t count = snapshot.bounds.size();
+    if (structure_changed || m_bvh.needs_rebuild()) {
+        m_bvh.build(snapshot.bounds, &m_thread_pool);
+        if (structure_changed)
+            m_cull_entities = snapshot.entities;
+    } else {
+        for (uint32_t object = 0; object < count; object += 1)
+            m_bvh.update(object, snapshot.bounds[object]);
+        m_bvh.refit();
     }
 
-    throw std::runtime_error("failed to find suitable memory type!");
+    auto const& slots = m_bvh.slots();
+    m_slot_instances.resize(count);
+    m_slot_meshes.resize(count);
+    m_slot_materials.resize(count);
+    uint32_t mesh_count = static_cast<uint32_t>(m_meshes->size());
+    uint32_t material_count = static_cast<uint32_t>(m_materials.size());
+    for (size_t slot = 0; slot < count; slot += 1) {
+        m_slot_instances[slot] = snapshot.instances[slots[slot]];
+        uint32_t mesh = snapshot.meshes[slots[slot]];
+        m_slot_meshes[slot] = mesh < mesh_count ? mesh : MeshManager::TRIANGLE;
+        uint32_t material = snapshot.materials[slots[slot]];
+        m_slot_materials[slot] = material < material_count ? material : 0;
+    }
+
+    m_culled_structure_version = snapshot.structure_version;
+    m_culled_transform_version = snapshot.transform_version;
 }
 
-void App::create_vertex_buffer()
+void App::update_instance_buffer(FrameSnapshot const& snapshot)
 {
-    VkBufferCreateInfo buffer_info {};
-    buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-    buffer_info.size = sizeof(vertices[0]) * vertices.size();
-    buffer_info.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
-    buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    update_culling(snapshot);
+
+    // the ones not drawn keep nothing from an earlier frame, its arena has been reset since
+    uint32_t drawn_windows = 0;
+    for (auto const& window : m_windows) {
+        if (!window)
+            continue;
+        window->draws = nullptr;
+        window->draw_count = 0;
+        drawn_windows += window->drawn;
+    }
 
-    if (vkCreateBuffer(m_device, &buffer_info, nullptr, &m_vertex_buffer) != VK_SUCCESS)
-        throw std::runtime_error("failed to create vertex buffer!");
+    // every window gets its own range of the buffer, with what is visible from its view
+    // the fence for m_current_frame has been waited on, so its buffer is free to rewrite or replace
+    size_t needed = m_slot_instances.size() * drawn_windows;
+    if (needed > m_instance_capacities[m_current_frame]) {
+        destroy_instance_buffer(m_current_frame);
+        create_instance_buffer(m_current_frame, std::max(needed, m_instance_capacities[m_current_frame] * 2));
+    }
 
-    VkMemoryRequirements mem_requirements;
-    vkGetBufferMemoryRequirements(m_device, m_vertex_buffer, &mem_requirements);
+    struct Range {
+        uint32_t first;
+        uint32_t count;
+        uint32_t offset;
+    };
+
+    FrameArena& arena = m_frame_arenas[m_current_frame];
+    // partly visible leaves give a range per slot, but every range has at least one, so there
+    // can't be more of them than slots per view
+    Range* ranges = arena.allocate<Range>(m_slot_instances.size() * drawn_windows);
+    // one state for everything, nothing to sort
+    bool uniform = m_meshes->lod_count() == 1 && m_materials.size() == 1;
+    auto instances = static_cast<Instance*>(m_instance_buffers_mapped[m_current_frame]);
+    uint32_t range_count = 0;
+    uint32_t count = 0;
+    for (auto& window : m_windows) {
+        if (!window || !window->drawn)
+            continue;
+        uint32_t first_range = range_count;
+        uint32_t first_instance = count;
+        m_bvh.query_frustum(Frustum::from_matrix(window->view_projection), [&](uint32_t first, uint32_t slot_count) {
+            ranges[range_count] = { first, slot_count, count };
+            range_count += 1;
+            count += slot_count;
+        });
+        uint32_t visible = count - first_instance;
+        if (visible == 0)
+            continue;
+
+        // the visible ranges are copied out whole
+        if (uniform) {
+            m_thread_pool.parallel_for(range_count - first_range, 256, [&](size_t begin, size_t end) {
+                for (size_t i = first_range + begin; i < first_range + end; i += 1)
+                    memcpy(instances + ranges[i].offset, m_slot_instances.data() + ranges[i].first, ranges[i].count * sizeof(Instance));
+            });
+            window->draws = arena.allocate<SceneDraw>(1);
+            window->draws[0] = { m_materials[0].pipeline, m_materials[0].texture, 0, first_instance, visible };
+            window->draw_count = 1;
+            continue;
+        }
 
-    VkMemoryAllocateInfo alloc_info {};
-    alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    alloc_info.allocationSize = mem_requirements.size;
-    alloc_info.memoryTypeIndex = find_memory_type(mem_requirements.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        // Each instance draws the coarsest LOD that stays within the threshold at its size on
+        // screen: pixels per unit are the larger axis of the projection, over w for perspective.
+        glm::mat4 const& view_projection = window->view_projection;
+        float pixels_x = glm::length(glm::vec3(view_projection[0].x, view_projection[1].x, view_projection[2].x)) * 0.5f * float(window->render_extent.width);
+        float pixels_y = glm::length(glm::vec3(view_projection[0].y, view_projection[1].y, view_projection[2].y)) * 0.5f * float(window->render_extent.height);
+        float pixels_per_unit = std::max(pixels_x, pixels_y);
+        DrawPacket* packets = arena.allocate<DrawPacket>(visible);
+        m_thread_pool.parallel_for(range_count - first_range, 64, [&](size_t begin, size_t end) {
+            for (size_t i = first_range + begin; i < first_range + end; i += 1) {
+                for (uint32_t j = 0; j < ranges[i].count; j += 1) {
+                    uint32_t slot = ranges[i].first + j;
+                    Instance const& instance = m_slot_instances[slot];
+                    glm::vec4 clip = view_projection * glm::vec4(instance.position, 1.0f);
+                    float scale = std::max(instance.scale.x, std::max(instance.scale.y, instance.scale.z));
+                    uint32_t material = m_slot_materials[slot];
+                    DrawState state {};
+                    state.pass = m_materials[material].pass;
+                    state.pipeline = m_materials[material].pipeline;
+                    state.material = material;
+                    state.lod = m_meshes->select_lod(m_slot_meshes[slot], pixels_per_unit * scale / std::max(clip.w, 1e-6f));
+                    packets[ranges[i].offset - first_instance + j] = { SortKey::make(state, SortKey::depth_bucket(clip.z)), slot };
+                }
+            }
+        });
+        if (m_sort_draws)
+            packets = radix_sort(packets, visible, arena, &m_thread_pool);
+
+        m_thread_pool.parallel_for(visible, 4096, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i += 1)
+                instances[first_instance + i] = m_slot_instances[packets[i].instance];
+        });
+
+        // one draw per run of the same state, what it changes is filtered when recording
+        window->draws = arena.allocate<SceneDraw>(visible);
+        DrawState previous = SortKey::state(packets[0].key);
+        window->draws[0] = { previous.pipeline, m_materials[previous.material].texture, previous.lod, first_instance, 0 };
+        window->draw_count = 1;
+        for (uint32_t i = 0; i < visible; i += 1) {
+            DrawState state = SortKey::state(packets[i].key);
+            // clang-format off
+            if (state.pipeline != previous.pipeline
+                || state.material != previous.material
+                || state.lod != previous.lod) {
+                // clang-format on
+                window->draws[window->draw_count] = { state.pipeline, m_materials[state.material].texture, state.lod, first_instance + i, 0 };
+                window->draw_count += 1;
+                previous = state;
+            }
+            window->draws[window->draw_count - 1].instance_count += 1;
+        }
+    }
 
-    if (vkAllocateMemory(m_device, &alloc_info, nullptr, &m_vertex_buffer_memory) != VK_SUCCESS)
-        throw std::runtime_error("failed to allocate vertex buffer memory!");
+    uint64_t frame = m_pending_frame_stats.frame;
+    for (auto const& window : m_windows) {
+        if (!window)
+            continue;
+        for (uint32_t i = 0; i < window->draw_count; i += 1)
+            m_textures->use(window->draws[i].texture, frame);
+    }
+    Stats::count(Counter::BYTES_UPLOADED, count * sizeof(Instance));
+}
 
-    vkBindBufferMemory(m_device, m_vertex_buffer, m_vertex_buffer_memory, 0);
+Entity App::pick(Ray const& ray) const
+{
+    RayHit hit = m_bvh.raycast(ray);
+    if (hit.object == Bvh::NO_OBJECT)
+        return NULL_ENTITY;
 
-    void* data;
-    vkMapMemory(m_device, m_vertex_buffer_memory, 0, buffer_info.size, 0, &data);
-    memcpy(data, vertices.data(), (size_t)buffer_info.size);
-    vkUnmapMemory(m_device, m_vertex_buffer_memory);
+    return m_cull_entities[hit.object];
 }
 
 void App::create_command_buffers()
@@ -868,7 +1417,101 @@ void App::create_command_buffers()
         throw std::runtime_error("failed to allocate command buffers!");
 }
 
-void App::record_command_buffer(VkCommandBuffer command_buffer, uint32_t const image_index)
+// results come back ordered by bit, which is the order of PipelineStatistic
+static VkQueryPipelineStatisticFlags const PIPELINE_STATISTICS = VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_VERTICES_BIT
+    | VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_PRIMITIVES_BIT
+    | VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT
+    | VK_QUERY_PIPELINE_STATISTIC_CLIPPING_INVOCATIONS_BIT
+    | VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT
+    | VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT;
+
+void App::create_query_pools()
+{
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(m_physical_device, &properties);
+    if (properties.limits.timestampComputeAndGraphics)
+        m_timestamp_period = properties.limits.timestampPeriod;
+
+    VkQueryPoolCreateInfo pool_info {};
+    pool_info.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    pool_info.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    pool_info.queryCount = MAX_FRAMES_IN_FLIGHT * 2;
+
+    if (vkCreateQueryPool(m_device, &pool_info, nullptr, &m_timestamp_query_pool) != VK_SUCCESS)
+        throw std::runtime_error("failed to create timestamp query pool!");
+
+    if (!m_gpu.enabled_features.pipelineStatisticsQuery)
+        return;
+
+    VkQueryPoolCreateInfo statistics_pool_info {};
+    statistics_pool_info.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    statistics_pool_info.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+    statistics_pool_info.queryCount = MAX_FRAMES_IN_FLIGHT;
+    statistics_pool_info.pipelineStatistics = PIPELINE_STATISTICS;
+
+    if (vkCreateQueryPool(m_device, &statistics_pool_info, nullptr, &m_statistics_query_pool) != VK_SUCCESS)
+        throw std::runtime_error("failed to create pipeline statistics query pool!");
+}
+
+void App::read_queries()
+{
+    // this frame's previous use is done, so its queries are in
+    if (m_timestamps_written[m_current_frame]) {
+        std::array<uint64_t, 2> timestamps;
+        if (vkGetQueryPoolResults(m_device, m_timestamp_query_pool, m_current_frame * 2, 2, sizeof(timestamps), timestamps.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT) == VK_SUCCESS) {
+            float gpu_ms = static_cast<float>(timestamps[1] - timestamps[0]) * m_timestamp_period / 1000000.0f;
+            m_pending_frame_stats.gpu_ms = gpu_ms;
+            m_resolution_controller.update(gpu_ms);
+            for (auto& window : m_windows) {
+                if (window)
+                    update_render_extent(*window);
+            }
+        }
+    }
+
+    if (m_statistics_written[m_current_frame]) {
+        auto& pipeline = m_pending_frame_stats.pipeline;
+        vkGetQueryPoolResults(m_device, m_statistics_query_pool, m_current_frame, 1, sizeof(pipeline), pipeline.data(), sizeof(pipeline), VK_QUERY_RESULT_64_BIT);
+    }
+
+    m_post->read_timings(m_current_frame);
+    m_pending_frame_stats.post_ms = m_post->total_ms();
+}
+
+void App::end_frame_stats()
+{
+    m_pending_frame_stats.counters = Stats::take();
+    m_pending_frame_stats.render_scale = m_resolution_controller.scale();
+    m_frame_stats = m_pending_frame_stats;
+    if (m_stats_log)
+        m_stats_log->add(m_frame_stats);
+
+    m_pending_frame_stats = {};
+    m_pending_frame_stats.frame = m_frame_stats.frame + 1;
+}
+
+void App::print_startup_report() const
+{
+    double initialized = 0.0;
+    for (StartupTiming const& timing : m_startup_timings) {
+        std::cout << "startup " << timing.name << ": " << timing.start_ms << " ms + " << timing.duration_ms << " ms"
+                  << (timing.main_thread ? " on the main thread\n" : "\n");
+        initialized = std::max(initialized, timing.start_ms + timing.duration_ms);
+    }
+    std::cout << "startup: initialized after " << initialized << " ms";
+    if (m_first_frame_ms >= 0.0)
+        std::cout << ", first frame submitted after " << m_first_frame_ms << " ms";
+    std::cout << '\n';
+}
+
+void App::update_render_extent(Window& window)
+{
+    float scale = m_resolution_controller.scale();
+    window.render_extent.width = std::max(1u, static_cast<uint32_t>(window.targets.extent.width * scale + 0.5f));
+    window.render_extent.height = std::max(1u, static_cast<uint32_t>(window.targets.extent.height * scale + 0.5f));
+}
+
+void App::record_command_buffer(VkCommandBuffer command_buffer)
 {
     VkCommandBufferBeginInfo begin_info {};
     begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
@@ -876,120 +1519,560 @@ void App::record_command_buffer(VkCommandBuffer command_buffer, uint32_t const i
     if (vkBeginCommandBuffer(command_buffer, &begin_info) != VK_SUCCESS)
         throw std::runtime_error("failed to begin recording command buffer!");
 
-    VkRenderPassBeginInfo render_pass_info {};
-    render_pass_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-    render_pass_info.renderPass = m_render_pass;
-    render_pass_info.framebuffer = m_swap_chain_framebuffers[image_index];
-    render_pass_info.renderArea.offset = { 0, 0 };
-    render_pass_info.renderArea.extent = m_swap_chain_extent;
-    VkClearValue clear_color = { { { 0.0f, 0.0f, 0.0f, 1.0f } } };
-    render_pass_info.clearValueCount = 1;
-    render_pass_info.pClearValues = &clear_color;
+    uint32_t first_query = m_current_frame * 2;
+    if (m_timestamp_period > 0.0f) {
+        vkCmdResetQueryPool(command_buffer, m_timestamp_query_pool, first_query, 2);
+        vkCmdWriteTimestamp(command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_timestamp_query_pool, first_query);
+    }
+    // evictions and restores of this frame, before anything samples
+    m_textures->record_transfers(command_buffer, m_pending_frame_stats.frame);
 
-    vkCmdBeginRenderPass(command_buffer, &render_pass_info, VK_SUBPASS_CONTENTS_INLINE);
+    // around the passes of all windows
+    if (m_statistics_query_pool != VK_NULL_HANDLE) {
+        vkCmdResetQueryPool(command_buffer, m_statistics_query_pool, m_current_frame, 1);
+        vkCmdBeginQuery(command_buffer, m_statistics_query_pool, m_current_frame, 0);
+    }
 
-    vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_graphics_pipeline);
+    // the series are decimated for every drawn window before any pass starts
+    SeriesRenderer::Target* series_targets = m_frame_arenas[m_current_frame].allocate<SeriesRenderer::Target>(m_windows.size());
+    uint32_t series_target_count = 0;
+    for (auto const& window : m_windows) {
+        if (window && window->drawn) {
+            series_targets[series_target_count] = { window->view_projection, window->render_extent };
+            series_target_count += 1;
+        }
+    }
+    m_series->record_compute(command_buffer, m_current_frame, series_targets, series_target_count);
+
+    // and the meshlets of every draw of a dense LOD, the scene passes draw what is left indirectly
+    if (m_meshlet_culling && m_meshlet_culler->supported()) {
+        size_t max_draws = 0;
+        for (auto const& window : m_windows)
+            max_draws += window ? window->draw_count : 0;
+        MeshletCuller::Draw* meshlet_draws = m_frame_arenas[m_current_frame].allocate<MeshletCuller::Draw>(max_draws);
+        uint32_t meshlet_draw_count = 0;
+        for (auto const& window : m_windows) {
+            if (!window || !window->drawn)
+                continue;
+            for (uint32_t i = 0; i < window->draw_count; i += 1) {
+                SceneDraw& draw = window->draws[i];
+                if (m_meshes->lod(draw.lod).meshlet_count == 0)
+                    continue;
+                PipelineDesc const& desc = m_scene_pipeline_descs[draw.pipeline];
+                meshlet_draws[meshlet_draw_count] = { window->view_projection, draw.lod, draw.first_instance, draw.instance_count, desc.cull_mode, desc.front_face };
+                draw.meshlet_draw = meshlet_draw_count;
+                meshlet_draw_count += 1;
+            }
+        }
+        m_meshlet_culler->record_compute(command_buffer, m_current_frame, m_instance_buffers[m_current_frame], meshlet_draws, meshlet_draw_count);
+    }
 
-    VkBuffer vertex_buffers[] = { m_vertex_buffer };
-    VkDeviceSize offsets[] = { 0 };
-    vkCmdBindVertexBuffers(command_buffer, 0, 1, vertex_buffers, offsets);
+    bool layers = m_cache_layers && m_layer_caching_supported;
+    uint64_t inputs_version = layer_inputs_version();
+    uint32_t series_target = 0;
+    for (auto const& window : m_windows) {
+        if (!window || !window->drawn)
+            continue;
+
+        VkRenderPassBeginInfo render_pass_info {};
+        render_pass_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+        render_pass_info.renderPass = m_render_pass;
+        render_pass_info.framebuffer = window->targets.scene_framebuffers[m_current_frame];
+        render_pass_info.renderArea.offset = { 0, 0 };
+        render_pass_info.renderArea.extent = window->render_extent;
+        VkClearValue clear_color = { { { 0.0f, 0.0f, 0.0f, 1.0f } } };
+        render_pass_info.clearValueCount = 1;
+        render_pass_info.pClearValues = &clear_color;
+
+        if (!layers) {
+            vkCmdBeginRenderPass(command_buffer, &render_pass_info, VK_SUBPASS_CONTENTS_INLINE);
+            set_viewport(command_buffer, *window);
+            std::array<uint64_t, COUNTER_COUNT> counts {};
+            record_scene_draws(command_buffer, *window, counts);
+            for (uint32_t i = 0; i < COUNTER_COUNT; i += 1)
+                Stats::count(static_cast<Counter>(i), counts[i]);
+
+            m_series->record(command_buffer, m_current_frame, series_target);
+            series_target += 1;
+            // the series bound their own layout, the text shares the scene's camera push constant
+            vkCmdPushConstants(command_buffer, m_pipeline_layout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(glm::mat4), &window->view_projection);
+            m_text->record(command_buffer, m_current_frame);
+
+            vkCmdEndRenderPass(command_buffer);
+            continue;
+        }
 
-    vkCmdDraw(command_buffer, static_cast<uint32_t>(vertices.size()), 1, 0, 0);
+        // this slot's last submit is done, so its layer can be kept or recorded over
+        SceneLayer& layer = window->scene_layers[m_current_frame];
+        // clang-format off
+        bool current = layer.recorded
+            && layer.inputs_version == inputs_version
+            && layer.view_projection == window->view_projection
+            && layer.render_extent.width == window->render_extent.width
+            && layer.render_extent.height == window->render_extent.height
+            && layer.max_instances_per_draw == m_max_instances_per_draw
+            && std::equal(layer.draws.begin(), layer.draws.end(), window->draws, window->draws + window->draw_count);
+        // clang-format on
+        if (!current) {
+            begin_layer(layer.commands, *window);
+            layer.counts = {};
+            record_scene_draws(layer.commands, *window, layer.counts);
+            if (vkEndCommandBuffer(layer.commands) != VK_SUCCESS)
+                throw std::runtime_error("failed to record scene draws!");
+            layer.recorded = true;
+            layer.inputs_version = inputs_version;
+            layer.view_projection = window->view_projection;
+            layer.render_extent = window->render_extent;
+            layer.max_instances_per_draw = m_max_instances_per_draw;
+            layer.draws.assign(window->draws, window->draws + window->draw_count);
+        }
+        for (uint32_t i = 0; i < COUNTER_COUNT; i += 1)
+            Stats::count(static_cast<Counter>(i), layer.counts[i]);
+
+        // text is immediate mode and the series stream, they are recorded every frame
+        VkCommandBuffer overlay = window->overlay_commands[m_current_frame];
+        begin_layer(overlay, *window);
+        m_series->record(overlay, m_current_frame, series_target);
+        series_target += 1;
+        vkCmdPushConstants(overlay, m_pipeline_layout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(glm::mat4), &window->view_projection);
+        m_text->record(overlay, m_current_frame);
+        if (vkEndCommandBuffer(overlay) != VK_SUCCESS)
+            throw std::runtime_error("failed to record overlay!");
+
+        vkCmdBeginRenderPass(command_buffer, &render_pass_info, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+        std::array<VkCommandBuffer, 2> secondaries = { layer.commands, overlay };
+        vkCmdExecuteCommands(command_buffer, static_cast<uint32_t>(secondaries.size()), secondaries.data());
+        vkCmdEndRenderPass(command_buffer);
+    }
 
-    vkCmdEndRenderPass(command_buffer);
+    // the post chain runs on every drawn scene at once, so each pass is one pipeline bind
+    if (!m_post->empty()) {
+        PostProcessor::View* views = m_frame_arenas[m_current_frame].allocate<PostProcessor::View>(m_windows.size());
+        uint32_t view_count = 0;
+        for (auto const& window : m_windows) {
+            if (window && window->drawn) {
+                views[view_count] = { &window->targets.post, window->targets.scene_images[m_current_frame], window->render_extent };
+                view_count += 1;
+            }
+        }
+        m_post->record(command_buffer, m_current_frame, views, view_count);
+    }
+
+    for (auto const& window : m_windows) {
+        if (window && window->drawn && window->handle != nullptr)
+            blit_to_swap_chain(command_buffer, *window);
+    }
+
+    if (m_statistics_query_pool != VK_NULL_HANDLE)
+        vkCmdEndQuery(command_buffer, m_statistics_query_pool, m_current_frame);
+
+    if (m_timestamp_period > 0.0f)
+        vkCmdWriteTimestamp(command_buffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_timestamp_query_pool, first_query + 1);
 
     if (vkEndCommandBuffer(command_buffer) != VK_SUCCESS)
         throw std::runtime_error("failed to record command buffer!");
 }
 
-void App::create_sync_objects()
+uint64_t App::layer_inputs_version() const
 {
-    VkSemaphoreCreateInfo semaphore_info {};
-    semaphore_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    // every one of them only counts up, so the sum changes whenever one does
+    return m_layer_version + m_textures->version() + m_meshes->version() + m_meshlet_culler->version(m_current_frame);
+}
+
+void App::begin_layer(VkCommandBuffer command_buffer, Window const& window)
+{
+    VkCommandBufferInheritanceInfo inheritance_info {};
+    inheritance_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+    inheritance_info.renderPass = m_render_pass;
+    inheritance_info.subpass = 0;
+    inheritance_info.framebuffer = window.targets.scene_framebuffers[m_current_frame];
+    // executed inside the statistics query around the passes
+    inheritance_info.pipelineStatistics = m_statistics_query_pool != VK_NULL_HANDLE ? PIPELINE_STATISTICS : 0;
+
+    VkCommandBufferBeginInfo begin_info {};
+    begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    begin_info.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+    begin_info.pInheritanceInfo = &inheritance_info;
+
+    if (vkBeginCommandBuffer(command_buffer, &begin_info) != VK_SUCCESS)
+        throw std::runtime_error("failed to begin recording secondary command buffer!");
+    // dynamic state isn't inherited
+    set_viewport(command_buffer, window);
+}
+
+void App::set_viewport(VkCommandBuffer command_buffer, Window const& window)
+{
+    VkViewport viewport {};
+    viewport.x = 0.0f;
+    viewport.y = 0.0f;
+    viewport.width = (float)window.render_extent.width;
+    viewport.height = (float)window.render_extent.height;
+    viewport.minDepth = 0.0f;
+    viewport.maxDepth = 1.0f;
+    vkCmdSetViewport(command_buffer, 0, 1, &viewport);
+
+    VkRect2D scissor {};
+    scissor.offset = { 0, 0 };
+    scissor.extent = window.render_extent;
+    vkCmdSetScissor(command_buffer, 0, 1, &scissor);
+}
+
+void App::record_scene_draws(VkCommandBuffer command_buffer, Window const& window, std::array<uint64_t, COUNTER_COUNT>& counts)
+{
+    auto count = [&counts](Counter counter, uint64_t amount) { counts[static_cast<uint32_t>(counter)] += amount; };
+
+    vkCmdPushConstants(command_buffer, m_pipeline_layout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(glm::mat4), &window.view_projection);
+
+    m_meshes->bind(command_buffer);
+    VkDeviceSize instance_offset = 0;
+    vkCmdBindVertexBuffers(command_buffer, 1, 1, &m_instance_buffers[m_current_frame], &instance_offset);
+
+    // one draw per run of the same state, unless split up on purpose, and binds only where
+    // the state changes
+    uint32_t bound_pipeline = UINT32_MAX;
+    uint32_t bound_texture = UINT32_MAX;
+    for (uint32_t i = 0; i < window.draw_count; i += 1) {
+        SceneDraw const& draw = window.draws[i];
+        if (draw.pipeline != bound_pipeline) {
+            vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_scene_pipelines[draw.pipeline]);
+            count(Counter::PIPELINE_BINDS, 1);
+            bound_pipeline = draw.pipeline;
+        }
+        if (draw.texture != bound_texture) {
+            VkDescriptorSet texture_set = m_textures->get(draw.texture).descriptor_set;
+            vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipeline_layout, 0, 1, &texture_set, 0, nullptr);
+            count(Counter::DESCRIPTOR_BINDS, 1);
+            bound_texture = draw.texture;
+        }
+        if (draw.meshlet_draw != SceneDraw::NO_MESHLET_DRAW) {
+            count(Counter::DRAW_CALLS, m_meshlet_culler->record(command_buffer, m_current_frame, draw.meshlet_draw));
+            count(Counter::INSTANCES, draw.instance_count);
+            continue;
+        }
+        LodRange const& lod = m_meshes->lod(draw.lod);
+        for (uint32_t first = 0; first < draw.instance_count; first += m_max_instances_per_draw) {
+            uint32_t instances = std::min(draw.instance_count - first, m_max_instances_per_draw);
+            vkCmdDrawIndexed(command_buffer, lod.index_count, instances, lod.first_index, lod.vertex_offset, draw.first_instance + first);
+            count(Counter::DRAW_CALLS, 1);
+        }
+        count(Counter::VERTICES, uint64_t(lod.index_count) * draw.instance_count);
+        count(Counter::INSTANCES, draw.instance_count);
+    }
+}
+
+void App::blit_to_swap_chain(VkCommandBuffer command_buffer, Window const& window)
+{
+    WindowTargets const& targets = window.targets;
+
+    // upscale the rendered part of the scene target into the swap chain image
+    VkImageMemoryBarrier barrier {};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.srcAccessMask = 0;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = targets.swap_chain_images[window.image_index];
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.baseMipLevel = 0;
+    barrier.subresourceRange.levelCount = 1;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount = 1;
+    vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+    VkImageBlit blit {};
+    blit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    blit.srcSubresource.mipLevel = 0;
+    blit.srcSubresource.baseArrayLayer = 0;
+    blit.srcSubresource.layerCount = 1;
+    blit.srcOffsets[0] = { 0, 0, 0 };
+    blit.srcOffsets[1] = { static_cast<int32_t>(window.render_extent.width), static_cast<int32_t>(window.render_extent.height), 1 };
+    blit.dstSubresource = blit.srcSubresource;
+    blit.dstOffsets[0] = { 0, 0, 0 };
+    blit.dstOffsets[1] = { static_cast<int32_t>(targets.extent.width), static_cast<int32_t>(targets.extent.height), 1 };
+    vkCmdBlitImage(command_buffer, targets.scene_images[m_current_frame], VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, targets.swap_chain_images[window.image_index], VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit, VK_FILTER_LINEAR);
+
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = 0;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+}
 
+void App::create_sync_objects()
+{
     VkFenceCreateInfo fence_info {};
     fence_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
     fence_info.flags = VK_FENCE_CREATE_SIGNALED_BIT;
 
     for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i += 1) {
-        // clang-format off
-        if (
-            vkCreateSemaphore(m_device, &semaphore_info, nullptr, &m_image_available_semaphores[i]) != VK_SUCCESS
-            || vkCreateSemaphore(m_device, &semaphore_info, nullptr, &m_render_finished_semaphores[i]) != VK_SUCCESS
-            || vkCreateFence(m_device, &fence_info, nullptr, &m_in_flight_fences[i]) != VK_SUCCESS
-        ) {
-            // clang-format on
+        if (vkCreateFence(m_device, &fence_info, nullptr, &m_in_flight_fences[i]) != VK_SUCCESS)
             throw std::runtime_error("failed to create sync objects for a frame!");
-        }
     }
 }
 
-void App::draw_frame()
+bool App::acquire(Window& window)
 {
-    vkWaitForFences(m_device, 1, &m_in_flight_fences[m_current_frame], VK_TRUE, UINT64_MAX);
+    if (window.handle == nullptr)
+        return true;
+
+    if (window.resized) {
+        recreate_swap_chain(window);
+        if (window.resized)
+            return false;
+    }
 
-    uint32_t image_index;
-    VkResult result = vkAcquireNextImageKHR(m_device, m_swap_chain, UINT64_MAX, m_image_available_semaphores[m_current_frame], VK_NULL_HANDLE, &image_index);
+    VkResult result = vkAcquireNextImageKHR(m_device, window.targets.swap_chain, UINT64_MAX, window.image_available_semaphores[m_current_frame], VK_NULL_HANDLE, &window.image_index);
     if (result == VK_ERROR_OUT_OF_DATE_KHR) {
-        recreate_swap_chain();
-        return;
+        // only this window sits the frame out
+        recreate_swap_chain(window);
+        return false;
     } else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) {
         throw std::runtime_error("failed to acquire swap chain image!");
     }
+    return true;
+}
+
+void App::draw_frame()
+{
+    vkWaitForFences(m_device, 1, &m_in_flight_fences[m_current_frame], VK_TRUE, UINT64_MAX);
+    FrameArena& arena = m_frame_arenas[m_current_frame];
+    arena.reset();
+    // that fence was for the frame MAX_FRAMES_IN_FLIGHT before this one, so it and everything
+    // before it are done
+    uint64_t frame = m_pending_frame_stats.frame;
+    m_deletion_queue->set_frame(frame);
+    if (frame >= MAX_FRAMES_IN_FLIGHT) {
+        m_deletion_queue->collect(frame - MAX_FRAMES_IN_FLIGHT);
+        m_textures->collect(frame - MAX_FRAMES_IN_FLIGHT);
+    }
+
+    // textures the frames still in flight may sample are kept, evicted ones come back on use
+    m_residency->update();
+    VkDeviceSize excess = m_residency->excess();
+    if (excess > 0)
+        m_textures->evict_unused(excess, frame >= MAX_FRAMES_IN_FLIGHT ? frame - MAX_FRAMES_IN_FLIGHT + 1 : 0);
+    m_pending_frame_stats.memory_headroom_mb = float(m_residency->headroom()) / (1024.0f * 1024.0f);
+
+    read_queries();
+
+    // the newest the simulation has, or the same as last frame if it hasn't published since
+    m_snapshots.acquire();
+    FrameSnapshot const& snapshot = m_snapshots.read_buffer();
+    for (size_t i = 0; i < m_windows.size() && i < snapshot.view_projections.size(); i += 1) {
+        if (m_windows[i])
+            m_windows[i]->view_projection = snapshot.view_projections[i];
+    }
+    if (m_capture)
+        capture_frame(snapshot);
+
+    VkSemaphore* wait_semaphores = arena.allocate<VkSemaphore>(m_windows.size());
+    VkPipelineStageFlags* wait_stages = arena.allocate<VkPipelineStageFlags>(m_windows.size());
+    VkSemaphore* signal_semaphores = arena.allocate<VkSemaphore>(m_windows.size());
+    uint32_t semaphore_count = 0;
+    for (auto& window : m_windows) {
+        if (!window)
+            continue;
+        window->drawn = !window->hidden && acquire(*window);
+        if (window->drawn && window->handle != nullptr) {
+            wait_semaphores[semaphore_count] = window->image_available_semaphores[m_current_frame];
+            // the swap chain image is only touched by the blit at the end
+            wait_stages[semaphore_count] = VK_PIPELINE_STAGE_TRANSFER_BIT;
+            signal_semaphores[semaphore_count] = window->render_finished_semaphores[m_current_frame];
+            semaphore_count += 1;
+        }
+    }
 
     vkResetFences(m_device, 1, &m_in_flight_fences[m_current_frame]);
 
+    auto record_start = Clock::now();
+    update_instance_buffer(snapshot);
+    float record_ms = std::chrono::duration<float, std::milli>(Clock::now() - record_start).count();
+    m_text->prepare(m_current_frame, snapshot.text);
+    m_series->prepare(m_current_frame);
+
+    vkResetCommandBuffer(m_command_buffers[m_current_frame], 0);
+    record_start = Clock::now();
+    record_command_buffer(m_command_buffers[m_current_frame]);
+    m_pending_frame_stats.record_ms = record_ms + std::chrono::duration<float, std::milli>(Clock::now() - record_start).count();
+
+    // all windows in one submit
     VkSubmitInfo submit_info {};
     submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-
-    VkSemaphore wait_semaphores[] = { m_image_available_semaphores[m_current_frame] };
-    VkPipelineStageFlags wait_stages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
-    submit_info.waitSemaphoreCount = 1;
+    submit_info.waitSemaphoreCount = semaphore_count;
     submit_info.pWaitSemaphores = wait_semaphores;
     submit_info.pWaitDstStageMask = wait_stages;
-
-    VkSemaphore signal_semaphores[] = { m_render_finished_semaphores[m_current_frame] };
-    submit_info.signalSemaphoreCount = 1;
-    submit_info.pSignalSemaphores = signal_semaphores;
-
-    vkResetCommandBuffer(m_command_buffers[m_current_frame], 0);
-    record_command_buffer(m_command_buffers[m_current_frame], image_index);
     submit_info.commandBufferCount = 1;
     submit_info.pCommandBuffers = &m_command_buffers[m_current_frame];
+    submit_info.signalSemaphoreCount = semaphore_count;
+    submit_info.pSignalSemaphores = signal_semaphores;
 
     if (vkQueueSubmit(m_graphics_queue, 1, &submit_info, m_in_flight_fences[m_current_frame]) != VK_SUCCESS)
         throw std::runtime_error("failed to submit draw command buffer!");
+    m_timestamps_written[m_current_frame] = m_timestamp_period > 0.0f;
+    m_statistics_written[m_current_frame] = m_statistics_query_pool != VK_NULL_HANDLE;
+    Stats::count(Counter::COMMAND_BUFFERS_SUBMITTED);
+    if (m_first_frame_ms < 0.0)
+        m_first_frame_ms = std::chrono::duration<double, std::milli>(Clock::now() - m_construction_start).count();
+    if (snapshot.sequence > 0)
+        m_pending_frame_stats.latency_ms = std::chrono::duration<float, std::milli>(Clock::now() - snapshot.produced).count();
 
+    present();
+
+    end_frame_stats();
+    m_current_frame = (m_current_frame + 1) % MAX_FRAMES_IN_FLIGHT;
+}
+
+void App::present()
+{
+    FrameArena& arena = m_frame_arenas[m_current_frame];
+    VkSwapchainKHR* swap_chains = arena.allocate<VkSwapchainKHR>(m_windows.size());
+    uint32_t* image_indices = arena.allocate<uint32_t>(m_windows.size());
+    VkSemaphore* wait_semaphores = arena.allocate<VkSemaphore>(m_windows.size());
+    VkResult* results = arena.allocate<VkResult>(m_windows.size());
+    Window** windows = arena.allocate<Window*>(m_windows.size());
+    uint32_t count = 0;
+    for (auto& window : m_windows) {
+        if (!window || !window->drawn || window->handle == nullptr)
+            continue;
+        swap_chains[count] = window->targets.swap_chain;
+        image_indices[count] = window->image_index;
+        wait_semaphores[count] = window->render_finished_semaphores[m_current_frame];
+        windows[count] = window.get();
+        count += 1;
+    }
+    if (count == 0)
+        return;
+
+    // every swap chain in one call, each with its own result
     VkPresentInfoKHR present_info {};
     present_info.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
-    present_info.waitSemaphoreCount = 1;
-    present_info.pWaitSemaphores = signal_semaphores;
-    VkSwapchainKHR swap_chains[] = { m_swap_chain };
-    present_info.swapchainCount = 1;
+    present_info.waitSemaphoreCount = count;
+    present_info.pWaitSemaphores = wait_semaphores;
+    present_info.swapchainCount = count;
     present_info.pSwapchains = swap_chains;
-    present_info.pImageIndices = &image_index;
-    // present_info.pResults = nullptr; for multiple swap chains
-
-    result = vkQueuePresentKHR(m_present_queue, &present_info);
+    present_info.pImageIndices = image_indices;
+    present_info.pResults = results;
 
-    if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || m_framebuffer_resized) {
-        m_framebuffer_resized = false;
-        recreate_swap_chain();
-    } else if (result != VK_SUCCESS) {
+    VkResult result = vkQueuePresentKHR(m_present_queue, &present_info);
+    if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR && result != VK_ERROR_OUT_OF_DATE_KHR)
         throw std::runtime_error("failed to present swap chain image!");
+
+    for (uint32_t i = 0; i < count; i += 1) {
+        if (results[i] == VK_ERROR_OUT_OF_DATE_KHR || results[i] == VK_SUBOPTIMAL_KHR || windows[i]->resized)
+            recreate_swap_chain(*windows[i]);
+        else if (results[i] != VK_SUCCESS)
+            throw std::runtime_error("failed to present swap chain image!");
     }
+}
 
-    m_current_frame = (m_current_frame + 1) % MAX_FRAMES_IN_FLIGHT;
+void App::step()
+{
+    auto now = Clock::now();
+    simulate(std::chrono::duration<float>(now - m_last_step).count());
+    m_last_step = now;
+    draw_frame();
 }
 
 void App::loop()
 {
-    while (!glfwWindowShouldClose(m_window)) {
+    while (!glfwWindowShouldClose(m_windows.front()->handle)) {
         glfwPollEvents();
-        draw_frame();
+        // closing the main window ends the loop, the others just go away
+        for (uint32_t i = 1; i < m_windows.size(); i += 1) {
+            if (m_windows[i] && glfwWindowShouldClose(m_windows[i]->handle))
+                close_window(i);
+        }
+        step();
+    }
+
+    vkDeviceWaitIdle(m_device);
+}
+
+void App::loop_threaded(uint32_t frame_count)
+{
+    // the render thread starts out with something to draw
+    if (m_snapshot_sequence == 0)
+        simulate(0.0f);
+
+    m_running = true;
+    std::exception_ptr simulation_error;
+    std::exception_ptr render_error;
+    std::thread simulation([this, &simulation_error] {
+        try {
+            simulation_loop();
+        } catch (...) {
+            simulation_error = std::current_exception();
+        }
+        m_running = false;
+    });
+    std::thread render([this, frame_count, &render_error] {
+        try {
+            render_loop(frame_count);
+        } catch (...) {
+            render_error = std::current_exception();
+        }
+        m_running = false;
+        if (!m_app_info.headless)
+            glfwPostEmptyEvent();
+    });
+
+    if (!m_app_info.headless) {
+        while (m_running) {
+            // woken by the render thread when it stops
+            glfwWaitEvents();
+            if (glfwWindowShouldClose(m_windows.front()->handle))
+                m_running = false;
+            // GLFW windows can only be destroyed here, so closed ones are only hidden until the
+            // render thread is done with them
+            for (uint32_t i = 1; i < m_windows.size(); i += 1) {
+                if (m_windows[i] && !m_windows[i]->hidden && glfwWindowShouldClose(m_windows[i]->handle)) {
+                    glfwHideWindow(m_windows[i]->handle);
+                    m_windows[i]->hidden = true;
+                }
+            }
+        }
     }
 
+    render.join();
+    simulation.join();
     vkDeviceWaitIdle(m_device);
+
+    for (uint32_t i = 1; i < m_windows.size(); i += 1) {
+        if (m_windows[i] && m_windows[i]->hidden)
+            close_window(i);
+    }
+    m_last_step = Clock::now();
+
+    if (render_error)
+        std::rethrow_exception(render_error);
+    if (simulation_error)
+        std::rethrow_exception(simulation_error);
+}
+
+void App::simulation_loop()
+{
+    auto const tick = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / m_simulation_rate));
+    float const dt = std::chrono::duration<float>(tick).count();
+    auto next = Clock::now();
+    while (m_running) {
+        simulate(dt);
+
+        // a slow update doesn't try to catch up, the simulation just runs slower
+        next += tick;
+        auto now = Clock::now();
+        if (next < now)
+            next = now;
+        else
+            std::this_thread::sleep_until(next);
+    }
+}
+
+void App::render_loop(uint32_t frame_count)
+{
+    for (uint32_t i = 0; m_running && (frame_count == 0 || i < frame_count); i += 1)
+        draw_frame();
 }
 
 }
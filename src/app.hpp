@@ -1,30 +1,153 @@
 #ifndef _HB_APP
 #define _HB_APP
 
+#include <algorithm>
 #include <array>
+#include <atomic>
+#include <chrono>
 #include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <string_view>
+#include <utility>
 #include <vector>
 
 #define GLFW_INCLUDE_VULKAN
 #include <GLFW/glfw3.h>
 #include <glm/glm.hpp>
 
+#include "bvh.hpp"
+#include "capture.hpp"
+#include "deletion_queue.hpp"
+#include "frame_arena.hpp"
+#include "geometry.hpp"
+#include "gpu.hpp"
+#include "mesh.hpp"
+#include "meshlet_culler.hpp"
+#include "pipeline.hpp"
+#include "post.hpp"
+#include "render_queue.hpp"
+#include "residency.hpp"
+#include "resolution.hpp"
+#include "scene.hpp"
+#include "series.hpp"
+#include "startup.hpp"
+#include "stats.hpp"
+#include "text.hpp"
+#include "text_renderer.hpp"
+#include "texture.hpp"
+#include "thread_pool.hpp"
+#include "triple_buffer.hpp"
+
 namespace HB {
 
+struct Instance;
+
 struct AppInfo {
     uint32_t width;
     uint32_t height;
     char const* name;
     char const* version;
+    // no window, surface or swap chain, frames only go to the offscreen scene target, for
+    // benchmarks and tests on machines without a display (e.g. lavapipe)
+    bool headless = false;
+    // Events, simulation and rendering each get their own thread: the main thread only handles
+    // window events, the update function runs at the simulation rate and publishes snapshots of
+    // the scene, and the render thread draws the newest one. While it runs only the update
+    // function may touch the scene or call set_view_projection(), anything else has to wait
+    // until run() returns.
+    bool threaded = false;
+    // where generated data (the glyph atlas) is kept between runs, the system's temporary
+    // directory if not set
+    char const* cache_directory = nullptr;
+    // records every texture, mesh and material created and every frame drawn to this file, for
+    // tools/replay.cpp to draw again without the application
+    char const* capture = nullptr;
+    // runs the initialization steps one after the other on the calling thread instead of
+    // overlapping them on the thread pool (for comparison)
+    bool serial_startup = false;
 };
 
 class App {
 public:
+    // until the window is closed, throws when headless
     void run();
+    // draws a fixed number of frames, returns once the last one is submitted
+    void run_frames(uint32_t count);
+    void wait_idle();
+    // called once per frame, or at the simulation rate when threaded, with the seconds since the
+    // previous call
+    void set_update(std::function<void(Scene&, float)> update) { m_update = std::move(update); }
+    void set_simulation_rate(float hz) { m_simulation_rate = std::max(hz, 1.0f); }
+    // Opens another window onto the scene that shares the device, pipelines and everything loaded.
+    // All windows are recorded into one submit and presented with one call. When headless it is
+    // another offscreen target. Returns its index, the main window is 0.
+    uint32_t add_window(uint32_t width, uint32_t height, char const* title);
+    uint32_t window_count() const { return static_cast<uint32_t>(m_windows.size()); }
+    // resizes the window, or the offscreen target when headless
+    void resize(uint32_t width, uint32_t height, uint32_t window = 0);
+    Scene& scene() { return m_scene; }
+    TextureManager& textures() { return *m_textures; }
+    // device memory usage and budgets, textures are evicted to keep within them
+    ResidencyManager& residency() { return *m_residency; }
+    // load meshes during setup, Renderable::mesh is the index they return
+    MeshManager& meshes() { return *m_meshes; }
+    // variants of the scene pipeline, made once and shared by everyone asking for the same state
+    PipelineCache& pipelines() { return *m_pipelines; }
+    // Creates these on the thread pool while setup and the first frames go on, so materials
+    // made from them later don't wait for the compiler.
+    void warm_pipelines(std::vector<PipelineDesc> const&);
+    void set_scene_pipeline(PipelineDesc const&);
+    // A pipeline state and texture for Renderable::material, made during setup. Blended ones are
+    // drawn after everything opaque, back to front.
+    uint32_t create_material(PipelineDesc const&, uint32_t texture = TextureManager::WHITE);
+    // Sorts the scene's draws by state every frame so each pipeline and texture is bound as few
+    // times as possible. Off, they are submitted in culling order (for comparison).
+    void set_draw_sorting(bool sort) { m_sort_draws = sort; }
+    // Culls the meshlets of LODs that have them on the GPU, per instance, before they are drawn
+    // indirectly. Off, they draw whole like everything else (for comparison).
+    void set_meshlet_culling(bool cull) { m_meshlet_culling = cull; }
+    // Records every window's scene draws once per frame slot and executes them again as long as
+    // nothing they draw has changed, only text and series are recorded every frame. Off, the
+    // scene draws are recorded again every frame too (for comparison).
+    void set_command_buffer_caching(bool cache) { m_cache_layers = cache; }
+    // call after moving or resizing entities, structural changes are picked up automatically
+    void scene_moved() { m_transform_version += 1; }
+    void set_view_projection(glm::mat4 const&, uint32_t window = 0);
+    // Queues a label for the next snapshot, text is immediate mode and has to be drawn again
+    // every frame (or simulation step). Positioned like the scene, at the top left of the first
+    // line, `size` is the line height.
+    void draw_text(std::string_view text, glm::vec3 position, float size, glm::vec4 color = glm::vec4(1.0f)) { m_text_batch.add(text, position, size, color); }
+    TextRenderer& text() { return *m_text; }
+    // streamed line plots, drawn over the scene in every window; appending is thread safe
+    SeriesRenderer& series() { return *m_series; }
+    // Compute passes run on the HDR scene before it is blitted to the swap chain, in order. Set
+    // during setup, an empty chain turns them off.
+    void set_post_chain(std::vector<PostEffect> const&, PostSettings const& = {});
+    PostProcessor& post() { return *m_post; }
+    // closest entity whose bounds the ray hits in the last drawn frame, NULL_ENTITY if there is none
+    Entity pick(Ray const&) const;
+    // GPU time per frame the render scale is adjusted to hold
+    void set_target_frame_time(float milliseconds) { m_resolution_controller.set_target(milliseconds); }
+    float render_scale() const { return m_resolution_controller.scale(); }
+    // splits the scene draw, to measure per-draw overhead without changing what is drawn
+    void set_max_instances_per_draw(uint32_t count) { m_max_instances_per_draw = std::max(count, 1u); }
+    // counters of the last finished frame
+    FrameStats const& frame_stats() const { return m_frame_stats; }
+    // appends every frame's stats to a CSV file, written out every `interval` frames
+    void log_stats(std::string const& path, uint32_t interval = 60) { m_stats_log = std::make_unique<StatsLog>(path, interval); }
+    // how long each initialization step took and when it started, relative to the constructor
+    std::vector<StartupTiming> const& startup_timings() const { return m_startup_timings; }
+    // from the start of the constructor to the first frame's submit, negative until then
+    double first_frame_ms() const { return m_first_frame_ms; }
+    void print_startup_report() const;
     App(AppInfo);
     ~App();
 
 private:
+    using Clock = std::chrono::steady_clock;
+
     static uint32_t const MAX_FRAMES_IN_FLIGHT = 2;
     std::vector<char const*> const m_validation_layers = {
         "VK_LAYER_KHRONOS_validation"
@@ -37,46 +160,225 @@ private:
     static VkDebugUtilsMessageSeverityFlagBitsEXT const LOG_LEVEL = VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT;
 #endif
     std::vector<char const*> m_instance_extensions = {};
-    std::vector<char const*> const m_device_extensions = {
+    // headless apps drop the swap chain extension
+    std::vector<char const*> m_device_extensions = {
         VK_KHR_SWAPCHAIN_EXTENSION_NAME
     };
+
+    // what a window needs to show the scene, replaced whenever it is resized
+    struct WindowTargets {
+        VkSwapchainKHR swap_chain = VK_NULL_HANDLE;
+        std::vector<VkImage> swap_chain_images;
+        VkExtent2D extent {};
+        // the scene is drawn into the top left render extent of these and blitted up to the swap
+        // chain, they are allocated at the full extent so changing the scale is free
+        std::array<VkImage, MAX_FRAMES_IN_FLIGHT> scene_images {};
+        std::array<VkDeviceMemory, MAX_FRAMES_IN_FLIGHT> scene_images_memory {};
+        std::array<VkImageView, MAX_FRAMES_IN_FLIGHT> scene_image_views {};
+        std::array<VkFramebuffer, MAX_FRAMES_IN_FLIGHT> scene_framebuffers {};
+        // empty until a post chain is set
+        PostTargets post;
+    };
+
+    // instances drawn with the same state, a range of the frame's instance buffer
+    struct SceneDraw {
+        static uint32_t const NO_MESHLET_DRAW = UINT32_MAX;
+
+        uint32_t pipeline;
+        uint32_t texture;
+        uint32_t lod;
+        uint32_t first_instance;
+        uint32_t instance_count;
+        // its index in this frame's MeshletCuller draws, if its meshlets were culled
+        uint32_t meshlet_draw = NO_MESHLET_DRAW;
+
+        bool operator==(SceneDraw const&) const = default;
+    };
+
+    // A window's scene draws of one frame slot, in a secondary command buffer that is executed
+    // again while its draws and inputs stay the same. The inputs are everything the recording
+    // refers to that isn't in the draws, see App::layer_inputs_version().
+    struct SceneLayer {
+        VkCommandBuffer commands = VK_NULL_HANDLE;
+        bool recorded = false;
+        uint64_t inputs_version = 0;
+        glm::mat4 view_projection = glm::mat4(1.0f);
+        VkExtent2D render_extent {};
+        uint32_t max_instances_per_draw = 0;
+        std::vector<SceneDraw> draws;
+        // what recording it counted, counted again every time it is executed
+        std::array<uint64_t, COUNTER_COUNT> counts {};
+    };
+
+    struct Material {
+        uint32_t pass;
+        uint32_t pipeline;
+        uint32_t texture;
+    };
+
+    // One view onto the scene. Without a GLFW window (always when headless) there is no surface
+    // or swap chain and frames end in the scene targets.
+    struct Window {
+        GLFWwindow* handle = nullptr;
+        VkSurfaceKHR surface = VK_NULL_HANDLE;
+        VkSurfaceFormatKHR surface_format {};
+        VkPresentModeKHR present_mode = VK_PRESENT_MODE_FIFO_KHR;
+        // the framebuffer size, kept up to date by the main thread so the render thread never has
+        // to ask GLFW
+        std::atomic<uint32_t> width = 0;
+        std::atomic<uint32_t> height = 0;
+        WindowTargets targets;
+        VkExtent2D render_extent {};
+        std::array<VkSemaphore, MAX_FRAMES_IN_FLIGHT> image_available_semaphores {};
+        std::array<VkSemaphore, MAX_FRAMES_IN_FLIGHT> render_finished_semaphores {};
+        glm::mat4 view_projection = glm::mat4(1.0f);
+        std::atomic<bool> resized = false;
+        // closed while running threaded, destroyed once the threads are done
+        std::atomic<bool> hidden = false;
+        // this frame's part, drawn is false while minimized or when acquiring failed
+        bool drawn = false;
+        uint32_t image_index = 0;
+        // in the frame's arena
+        SceneDraw* draws = nullptr;
+        uint32_t draw_count = 0;
+        // per frame in flight, when the scene draws are cached: the text and series are drawn by
+        // their own secondary command buffer, recorded every frame
+        std::array<SceneLayer, MAX_FRAMES_IN_FLIGHT> scene_layers {};
+        std::array<VkCommandBuffer, MAX_FRAMES_IN_FLIGHT> overlay_commands {};
+    };
+
     AppInfo m_app_info;
-    GLFWwindow* m_window;
+    // closed windows leave an empty slot, so indices stay valid; owned by pointer so the GLFW
+    // user pointer does too
+    std::vector<std::unique_ptr<Window>> m_windows;
     VkInstance m_instance;
     VkDebugUtilsMessengerEXT m_debug_messenger;
-    VkSurfaceKHR m_surface;
     VkPhysicalDevice m_physical_device = VK_NULL_HANDLE;
+    // picked along with the physical device, for the main window's surface
+    uint32_t m_graphics_family;
+    uint32_t m_present_family;
     VkDevice m_device;
     VkQueue m_graphics_queue;
     VkQueue m_present_queue;
-    VkSwapchainKHR m_swap_chain;
-    std::vector<VkImage> m_swap_chain_images;
-    VkFormat m_swap_chain_image_format;
-    VkExtent2D m_swap_chain_extent;
-    std::vector<VkImageView> m_swap_chain_image_views;
+    // HDR so bloom and tonemapping have something to work with, every window's swap chain gets
+    // blitted to from it
+    VkFormat m_scene_format = VK_FORMAT_R16G16B16A16_SFLOAT;
     VkPipelineLayout m_pipeline_layout;
     VkRenderPass m_render_pass;
-    VkPipeline m_graphics_pipeline;
-    std::vector<VkFramebuffer> m_swap_chain_framebuffers;
     VkCommandPool m_command_pool;
+    GpuContext m_gpu;
+    // VK_EXT_memory_budget is optional, without it budgets are the heap sizes
+    bool m_memory_budget = false;
+    // VK_KHR_draw_indirect_count is optional too, meshlet culling compacts its draws with it
+    bool m_draw_indirect_count = false;
+    std::unique_ptr<ResidencyManager> m_residency;
+    // resized targets, closed windows and replaced resources, so changing one never waits for
+    // the whole device
+    std::unique_ptr<DeletionQueue> m_deletion_queue;
+    std::unique_ptr<TextureManager> m_textures;
+    std::unique_ptr<MeshManager> m_meshes;
+    std::unique_ptr<PipelineCache> m_pipelines;
+    // owned by m_pipelines, the ones materials use, material 0's is the scene pipeline
+    std::vector<VkPipeline> m_scene_pipelines;
+    // what they were made from, by the same index
+    std::vector<PipelineDesc> m_scene_pipeline_descs;
+    std::vector<Material> m_materials;
+    bool m_sort_draws = true;
+    std::unique_ptr<MeshletCuller> m_meshlet_culler;
+    bool m_meshlet_culling = true;
+    bool m_cache_layers = true;
+    // secondary command buffers can't run inside the pipeline statistics query without
+    // inheritedQueries, the scene draws are recorded inline every frame then
+    bool m_layer_caching_supported = false;
+    // counts up whenever the framebuffers, instance buffers or scene pipeline are replaced
+    uint64_t m_layer_version = 0;
+    std::unique_ptr<TextRenderer> m_text;
+    std::unique_ptr<SeriesRenderer> m_series;
+    std::unique_ptr<PostProcessor> m_post;
     // https://vulkan-tutorial.com/Drawing_a_triangle/Drawing/Frames_in_flight
     // these need to be vectors and be resized in their respective create functions if we want
     // to change max frames in flight (double/triple-buffering) on the fly
     std::array<VkCommandBuffer, MAX_FRAMES_IN_FLIGHT> m_command_buffers;
-    std::array<VkSemaphore, MAX_FRAMES_IN_FLIGHT> m_image_available_semaphores;
-    std::array<VkSemaphore, MAX_FRAMES_IN_FLIGHT> m_render_finished_semaphores;
     std::array<VkFence, MAX_FRAMES_IN_FLIGHT> m_in_flight_fences;
-    bool m_framebuffer_resized = false;
+    // scratch memory for building a frame, reset once its fence has been waited on
+    std::array<FrameArena, MAX_FRAMES_IN_FLIGHT> m_frame_arenas;
     uint32_t m_current_frame = 0;
-    VkBuffer m_vertex_buffer;
-    VkDeviceMemory m_vertex_buffer_memory;
+    // two timestamps per frame in flight, bracketing all of its GPU work
+    VkQueryPool m_timestamp_query_pool;
+    std::array<bool, MAX_FRAMES_IN_FLIGHT> m_timestamps_written {};
+    // nanoseconds per timestamp tick, 0 if the graphics queue can't write timestamps
+    float m_timestamp_period = 0.0f;
+    ResolutionController m_resolution_controller;
+    // one query per frame in flight around the scene pass, if pipelineStatisticsQuery is there
+    VkQueryPool m_statistics_query_pool = VK_NULL_HANDLE;
+    std::array<bool, MAX_FRAMES_IN_FLIGHT> m_statistics_written {};
+    FrameStats m_frame_stats;
+    FrameStats m_pending_frame_stats;
+    std::unique_ptr<StatsLog> m_stats_log;
+    // AppInfo::capture, the scene is only written again when it changed since the last frame
+    std::unique_ptr<CaptureWriter> m_capture;
+    Clock::time_point m_capture_start;
+    uint64_t m_captured_structure_version = UINT64_MAX;
+    uint64_t m_captured_transform_version = UINT64_MAX;
+    std::vector<CapturedEntity> m_captured_entities;
+    CapturedFrame m_captured_frame;
+    uint32_t m_max_instances_per_draw = UINT32_MAX;
+    Clock::time_point m_construction_start;
+    std::vector<StartupTiming> m_startup_timings;
+    double m_first_frame_ms = -1.0;
+    ThreadPool m_thread_pool;
+    // warm_pipelines(), waited for before the pipeline cache goes
+    std::vector<std::future<VkPipeline>> m_warming_pipelines;
+    Scene m_scene;
+    // per frame in flight, rewritten from the scene every frame and kept persistently mapped
+    std::array<VkBuffer, MAX_FRAMES_IN_FLIGHT> m_instance_buffers {};
+    std::array<VkDeviceMemory, MAX_FRAMES_IN_FLIGHT> m_instance_buffers_memory {};
+    std::array<void*, MAX_FRAMES_IN_FLIGHT> m_instance_buffers_mapped {};
+    std::array<size_t, MAX_FRAMES_IN_FLIGHT> m_instance_capacities {};
+
+    // Everything the renderer reads from the simulation for one frame, the drawables in object
+    // order. Written whole by gather_snapshot() and left alone once published.
+    struct FrameSnapshot {
+        uint64_t sequence = 0;
+        Clock::time_point produced {};
+        uint64_t structure_version = UINT64_MAX;
+        uint64_t transform_version = UINT64_MAX;
+        std::vector<Entity> entities;
+        std::vector<Bounds> bounds;
+        std::vector<Instance> instances;
+        std::vector<uint32_t> meshes;
+        std::vector<uint32_t> materials;
+        std::vector<glm::mat4> view_projections;
+        TextBatch text;
+    };
+
+    std::function<void(Scene&, float)> m_update;
+    float m_simulation_rate = 60.0f;
+    Clock::time_point m_last_step;
+    // simulation side, copied into every snapshot
+    std::vector<glm::mat4> m_view_projections;
+    TextBatch m_text_batch;
+    uint64_t m_transform_version = 0;
+    uint64_t m_snapshot_sequence = 0;
+    TripleBuffer<FrameSnapshot> m_snapshots;
+    std::atomic<bool> m_running = false;
+
+    // render side, built from the snapshots: the BVH over the drawables, their instances in slot
+    // order so visible subtrees can be copied out as whole ranges
+    Bvh m_bvh;
+    std::vector<Entity> m_cull_entities;
+    std::vector<Instance> m_slot_instances;
+    std::vector<uint32_t> m_slot_meshes;
+    std::vector<uint32_t> m_slot_materials;
+    uint64_t m_culled_structure_version = UINT64_MAX;
+    uint64_t m_culled_transform_version = UINT64_MAX;
 
     struct QueueFamilyIndices;
     struct SwapChainSupportDetails;
 
-    void destruct_swap_chain();
     bool check_validation_layer_support() const;
     void init_window();
+    void create_glfw_window(Window&, std::string const& title);
     static void framebuffer_resize_callback(GLFWwindow*, int, int);
     void set_required_instance_extensions();
     bool check_instance_extension_support() const;
@@ -88,32 +390,61 @@ private:
         void*);
     void populate_debug_messenger_create_info(VkDebugUtilsMessengerCreateInfoEXT&);
     void setup_debug_messenger();
-    void create_surface();
+    void create_surface(Window&);
     void init_vulkan();
     void pick_physical_device();
     QueueFamilyIndices find_queue_families(VkPhysicalDevice const&) const;
     bool check_device_extension_support(VkPhysicalDevice const&) const;
-    SwapChainSupportDetails query_swap_chain_support(VkPhysicalDevice const&) const;
+    SwapChainSupportDetails query_swap_chain_support(VkPhysicalDevice const&, VkSurfaceKHR) const;
     VkSurfaceFormatKHR choose_swap_surface_format(std::vector<VkSurfaceFormatKHR> const&) const;
     VkPresentModeKHR choose_swap_present_mode(std::vector<VkPresentModeKHR> const&) const;
-    VkExtent2D choose_swap_extent(VkSurfaceCapabilitiesKHR const&) const;
+    VkExtent2D choose_swap_extent(VkSurfaceCapabilitiesKHR const&, Window const&) const;
     bool is_device_suitable(VkPhysicalDevice const&) const;
     void create_logical_device();
-    void create_swap_chain();
-    void create_image_views();
-    VkShaderModule create_shader_module(std::vector<char> const&) const;
+    void create_swap_chain(Window&, VkSwapchainKHR old_swap_chain);
+    void create_scene_targets(Window&);
     void create_render_pass();
     void create_graphics_pipeline();
-    void create_framebuffers();
-    void recreate_swap_chain();
+    // the m_scene_pipelines index of the pipeline for `desc`, added if no material uses it yet
+    uint32_t scene_pipeline_slot(PipelineDesc const&);
+    void create_text_renderer();
+    void create_framebuffers(Window&);
+    void create_window_semaphores(Window&);
+    void create_window_command_buffers(Window&);
+    void create_window_targets(Window&, VkSwapchainKHR old_swap_chain);
+    void recreate_swap_chain(Window&);
+    void destroy_window_targets(WindowTargets&);
+    void retire_window_targets(WindowTargets&);
+    void destroy_window(Window&);
+    void close_window(uint32_t);
     void create_command_pool();
-    uint32_t find_memory_type(uint32_t const, VkMemoryPropertyFlags const&) const;
-    void create_vertex_buffer();
+    void create_instance_buffer(uint32_t const, size_t const);
+    void destroy_instance_buffer(uint32_t const);
+    void simulate(float dt);
+    void gather_snapshot(FrameSnapshot&);
+    void capture_frame(FrameSnapshot const&);
+    void update_culling(FrameSnapshot const&);
+    void update_instance_buffer(FrameSnapshot const&);
     void create_command_buffers();
-    void record_command_buffer(VkCommandBuffer, uint32_t const);
+    void create_query_pools();
+    void read_queries();
+    void end_frame_stats();
+    void update_render_extent(Window&);
+    bool acquire(Window&);
+    void present();
+    void record_command_buffer(VkCommandBuffer);
+    uint64_t layer_inputs_version() const;
+    void begin_layer(VkCommandBuffer, Window const&);
+    void set_viewport(VkCommandBuffer, Window const&);
+    void record_scene_draws(VkCommandBuffer, Window const&, std::array<uint64_t, COUNTER_COUNT>& counts);
+    void blit_to_swap_chain(VkCommandBuffer, Window const&);
     void create_sync_objects();
     void draw_frame();
+    void step();
     void loop();
+    void loop_threaded(uint32_t frame_count);
+    void simulation_loop();
+    void render_loop(uint32_t frame_count);
 };
 
 }
@@ -0,0 +1,307 @@
+#include <algorithm>
+#include <array>
+#include <deque>
+
+#include "bvh.hpp"
+
+namespace HB {
+
+static uint32_t const BIN_COUNT = 16;
+// cost of visiting a node relative to testing one object against it
+static float const TRAVERSAL_COST = 1.0f;
+// subtrees smaller than this are not worth handing to another thread
+static uint32_t const PARALLEL_BUILD_THRESHOLD = 4096;
+// refitting keeps the topology, rebuild once the SAH cost has grown by this much
+static float const REBUILD_COST_RATIO = 1.5f;
+
+void Bvh::build(std::vector<Bounds> const& bounds, ThreadPool* pool)
+{
+    uint32_t object_count = static_cast<uint32_t>(bounds.size());
+
+    m_nodes.clear();
+    m_slots.resize(object_count);
+    m_object_slots.resize(object_count);
+    m_slot_bounds.resize(object_count);
+    if (object_count == 0) {
+        m_cost = m_build_cost = 0.0f;
+        return;
+    }
+
+    // the build partitions these in place, so every pass over a subtree is a linear scan
+    m_primitives.resize(object_count);
+    for (uint32_t i = 0; i < object_count; i += 1)
+        m_primitives[i] = { bounds[i], i };
+
+    // a binary tree with at most one object per leaf never needs more nodes than this
+    m_nodes.resize(2 * object_count - 1);
+    std::atomic<uint32_t> next_node = 1;
+    BuildTask root = { 0, 0, object_count, 0 };
+
+    if (pool == nullptr || object_count < PARALLEL_BUILD_THRESHOLD) {
+        build_subtree(root, next_node);
+    } else {
+        // split the top of the tree breadth first until there are enough independent subtrees
+        // to keep every thread busy, then finish those in parallel
+        size_t target = 4 * (pool->worker_count() + 1);
+        std::deque<BuildTask> open = { root };
+        std::vector<BuildTask> subtrees;
+
+        while (!open.empty() && open.size() + subtrees.size() < target) {
+            BuildTask task = open.front();
+            open.pop_front();
+
+            BuildTask left, right;
+            if (task.count < PARALLEL_BUILD_THRESHOLD) {
+                subtrees.push_back(task);
+            } else if (split(task, next_node, left, right)) {
+                open.push_back(left);
+                open.push_back(right);
+            }
+        }
+        subtrees.insert(subtrees.end(), open.begin(), open.end());
+
+        pool->parallel_for(subtrees.size(), 1, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i += 1)
+                build_subtree(subtrees[i], next_node);
+        });
+    }
+
+    m_nodes.resize(next_node.load());
+    for (uint32_t slot = 0; slot < object_count; slot += 1) {
+        m_slots[slot] = m_primitives[slot].object;
+        m_slot_bounds[slot] = m_primitives[slot].bounds;
+        m_object_slots[m_primitives[slot].object] = slot;
+    }
+    m_primitives.clear();
+    m_primitives.shrink_to_fit();
+
+    m_cost = m_build_cost = compute_cost();
+}
+
+void Bvh::build_subtree(BuildTask const& root, std::atomic<uint32_t>& next_node)
+{
+    std::array<BuildTask, MAX_DEPTH * 2> stack;
+    uint32_t top = 0;
+    stack[top++] = root;
+
+    while (top > 0) {
+        BuildTask task = stack[--top];
+        BuildTask left, right;
+        if (split(task, next_node, left, right)) {
+            stack[top++] = right;
+            stack[top++] = left;
+        }
+    }
+}
+
+// Turns the task's node into a leaf (returns false) or an interior node with two new children.
+bool Bvh::split(BuildTask const& task, std::atomic<uint32_t>& next_node, BuildTask& left, BuildTask& right)
+{
+    BvhNode& node = m_nodes[task.node];
+
+    Bounds node_bounds = Bounds::empty();
+    Bounds centroid_bounds = Bounds::empty();
+    for (uint32_t slot = task.first; slot < task.first + task.count; slot += 1) {
+        node_bounds.grow(m_primitives[slot].bounds);
+        centroid_bounds.grow(m_primitives[slot].bounds.center());
+    }
+    node.min = node_bounds.min;
+    node.max = node_bounds.max;
+    node.left_first = task.first;
+    node.count = task.count;
+
+    if (task.count <= 1)
+        return false;
+
+    // binned SAH: cost of a split is area * count of both halves
+    float best_cost = std::numeric_limits<float>::infinity();
+    uint32_t best_axis = 0;
+    uint32_t best_split = 0;
+    glm::vec3 extent = centroid_bounds.max - centroid_bounds.min;
+
+    // one pass bins the objects along all three axes at once
+    std::array<std::array<Bounds, BIN_COUNT>, 3> bins;
+    std::array<std::array<uint32_t, BIN_COUNT>, 3> counts {};
+    for (auto& axis_bins : bins)
+        axis_bins.fill(Bounds::empty());
+
+    glm::vec3 scale = {
+        extent.x > 0.0f ? BIN_COUNT / extent.x : 0.0f,
+        extent.y > 0.0f ? BIN_COUNT / extent.y : 0.0f,
+        extent.z > 0.0f ? BIN_COUNT / extent.z : 0.0f,
+    };
+    for (uint32_t slot = task.first; slot < task.first + task.count; slot += 1) {
+        Bounds const& bounds = m_primitives[slot].bounds;
+        glm::vec3 offset = (bounds.center() - centroid_bounds.min) * scale;
+        for (uint32_t axis = 0; axis < 3; axis += 1) {
+            uint32_t bin = std::min(BIN_COUNT - 1, static_cast<uint32_t>(offset[axis]));
+            bins[axis][bin].grow(bounds);
+            counts[axis][bin] += 1;
+        }
+    }
+
+    for (uint32_t axis = 0; axis < 3; axis += 1) {
+        if (extent[axis] <= 0.0f)
+            continue;
+
+        // sweep from the right to get the area/count of every right half, then from the left
+        std::array<float, BIN_COUNT - 1> right_areas;
+        std::array<uint32_t, BIN_COUNT - 1> right_counts;
+        Bounds accumulated = Bounds::empty();
+        uint32_t accumulated_count = 0;
+        for (uint32_t i = BIN_COUNT - 1; i > 0; i -= 1) {
+            accumulated.grow(bins[axis][i]);
+            accumulated_count += counts[axis][i];
+            right_areas[i - 1] = accumulated.surface_area();
+            right_counts[i - 1] = accumulated_count;
+        }
+
+        accumulated = Bounds::empty();
+        accumulated_count = 0;
+        for (uint32_t i = 0; i < BIN_COUNT - 1; i += 1) {
+            accumulated.grow(bins[axis][i]);
+            accumulated_count += counts[axis][i];
+            if (accumulated_count == 0 || right_counts[i] == 0)
+                continue;
+
+            float cost = accumulated.surface_area() * accumulated_count + right_areas[i] * right_counts[i];
+            if (cost < best_cost) {
+                best_cost = cost;
+                best_axis = axis;
+                best_split = i;
+            }
+        }
+    }
+
+    // the depth limit keeps the fixed size traversal stacks safe on degenerate input, at the
+    // price of an oversized leaf
+    float leaf_cost = node_bounds.surface_area() * task.count;
+    float split_cost = node_bounds.surface_area() * TRAVERSAL_COST + best_cost;
+    if (task.depth + 1 >= MAX_DEPTH || (task.count <= MAX_LEAF_SIZE && split_cost >= leaf_cost))
+        return false;
+
+    uint32_t middle;
+    if (best_cost < std::numeric_limits<float>::infinity()) {
+        auto first = m_primitives.begin() + task.first;
+        auto split_point = std::partition(first, first + task.count, [&](BuildPrimitive const& primitive) {
+            uint32_t bin = std::min(BIN_COUNT - 1, static_cast<uint32_t>((primitive.bounds.center()[best_axis] - centroid_bounds.min[best_axis]) * scale[best_axis]));
+            return bin <= best_split;
+        });
+        middle = static_cast<uint32_t>(split_point - m_primitives.begin());
+    } else {
+        // all centroids coincide, any split is as good as another
+        middle = task.first + task.count / 2;
+    }
+
+    uint32_t children = next_node.fetch_add(2);
+    node.left_first = children;
+    node.count = 0;
+
+    left = { children, task.first, middle - task.first, task.depth + 1 };
+    right = { children + 1, middle, task.first + task.count - middle, task.depth + 1 };
+    return true;
+}
+
+void Bvh::subtree_slots(BvhNode const& node, uint32_t& first, uint32_t& count) const
+{
+    BvhNode const* leftmost = &node;
+    while (leftmost->count == 0)
+        leftmost = &m_nodes[leftmost->left_first];
+
+    BvhNode const* rightmost = &node;
+    while (rightmost->count == 0)
+        rightmost = &m_nodes[rightmost->left_first + 1];
+
+    first = leftmost->left_first;
+    count = rightmost->left_first + rightmost->count - first;
+}
+
+void Bvh::refit()
+{
+    // children always have higher indices than their parent, so a reverse sweep is bottom-up
+    for (size_t i = m_nodes.size(); i-- > 0;) {
+        BvhNode& node = m_nodes[i];
+        Bounds bounds = Bounds::empty();
+
+        if (node.count > 0) {
+            for (uint32_t slot = node.left_first; slot < node.left_first + node.count; slot += 1)
+                bounds.grow(m_slot_bounds[slot]);
+        } else {
+            BvhNode const& left = m_nodes[node.left_first];
+            BvhNode const& right = m_nodes[node.left_first + 1];
+            bounds = { glm::min(left.min, right.min), glm::max(left.max, right.max) };
+        }
+
+        node.min = bounds.min;
+        node.max = bounds.max;
+    }
+
+    m_cost = compute_cost();
+}
+
+bool Bvh::needs_rebuild() const
+{
+    return m_cost > m_build_cost * REBUILD_COST_RATIO;
+}
+
+float Bvh::compute_cost() const
+{
+    if (m_nodes.empty())
+        return 0.0f;
+
+    float total = 0.0f;
+    for (BvhNode const& node : m_nodes) {
+        float area = Bounds { node.min, node.max }.surface_area();
+        total += node.count > 0 ? area * node.count : area;
+    }
+
+    float root_area = Bounds { m_nodes[0].min, m_nodes[0].max }.surface_area();
+    return root_area > 0.0f ? total / root_area : 0.0f;
+}
+
+RayHit Bvh::raycast(Ray const& ray, float max_distance) const
+{
+    RayHit hit = { NO_OBJECT, max_distance };
+    if (m_nodes.empty())
+        return hit;
+
+    RayTest test(ray);
+    if (test.intersect({ m_nodes[0].min, m_nodes[0].max }, hit.distance) < 0.0f)
+        return hit;
+
+    uint32_t stack[MAX_DEPTH * 2];
+    uint32_t top = 0;
+    stack[top++] = 0;
+
+    while (top > 0) {
+        BvhNode const& node = m_nodes[stack[--top]];
+
+        if (node.count > 0) {
+            for (uint32_t slot = node.left_first; slot < node.left_first + node.count; slot += 1) {
+                float distance = test.intersect(m_slot_bounds[slot], hit.distance);
+                if (distance >= 0.0f && distance < hit.distance)
+                    hit = { m_slots[slot], distance };
+            }
+            continue;
+        }
+
+        // visit the nearer child first so the further one is likely culled by the closer hit
+        uint32_t near_child = node.left_first;
+        uint32_t far_child = node.left_first + 1;
+        float near_distance = test.intersect({ m_nodes[near_child].min, m_nodes[near_child].max }, hit.distance);
+        float far_distance = test.intersect({ m_nodes[far_child].min, m_nodes[far_child].max }, hit.distance);
+        if (far_distance >= 0.0f && (near_distance < 0.0f || far_distance < near_distance)) {
+            std::swap(near_child, far_child);
+            std::swap(near_distance, far_distance);
+        }
+
+        if (far_distance >= 0.0f)
+            stack[top++] = far_child;
+        if (near_distance >= 0.0f)
+            stack[top++] = near_child;
+    }
+
+    return hit;
+}
+
+}
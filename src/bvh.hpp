@@ -0,0 +1,160 @@
+#ifndef _HB_BVH
+#define _HB_BVH
+
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "geometry.hpp"
+#include "thread_pool.hpp"
+
+namespace HB {
+
+// Two nodes share a cache line, siblings are always allocated next to each other.
+struct alignas(32) BvhNode {
+    glm::vec3 min;
+    // leaves: first slot, interior nodes: index of the left child (right child follows it)
+    uint32_t left_first;
+    glm::vec3 max;
+    // number of slots in a leaf, 0 for interior nodes
+    uint32_t count;
+};
+
+static_assert(sizeof(BvhNode) == 32);
+
+struct RayHit {
+    uint32_t object;
+    float distance;
+};
+
+// Bounding volume hierarchy over object bounds, built with binned SAH. Objects are identified
+// by their index in the bounds passed to build(). Leaves reference contiguous "slots", which
+// are a permutation of the objects: every subtree covers one contiguous slot range, so callers
+// can keep their per-object data in slot order and copy visible ranges in one go.
+//
+// Moving objects are handled by update() + refit(), which keeps the topology, once the tree has
+// degraded too much needs_rebuild() asks for a fresh build().
+class Bvh {
+public:
+    static uint32_t const NO_OBJECT = UINT32_MAX;
+    static uint32_t const MAX_LEAF_SIZE = 4;
+    static uint32_t const MAX_DEPTH = 64;
+
+    void build(std::vector<Bounds> const& bounds, ThreadPool* pool = nullptr);
+    void update(uint32_t object, Bounds const& bounds) { m_slot_bounds[m_object_slots[object]] = bounds; }
+    void refit();
+    bool needs_rebuild() const;
+
+    size_t object_count() const { return m_slots.size(); }
+    size_t node_count() const { return m_nodes.size(); }
+    // slot -> object
+    std::vector<uint32_t> const& slots() const { return m_slots; }
+    Bounds const& bounds(uint32_t object) const { return m_slot_bounds[m_object_slots[object]]; }
+    // SAH cost relative to the root surface area, lower is better
+    float cost() const { return m_cost; }
+
+    // visit(uint32_t first_slot, uint32_t slot_count) for every run of slots whose objects are
+    // (at least partially) inside the frustum
+    template<typename F>
+    void query_frustum(Frustum const& frustum, F&& visit) const
+    {
+        if (m_nodes.empty())
+            return;
+
+        uint32_t stack[MAX_DEPTH * 2];
+        uint32_t top = 0;
+        stack[top++] = 0;
+
+        while (top > 0) {
+            BvhNode const& node = m_nodes[stack[--top]];
+
+            Containment containment = frustum.classify({ node.min, node.max });
+            if (containment == Containment::OUTSIDE)
+                continue;
+
+            if (containment == Containment::INSIDE) {
+                // no more plane tests needed anywhere below, emit the whole range
+                uint32_t first, count;
+                subtree_slots(node, first, count);
+                visit(first, count);
+            } else if (node.count > 0) {
+                for (uint32_t slot = node.left_first; slot < node.left_first + node.count; slot += 1) {
+                    if (frustum.classify(m_slot_bounds[slot]) != Containment::OUTSIDE)
+                        visit(slot, 1u);
+                }
+            } else {
+                stack[top++] = node.left_first;
+                stack[top++] = node.left_first + 1;
+            }
+        }
+    }
+
+    // visit(uint32_t first_slot, uint32_t slot_count) for runs of objects overlapping the box
+    template<typename F>
+    void query_range(Bounds const& range, F&& visit) const
+    {
+        if (m_nodes.empty())
+            return;
+
+        uint32_t stack[MAX_DEPTH * 2];
+        uint32_t top = 0;
+        stack[top++] = 0;
+
+        while (top > 0) {
+            BvhNode const& node = m_nodes[stack[--top]];
+            Bounds node_bounds = { node.min, node.max };
+
+            if (!range.overlaps(node_bounds))
+                continue;
+
+            if (range.contains(node_bounds)) {
+                uint32_t first, count;
+                subtree_slots(node, first, count);
+                visit(first, count);
+            } else if (node.count > 0) {
+                for (uint32_t slot = node.left_first; slot < node.left_first + node.count; slot += 1) {
+                    if (range.overlaps(m_slot_bounds[slot]))
+                        visit(slot, 1u);
+                }
+            } else {
+                stack[top++] = node.left_first;
+                stack[top++] = node.left_first + 1;
+            }
+        }
+    }
+
+    // closest object whose bounds the ray enters, object is NO_OBJECT on a miss
+    RayHit raycast(Ray const&, float max_distance = std::numeric_limits<float>::infinity()) const;
+
+private:
+    struct BuildPrimitive {
+        Bounds bounds;
+        uint32_t object;
+    };
+
+    struct BuildTask {
+        uint32_t node;
+        uint32_t first;
+        uint32_t count;
+        uint32_t depth;
+    };
+
+    std::vector<BvhNode> m_nodes;
+    std::vector<uint32_t> m_slots;
+    std::vector<uint32_t> m_object_slots;
+    // kept in slot order so leaves and refitting read memory sequentially
+    std::vector<Bounds> m_slot_bounds;
+    std::vector<BuildPrimitive> m_primitives;
+    float m_cost = 0.0f;
+    float m_build_cost = 0.0f;
+
+    void subtree_slots(BvhNode const&, uint32_t& first, uint32_t& count) const;
+    bool split(BuildTask const&, std::atomic<uint32_t>& next_node, BuildTask& left, BuildTask& right);
+    void build_subtree(BuildTask const&, std::atomic<uint32_t>& next_node);
+    float compute_cost() const;
+};
+
+}
+
+#endif
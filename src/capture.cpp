@@ -0,0 +1,330 @@
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include "capture.hpp"
+
+namespace HB {
+
+// "HBCP", bumped whenever a record changes
+static uint32_t const MAGIC = 0x50434248;
+static uint32_t const VERSION = 2;
+
+CaptureWriter::CaptureWriter(std::string const& path, uint32_t width, uint32_t height)
+    : m_file(path, std::ios::binary)
+{
+    if (!m_file.is_open())
+        throw std::runtime_error("failed to open capture file!");
+
+    uint32_t header[] = { MAGIC, VERSION, width, height };
+    m_file.write(reinterpret_cast<char const*>(header), sizeof(header));
+}
+
+CaptureWriter::~CaptureWriter()
+{
+    m_file.flush();
+}
+
+void CaptureWriter::put(void const* data, size_t size)
+{
+    size_t offset = m_record.size();
+    m_record.resize(offset + size);
+    std::memcpy(m_record.data() + offset, data, size);
+}
+
+void CaptureWriter::put(std::string const& string)
+{
+    put(static_cast<uint32_t>(string.size()));
+    put(string.data(), string.size());
+}
+
+void CaptureWriter::put(PipelineDesc const& desc)
+{
+    put(desc.vertex_shader);
+    put(desc.fragment_shader);
+    put(static_cast<uint32_t>(desc.topology));
+    put(static_cast<uint32_t>(desc.cull_mode));
+    put(static_cast<uint32_t>(desc.front_face));
+    put(static_cast<uint32_t>(desc.blend));
+    put(desc.specialization_count);
+    put(desc.specialization);
+}
+
+void CaptureWriter::write(CaptureRecord kind)
+{
+    uint32_t tag = static_cast<uint32_t>(kind);
+    uint64_t size = m_record.size();
+    m_file.write(reinterpret_cast<char const*>(&tag), sizeof(tag));
+    m_file.write(reinterpret_cast<char const*>(&size), sizeof(size));
+    m_file.write(reinterpret_cast<char const*>(m_record.data()), static_cast<std::streamsize>(size));
+    m_record.clear();
+}
+
+void CaptureWriter::texture(VkFormat format, uint32_t width, uint32_t height, std::vector<ImageFile::Level> const& levels, std::byte const* data)
+{
+    std::lock_guard lock(m_mutex);
+    put(static_cast<uint32_t>(format));
+    put(width);
+    put(height);
+    put(static_cast<uint32_t>(levels.size()));
+    for (ImageFile::Level const& level : levels) {
+        put(level.width);
+        put(level.height);
+        put(static_cast<uint64_t>(level.size));
+    }
+    // packed back to back, whatever the layout of the source was
+    for (ImageFile::Level const& level : levels)
+        put(data + level.offset, level.size);
+    write(CaptureRecord::TEXTURE);
+}
+
+void CaptureWriter::mesh(MeshData const& data, LodSettings const& settings)
+{
+    std::lock_guard lock(m_mutex);
+    put(settings);
+    put(static_cast<uint32_t>(data.vertices.size()));
+    put(static_cast<uint32_t>(data.indices.size()));
+    put(data.vertices.data(), data.vertices.size() * sizeof(Vertex));
+    put(data.indices.data(), data.indices.size() * sizeof(uint32_t));
+    write(CaptureRecord::MESH);
+}
+
+void CaptureWriter::material(PipelineDesc const& desc, uint32_t texture)
+{
+    std::lock_guard lock(m_mutex);
+    put(desc);
+    put(texture);
+    write(CaptureRecord::MATERIAL);
+}
+
+void CaptureWriter::scene_pipeline(PipelineDesc const& desc)
+{
+    std::lock_guard lock(m_mutex);
+    put(desc);
+    write(CaptureRecord::SCENE_PIPELINE);
+}
+
+void CaptureWriter::post_chain(std::vector<PostEffect> const& chain, PostSettings const& settings)
+{
+    std::lock_guard lock(m_mutex);
+    put(static_cast<uint32_t>(chain.size()));
+    put(chain.data(), chain.size() * sizeof(PostEffect));
+    put(settings);
+    write(CaptureRecord::POST_CHAIN);
+}
+
+void CaptureWriter::scene(bool structure_changed, std::vector<CapturedEntity> const& entities)
+{
+    std::lock_guard lock(m_mutex);
+    put(static_cast<uint32_t>(structure_changed));
+    put(static_cast<uint32_t>(entities.size()));
+    put(entities.data(), entities.size() * sizeof(CapturedEntity));
+    write(CaptureRecord::SCENE);
+}
+
+void CaptureWriter::frame(CapturedFrame const& frame)
+{
+    std::lock_guard lock(m_mutex);
+    put(frame.seconds);
+    put(static_cast<uint32_t>(frame.sort_draws));
+    put(static_cast<uint32_t>(frame.meshlet_culling));
+    put(static_cast<uint32_t>(frame.cache_command_buffers));
+    put(frame.max_instances_per_draw);
+    put(frame.lod_threshold);
+    put(static_cast<uint32_t>(frame.views.size()));
+    put(frame.views.data(), frame.views.size() * sizeof(CapturedView));
+    put(static_cast<uint32_t>(frame.text.labels.size()));
+    put(static_cast<uint32_t>(frame.text.characters.size()));
+    put(frame.text.labels.data(), frame.text.labels.size() * sizeof(TextLabel));
+    put(frame.text.characters.data(), frame.text.characters.size());
+    write(CaptureRecord::FRAME);
+    m_frame_count += 1;
+}
+
+CaptureReader::CaptureReader(std::string const& path)
+    : m_file(path, std::ios::binary)
+{
+    if (!m_file.is_open())
+        throw std::runtime_error("failed to open capture file!");
+    m_file.seekg(0, std::ios::end);
+    m_file_size = static_cast<uint64_t>(m_file.tellg());
+    m_file.seekg(0, std::ios::beg);
+
+    uint32_t header[4] = {};
+    if (!m_file.read(reinterpret_cast<char*>(header), sizeof(header)) || header[0] != MAGIC)
+        throw std::runtime_error("failed to read capture, it isn't one!");
+    if (header[1] != VERSION)
+        throw std::runtime_error("failed to read capture, it was written by another version!");
+    m_width = header[2];
+    m_height = header[3];
+}
+
+void CaptureReader::get(void* data, size_t size)
+{
+    if (size > m_record.size() - m_offset)
+        throw std::runtime_error("failed to read capture, a record is too short!");
+    std::memcpy(data, m_record.data() + m_offset, size);
+    m_offset += size;
+}
+
+uint32_t CaptureReader::get_count(size_t element_size)
+{
+    uint32_t count = get<uint32_t>();
+    if (element_size > 0 && count > (m_record.size() - m_offset) / element_size)
+        throw std::runtime_error("failed to read capture, a record is too short!");
+    return count;
+}
+
+std::string CaptureReader::get_string()
+{
+    std::string string(get_count(1), '\0');
+    get(string.data(), string.size());
+    return string;
+}
+
+PipelineDesc CaptureReader::get_pipeline()
+{
+    PipelineDesc desc {};
+    desc.vertex_shader = get_string();
+    desc.fragment_shader = get_string();
+    desc.topology = static_cast<VkPrimitiveTopology>(get<uint32_t>());
+    desc.cull_mode = static_cast<VkCullModeFlags>(get<uint32_t>());
+    desc.front_face = static_cast<VkFrontFace>(get<uint32_t>());
+    desc.blend = static_cast<BlendMode>(get<uint32_t>());
+    desc.specialization_count = get<uint32_t>();
+    desc.specialization = get<std::array<uint32_t, PipelineDesc::MAX_SPECIALIZATION_CONSTANTS>>();
+    if (desc.blend > BlendMode::ADDITIVE || desc.specialization_count > PipelineDesc::MAX_SPECIALIZATION_CONSTANTS)
+        throw std::runtime_error("failed to read capture, a pipeline is invalid!");
+    return desc;
+}
+
+bool CaptureReader::next(CaptureEvent& event)
+{
+    uint32_t tag;
+    uint64_t size;
+    while (true) {
+        if (!m_file.read(reinterpret_cast<char*>(&tag), sizeof(tag)))
+            return false;
+        if (!m_file.read(reinterpret_cast<char*>(&size), sizeof(size)))
+            throw std::runtime_error("failed to read capture, it ends in a record!");
+        // the size comes from the file, nothing is skipped or allocated past its end
+        uint64_t position = static_cast<uint64_t>(m_file.tellg());
+        if (size > m_file_size - position)
+            throw std::runtime_error("failed to read capture, it ends in a record!");
+        // newer kinds are skipped
+        if (tag <= static_cast<uint32_t>(CaptureRecord::FRAME))
+            break;
+        m_file.seekg(static_cast<std::streamoff>(size), std::ios::cur);
+    }
+
+    m_record.resize(size);
+    m_offset = 0;
+    if (!m_file.read(reinterpret_cast<char*>(m_record.data()), static_cast<std::streamsize>(size)))
+        throw std::runtime_error("failed to read capture, it ends in a record!");
+
+    event.kind = static_cast<CaptureRecord>(tag);
+    switch (event.kind) {
+    case CaptureRecord::TEXTURE: {
+        ImageFile& image = event.image;
+        image.format = static_cast<VkFormat>(get<uint32_t>());
+        image.width = get<uint32_t>();
+        image.height = get<uint32_t>();
+        // clang-format off
+        if (!is_supported_image_format(image.format)
+            || image.width == 0
+            || image.height == 0
+            || image.width > MAX_IMAGE_DIMENSION
+            || image.height > MAX_IMAGE_DIMENSION)
+            throw std::runtime_error("failed to read capture, a texture has an invalid format or size!");
+        // clang-format on
+        image.levels.resize(get_count(sizeof(uint32_t) * 2 + sizeof(uint64_t)));
+        if (image.levels.empty() || image.levels.size() > full_mip_count(image.width, image.height))
+            throw std::runtime_error("failed to read capture, a texture has an invalid number of levels!");
+        // every level has to be the size its format and extent make it, which also keeps the sum
+        // from wrapping around
+        size_t offset = 0;
+        uint32_t width = image.width;
+        uint32_t height = image.height;
+        for (ImageFile::Level& level : image.levels) {
+            level.width = get<uint32_t>();
+            level.height = get<uint32_t>();
+            uint64_t level_size = get<uint64_t>();
+            if (level.width != width || level.height != height || level_size != image_level_size(image.format, width, height))
+                throw std::runtime_error("failed to read capture, a texture level doesn't match its format and size!");
+            level.size = static_cast<size_t>(level_size);
+            level.offset = offset;
+            offset += level.size;
+            width = std::max(width / 2, 1u);
+            height = std::max(height / 2, 1u);
+        }
+        if (offset > m_record.size() - m_offset)
+            throw std::runtime_error("failed to read capture, a record is too short!");
+        image.data.resize(offset);
+        get(image.data.data(), offset);
+        break;
+    }
+    case CaptureRecord::MESH: {
+        event.lod_settings = get<LodSettings>();
+        uint32_t vertex_count = get<uint32_t>();
+        uint32_t index_count = get<uint32_t>();
+        if (vertex_count > (m_record.size() - m_offset) / sizeof(Vertex))
+            throw std::runtime_error("failed to read capture, a record is too short!");
+        event.mesh.vertices.resize(vertex_count);
+        get(event.mesh.vertices.data(), event.mesh.vertices.size() * sizeof(Vertex));
+        if (index_count > (m_record.size() - m_offset) / sizeof(uint32_t))
+            throw std::runtime_error("failed to read capture, a record is too short!");
+        event.mesh.indices.resize(index_count);
+        get(event.mesh.indices.data(), event.mesh.indices.size() * sizeof(uint32_t));
+        if (std::any_of(event.mesh.indices.begin(), event.mesh.indices.end(), [vertex_count](uint32_t index) { return index >= vertex_count; }))
+            throw std::runtime_error("failed to read capture, a mesh has indices past its vertices!");
+        break;
+    }
+    case CaptureRecord::MATERIAL:
+        event.pipeline = get_pipeline();
+        event.texture = get<uint32_t>();
+        break;
+    case CaptureRecord::SCENE_PIPELINE:
+        event.pipeline = get_pipeline();
+        break;
+    case CaptureRecord::POST_CHAIN:
+        event.post_chain.resize(get_count(sizeof(PostEffect)));
+        get(event.post_chain.data(), event.post_chain.size() * sizeof(PostEffect));
+        if (std::any_of(event.post_chain.begin(), event.post_chain.end(), [](PostEffect effect) { return effect > PostEffect::TONEMAP; }))
+            throw std::runtime_error("failed to read capture, a post effect is unknown!");
+        event.post_settings = get<PostSettings>();
+        break;
+    case CaptureRecord::SCENE:
+        event.structure_changed = get<uint32_t>() != 0;
+        event.entities.resize(get_count(sizeof(CapturedEntity)));
+        get(event.entities.data(), event.entities.size() * sizeof(CapturedEntity));
+        break;
+    case CaptureRecord::FRAME: {
+        CapturedFrame& frame = event.frame;
+        frame.seconds = get<double>();
+        frame.sort_draws = get<uint32_t>() != 0;
+        frame.meshlet_culling = get<uint32_t>() != 0;
+        frame.cache_command_buffers = get<uint32_t>() != 0;
+        frame.max_instances_per_draw = get<uint32_t>();
+        frame.lod_threshold = get<float>();
+        frame.views.resize(get_count(sizeof(CapturedView)));
+        get(frame.views.data(), frame.views.size() * sizeof(CapturedView));
+        uint32_t label_count = get<uint32_t>();
+        uint32_t character_count = get<uint32_t>();
+        if (label_count > (m_record.size() - m_offset) / sizeof(TextLabel))
+            throw std::runtime_error("failed to read capture, a record is too short!");
+        frame.text.labels.resize(label_count);
+        get(frame.text.labels.data(), frame.text.labels.size() * sizeof(TextLabel));
+        if (character_count > m_record.size() - m_offset)
+            throw std::runtime_error("failed to read capture, a record is too short!");
+        frame.text.characters.resize(character_count);
+        get(frame.text.characters.data(), frame.text.characters.size());
+        for (TextLabel const& label : frame.text.labels) {
+            if (label.first > character_count || label.length > character_count - label.first)
+                throw std::runtime_error("failed to read capture, a label's text is out of bounds!");
+        }
+        break;
+    }
+    }
+    return true;
+}
+}
@@ -0,0 +1,156 @@
+#ifndef _HB_CAPTURE
+#define _HB_CAPTURE
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "geometry.hpp"
+#include "image_file.hpp"
+#include "mesh_data.hpp"
+#include "pipeline.hpp"
+#include "post.hpp"
+#include "scene.hpp"
+#include "text.hpp"
+
+namespace HB {
+
+enum class CaptureRecord : uint32_t {
+    TEXTURE,
+    MESH,
+    MATERIAL,
+    SCENE_PIPELINE,
+    POST_CHAIN,
+    // the drawables, only when they changed since the one before
+    SCENE,
+    FRAME,
+};
+
+// one drawable, the components App draws it from
+struct CapturedEntity {
+    Transform transform;
+    Bounds bounds;
+    Renderable renderable;
+};
+
+struct CapturedView {
+    // 0 for a closed window
+    uint32_t width;
+    uint32_t height;
+    glm::mat4 view_projection;
+};
+
+// everything about a frame that isn't the scene or loaded once
+struct CapturedFrame {
+    // since the capture started, when it was drawn
+    double seconds = 0.0;
+    bool sort_draws = true;
+    bool meshlet_culling = true;
+    bool cache_command_buffers = true;
+    uint32_t max_instances_per_draw = UINT32_MAX;
+    float lod_threshold = 0.0f;
+    std::vector<CapturedView> views;
+    TextBatch text;
+};
+
+// One record as read back, only the fields of its kind are filled in. Kept between calls to
+// CaptureReader::next() so its vectors are reused.
+struct CaptureEvent {
+    CaptureRecord kind;
+    ImageFile image;
+    MeshData mesh;
+    LodSettings lod_settings;
+    PipelineDesc pipeline;
+    uint32_t texture = 0;
+    std::vector<PostEffect> post_chain;
+    PostSettings post_settings;
+    bool structure_changed = false;
+    std::vector<CapturedEntity> entities;
+    CapturedFrame frame;
+};
+
+// Records what App is asked to draw rather than how the application got there: textures and
+// meshes as they are created, materials, the scene pipeline and post chain, and for every drawn
+// frame its views, text and, when it changed, the scene. Replaying that through a headless App
+// (tools/replay.cpp) issues the same uploads, draws and binds without the application.
+//
+// The file is a short header followed by tagged records, each with its size so readers can skip
+// kinds they don't know. Components are stored as they are in memory, so a capture is read back
+// by a build for the same platform. Thread safe, resources are created on the main thread while
+// the render thread writes frames.
+class CaptureWriter {
+public:
+    CaptureWriter(std::string const& path, uint32_t width, uint32_t height);
+    ~CaptureWriter();
+    CaptureWriter(CaptureWriter const&) = delete;
+    CaptureWriter& operator=(CaptureWriter const&) = delete;
+
+    void texture(VkFormat, uint32_t width, uint32_t height, std::vector<ImageFile::Level> const&, std::byte const* data);
+    void mesh(MeshData const&, LodSettings const&);
+    void material(PipelineDesc const&, uint32_t texture);
+    void scene_pipeline(PipelineDesc const&);
+    void post_chain(std::vector<PostEffect> const&, PostSettings const&);
+    void scene(bool structure_changed, std::vector<CapturedEntity> const&);
+    void frame(CapturedFrame const&);
+    uint64_t frame_count() const { return m_frame_count; }
+
+private:
+    std::mutex m_mutex;
+    std::ofstream m_file;
+    // the record being written, reused
+    std::vector<std::byte> m_record;
+    uint64_t m_frame_count = 0;
+
+    void put(void const* data, size_t size);
+    template<typename T>
+    void put(T const& value) { put(&value, sizeof(T)); }
+    void put(std::string const&);
+    void put(PipelineDesc const&);
+    void write(CaptureRecord);
+};
+
+class CaptureReader {
+public:
+    // throws if it isn't a capture
+    CaptureReader(std::string const& path);
+    CaptureReader(CaptureReader const&) = delete;
+    CaptureReader& operator=(CaptureReader const&) = delete;
+
+    // the main window's size when capturing started
+    uint32_t width() const { return m_width; }
+    uint32_t height() const { return m_height; }
+    // False at the end of the file. Throws if it ends in the middle of a record or a record
+    // doesn't hold together (sizes, levels, indices, text ranges), replay hands them to the engine
+    // as they are.
+    bool next(CaptureEvent&);
+
+private:
+    std::ifstream m_file;
+    uint64_t m_file_size = 0;
+    uint32_t m_width;
+    uint32_t m_height;
+    std::vector<std::byte> m_record;
+    size_t m_offset = 0;
+
+    void get(void* data, size_t size);
+    template<typename T>
+    T get()
+    {
+        T value;
+        get(&value, sizeof(T));
+        return value;
+    }
+    // a count of elements that follow, throws if the record can't hold that many
+    uint32_t get_count(size_t element_size);
+    std::string get_string();
+    PipelineDesc get_pipeline();
+};
+
+}
+
+#endif
@@ -0,0 +1,145 @@
+#include <iterator>
+
+#include "deletion_queue.hpp"
+#include "stats.hpp"
+
+namespace HB {
+
+namespace {
+
+    // the lists are in frame order, so everything due is at the front
+    template<typename List, typename F>
+    void destroy_due(List& list, uint64_t frame, bool all, F&& destroy)
+    {
+        size_t due = 0;
+        while (due < list.size() && (all || list[due].first <= frame)) {
+            destroy(list[due].second);
+            due += 1;
+        }
+        list.erase(list.begin(), list.begin() + due);
+    }
+
+}
+
+DeletionQueue::DeletionQueue(GpuContext const& gpu)
+    : m_gpu(gpu)
+{
+}
+
+DeletionQueue::~DeletionQueue()
+{
+    flush();
+}
+
+void DeletionQueue::retire_buffer(VkBuffer buffer, VkDeviceMemory memory)
+{
+    std::lock_guard lock(m_mutex);
+    m_buffers.emplace_back(m_frame, std::pair(buffer, memory));
+}
+
+void DeletionQueue::retire_image(VkImage image, VkDeviceMemory memory)
+{
+    std::lock_guard lock(m_mutex);
+    m_images.emplace_back(m_frame, std::pair(image, memory));
+}
+
+void DeletionQueue::retire_image_view(VkImageView image_view)
+{
+    std::lock_guard lock(m_mutex);
+    m_image_views.emplace_back(m_frame, image_view);
+}
+
+void DeletionQueue::retire_framebuffer(VkFramebuffer framebuffer)
+{
+    std::lock_guard lock(m_mutex);
+    m_framebuffers.emplace_back(m_frame, framebuffer);
+}
+
+void DeletionQueue::retire_pipeline(VkPipeline pipeline)
+{
+    std::lock_guard lock(m_mutex);
+    m_pipelines.emplace_back(m_frame, pipeline);
+}
+
+void DeletionQueue::retire_memory(VkDeviceMemory memory)
+{
+    std::lock_guard lock(m_mutex);
+    m_memory.emplace_back(m_frame, memory);
+}
+
+void DeletionQueue::retire_semaphore(VkSemaphore semaphore)
+{
+    std::lock_guard lock(m_mutex);
+    m_semaphores.emplace_back(m_frame, semaphore);
+}
+
+void DeletionQueue::retire_swap_chain(VkSwapchainKHR swap_chain)
+{
+    std::lock_guard lock(m_mutex);
+    m_swap_chains.emplace_back(m_frame, swap_chain);
+}
+
+void DeletionQueue::retire(std::function<void()> destroy)
+{
+    std::lock_guard lock(m_mutex);
+    m_callbacks.emplace_back(m_frame, std::move(destroy));
+}
+
+void DeletionQueue::set_frame(uint64_t frame)
+{
+    std::lock_guard lock(m_mutex);
+    m_frame = frame;
+}
+
+void DeletionQueue::collect(uint64_t frame)
+{
+    collect(frame, false);
+}
+
+void DeletionQueue::flush()
+{
+    collect(0, true);
+}
+
+size_t DeletionQueue::size() const
+{
+    std::lock_guard lock(m_mutex);
+    // clang-format off
+    return m_framebuffers.size() + m_pipelines.size() + m_image_views.size() + m_images.size()
+        + m_buffers.size() + m_memory.size() + m_semaphores.size() + m_swap_chains.size()
+        + m_callbacks.size();
+    // clang-format on
+}
+
+void DeletionQueue::collect(uint64_t frame, bool all)
+{
+    List<std::function<void()>> callbacks;
+    {
+        std::lock_guard lock(m_mutex);
+        VkDevice device = m_gpu.device;
+        destroy_due(m_framebuffers, frame, all, [device](VkFramebuffer framebuffer) { vkDestroyFramebuffer(device, framebuffer, nullptr); });
+        destroy_due(m_pipelines, frame, all, [device](VkPipeline pipeline) {
+            vkDestroyPipeline(device, pipeline, nullptr);
+            Stats::count(Counter::OBJECTS_DESTROYED);
+        });
+        destroy_due(m_image_views, frame, all, [this](VkImageView image_view) { Gpu::destroy_image_view(m_gpu, image_view); });
+        destroy_due(m_images, frame, all, [this](auto const& image) { Gpu::destroy_image(m_gpu, image.first, image.second); });
+        destroy_due(m_buffers, frame, all, [this](auto const& buffer) { Gpu::destroy_buffer(m_gpu, buffer.first, buffer.second); });
+        destroy_due(m_memory, frame, all, [this](VkDeviceMemory memory) { Gpu::free_memory(m_gpu, memory); });
+        destroy_due(m_semaphores, frame, all, [device](VkSemaphore semaphore) { vkDestroySemaphore(device, semaphore, nullptr); });
+        destroy_due(m_swap_chains, frame, all, [device](VkSwapchainKHR swap_chain) { vkDestroySwapchainKHR(device, swap_chain, nullptr); });
+
+        // callbacks may retire more, so they run without the lock
+        if (!m_callbacks.empty() && (all || m_callbacks.front().first <= frame)) {
+            size_t due = 0;
+            while (due < m_callbacks.size() && (all || m_callbacks[due].first <= frame))
+                due += 1;
+            callbacks.assign(std::make_move_iterator(m_callbacks.begin()), std::make_move_iterator(m_callbacks.begin() + due));
+            m_callbacks.erase(m_callbacks.begin(), m_callbacks.begin() + due);
+        }
+    }
+    for (auto& callback : callbacks)
+        callback.second();
+}
+
+}
@@ -0,0 +1,71 @@
+#ifndef _HB_DELETION_QUEUE
+#define _HB_DELETION_QUEUE
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "gpu.hpp"
+
+namespace HB {
+
+// GPU objects that frames in flight may still use, destroyed once those frames are done instead
+// of waiting for the device. Everything retired is tagged with the frame being recorded (see
+// set_frame()), and collect() destroys what belongs to frames the GPU is past. Objects of one
+// frame go in dependency order: framebuffers before their views, views before their images.
+// Thread safe, so managers can replace resources from any thread.
+class DeletionQueue {
+public:
+    DeletionQueue(GpuContext const&);
+    // flushes, the device has to be idle by then
+    ~DeletionQueue();
+    DeletionQueue(DeletionQueue const&) = delete;
+    DeletionQueue& operator=(DeletionQueue const&) = delete;
+
+    void retire_buffer(VkBuffer, VkDeviceMemory);
+    void retire_image(VkImage, VkDeviceMemory);
+    void retire_image_view(VkImageView);
+    void retire_framebuffer(VkFramebuffer);
+    void retire_pipeline(VkPipeline);
+    void retire_memory(VkDeviceMemory);
+    void retire_semaphore(VkSemaphore);
+    void retire_swap_chain(VkSwapchainKHR);
+    // for anything else, like what belongs to the instance or the window system, runs after the
+    // frame's objects are destroyed
+    void retire(std::function<void()>);
+
+    // what is retired from now on may be used by this frame and the ones before it
+    void set_frame(uint64_t frame);
+    // destroys everything retired up to and including `frame`, call it once that frame's fence
+    // has been waited on
+    void collect(uint64_t frame);
+    // destroys everything, the device has to be idle
+    void flush();
+    size_t size() const;
+
+private:
+    template<typename T>
+    using List = std::vector<std::pair<uint64_t, T>>;
+
+    GpuContext m_gpu;
+    mutable std::mutex m_mutex;
+    uint64_t m_frame = 0;
+    List<VkFramebuffer> m_framebuffers;
+    List<VkPipeline> m_pipelines;
+    List<VkImageView> m_image_views;
+    List<std::pair<VkImage, VkDeviceMemory>> m_images;
+    List<std::pair<VkBuffer, VkDeviceMemory>> m_buffers;
+    List<VkDeviceMemory> m_memory;
+    List<VkSemaphore> m_semaphores;
+    List<VkSwapchainKHR> m_swap_chains;
+    List<std::function<void()>> m_callbacks;
+
+    void collect(uint64_t frame, bool all);
+};
+
+}
+
+#endif
@@ -0,0 +1,41 @@
+#include <algorithm>
+#include <bit>
+
+#include "frame_arena.hpp"
+
+namespace HB {
+
+FrameArena::FrameArena(size_t capacity)
+    : m_block(std::make_unique<std::byte[]>(capacity))
+    , m_capacity(capacity)
+{
+}
+
+void* FrameArena::allocate(size_t size, size_t alignment)
+{
+    // new[] only aligns to max_align_t, so that is the limit here too
+    alignment = std::min(alignment, alignof(std::max_align_t));
+    size_t offset = (m_offset + alignment - 1) & ~(alignment - 1);
+    if (offset + size <= m_capacity) {
+        m_offset = offset + size;
+        return m_block.get() + offset;
+    }
+
+    m_overflow.push_back(std::make_unique<std::byte[]>(size));
+    m_overflow_used += size;
+    return m_overflow.back().get();
+}
+
+void FrameArena::reset()
+{
+    if (!m_overflow.empty()) {
+        // with some slack for alignment padding, so the same frame fits next time
+        m_capacity = std::bit_ceil(m_offset + m_overflow_used + m_overflow.size() * alignof(std::max_align_t));
+        m_block = std::make_unique<std::byte[]>(m_capacity);
+        m_overflow.clear();
+        m_overflow_used = 0;
+    }
+    m_offset = 0;
+}
+
+}
@@ -0,0 +1,45 @@
+#ifndef _HB_FRAME_ARENA
+#define _HB_FRAME_ARENA
+
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace HB {
+
+// Bump allocator for CPU data that only lives until its frame's fence has been waited on.
+// Allocating is a pointer bump and reset() drops everything at once, nothing gets destructed.
+// When a frame needs more than the capacity the rest comes from overflow blocks, and the next
+// reset() grows the main block to fit, so a steady state never touches the heap.
+class FrameArena {
+public:
+    explicit FrameArena(size_t capacity = 1 << 20);
+    FrameArena(FrameArena const&) = delete;
+    FrameArena& operator=(FrameArena const&) = delete;
+
+    void* allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+    template<typename T>
+    T* allocate(size_t count)
+    {
+        static_assert(std::is_trivially_destructible_v<T>, "arena memory is never destructed");
+        return static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+    }
+
+    void reset();
+    size_t capacity() const { return m_capacity; }
+    // bytes handed out since the last reset, overflow included
+    size_t used() const { return m_offset + m_overflow_used; }
+
+private:
+    std::unique_ptr<std::byte[]> m_block;
+    size_t m_capacity;
+    size_t m_offset = 0;
+    std::vector<std::unique_ptr<std::byte[]>> m_overflow;
+    size_t m_overflow_used = 0;
+};
+
+}
+
+#endif
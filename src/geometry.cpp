@@ -0,0 +1,76 @@
+#include <algorithm>
+
+#include "geometry.hpp"
+
+namespace HB {
+
+RayTest::RayTest(Ray const& ray)
+    : origin(ray.origin)
+    , inverse_direction(1.0f / ray.direction.x, 1.0f / ray.direction.y, 1.0f / ray.direction.z)
+{
+}
+
+float RayTest::intersect(Bounds const& bounds, float max_t) const
+{
+    glm::vec3 t0 = (bounds.min - origin) * inverse_direction;
+    glm::vec3 t1 = (bounds.max - origin) * inverse_direction;
+    glm::vec3 near = glm::min(t0, t1);
+    glm::vec3 far = glm::max(t0, t1);
+
+    float entry = std::max({ near.x, near.y, near.z, 0.0f });
+    float exit = std::min({ far.x, far.y, far.z, max_t });
+
+    return entry <= exit ? entry : -1.0f;
+}
+
+Frustum Frustum::from_matrix(glm::mat4 const& m)
+{
+    // rows of the matrix, glm is column major
+    glm::vec4 row0 = { m[0][0], m[1][0], m[2][0], m[3][0] };
+    glm::vec4 row1 = { m[0][1], m[1][1], m[2][1], m[3][1] };
+    glm::vec4 row2 = { m[0][2], m[1][2], m[2][2], m[3][2] };
+    glm::vec4 row3 = { m[0][3], m[1][3], m[2][3], m[3][3] };
+
+    Frustum frustum;
+    frustum.planes = {
+        row3 + row0, // left
+        row3 - row0, // right
+        row3 + row1, // top (Vulkan's y points down)
+        row3 - row1, // bottom
+        row2, // near
+        row3 - row2, // far
+    };
+
+    for (glm::vec4& plane : frustum.planes)
+        plane /= glm::length(glm::vec3(plane.x, plane.y, plane.z));
+
+    return frustum;
+}
+
+Containment Frustum::classify(Bounds const& bounds) const
+{
+    Containment result = Containment::INSIDE;
+
+    for (glm::vec4 const& plane : planes) {
+        // the corners furthest along and against the plane normal
+        glm::vec3 positive = {
+            plane.x >= 0.0f ? bounds.max.x : bounds.min.x,
+            plane.y >= 0.0f ? bounds.max.y : bounds.min.y,
+            plane.z >= 0.0f ? bounds.max.z : bounds.min.z,
+        };
+        glm::vec3 negative = {
+            plane.x >= 0.0f ? bounds.min.x : bounds.max.x,
+            plane.y >= 0.0f ? bounds.min.y : bounds.max.y,
+            plane.z >= 0.0f ? bounds.min.z : bounds.max.z,
+        };
+
+        if (plane.x * positive.x + plane.y * positive.y + plane.z * positive.z + plane.w < 0.0f)
+            return Containment::OUTSIDE;
+        if (plane.x * negative.x + plane.y * negative.y + plane.z * negative.z + plane.w < 0.0f)
+            result = Containment::INTERSECTS;
+    }
+
+    return result;
+}
+
+}
@@ -0,0 +1,95 @@
+#ifndef _HB_GEOMETRY
+#define _HB_GEOMETRY
+
+#include <array>
+#include <cstdint>
+#include <limits>
+
+#include <glm/glm.hpp>
+
+namespace HB {
+
+// axis aligned bounding box
+struct Bounds {
+    glm::vec3 min;
+    glm::vec3 max;
+
+    // inverted box that any grow() replaces
+    static Bounds empty()
+    {
+        float const inf = std::numeric_limits<float>::infinity();
+        return { glm::vec3(inf), glm::vec3(-inf) };
+    }
+
+    void grow(Bounds const& other)
+    {
+        min = glm::min(min, other.min);
+        max = glm::max(max, other.max);
+    }
+
+    void grow(glm::vec3 const& point)
+    {
+        min = glm::min(min, point);
+        max = glm::max(max, point);
+    }
+
+    glm::vec3 center() const { return (min + max) * 0.5f; }
+
+    float surface_area() const
+    {
+        glm::vec3 extent = glm::max(max - min, glm::vec3(0.0f));
+        return 2.0f * (extent.x * extent.y + extent.y * extent.z + extent.z * extent.x);
+    }
+
+    bool overlaps(Bounds const& other) const
+    {
+        // clang-format off
+        return min.x <= other.max.x && max.x >= other.min.x
+            && min.y <= other.max.y && max.y >= other.min.y
+            && min.z <= other.max.z && max.z >= other.min.z;
+        // clang-format on
+    }
+
+    bool contains(Bounds const& other) const
+    {
+        // clang-format off
+        return min.x <= other.min.x && max.x >= other.max.x
+            && min.y <= other.min.y && max.y >= other.max.y
+            && min.z <= other.min.z && max.z >= other.max.z;
+        // clang-format on
+    }
+};
+
+struct Ray {
+    glm::vec3 origin;
+    glm::vec3 direction;
+};
+
+// Ray with the reciprocal direction precomputed, for testing it against many boxes.
+struct RayTest {
+    glm::vec3 origin;
+    glm::vec3 inverse_direction;
+
+    RayTest(Ray const&);
+    // distance to the entry point, or a negative value for a miss (or a box further than max_t)
+    float intersect(Bounds const&, float max_t) const;
+};
+
+enum class Containment {
+    OUTSIDE,
+    INTERSECTS,
+    INSIDE,
+};
+
+// Six inward facing planes, extracted from a view-projection matrix with Vulkan clip space
+// (0 <= z <= w).
+struct Frustum {
+    std::array<glm::vec4, 6> planes;
+
+    static Frustum from_matrix(glm::mat4 const& view_projection);
+    Containment classify(Bounds const&) const;
+};
+
+}
+
+#endif
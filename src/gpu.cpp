@@ -0,0 +1,171 @@
+#include <stdexcept>
+
+#include "gpu.hpp"
+#include "residency.hpp"
+#include "stats.hpp"
+
+namespace HB::Gpu {
+
+uint32_t find_memory_type(GpuContext const& gpu, uint32_t const type_filter, VkMemoryPropertyFlags const properties)
+{
+    VkPhysicalDeviceMemoryProperties mem_properties;
+    vkGetPhysicalDeviceMemoryProperties(gpu.physical_device, &mem_properties);
+
+    for (uint32_t i = 0; i < mem_properties.memoryTypeCount; i += 1) {
+        // clang-format off
+        if (
+            type_filter & (1 << i)
+            && (mem_properties.memoryTypes[i].propertyFlags & properties) == properties
+        ) {
+            // clang-format on
+            return i;
+        }
+    }
+
+    throw std::runtime_error("failed to find suitable memory type!");
+}
+
+void create_buffer(GpuContext const& gpu, VkDeviceSize const size, VkBufferUsageFlags const usage, VkMemoryPropertyFlags const properties, VkBuffer& buffer, VkDeviceMemory& buffer_memory, MemoryClass memory_class)
+{
+    VkBufferCreateInfo buffer_info {};
+    buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    buffer_info.size = size;
+    buffer_info.usage = usage;
+    buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    if (vkCreateBuffer(gpu.device, &buffer_info, nullptr, &buffer) != VK_SUCCESS)
+        throw std::runtime_error("failed to create buffer!");
+
+    VkMemoryRequirements mem_requirements;
+    vkGetBufferMemoryRequirements(gpu.device, buffer, &mem_requirements);
+
+    VkMemoryAllocateInfo alloc_info {};
+    alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    alloc_info.allocationSize = mem_requirements.size;
+    alloc_info.memoryTypeIndex = find_memory_type(gpu, mem_requirements.memoryTypeBits, properties);
+
+    if (vkAllocateMemory(gpu.device, &alloc_info, nullptr, &buffer_memory) != VK_SUCCESS)
+        throw std::runtime_error("failed to allocate buffer memory!");
+    if (gpu.residency != nullptr)
+        gpu.residency->allocated(buffer_memory, memory_class, alloc_info.memoryTypeIndex, alloc_info.allocationSize);
+
+    vkBindBufferMemory(gpu.device, buffer, buffer_memory, 0);
+    Stats::count(Counter::OBJECTS_CREATED, 2);
+}
+
+void create_image(GpuContext const& gpu, VkImageCreateInfo const& image_info, VkMemoryPropertyFlags const properties, VkImage& image, VkDeviceMemory& image_memory, MemoryClass memory_class)
+{
+    if (vkCreateImage(gpu.device, &image_info, nullptr, &image) != VK_SUCCESS)
+        throw std::runtime_error("failed to create image!");
+
+    VkMemoryRequirements mem_requirements;
+    vkGetImageMemoryRequirements(gpu.device, image, &mem_requirements);
+
+    VkMemoryAllocateInfo alloc_info {};
+    alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    alloc_info.allocationSize = mem_requirements.size;
+    alloc_info.memoryTypeIndex = find_memory_type(gpu, mem_requirements.memoryTypeBits, properties);
+
+    if (vkAllocateMemory(gpu.device, &alloc_info, nullptr, &image_memory) != VK_SUCCESS)
+        throw std::runtime_error("failed to allocate image memory!");
+    if (gpu.residency != nullptr)
+        gpu.residency->allocated(image_memory, memory_class, alloc_info.memoryTypeIndex, alloc_info.allocationSize);
+
+    vkBindImageMemory(gpu.device, image, image_memory, 0);
+    Stats::count(Counter::OBJECTS_CREATED, 2);
+}
+
+VkImageView create_image_view(GpuContext const& gpu, VkImage image, VkFormat format, VkImageAspectFlags aspect, uint32_t const mip_levels)
+{
+    VkImageViewCreateInfo create_info {};
+    create_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    create_info.image = image;
+    create_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    create_info.format = format;
+    create_info.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
+    create_info.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
+    create_info.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
+    create_info.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
+    create_info.subresourceRange.aspectMask = aspect;
+    create_info.subresourceRange.baseMipLevel = 0;
+    create_info.subresourceRange.levelCount = mip_levels;
+    create_info.subresourceRange.baseArrayLayer = 0;
+    create_info.subresourceRange.layerCount = 1;
+
+    VkImageView image_view;
+    if (vkCreateImageView(gpu.device, &create_info, nullptr, &image_view) != VK_SUCCESS)
+        throw std::runtime_error("failed to create image view!");
+    Stats::count(Counter::OBJECTS_CREATED);
+
+    return image_view;
+}
+
+void destroy_buffer(GpuContext const& gpu, VkBuffer buffer, VkDeviceMemory buffer_memory)
+{
+    vkDestroyBuffer(gpu.device, buffer, nullptr);
+    Stats::count(Counter::OBJECTS_DESTROYED);
+    free_memory(gpu, buffer_memory);
+}
+
+void destroy_image(GpuContext const& gpu, VkImage image, VkDeviceMemory image_memory)
+{
+    vkDestroyImage(gpu.device, image, nullptr);
+    Stats::count(Counter::OBJECTS_DESTROYED);
+    free_memory(gpu, image_memory);
+}
+
+void destroy_image_view(GpuContext const& gpu, VkImageView image_view)
+{
+    vkDestroyImageView(gpu.device, image_view, nullptr);
+    Stats::count(Counter::OBJECTS_DESTROYED);
+}
+
+void free_memory(GpuContext const& gpu, VkDeviceMemory memory)
+{
+    if (gpu.residency != nullptr)
+        gpu.residency->freed(memory);
+    vkFreeMemory(gpu.device, memory, nullptr);
+    Stats::count(Counter::OBJECTS_DESTROYED);
+}
+
+VkCommandBuffer begin_one_time_commands(GpuContext const& gpu)
+{
+    VkCommandBufferAllocateInfo alloc_info {};
+    alloc_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    alloc_info.commandPool = gpu.command_pool;
+    alloc_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    alloc_info.commandBufferCount = 1;
+
+    VkCommandBuffer command_buffer;
+    if (vkAllocateCommandBuffers(gpu.device, &alloc_info, &command_buffer) != VK_SUCCESS)
+        throw std::runtime_error("failed to allocate command buffer!");
+
+    VkCommandBufferBeginInfo begin_info {};
+    begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+    if (vkBeginCommandBuffer(command_buffer, &begin_info) != VK_SUCCESS)
+        throw std::runtime_error("failed to begin recording command buffer!");
+
+    return command_buffer;
+}
+
+void end_one_time_commands(GpuContext const& gpu, VkCommandBuffer command_buffer)
+{
+    if (vkEndCommandBuffer(command_buffer) != VK_SUCCESS)
+        throw std::runtime_error("failed to record command buffer!");
+
+    VkSubmitInfo submit_info {};
+    submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submit_info.commandBufferCount = 1;
+    submit_info.pCommandBuffers = &command_buffer;
+
+    if (vkQueueSubmit(gpu.graphics_queue, 1, &submit_info, VK_NULL_HANDLE) != VK_SUCCESS)
+        throw std::runtime_error("failed to submit command buffer!");
+    Stats::count(Counter::COMMAND_BUFFERS_SUBMITTED);
+    vkQueueWaitIdle(gpu.graphics_queue);
+
+    vkFreeCommandBuffers(gpu.device, gpu.command_pool, 1, &command_buffer);
+}
+
+}
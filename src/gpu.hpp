@@ -0,0 +1,62 @@
+#ifndef _HB_GPU
+#define _HB_GPU
+
+#include <cstdint>
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+namespace HB {
+
+class DeletionQueue;
+class ResidencyManager;
+
+// what device memory is for, usage is tracked per class (see ResidencyManager)
+enum class MemoryClass : uint32_t {
+    TEXTURE,
+    MESH,
+    SERIES,
+    RENDER_TARGET,
+    // rewritten every frame, per frame in flight
+    FRAME,
+    // one-off uploads and readbacks
+    STAGING,
+    OTHER,
+};
+constexpr uint32_t const MEMORY_CLASS_COUNT = 7;
+
+// The handles everything that creates GPU resources next to App needs.
+struct GpuContext {
+    VkPhysicalDevice physical_device = VK_NULL_HANDLE;
+    VkDevice device = VK_NULL_HANDLE;
+    VkQueue graphics_queue = VK_NULL_HANDLE;
+    uint32_t graphics_family = 0;
+    // for short-lived setup/upload command buffers
+    VkCommandPool command_pool = VK_NULL_HANDLE;
+    VkPhysicalDeviceFeatures enabled_features {};
+    // App's, for objects that frames in flight may still use
+    DeletionQueue* deletion_queue = nullptr;
+    // App's, every allocation below is reported to it
+    ResidencyManager* residency = nullptr;
+};
+
+namespace Gpu {
+
+uint32_t find_memory_type(GpuContext const&, uint32_t const type_filter, VkMemoryPropertyFlags const);
+void create_buffer(GpuContext const&, VkDeviceSize const, VkBufferUsageFlags const, VkMemoryPropertyFlags const, VkBuffer&, VkDeviceMemory&, MemoryClass = MemoryClass::OTHER);
+void create_image(GpuContext const&, VkImageCreateInfo const&, VkMemoryPropertyFlags const, VkImage&, VkDeviceMemory&, MemoryClass = MemoryClass::OTHER);
+VkImageView create_image_view(GpuContext const&, VkImage, VkFormat, VkImageAspectFlags, uint32_t const mip_levels);
+// counterparts of the above, they keep the object counters in stats.hpp balanced
+void destroy_buffer(GpuContext const&, VkBuffer, VkDeviceMemory);
+void destroy_image(GpuContext const&, VkImage, VkDeviceMemory);
+void destroy_image_view(GpuContext const&, VkImageView);
+void free_memory(GpuContext const&, VkDeviceMemory);
+// Records into a fresh command buffer, end_one_time_commands() submits it and waits for it.
+VkCommandBuffer begin_one_time_commands(GpuContext const&);
+void end_one_time_commands(GpuContext const&, VkCommandBuffer);
+
+}
+
+}
+
+#endif
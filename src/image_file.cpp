@@ -0,0 +1,268 @@
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <stdexcept>
+
+#include "image_file.hpp"
+#include "util.hpp"
+
+namespace HB {
+
+namespace {
+
+    template<typename T>
+    T read(std::vector<char> const& bytes, size_t offset)
+    {
+        if (offset + sizeof(T) > bytes.size())
+            throw std::runtime_error("image file is truncated!");
+        T value;
+        std::memcpy(&value, bytes.data() + offset, sizeof(T));
+        return value;
+    }
+
+    constexpr uint32_t four_cc(char const (&code)[5])
+    {
+        return uint32_t(uint8_t(code[0])) | uint32_t(uint8_t(code[1])) << 8 | uint32_t(uint8_t(code[2])) << 16 | uint32_t(uint8_t(code[3])) << 24;
+    }
+
+    // https://registry.khronos.org/KTX/specs/2.0/ktxspec.v2.html
+    constexpr unsigned char const KTX2_IDENTIFIER[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+    constexpr size_t const KTX2_HEADER_SIZE = 80;
+    constexpr size_t const KTX2_LEVEL_INDEX_ENTRY_SIZE = 24;
+
+    // https://learn.microsoft.com/en-us/windows/win32/direct3ddds/dx-graphics-dds-pguide
+    constexpr uint32_t const DDS_MAGIC = four_cc("DDS ");
+    constexpr size_t const DDS_HEADER_SIZE = 124;
+    constexpr size_t const DDS_DX10_HEADER_SIZE = 20;
+    constexpr uint32_t const DDPF_FOURCC = 0x4;
+    constexpr uint32_t const DDPF_RGB = 0x40;
+
+    enum DxgiFormat : uint32_t {
+        DXGI_FORMAT_R8G8B8A8_UNORM = 28,
+        DXGI_FORMAT_R8G8B8A8_UNORM_SRGB = 29,
+        DXGI_FORMAT_BC1_UNORM = 71,
+        DXGI_FORMAT_BC1_UNORM_SRGB = 72,
+        DXGI_FORMAT_BC3_UNORM = 77,
+        DXGI_FORMAT_BC3_UNORM_SRGB = 78,
+        DXGI_FORMAT_BC5_UNORM = 83,
+        DXGI_FORMAT_BC5_SNORM = 84,
+        DXGI_FORMAT_BC7_UNORM = 98,
+        DXGI_FORMAT_BC7_UNORM_SRGB = 99,
+    };
+
+    VkFormat format_from_dxgi(uint32_t format)
+    {
+        switch (format) {
+        case DXGI_FORMAT_R8G8B8A8_UNORM:
+            return VK_FORMAT_R8G8B8A8_UNORM;
+        case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+            return VK_FORMAT_R8G8B8A8_SRGB;
+        case DXGI_FORMAT_BC1_UNORM:
+            return VK_FORMAT_BC1_RGBA_UNORM_BLOCK;
+        case DXGI_FORMAT_BC1_UNORM_SRGB:
+            return VK_FORMAT_BC1_RGBA_SRGB_BLOCK;
+        case DXGI_FORMAT_BC3_UNORM:
+            return VK_FORMAT_BC3_UNORM_BLOCK;
+        case DXGI_FORMAT_BC3_UNORM_SRGB:
+            return VK_FORMAT_BC3_SRGB_BLOCK;
+        case DXGI_FORMAT_BC5_UNORM:
+            return VK_FORMAT_BC5_UNORM_BLOCK;
+        case DXGI_FORMAT_BC5_SNORM:
+            return VK_FORMAT_BC5_SNORM_BLOCK;
+        case DXGI_FORMAT_BC7_UNORM:
+            return VK_FORMAT_BC7_UNORM_BLOCK;
+        case DXGI_FORMAT_BC7_UNORM_SRGB:
+            return VK_FORMAT_BC7_SRGB_BLOCK;
+        default:
+            return VK_FORMAT_UNDEFINED;
+        }
+    }
+
+    // fills in the level table for tightly packed mips starting at `offset`
+    void add_packed_levels(ImageFile& image, size_t offset, uint32_t level_count, size_t file_size)
+    {
+        uint32_t width = image.width;
+        uint32_t height = image.height;
+        for (uint32_t level = 0; level < level_count; level += 1) {
+            size_t size = image_level_size(image.format, width, height);
+            if (offset > file_size || size > file_size - offset)
+                throw std::runtime_error("image file is truncated!");
+            image.levels.push_back({ offset, size, width, height });
+            offset += size;
+            width = std::max(width / 2, 1u);
+            height = std::max(height / 2, 1u);
+        }
+    }
+
+}
+
+bool is_block_compressed(VkFormat format)
+{
+    switch (format) {
+    case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+    case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+    case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+    case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+    case VK_FORMAT_BC3_UNORM_BLOCK:
+    case VK_FORMAT_BC3_SRGB_BLOCK:
+    case VK_FORMAT_BC5_UNORM_BLOCK:
+    case VK_FORMAT_BC5_SNORM_BLOCK:
+    case VK_FORMAT_BC7_UNORM_BLOCK:
+    case VK_FORMAT_BC7_SRGB_BLOCK:
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool is_supported_image_format(VkFormat format)
+{
+    return format == VK_FORMAT_R8G8B8A8_UNORM || format == VK_FORMAT_R8G8B8A8_SRGB || is_block_compressed(format);
+}
+
+uint32_t image_bits_per_texel(VkFormat format)
+{
+    switch (format) {
+    case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+    case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+    case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+    case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+        return 4;
+    default:
+        return is_block_compressed(format) ? 8 : 32;
+    }
+}
+
+size_t image_level_size(VkFormat format, uint32_t width, uint32_t height)
+{
+    if (!is_block_compressed(format))
+        return size_t(width) * height * 4;
+
+    // 4x4 texel blocks, partial blocks at the edges still take up a whole one
+    size_t blocks = ((size_t(width) + 3) / 4) * ((size_t(height) + 3) / 4);
+    return blocks * image_bits_per_texel(format) * 16 / 8;
+}
+
+uint32_t full_mip_count(uint32_t width, uint32_t height)
+{
+    return std::bit_width(std::max(width, height));
+}
+
+ImageFile ImageFile::load(std::string const& path)
+{
+    return parse(Util::read_file(path));
+}
+
+ImageFile ImageFile::parse(std::vector<char> const& bytes)
+{
+    if (bytes.size() >= sizeof(KTX2_IDENTIFIER) && std::memcmp(bytes.data(), KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)) == 0)
+        return parse_ktx2(bytes);
+    if (bytes.size() >= 4 && read<uint32_t>(bytes, 0) == DDS_MAGIC)
+        return parse_dds(bytes);
+
+    throw std::runtime_error("unknown image container, expected KTX2 or DDS!");
+}
+
+ImageFile ImageFile::parse_ktx2(std::vector<char> const& bytes)
+{
+    if (bytes.size() < KTX2_HEADER_SIZE || std::memcmp(bytes.data(), KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)) != 0)
+        throw std::runtime_error("not a KTX2 file!");
+
+    // KTX2 stores the VkFormat value itself
+    ImageFile image;
+    image.format = static_cast<VkFormat>(read<uint32_t>(bytes, 12));
+    image.width = read<uint32_t>(bytes, 20);
+    image.height = read<uint32_t>(bytes, 24);
+    uint32_t depth = read<uint32_t>(bytes, 28);
+    uint32_t layer_count = read<uint32_t>(bytes, 32);
+    uint32_t face_count = read<uint32_t>(bytes, 36);
+    uint32_t level_count = std::max(read<uint32_t>(bytes, 40), 1u);
+    uint32_t supercompression = read<uint32_t>(bytes, 44);
+
+    if (!is_supported_image_format(image.format))
+        throw std::runtime_error("unsupported KTX2 texture format!");
+    if (image.width == 0 || image.height == 0 || depth > 1 || layer_count > 1 || face_count != 1)
+        throw std::runtime_error("only plain 2D KTX2 textures are supported!");
+    if (image.width > MAX_IMAGE_DIMENSION || image.height > MAX_IMAGE_DIMENSION)
+        throw std::runtime_error("KTX2 texture is too large!");
+    if (supercompression != 0)
+        throw std::runtime_error("supercompressed KTX2 files are not supported!");
+    if (level_count > full_mip_count(image.width, image.height))
+        throw std::runtime_error("KTX2 file has more levels than its size allows!");
+
+    uint32_t width = image.width;
+    uint32_t height = image.height;
+    for (uint32_t level = 0; level < level_count; level += 1) {
+        size_t entry = KTX2_HEADER_SIZE + level * KTX2_LEVEL_INDEX_ENTRY_SIZE;
+        size_t offset = read<uint64_t>(bytes, entry);
+        size_t size = read<uint64_t>(bytes, entry + 8);
+        // offset and size come from the file, the check mustn't wrap around
+        if (offset > bytes.size() || size > bytes.size() - offset || size < image_level_size(image.format, width, height))
+            throw std::runtime_error("KTX2 level data is truncated!");
+        image.levels.push_back({ offset, image_level_size(image.format, width, height), width, height });
+        width = std::max(width / 2, 1u);
+        height = std::max(height / 2, 1u);
+    }
+
+    image.data.resize(bytes.size());
+    std::memcpy(image.data.data(), bytes.data(), bytes.size());
+    return image;
+}
+
+ImageFile ImageFile::parse_dds(std::vector<char> const& bytes)
+{
+    if (bytes.size() < 4 + DDS_HEADER_SIZE || read<uint32_t>(bytes, 0) != DDS_MAGIC)
+        throw std::runtime_error("not a DDS file!");
+
+    // offsets are relative to the header, right after the magic
+    size_t header = 4;
+    ImageFile image;
+    image.height = read<uint32_t>(bytes, header + 8);
+    image.width = read<uint32_t>(bytes, header + 12);
+    uint32_t level_count = std::max(read<uint32_t>(bytes, header + 24), 1u);
+    uint32_t pixel_flags = read<uint32_t>(bytes, header + 76);
+    uint32_t pixel_four_cc = read<uint32_t>(bytes, header + 80);
+    size_t data_offset = 4 + DDS_HEADER_SIZE;
+
+    if (pixel_flags & DDPF_FOURCC) {
+        if (pixel_four_cc == four_cc("DXT1"))
+            image.format = VK_FORMAT_BC1_RGBA_UNORM_BLOCK;
+        else if (pixel_four_cc == four_cc("DXT5"))
+            image.format = VK_FORMAT_BC3_UNORM_BLOCK;
+        else if (pixel_four_cc == four_cc("ATI2") || pixel_four_cc == four_cc("BC5U"))
+            image.format = VK_FORMAT_BC5_UNORM_BLOCK;
+        else if (pixel_four_cc == four_cc("BC5S"))
+            image.format = VK_FORMAT_BC5_SNORM_BLOCK;
+        else if (pixel_four_cc == four_cc("DX10")) {
+            image.format = format_from_dxgi(read<uint32_t>(bytes, data_offset));
+            uint32_t array_size = read<uint32_t>(bytes, data_offset + 12);
+            if (array_size > 1)
+                throw std::runtime_error("DDS texture arrays are not supported!");
+            data_offset += DDS_DX10_HEADER_SIZE;
+        }
+    } else if (pixel_flags & DDPF_RGB) {
+        uint32_t bit_count = read<uint32_t>(bytes, header + 84);
+        uint32_t red_mask = read<uint32_t>(bytes, header + 88);
+        if (bit_count == 32 && red_mask == 0x000000FF)
+            image.format = VK_FORMAT_R8G8B8A8_UNORM;
+    }
+
+    if (!is_supported_image_format(image.format))
+        throw std::runtime_error("unsupported DDS texture format!");
+    // clang-format off
+    if (image.width == 0
+        || image.height == 0
+        || image.width > MAX_IMAGE_DIMENSION
+        || image.height > MAX_IMAGE_DIMENSION
+        || level_count > full_mip_count(image.width, image.height))
+        throw std::runtime_error("invalid DDS texture size!");
+    // clang-format on
+
+    add_packed_levels(image, data_offset, level_count, bytes.size());
+
+    image.data.resize(bytes.size());
+    std::memcpy(image.data.data(), bytes.data(), bytes.size());
+    return image;
+}
+
+}
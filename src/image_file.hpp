@@ -0,0 +1,53 @@
+#ifndef _HB_IMAGE_FILE
+#define _HB_IMAGE_FILE
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+namespace HB {
+
+// A 2D image with its mip chain as it sits on disk, ready to be copied into a staging buffer.
+struct ImageFile {
+    struct Level {
+        size_t offset;
+        size_t size;
+        uint32_t width;
+        uint32_t height;
+    };
+
+    VkFormat format = VK_FORMAT_UNDEFINED;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    // level 0 is the full resolution image
+    std::vector<Level> levels;
+    std::vector<std::byte> data;
+
+    // picks the container by its magic number, throws for anything else
+    static ImageFile load(std::string const& path);
+    static ImageFile parse(std::vector<char> const& bytes);
+    static ImageFile parse_ktx2(std::vector<char> const& bytes);
+    static ImageFile parse_dds(std::vector<char> const& bytes);
+};
+
+// Largest width or height accepted, what every desktop GPU can create (maxImageDimension2D) and
+// small enough that no size computed from it overflows. Files claiming more are rejected.
+constexpr uint32_t const MAX_IMAGE_DIMENSION = 16384;
+
+// Formats textures can be created from: RGBA8 (mips generated on the GPU) and BC1/BC3/BC5/BC7
+// (mips have to come with the file, compressed formats can't be blitted to).
+bool is_block_compressed(VkFormat);
+bool is_supported_image_format(VkFormat);
+// bytes one level takes up in the given format
+size_t image_level_size(VkFormat, uint32_t width, uint32_t height);
+// what a texel costs to store and to fetch, 32 for RGBA8, 4 for BC1, 8 for the other BC formats
+uint32_t image_bits_per_texel(VkFormat);
+uint32_t full_mip_count(uint32_t width, uint32_t height);
+
+}
+
+#endif
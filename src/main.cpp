@@ -1,4 +1,5 @@
 #include <cstdint>
+#include <cstdlib>
 #include <vector>
 
 #include "app.hpp"
@@ -9,16 +10,36 @@ constexpr uint32_t const HEIGHT = 720;
 
 int main(int argc, char** argv)
 {
-    (void)argc;
-    (void)argv;
-
     HB::AppInfo app_info {};
     app_info.width = WIDTH;
     app_info.height = HEIGHT;
     app_info.name = APP_NAME;
     app_info.version = APP_VERSION;
+    app_info.threaded = std::getenv("HB_THREADED") != nullptr;
+    app_info.capture = std::getenv("HB_CAPTURE");
     HB::App app { app_info };
+
+    char const* stats_path = std::getenv("HB_STATS_CSV");
+    if (stats_path)
+        app.log_stats(stats_path);
+
+    // any KTX2/DDS files given on the command line get loaded, to compare their footprint
+    for (int i = 1; i < argc; i += 1)
+        app.textures().load(argv[i]);
+    if (argc > 1)
+        app.textures().print_memory_report();
+
+    HB::Transform transform { { 0.0f, 0.0f, 0.0f }, { 1.0f, 1.0f, 1.0f } };
+    HB::Bounds bounds { { -0.5f, -0.5f, 0.0f }, { 0.5f, 0.5f, 0.0f } };
+    HB::Renderable renderable { 0, { 1.0f, 1.0f, 1.0f } };
+    app.scene().create(transform, bounds, renderable);
+
     app.run();
 
+    if (stats_path) {
+        app.pipelines().print_report();
+        app.print_startup_report();
+    }
+
     return 0;
 }
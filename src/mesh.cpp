@@ -0,0 +1,127 @@
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include "capture.hpp"
+#include "deletion_queue.hpp"
+#include "geometry.hpp"
+#include "mesh.hpp"
+#include "stats.hpp"
+
+namespace HB {
+
+MeshManager::MeshManager(GpuContext const& gpu)
+    : m_gpu(gpu)
+{
+    MeshData triangle;
+    triangle.vertices = {
+        { { 0.0f, -0.5f, 0.0f }, { 1.0f, 0.0f, 0.0f }, { 0.5f, 0.0f } },
+        { { 0.5f, 0.5f, 0.0f }, { 0.0f, 1.0f, 0.0f }, { 1.0f, 1.0f } },
+        { { -0.5f, 0.5f, 0.0f }, { 0.0f, 0.0f, 1.0f }, { 0.0f, 1.0f } }
+    };
+    triangle.indices = { 0, 1, 2 };
+    create(std::move(triangle));
+}
+
+MeshManager::~MeshManager()
+{
+    if (m_vertices.buffer != VK_NULL_HANDLE)
+        Gpu::destroy_buffer(m_gpu, m_vertices.buffer, m_vertices.memory);
+    if (m_indices.buffer != VK_NULL_HANDLE)
+        Gpu::destroy_buffer(m_gpu, m_indices.buffer, m_indices.memory);
+    if (m_meshlets.buffer != VK_NULL_HANDLE)
+        Gpu::destroy_buffer(m_gpu, m_meshlets.buffer, m_meshlets.memory);
+}
+
+uint32_t MeshManager::create(MeshData data, LodSettings const& settings)
+{
+    if (data.vertices.empty() || data.indices.empty())
+        throw std::runtime_error("mesh has no triangles!");
+    if (m_capture)
+        m_capture->mesh(data, settings);
+
+    LodChain chain = build_lods(std::move(data), settings);
+
+    Mesh mesh {};
+    mesh.vertex_offset = static_cast<int32_t>(m_vertices.size / sizeof(Vertex));
+    mesh.vertex_count = static_cast<uint32_t>(chain.mesh.vertices.size());
+    Bounds bounds = Bounds::empty();
+    for (Vertex const& vertex : chain.mesh.vertices)
+        bounds.grow(vertex.pos);
+    mesh.center = bounds.center();
+    for (Vertex const& vertex : chain.mesh.vertices)
+        mesh.radius = std::max(mesh.radius, glm::length(vertex.pos - mesh.center));
+    mesh.first_lod = static_cast<uint32_t>(m_lods.size());
+    mesh.lod_count = static_cast<uint32_t>(chain.lods.size());
+
+    uint32_t first_index = static_cast<uint32_t>(m_indices.size / sizeof(uint32_t));
+    std::vector<Meshlet> meshlets;
+    for (MeshLod const& lod : chain.lods) {
+        LodRange range { first_index + lod.first_index, lod.index_count, mesh.vertex_offset, lod.error, 0, 0 };
+        // one meshlet culls no better than the object itself
+        if (lod.index_count / 3 > MESHLET_MAX_TRIANGLES) {
+            std::vector<Meshlet> lod_meshlets = build_meshlets(chain.mesh.vertices, chain.mesh.indices, lod.first_index, lod.index_count);
+            range.first_meshlet = meshlet_count() + static_cast<uint32_t>(meshlets.size());
+            range.meshlet_count = static_cast<uint32_t>(lod_meshlets.size());
+            for (Meshlet& meshlet : lod_meshlets) {
+                meshlet.first_index += first_index;
+                meshlets.push_back(meshlet);
+            }
+        }
+        m_lods.push_back(range);
+    }
+
+    append(m_vertices, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, chain.mesh.vertices.data(), chain.mesh.vertices.size() * sizeof(Vertex));
+    append(m_indices, VK_BUFFER_USAGE_INDEX_BUFFER_BIT, chain.mesh.indices.data(), chain.mesh.indices.size() * sizeof(uint32_t));
+    if (!meshlets.empty())
+        append(m_meshlets, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, meshlets.data(), meshlets.size() * sizeof(Meshlet));
+
+    m_meshes.push_back(mesh);
+    return static_cast<uint32_t>(m_meshes.size() - 1);
+}
+
+void MeshManager::append(GeometryBuffer& target, VkBufferUsageFlags usage, void const* data, VkDeviceSize size)
+{
+    VkBuffer staging_buffer;
+    VkDeviceMemory staging_buffer_memory;
+    Gpu::create_buffer(m_gpu, size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, staging_buffer, staging_buffer_memory, MemoryClass::STAGING);
+
+    void* mapped;
+    vkMapMemory(m_gpu.device, staging_buffer_memory, 0, size, 0, &mapped);
+    memcpy(mapped, data, size);
+    vkUnmapMemory(m_gpu.device, staging_buffer_memory);
+    Stats::count(Counter::BYTES_UPLOADED, size);
+
+    VkCommandBuffer command_buffer = Gpu::begin_one_time_commands(m_gpu);
+
+    GeometryBuffer old = target;
+    if (target.size + size > target.capacity) {
+        target.capacity = std::max(target.size + size, target.capacity * 2);
+        m_version += 1;
+        Gpu::create_buffer(m_gpu, target.capacity, usage | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, target.buffer, target.memory, MemoryClass::MESH);
+        if (old.size > 0) {
+            VkBufferCopy region { 0, 0, old.size };
+            vkCmdCopyBuffer(command_buffer, old.buffer, target.buffer, 1, &region);
+        }
+    }
+
+    VkBufferCopy region { 0, target.size, size };
+    vkCmdCopyBuffer(command_buffer, staging_buffer, target.buffer, 1, &region);
+
+    Gpu::end_one_time_commands(m_gpu, command_buffer);
+
+    Gpu::destroy_buffer(m_gpu, staging_buffer, staging_buffer_memory);
+    // retired like anything replaced at runtime, frames recorded before the copy read the old one
+    if (old.buffer != VK_NULL_HANDLE && old.buffer != target.buffer)
+        m_gpu.deletion_queue->retire_buffer(old.buffer, old.memory);
+    target.size += size;
+}
+
+void MeshManager::bind(VkCommandBuffer command_buffer) const
+{
+    VkDeviceSize offset = 0;
+    vkCmdBindVertexBuffers(command_buffer, 0, 1, &m_vertices.buffer, &offset);
+    vkCmdBindIndexBuffer(command_buffer, m_indices.buffer, 0, VK_INDEX_TYPE_UINT32);
+}
+
+}
@@ -0,0 +1,118 @@
+#ifndef _HB_MESH
+#define _HB_MESH
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "gpu.hpp"
+#include "mesh_data.hpp"
+
+namespace HB {
+
+class CaptureWriter;
+
+struct Mesh {
+    int32_t vertex_offset;
+    uint32_t vertex_count;
+    // bounding sphere in the mesh's own space
+    glm::vec3 center;
+    float radius;
+    // its LODs are the draw keys from first_lod on, full detail first
+    uint32_t first_lod;
+    uint32_t lod_count;
+};
+
+// one LOD of one mesh, everything its draw needs
+struct LodRange {
+    uint32_t first_index;
+    uint32_t index_count;
+    int32_t vertex_offset;
+    // in the mesh's own space
+    float error;
+    // its meshlets in meshlet_buffer(), none when it fits in one
+    uint32_t first_meshlet;
+    uint32_t meshlet_count;
+};
+
+// Owns every mesh: all of them and all of their LODs share one vertex and one index buffer, so
+// the scene pass binds them once. Meshes are optimized and simplified when they are created (see
+// build_lods()) and uploads are waited on, so like TextureManager this is for load time.
+//
+// Every LOD of every mesh is a draw key, numbered consecutively; instances are grouped by them.
+// LODs larger than one meshlet are also split into meshlets (see build_meshlets()), which
+// MeshletCuller culls on the GPU.
+class MeshManager {
+public:
+    // what renderables without a mesh of their own draw
+    static uint32_t const TRIANGLE = 0;
+
+    MeshManager(GpuContext const&);
+    ~MeshManager();
+    MeshManager(MeshManager const&) = delete;
+    MeshManager& operator=(MeshManager const&) = delete;
+
+    // returns the index for Renderable::mesh
+    uint32_t create(MeshData, LodSettings const& = {});
+    uint32_t load_obj(std::string const& path, LodSettings const& settings = {}) { return create(HB::load_obj(path), settings); }
+
+    Mesh const& get(uint32_t mesh) const { return m_meshes[mesh]; }
+    size_t size() const { return m_meshes.size(); }
+    LodRange const& lod(uint32_t key) const { return m_lods[key]; }
+    uint32_t lod_count() const { return static_cast<uint32_t>(m_lods.size()); }
+
+    // how many pixels a LOD may be off by on screen, 0 always draws full detail
+    void set_lod_threshold(float pixels) { m_lod_threshold = pixels; }
+    float lod_threshold() const { return m_lod_threshold; }
+    // the draw key of the coarsest LOD within the threshold, at this many pixels per unit of the
+    // mesh's own space (the instance's scale included)
+    uint32_t select_lod(uint32_t mesh, float pixels_per_unit) const
+    {
+        Mesh const& info = m_meshes[mesh];
+        uint32_t key = info.first_lod;
+        while (key + 1 < info.first_lod + info.lod_count && m_lods[key + 1].error * pixels_per_unit <= m_lod_threshold)
+            key += 1;
+        return key;
+    }
+
+    // the vertex buffer at binding 0, and the index buffer
+    void bind(VkCommandBuffer) const;
+    // every Meshlet of every LOD, first_index counts from the start of the index buffer; null
+    // until a mesh has any
+    VkBuffer meshlet_buffer() const { return m_meshlets.buffer; }
+    uint32_t meshlet_count() const { return static_cast<uint32_t>(m_meshlets.size / sizeof(Meshlet)); }
+
+    VkDeviceSize memory_size() const { return m_vertices.capacity + m_indices.capacity + m_meshlets.capacity; }
+    // every mesh created from now on is recorded to it, as it was given, null stops
+    void set_capture(CaptureWriter* capture) { m_capture = capture; }
+    // counts up whenever a buffer bind() binds is replaced by a larger one, command buffers that
+    // bound it have to be recorded again
+    uint64_t version() const { return m_version; }
+
+private:
+    struct GeometryBuffer {
+        VkBuffer buffer = VK_NULL_HANDLE;
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        VkDeviceSize size = 0;
+        VkDeviceSize capacity = 0;
+    };
+
+    GpuContext m_gpu;
+    CaptureWriter* m_capture = nullptr;
+    std::vector<Mesh> m_meshes;
+    std::vector<LodRange> m_lods;
+    float m_lod_threshold = 1.0f;
+    uint64_t m_version = 0;
+    GeometryBuffer m_vertices;
+    GeometryBuffer m_indices;
+    GeometryBuffer m_meshlets;
+
+    // grows the buffer to twice its size when it doesn't fit, the old contents are copied over
+    void append(GeometryBuffer&, VkBufferUsageFlags, void const* data, VkDeviceSize size);
+};
+
+}
+
+#endif
@@ -0,0 +1,628 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <unordered_map>
+
+#include "geometry.hpp"
+#include "mesh_data.hpp"
+#include "util.hpp"
+
+namespace HB {
+
+namespace {
+
+    bool is_space(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+    // strtol would skip whitespace, up to the next line
+    bool starts_number(char c) { return (c >= '0' && c <= '9') || c == '-'; }
+
+    char const* skip_spaces(char const* c, char const* end)
+    {
+        while (c < end && is_space(*c))
+            c += 1;
+        return c;
+    }
+
+    // up to `max` floats separated by spaces, returns how many were read
+    uint32_t parse_floats(char const* c, char const* end, float* out, uint32_t max)
+    {
+        uint32_t count = 0;
+        while (count < max) {
+            c = skip_spaces(c, end);
+            if (c >= end)
+                break;
+            char* parsed;
+            float value = std::strtof(c, &parsed);
+            if (parsed == c)
+                break;
+            out[count] = value;
+            count += 1;
+            c = parsed;
+        }
+        return count;
+    }
+
+    // 1-based, negative counts back from the last one read
+    uint32_t resolve_index(long index, size_t count)
+    {
+        long resolved = index < 0 ? static_cast<long>(count) + index : index - 1;
+        if (resolved < 0 || resolved >= static_cast<long>(count))
+            throw std::runtime_error("mesh file has an index out of range!");
+        return static_cast<uint32_t>(resolved);
+    }
+
+    // a symmetric 4x4 matrix, the sum of squared distances to planes, and the area they came from
+    struct Quadric {
+        float a00, a01, a02, a03;
+        float a11, a12, a13;
+        float a22, a23;
+        float a33;
+        float weight;
+    };
+
+    Quadric plane_quadric(glm::vec3 normal, float d, float weight)
+    {
+        Quadric q;
+        q.a00 = weight * normal.x * normal.x;
+        q.a01 = weight * normal.x * normal.y;
+        q.a02 = weight * normal.x * normal.z;
+        q.a03 = weight * normal.x * d;
+        q.a11 = weight * normal.y * normal.y;
+        q.a12 = weight * normal.y * normal.z;
+        q.a13 = weight * normal.y * d;
+        q.a22 = weight * normal.z * normal.z;
+        q.a23 = weight * normal.z * d;
+        q.a33 = weight * d * d;
+        q.weight = weight;
+        return q;
+    }
+
+    void add(Quadric& q, Quadric const& other)
+    {
+        q.a00 += other.a00;
+        q.a01 += other.a01;
+        q.a02 += other.a02;
+        q.a03 += other.a03;
+        q.a11 += other.a11;
+        q.a12 += other.a12;
+        q.a13 += other.a13;
+        q.a22 += other.a22;
+        q.a23 += other.a23;
+        q.a33 += other.a33;
+        q.weight += other.weight;
+    }
+
+    // mean squared distance of the point to the planes
+    float evaluate(Quadric const& q, glm::vec3 p)
+    {
+        float x = p.x, y = p.y, z = p.z;
+        float result = q.a00 * x * x + 2.0f * q.a01 * x * y + 2.0f * q.a02 * x * z + 2.0f * q.a03 * x
+            + q.a11 * y * y + 2.0f * q.a12 * y * z + 2.0f * q.a13 * y
+            + q.a22 * z * z + 2.0f * q.a23 * z
+            + q.a33;
+        return std::max(result, 0.0f) / std::max(q.weight, 1e-12f);
+    }
+
+    struct PositionHash {
+        size_t operator()(glm::vec3 const& p) const
+        {
+            uint32_t bits[3];
+            std::memcpy(bits, &p, sizeof(bits));
+            return (bits[0] * 73856093u) ^ (bits[1] * 19349663u) ^ (bits[2] * 83492791u);
+        }
+    };
+
+    struct PositionEqual {
+        bool operator()(glm::vec3 const& a, glm::vec3 const& b) const { return a.x == b.x && a.y == b.y && a.z == b.z; }
+    };
+
+    // triangles around every vertex, as offsets into one array
+    struct Adjacency {
+        std::vector<uint32_t> offsets;
+        std::vector<uint32_t> triangles;
+
+        void build(std::vector<uint32_t> const& indices, size_t vertex_count)
+        {
+            offsets.assign(vertex_count + 1, 0);
+            for (uint32_t index : indices)
+                offsets[index + 1] += 1;
+            for (size_t i = 0; i < vertex_count; i += 1)
+                offsets[i + 1] += offsets[i];
+
+            triangles.resize(indices.size());
+            std::vector<uint32_t> cursor(offsets.begin(), offsets.end() - 1);
+            for (size_t i = 0; i < indices.size(); i += 1) {
+                triangles[cursor[indices[i]]] = static_cast<uint32_t>(i / 3);
+                cursor[indices[i]] += 1;
+            }
+        }
+    };
+
+}
+
+MeshData load_obj(std::string const& path)
+{
+    std::vector<char> file = Util::read_file(path);
+    // every line ends in one, so the parsers below always stop within the file
+    file.push_back('\n');
+
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec3> colors;
+    std::vector<glm::vec2> uvs;
+    MeshData mesh;
+    // every position/texture coordinate pair becomes one vertex
+    std::unordered_map<uint64_t, uint32_t> vertex_ids;
+    std::vector<uint32_t> polygon;
+
+    char const* c = file.data();
+    char const* file_end = file.data() + file.size();
+    while (c < file_end) {
+        char const* line_end = static_cast<char const*>(std::memchr(c, '\n', file_end - c));
+
+        if (line_end - c > 2 && c[0] == 'v' && c[1] == ' ') {
+            float values[6];
+            uint32_t count = parse_floats(c + 2, line_end, values, 6);
+            if (count < 3)
+                throw std::runtime_error("mesh file has a malformed vertex!");
+            positions.push_back({ values[0], values[1], values[2] });
+            colors.push_back(count == 6 ? glm::vec3(values[3], values[4], values[5]) : glm::vec3(1.0f));
+        } else if (line_end - c > 3 && c[0] == 'v' && c[1] == 't' && c[2] == ' ') {
+            float values[2] = { 0.0f, 0.0f };
+            if (parse_floats(c + 3, line_end, values, 2) < 1)
+                throw std::runtime_error("mesh file has a malformed texture coordinate!");
+            // OBJ has v going up, images start at the top
+            uvs.push_back({ values[0], 1.0f - values[1] });
+        } else if (line_end - c > 2 && c[0] == 'f' && c[1] == ' ') {
+            polygon.clear();
+            char const* p = c + 2;
+            while (true) {
+                p = skip_spaces(p, line_end);
+                if (p >= line_end || *p == '#')
+                    break;
+
+                char* parsed;
+                long position = std::strtol(p, &parsed, 10);
+                if (!starts_number(*p) || parsed == p)
+                    throw std::runtime_error("mesh file has a malformed face!");
+                p = parsed;
+                long uv = 0;
+                if (*p == '/') {
+                    p += 1;
+                    if (starts_number(*p)) {
+                        uv = std::strtol(p, &parsed, 10);
+                        p = parsed;
+                    }
+                    // the normal, not used
+                    if (*p == '/') {
+                        p += 1;
+                        if (starts_number(*p)) {
+                            std::strtol(p, &parsed, 10);
+                            p = parsed;
+                        }
+                    }
+                }
+
+                uint32_t position_index = resolve_index(position, positions.size());
+                uint32_t uv_index = uv != 0 ? resolve_index(uv, uvs.size()) : UINT32_MAX;
+                uint64_t key = (uint64_t(position_index) << 32) | uv_index;
+                auto [it, inserted] = vertex_ids.try_emplace(key, static_cast<uint32_t>(mesh.vertices.size()));
+                if (inserted)
+                    mesh.vertices.push_back({ positions[position_index], colors[position_index], uv != 0 ? uvs[uv_index] : glm::vec2(0.0f) });
+                polygon.push_back(it->second);
+            }
+
+            for (size_t i = 2; i < polygon.size(); i += 1) {
+                mesh.indices.push_back(polygon[0]);
+                mesh.indices.push_back(polygon[i - 1]);
+                mesh.indices.push_back(polygon[i]);
+            }
+        }
+
+        c = line_end + 1;
+    }
+
+    if (mesh.indices.empty())
+        throw std::runtime_error("mesh file has no faces!");
+    return mesh;
+}
+
+void optimize_vertex_cache(std::vector<uint32_t>& indices, size_t vertex_count)
+{
+    uint32_t const CACHE_SIZE = 32;
+    uint32_t const NONE = UINT32_MAX;
+    size_t triangle_count = indices.size() / 3;
+    if (triangle_count == 0)
+        return;
+
+    Adjacency adjacency;
+    adjacency.build(indices, vertex_count);
+    // the first `remaining` entries of a vertex's list are the triangles not emitted yet
+    std::vector<uint32_t> remaining(vertex_count);
+    for (size_t v = 0; v < vertex_count; v += 1)
+        remaining[v] = adjacency.offsets[v + 1] - adjacency.offsets[v];
+
+    std::vector<int32_t> cache_position(vertex_count, -1);
+    auto vertex_score = [&](uint32_t v) {
+        if (remaining[v] == 0)
+            return -1.0f;
+        float score = 0.0f;
+        int32_t position = cache_position[v];
+        // the last triangle's vertices score the same, so it doesn't matter which one it used last
+        if (position >= 0)
+            score = position < 3 ? 0.75f : std::pow(1.0f - float(position - 3) / float(CACHE_SIZE - 3), 1.5f);
+        // vertices with few triangles left are worth finishing off
+        return score + 2.0f / std::sqrt(float(remaining[v]));
+    };
+
+    std::vector<float> vertex_scores(vertex_count);
+    for (size_t v = 0; v < vertex_count; v += 1)
+        vertex_scores[v] = vertex_score(static_cast<uint32_t>(v));
+    std::vector<float> triangle_scores(triangle_count);
+    uint32_t best = 0;
+    for (size_t t = 0; t < triangle_count; t += 1) {
+        triangle_scores[t] = vertex_scores[indices[t * 3]] + vertex_scores[indices[t * 3 + 1]] + vertex_scores[indices[t * 3 + 2]];
+        if (triangle_scores[t] > triangle_scores[best])
+            best = static_cast<uint32_t>(t);
+    }
+
+    std::vector<bool> emitted(triangle_count, false);
+    std::vector<uint32_t> result;
+    result.reserve(indices.size());
+    std::vector<uint32_t> cache;
+    std::vector<uint32_t> next_cache;
+    cache.reserve(CACHE_SIZE + 3);
+    next_cache.reserve(CACHE_SIZE + 3);
+    size_t scan = 0;
+
+    while (result.size() < indices.size()) {
+        // nothing around the cache is left, continue with the first triangle still to go
+        if (best == NONE) {
+            while (emitted[scan])
+                scan += 1;
+            best = static_cast<uint32_t>(scan);
+        }
+
+        emitted[best] = true;
+        next_cache.clear();
+        for (uint32_t corner = 0; corner < 3; corner += 1) {
+            uint32_t v = indices[best * 3 + corner];
+            result.push_back(v);
+            next_cache.push_back(v);
+
+            uint32_t* triangles = adjacency.triangles.data() + adjacency.offsets[v];
+            uint32_t* last = triangles + remaining[v] - 1;
+            std::iter_swap(std::find(triangles, last + 1, best), last);
+            remaining[v] -= 1;
+        }
+        for (uint32_t v : cache) {
+            if (std::find(next_cache.begin(), next_cache.end(), v) == next_cache.end())
+                next_cache.push_back(v);
+        }
+
+        // what falls out of the cache loses its position score, what stays is rescored
+        for (size_t i = 0; i < next_cache.size(); i += 1)
+            cache_position[next_cache[i]] = i < CACHE_SIZE ? static_cast<int32_t>(i) : -1;
+        for (uint32_t v : next_cache)
+            vertex_scores[v] = vertex_score(v);
+
+        best = NONE;
+        float best_score = -1.0f;
+        for (uint32_t v : next_cache) {
+            uint32_t const* triangles = adjacency.triangles.data() + adjacency.offsets[v];
+            for (uint32_t i = 0; i < remaining[v]; i += 1) {
+                uint32_t t = triangles[i];
+                triangle_scores[t] = vertex_scores[indices[t * 3]] + vertex_scores[indices[t * 3 + 1]] + vertex_scores[indices[t * 3 + 2]];
+                if (triangle_scores[t] > best_score) {
+                    best_score = triangle_scores[t];
+                    best = t;
+                }
+            }
+        }
+
+        if (next_cache.size() > CACHE_SIZE)
+            next_cache.resize(CACHE_SIZE);
+        cache.swap(next_cache);
+    }
+
+    indices.swap(result);
+}
+
+void optimize_vertex_fetch(MeshData& mesh)
+{
+    std::vector<uint32_t> remap(mesh.vertices.size(), UINT32_MAX);
+    std::vector<Vertex> ordered;
+    ordered.reserve(mesh.vertices.size());
+    for (uint32_t& index : mesh.indices) {
+        if (remap[index] == UINT32_MAX) {
+            remap[index] = static_cast<uint32_t>(ordered.size());
+            ordered.push_back(mesh.vertices[index]);
+        }
+        index = remap[index];
+    }
+    mesh.vertices.swap(ordered);
+}
+
+float average_cache_miss_ratio(std::vector<uint32_t> const& indices, size_t vertex_count, uint32_t cache_size)
+{
+    if (indices.empty())
+        return 0.0f;
+
+    // when each vertex went into the FIFO, in misses
+    std::vector<uint64_t> inserted(vertex_count, 0);
+    uint64_t misses = 0;
+    for (uint32_t index : indices) {
+        if (inserted[index] == 0 || misses - inserted[index] >= cache_size) {
+            misses += 1;
+            inserted[index] = misses;
+        }
+    }
+    return float(misses) / float(indices.size() / 3);
+}
+
+std::vector<uint32_t> simplify(std::vector<Vertex> const& vertices, std::vector<uint32_t> const& input, size_t target_index_count, float* error)
+{
+    // extra weight of the planes that hold borders in place
+    float const BORDER_WEIGHT = 10.0f;
+    float const inf = std::numeric_limits<float>::infinity();
+
+    std::vector<uint32_t> indices = input;
+    size_t vertex_count = vertices.size();
+    float max_error = 0.0f;
+
+    // vertices that share their position with another one are on a seam, moving only one side
+    // would tear it open
+    std::vector<bool> locked(vertex_count, false);
+    std::vector<uint32_t> welded(vertex_count);
+    {
+        std::unordered_map<glm::vec3, uint32_t, PositionHash, PositionEqual> first_at;
+        for (uint32_t v = 0; v < vertex_count; v += 1) {
+            auto [it, inserted] = first_at.try_emplace(vertices[v].pos, v);
+            welded[v] = it->second;
+            if (!inserted) {
+                locked[v] = true;
+                locked[it->second] = true;
+            }
+        }
+    }
+
+    std::vector<Quadric> quadrics(vertex_count, Quadric {});
+    std::unordered_map<uint64_t, uint32_t> edge_counts;
+    auto edge_key = [&](uint32_t a, uint32_t b) {
+        uint32_t wa = welded[a], wb = welded[b];
+        return wa < wb ? (uint64_t(wa) << 32) | wb : (uint64_t(wb) << 32) | wa;
+    };
+    for (size_t t = 0; t < indices.size(); t += 3) {
+        for (uint32_t corner = 0; corner < 3; corner += 1)
+            edge_counts[edge_key(indices[t + corner], indices[t + (corner + 1) % 3])] += 1;
+    }
+    for (size_t t = 0; t < indices.size(); t += 3) {
+        glm::vec3 p0 = vertices[indices[t]].pos;
+        glm::vec3 p1 = vertices[indices[t + 1]].pos;
+        glm::vec3 p2 = vertices[indices[t + 2]].pos;
+        glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+        float length = glm::length(normal);
+        if (length == 0.0f)
+            continue;
+        normal /= length;
+
+        Quadric plane = plane_quadric(normal, -glm::dot(normal, p0), length * 0.5f);
+        for (uint32_t corner = 0; corner < 3; corner += 1)
+            add(quadrics[indices[t + corner]], plane);
+
+        // a border edge gets a plane through it standing up from the triangle
+        for (uint32_t corner = 0; corner < 3; corner += 1) {
+            uint32_t a = indices[t + corner];
+            uint32_t b = indices[t + (corner + 1) % 3];
+            if (edge_counts[edge_key(a, b)] != 1)
+                continue;
+            glm::vec3 edge = vertices[b].pos - vertices[a].pos;
+            float edge_length = glm::length(edge);
+            if (edge_length == 0.0f)
+                continue;
+            glm::vec3 side = glm::normalize(glm::cross(edge, normal));
+            Quadric border = plane_quadric(side, -glm::dot(side, vertices[a].pos), edge_length * edge_length * BORDER_WEIGHT);
+            add(quadrics[a], border);
+            add(quadrics[b], border);
+        }
+    }
+
+    struct Collapse {
+        uint32_t from;
+        uint32_t to;
+        float cost;
+    };
+
+    std::vector<Collapse> collapses;
+    std::vector<bool> touched(vertex_count, false);
+    Adjacency adjacency;
+
+    while (indices.size() > target_index_count) {
+        // every edge once per triangle using it (so mostly twice), in the cheaper direction
+        collapses.clear();
+        for (size_t t = 0; t < indices.size(); t += 3) {
+            for (uint32_t corner = 0; corner < 3; corner += 1) {
+                uint32_t a = indices[t + corner];
+                uint32_t b = indices[t + (corner + 1) % 3];
+                Quadric sum = quadrics[a];
+                add(sum, quadrics[b]);
+                float a_to_b = locked[a] ? inf : evaluate(sum, vertices[b].pos);
+                float b_to_a = locked[b] ? inf : evaluate(sum, vertices[a].pos);
+                if (locked[a] && locked[b])
+                    continue;
+                if (a_to_b <= b_to_a)
+                    collapses.push_back({ a, b, a_to_b });
+                else
+                    collapses.push_back({ b, a, b_to_a });
+            }
+        }
+        if (collapses.empty())
+            break;
+        std::sort(collapses.begin(), collapses.end(), [](Collapse const& a, Collapse const& b) { return a.cost < b.cost; });
+
+        // a collapse removes about two triangles, and every one locks its neighbourhood for the
+        // rest of the pass so the flip tests stay valid
+        size_t triangle_count = indices.size() / 3;
+        size_t limit = std::max<size_t>((triangle_count - target_index_count / 3 + 1) / 2, 1);
+        adjacency.build(indices, vertex_count);
+        std::fill(touched.begin(), touched.end(), false);
+
+        size_t collapsed = 0;
+        for (Collapse const& collapse : collapses) {
+            if (collapsed >= limit)
+                break;
+            if (touched[collapse.from] || touched[collapse.to])
+                continue;
+
+            glm::vec3 target = vertices[collapse.to].pos;
+            bool flips = false;
+            for (uint32_t i = adjacency.offsets[collapse.from]; i < adjacency.offsets[collapse.from + 1] && !flips; i += 1) {
+                uint32_t const* triangle = indices.data() + adjacency.triangles[i] * 3;
+                if (triangle[0] == collapse.to || triangle[1] == collapse.to || triangle[2] == collapse.to)
+                    continue;
+                glm::vec3 p[3];
+                for (uint32_t corner = 0; corner < 3; corner += 1)
+                    p[corner] = vertices[triangle[corner]].pos;
+                glm::vec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+                for (uint32_t corner = 0; corner < 3; corner += 1) {
+                    if (triangle[corner] == collapse.from)
+                        p[corner] = target;
+                }
+                glm::vec3 after = glm::cross(p[1] - p[0], p[2] - p[0]);
+                flips = glm::dot(before, after) <= 0.0f;
+            }
+            if (flips)
+                continue;
+
+            for (uint32_t i = adjacency.offsets[collapse.from]; i < adjacency.offsets[collapse.from + 1]; i += 1) {
+                uint32_t* triangle = indices.data() + adjacency.triangles[i] * 3;
+                for (uint32_t corner = 0; corner < 3; corner += 1) {
+                    touched[triangle[corner]] = true;
+                    if (triangle[corner] == collapse.from)
+                        triangle[corner] = collapse.to;
+                }
+            }
+            add(quadrics[collapse.to], quadrics[collapse.from]);
+            max_error = std::max(max_error, collapse.cost);
+            collapsed += 1;
+        }
+        if (collapsed == 0)
+            break;
+
+        size_t kept = 0;
+        for (size_t t = 0; t < indices.size(); t += 3) {
+            uint32_t a = indices[t], b = indices[t + 1], c = indices[t + 2];
+            if (a == b || b == c || c == a)
+                continue;
+            indices[kept] = a;
+            indices[kept + 1] = b;
+            indices[kept + 2] = c;
+            kept += 3;
+        }
+        indices.resize(kept);
+    }
+
+    if (error)
+        *error = std::sqrt(max_error);
+    return indices;
+}
+
+LodChain build_lods(MeshData mesh, LodSettings const& settings)
+{
+    optimize_vertex_cache(mesh.indices, mesh.vertices.size());
+    optimize_vertex_fetch(mesh);
+
+    LodChain chain;
+    chain.lods.push_back({ 0, static_cast<uint32_t>(mesh.indices.size()), 0.0f });
+    std::vector<uint32_t> lod = mesh.indices;
+    float error = 0.0f;
+    while (chain.lods.size() < settings.max_lods) {
+        size_t target_triangles = static_cast<size_t>(float(lod.size() / 3) * settings.ratio);
+        if (target_triangles < settings.min_triangles)
+            break;
+
+        float lod_error;
+        std::vector<uint32_t> next = simplify(mesh.vertices, lod, target_triangles * 3, &lod_error);
+        // not even halfway there, whatever is left is locked
+        if (next.size() / 3 > (lod.size() / 3 + target_triangles) / 2)
+            break;
+
+        optimize_vertex_cache(next, mesh.vertices.size());
+        // simplified from the previous LOD, so the errors add up
+        error += lod_error;
+        chain.lods.push_back({ static_cast<uint32_t>(mesh.indices.size()), static_cast<uint32_t>(next.size()), error });
+        mesh.indices.insert(mesh.indices.end(), next.begin(), next.end());
+        lod.swap(next);
+    }
+
+    chain.mesh = std::move(mesh);
+    return chain;
+}
+
+std::vector<Meshlet> build_meshlets(std::vector<Vertex> const& vertices, std::vector<uint32_t> const& indices, uint32_t first_index, uint32_t index_count)
+{
+    std::vector<Meshlet> meshlets;
+    // the meshlet each vertex was last counted in
+    std::vector<uint32_t> seen(vertices.size(), UINT32_MAX);
+    uint32_t end = first_index + index_count;
+    uint32_t start = first_index;
+    while (start < end) {
+        uint32_t meshlet = static_cast<uint32_t>(meshlets.size());
+        uint32_t vertex_count = 0;
+        uint32_t triangle_end = start;
+        while (triangle_end < end && (triangle_end - start) / 3 < MESHLET_MAX_TRIANGLES) {
+            uint32_t added = 0;
+            for (uint32_t i = 0; i < 3; i += 1)
+                added += seen[indices[triangle_end + i]] != meshlet;
+            if (vertex_count + added > MESHLET_MAX_VERTICES)
+                break;
+            for (uint32_t i = 0; i < 3; i += 1) {
+                // a vertex repeated within the triangle is only counted once
+                if (seen[indices[triangle_end + i]] != meshlet) {
+                    seen[indices[triangle_end + i]] = meshlet;
+                    vertex_count += 1;
+                }
+            }
+            triangle_end += 3;
+        }
+
+        Meshlet result {};
+        result.first_index = start;
+        result.index_count = triangle_end - start;
+
+        Bounds bounds = Bounds::empty();
+        for (uint32_t i = start; i < triangle_end; i += 1)
+            bounds.grow(vertices[indices[i]].pos);
+        result.center = bounds.center();
+        for (uint32_t i = start; i < triangle_end; i += 1)
+            result.radius = std::max(result.radius, glm::length(vertices[indices[i]].pos - result.center));
+
+        // the average normal, and how far the furthest one is from it
+        glm::vec3 sum(0.0f);
+        for (uint32_t i = start; i < triangle_end; i += 3) {
+            glm::vec3 a = vertices[indices[i]].pos;
+            glm::vec3 normal = glm::cross(vertices[indices[i + 1]].pos - a, vertices[indices[i + 2]].pos - a);
+            float length = glm::length(normal);
+            if (length > 0.0f)
+                sum += normal / length;
+        }
+        float sum_length = glm::length(sum);
+        result.cone_axis = sum_length > 0.0f ? sum / sum_length : glm::vec3(0.0f, 0.0f, 1.0f);
+        float min_dot = sum_length > 0.0f ? 1.0f : -1.0f;
+        for (uint32_t i = start; i < triangle_end; i += 3) {
+            glm::vec3 a = vertices[indices[i]].pos;
+            glm::vec3 normal = glm::cross(vertices[indices[i + 1]].pos - a, vertices[indices[i + 2]].pos - a);
+            float length = glm::length(normal);
+            if (length > 0.0f)
+                min_dot = std::min(min_dot, glm::dot(normal / length, result.cone_axis));
+        }
+        result.cone_cutoff = min_dot > 0.0f ? std::sqrt(1.0f - min_dot * min_dot) : 1.0f;
+
+        meshlets.push_back(result);
+        start = triangle_end;
+    }
+    return meshlets;
+}
+
+}
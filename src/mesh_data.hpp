@@ -0,0 +1,97 @@
+#ifndef _HB_MESH_DATA
+#define _HB_MESH_DATA
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+namespace HB {
+
+struct Vertex {
+    glm::vec3 pos;
+    glm::vec3 color;
+    glm::vec2 uv;
+};
+
+// an indexed triangle list
+struct MeshData {
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+};
+
+// Reads the positions, texture coordinates and faces of a Wavefront OBJ, polygons become triangle
+// fans. Vertex colors ("v x y z r g b") are read when present, white otherwise. Normals, groups
+// and materials are skipped.
+MeshData load_obj(std::string const& path);
+
+// Reorders the triangles for the post-transform vertex cache, after Tom Forsyth's "Linear-Speed
+// Vertex Cache Optimisation": the next triangle is the best scoring one around the vertices that
+// were just used.
+void optimize_vertex_cache(std::vector<uint32_t>& indices, size_t vertex_count);
+// Renumbers the vertices in the order the indices first use them, so vertex fetch walks the
+// buffer front to back. Unused vertices are dropped.
+void optimize_vertex_fetch(MeshData&);
+// vertices transformed per triangle with a FIFO cache of `cache_size` entries, 3 is no reuse at
+// all and a large regular mesh can get close to 0.5
+float average_cache_miss_ratio(std::vector<uint32_t> const& indices, size_t vertex_count, uint32_t cache_size = 16);
+
+// Collapses edges by quadric error (Garland and Heckbert) until at most `target_index_count`
+// indices are left or nothing can collapse without flipping a triangle. Vertices only ever move
+// onto other vertices, so the result indexes the same vertex array. Borders are held by extra
+// planes along them, vertices on attribute seams (one position, several vertices) stay put.
+// `error` gets the largest distance from the input surface a collapse introduced.
+std::vector<uint32_t> simplify(std::vector<Vertex> const&, std::vector<uint32_t> const& indices, size_t target_index_count, float* error = nullptr);
+
+struct MeshLod {
+    uint32_t first_index;
+    uint32_t index_count;
+    // how far it may be from the full detail mesh, in the mesh's units
+    float error;
+};
+
+struct LodSettings {
+    uint32_t max_lods = 8;
+    // triangles of every LOD relative to the one before
+    float ratio = 0.5f;
+    // the chain stops before a LOD would have fewer
+    uint32_t min_triangles = 32;
+};
+
+// A mesh optimized for vertex cache and fetch, with all of its LODs back to back in
+// `mesh.indices`, full detail first. Every LOD is simplified from the one before it.
+struct LodChain {
+    MeshData mesh;
+    std::vector<MeshLod> lods;
+};
+
+LodChain build_lods(MeshData, LodSettings const& = {});
+
+// A cluster of a LOD's triangles, culled on its own. Its triangles are a run of the LOD's indices,
+// so it draws like any other index range. Laid out as the culling shader reads it.
+struct Meshlet {
+    uint32_t first_index;
+    uint32_t index_count;
+    // bounding sphere in the mesh's own space
+    glm::vec3 center;
+    float radius;
+    // Every triangle's normal, cross(b - a, c - a), is within the cone around the axis. The cutoff
+    // is the sine of its half angle, 1 when they point every way and the cone can't cull.
+    glm::vec3 cone_axis;
+    float cone_cutoff;
+};
+
+uint32_t const MESHLET_MAX_VERTICES = 64;
+uint32_t const MESHLET_MAX_TRIANGLES = 124;
+
+// Splits the triangles of indices[first_index, first_index + index_count) into meshlets, in order,
+// each with at most MESHLET_MAX_VERTICES distinct vertices and MESHLET_MAX_TRIANGLES triangles.
+// After optimize_vertex_cache() consecutive triangles share most of their vertices, so the runs
+// are compact patches of the surface.
+std::vector<Meshlet> build_meshlets(std::vector<Vertex> const&, std::vector<uint32_t> const& indices, uint32_t first_index, uint32_t index_count);
+
+}
+
+#endif
@@ -0,0 +1,290 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <stdexcept>
+
+#include "meshlet_culler.hpp"
+#include "stats.hpp"
+
+namespace HB {
+
+namespace {
+
+    struct CullConstants {
+        glm::mat4 view_projection;
+        glm::vec4 depth;
+        uint32_t first_meshlet;
+        uint32_t meshlet_count;
+        uint32_t first_instance;
+        uint32_t instance_count;
+        uint32_t first_command;
+        uint32_t count_index;
+        int32_t vertex_offset;
+        float facing;
+        uint32_t compact;
+    };
+
+    enum Binding : uint32_t {
+        MESHLETS,
+        INSTANCES,
+        COMMANDS,
+        COUNTS,
+        BINDING_COUNT,
+    };
+
+    // local_size_x of meshlet_cull.glsl
+    uint32_t const GROUP_SIZE = 64;
+
+}
+
+MeshletCuller::MeshletCuller(GpuContext const& gpu, MeshManager const& meshes, bool draw_indirect_count, uint32_t frames_in_flight)
+    : m_gpu(gpu)
+    , m_meshes(meshes)
+    , m_frames(frames_in_flight)
+{
+    m_supported = m_gpu.enabled_features.multiDrawIndirect && m_gpu.enabled_features.drawIndirectFirstInstance;
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(m_gpu.physical_device, &properties);
+    // every command is also a thread of a one dimensional dispatch
+    uint64_t max_threads = uint64_t(properties.limits.maxComputeWorkGroupCount[0]) * GROUP_SIZE;
+    m_max_commands = static_cast<uint32_t>(std::min<uint64_t>(properties.limits.maxDrawIndirectCount, max_threads));
+
+    if (draw_indirect_count)
+        m_draw_indexed_indirect_count = (PFN_vkCmdDrawIndexedIndirectCountKHR)vkGetDeviceProcAddr(m_gpu.device, "vkCmdDrawIndexedIndirectCountKHR");
+
+    create_descriptors(frames_in_flight);
+
+    VkPushConstantRange push_constant_range {};
+    push_constant_range.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    push_constant_range.offset = 0;
+    push_constant_range.size = sizeof(CullConstants);
+
+    VkPipelineLayoutCreateInfo pipeline_layout_info {};
+    pipeline_layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipeline_layout_info.setLayoutCount = 1;
+    pipeline_layout_info.pSetLayouts = &m_set_layout;
+    pipeline_layout_info.pushConstantRangeCount = 1;
+    pipeline_layout_info.pPushConstantRanges = &push_constant_range;
+
+    if (vkCreatePipelineLayout(m_gpu.device, &pipeline_layout_info, nullptr, &m_layout) != VK_SUCCESS)
+        throw std::runtime_error("failed to create meshlet culling pipeline layout!");
+
+    // compute only, there is no render pass or vertex input
+    m_pipelines = std::make_unique<PipelineCache>(m_gpu, m_layout, VK_NULL_HANDLE, std::vector<VkVertexInputBindingDescription> {}, std::vector<VkVertexInputAttributeDescription> {});
+    if (m_supported)
+        m_cull_pipeline = m_pipelines->compute("meshlet_cull");
+}
+
+MeshletCuller::~MeshletCuller()
+{
+    for (FrameData& frame : m_frames)
+        destroy_buffers(frame);
+    m_pipelines.reset();
+    vkDestroyPipelineLayout(m_gpu.device, m_layout, nullptr);
+    vkDestroyDescriptorPool(m_gpu.device, m_descriptor_pool, nullptr);
+    vkDestroyDescriptorSetLayout(m_gpu.device, m_set_layout, nullptr);
+}
+
+void MeshletCuller::create_descriptors(uint32_t frames_in_flight)
+{
+    std::array<VkDescriptorSetLayoutBinding, BINDING_COUNT> bindings {};
+    for (uint32_t i = 0; i < BINDING_COUNT; i += 1) {
+        bindings[i].binding = i;
+        bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        bindings[i].descriptorCount = 1;
+        bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    }
+
+    VkDescriptorSetLayoutCreateInfo layout_info {};
+    layout_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layout_info.bindingCount = BINDING_COUNT;
+    layout_info.pBindings = bindings.data();
+
+    if (vkCreateDescriptorSetLayout(m_gpu.device, &layout_info, nullptr, &m_set_layout) != VK_SUCCESS)
+        throw std::runtime_error("failed to create meshlet culling descriptor set layout!");
+
+    VkDescriptorPoolSize pool_size {};
+    pool_size.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    pool_size.descriptorCount = frames_in_flight * BINDING_COUNT;
+
+    VkDescriptorPoolCreateInfo pool_info {};
+    pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    pool_info.poolSizeCount = 1;
+    pool_info.pPoolSizes = &pool_size;
+    pool_info.maxSets = frames_in_flight;
+
+    if (vkCreateDescriptorPool(m_gpu.device, &pool_info, nullptr, &m_descriptor_pool) != VK_SUCCESS)
+        throw std::runtime_error("failed to create meshlet culling descriptor pool!");
+
+    std::vector<VkDescriptorSetLayout> layouts(frames_in_flight, m_set_layout);
+    std::vector<VkDescriptorSet> sets(frames_in_flight);
+
+    VkDescriptorSetAllocateInfo alloc_info {};
+    alloc_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    alloc_info.descriptorPool = m_descriptor_pool;
+    alloc_info.descriptorSetCount = frames_in_flight;
+    alloc_info.pSetLayouts = layouts.data();
+
+    if (vkAllocateDescriptorSets(m_gpu.device, &alloc_info, sets.data()) != VK_SUCCESS)
+        throw std::runtime_error("failed to allocate meshlet culling descriptor sets!");
+
+    for (uint32_t i = 0; i < frames_in_flight; i += 1)
+        m_frames[i].descriptor_set = sets[i];
+}
+
+void MeshletCuller::create_buffers(FrameData& frame, uint32_t commands, uint32_t counts)
+{
+    VkBufferUsageFlags usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT;
+    Gpu::create_buffer(m_gpu, VkDeviceSize(commands) * sizeof(VkDrawIndexedIndirectCommand), usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, frame.commands, frame.commands_memory, MemoryClass::FRAME);
+    frame.command_capacity = commands;
+    Gpu::create_buffer(m_gpu, VkDeviceSize(counts) * sizeof(uint32_t), usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, frame.counts, frame.counts_memory, MemoryClass::FRAME);
+    frame.count_capacity = counts;
+}
+
+void MeshletCuller::destroy_buffers(FrameData& frame)
+{
+    if (frame.commands == VK_NULL_HANDLE)
+        return;
+
+    Gpu::destroy_buffer(m_gpu, frame.commands, frame.commands_memory);
+    Gpu::destroy_buffer(m_gpu, frame.counts, frame.counts_memory);
+    frame.commands = VK_NULL_HANDLE;
+    frame.commands_memory = VK_NULL_HANDLE;
+    frame.command_capacity = 0;
+    frame.counts = VK_NULL_HANDLE;
+    frame.counts_memory = VK_NULL_HANDLE;
+    frame.count_capacity = 0;
+}
+
+void MeshletCuller::record_compute(VkCommandBuffer command_buffer, uint32_t frame_index, VkBuffer instances, Draw const* draws, uint32_t draw_count)
+{
+    FrameData& frame = m_frames[frame_index];
+    frame.chunks.clear();
+    frame.draw_chunks.clear();
+    if (!m_supported || draw_count == 0)
+        return;
+
+    uint32_t command_count = 0;
+    for (uint32_t i = 0; i < draw_count; i += 1) {
+        frame.draw_chunks.push_back(static_cast<uint32_t>(frame.chunks.size()));
+        uint32_t meshlet_count = m_meshes.lod(draws[i].lod).meshlet_count;
+        uint32_t per_chunk = std::max(m_max_commands / meshlet_count, 1u);
+        for (uint32_t first = 0; first < draws[i].instance_count; first += per_chunk) {
+            uint32_t count = std::min(draws[i].instance_count - first, per_chunk) * meshlet_count;
+            frame.chunks.push_back({ command_count, count });
+            command_count += count;
+        }
+    }
+    frame.draw_chunks.push_back(static_cast<uint32_t>(frame.chunks.size()));
+    uint32_t chunk_count = static_cast<uint32_t>(frame.chunks.size());
+
+    // this frame's last use of them is done, its fence has been waited on
+    if (command_count > frame.command_capacity || chunk_count > frame.count_capacity) {
+        uint32_t commands = std::max(command_count, frame.command_capacity * 2);
+        uint32_t counts = std::max(chunk_count, frame.count_capacity * 2);
+        destroy_buffers(frame);
+        create_buffers(frame, commands, counts);
+        frame.version += 1;
+    }
+
+    // the instance and meshlet buffers may have been replaced since the last frame
+    std::array<VkBuffer, BINDING_COUNT> buffers = { m_meshes.meshlet_buffer(), instances, frame.commands, frame.counts };
+    std::array<VkDescriptorBufferInfo, BINDING_COUNT> buffer_infos {};
+    std::array<VkWriteDescriptorSet, BINDING_COUNT> writes {};
+    for (uint32_t i = 0; i < BINDING_COUNT; i += 1) {
+        buffer_infos[i].buffer = buffers[i];
+        buffer_infos[i].offset = 0;
+        buffer_infos[i].range = VK_WHOLE_SIZE;
+
+        writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writes[i].dstSet = frame.descriptor_set;
+        writes[i].dstBinding = i;
+        writes[i].dstArrayElement = 0;
+        writes[i].descriptorCount = 1;
+        writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        writes[i].pBufferInfo = &buffer_infos[i];
+    }
+    vkUpdateDescriptorSets(m_gpu.device, BINDING_COUNT, writes.data(), 0, nullptr);
+
+    bool compact = m_draw_indexed_indirect_count != nullptr;
+    if (compact) {
+        vkCmdFillBuffer(command_buffer, frame.counts, 0, VkDeviceSize(chunk_count) * sizeof(uint32_t), 0);
+
+        VkMemoryBarrier barrier {};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+        vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+    }
+
+    vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_cull_pipeline);
+    Stats::count(Counter::PIPELINE_BINDS);
+    vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_layout, 0, 1, &frame.descriptor_set, 0, nullptr);
+    Stats::count(Counter::DESCRIPTOR_BINDS);
+
+    for (uint32_t i = 0; i < draw_count; i += 1) {
+        Draw const& draw = draws[i];
+        LodRange const& lod = m_meshes.lod(draw.lod);
+
+        // Depth increases along inverse(view_projection) * (0, 0, 1, 0) taken as a homogeneous
+        // point, x - p * w at p: away from the eye for perspective views, and the same direction
+        // everywhere for orthographic ones, where w is 0.
+        CullConstants constants {};
+        constants.view_projection = draw.view_projection;
+        glm::vec4 depth = glm::inverse(draw.view_projection) * glm::vec4(0.0f, 0.0f, 1.0f, 0.0f);
+        float depth_length = glm::length(glm::vec3(depth));
+        if (std::abs(depth.w) > depth_length * 1e-6f)
+            constants.depth = depth / std::abs(depth.w);
+        else
+            constants.depth = glm::vec4(glm::vec3(depth) / std::max(depth_length, 1e-20f), 0.0f);
+        // A triangle is front facing in clockwise order when its normal points along depth, as
+        // long as the view doesn't mirror it. The cone test culls when they all point along it.
+        if ((draw.cull_mode & VK_CULL_MODE_BACK_BIT) != 0) {
+            float determinant = glm::determinant(draw.view_projection);
+            float clockwise = draw.front_face == VK_FRONT_FACE_CLOCKWISE ? 1.0f : -1.0f;
+            constants.facing = determinant > 0.0f ? -clockwise : determinant < 0.0f ? clockwise : 0.0f;
+        }
+        constants.first_meshlet = lod.first_meshlet;
+        constants.meshlet_count = lod.meshlet_count;
+        constants.vertex_offset = lod.vertex_offset;
+        constants.compact = compact;
+
+        uint32_t first_instance = 0;
+        for (uint32_t chunk = frame.draw_chunks[i]; chunk < frame.draw_chunks[i + 1]; chunk += 1) {
+            uint32_t instance_count = frame.chunks[chunk].command_count / lod.meshlet_count;
+            constants.first_instance = draw.first_instance + first_instance;
+            constants.instance_count = instance_count;
+            constants.first_command = frame.chunks[chunk].first_command;
+            constants.count_index = chunk;
+            vkCmdPushConstants(command_buffer, m_layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(constants), &constants);
+
+            vkCmdDispatch(command_buffer, (frame.chunks[chunk].command_count + GROUP_SIZE - 1) / GROUP_SIZE, 1, 1);
+            Stats::count(Counter::DISPATCHES);
+            first_instance += instance_count;
+        }
+        Stats::count(Counter::MESHLETS, uint64_t(draw.instance_count) * lod.meshlet_count);
+    }
+
+    VkMemoryBarrier barrier {};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+    vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+}
+
+uint32_t MeshletCuller::record(VkCommandBuffer command_buffer, uint32_t frame_index, uint32_t draw) const
+{
+    FrameData const& frame = m_frames[frame_index];
+    for (uint32_t i = frame.draw_chunks[draw]; i < frame.draw_chunks[draw + 1]; i += 1) {
+        Chunk const& chunk = frame.chunks[i];
+        VkDeviceSize offset = VkDeviceSize(chunk.first_command) * sizeof(VkDrawIndexedIndirectCommand);
+        if (m_draw_indexed_indirect_count != nullptr)
+            m_draw_indexed_indirect_count(command_buffer, frame.commands, offset, frame.counts, VkDeviceSize(i) * sizeof(uint32_t), chunk.command_count, sizeof(VkDrawIndexedIndirectCommand));
+        else
+            vkCmdDrawIndexedIndirect(command_buffer, frame.commands, offset, chunk.command_count, sizeof(VkDrawIndexedIndirectCommand));
+    }
+    return frame.draw_chunks[draw + 1] - frame.draw_chunks[draw];
+}
+
+}
@@ -0,0 +1,95 @@
+#ifndef _HB_MESHLET_CULLER
+#define _HB_MESHLET_CULLER
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "gpu.hpp"
+#include "mesh.hpp"
+#include "pipeline.hpp"
+
+namespace HB {
+
+// Culls the meshlets of dense meshes on the GPU, per instance: a compute pass before the scene
+// passes tests every meshlet against the frustum and its normal cone, and writes an indexed
+// indirect draw for each one that is left. Per-object culling on the CPU has already dropped
+// whole instances, this drops the parts of the ones that are left that face away or are off
+// screen.
+//
+// With VK_KHR_draw_indirect_count the visible meshlets are compacted and their count read by the
+// GPU, without it every meshlet keeps a draw and culled ones draw nothing.
+class MeshletCuller {
+public:
+    // an instanced draw of a LOD with meshlets, as the scene pass would have drawn it
+    struct Draw {
+        glm::mat4 view_projection;
+        uint32_t lod;
+        uint32_t first_instance;
+        uint32_t instance_count;
+        // the pipeline's, back facing meshlets are only culled when it culls back faces
+        VkCullModeFlags cull_mode;
+        VkFrontFace front_face;
+    };
+
+    MeshletCuller(GpuContext const&, MeshManager const&, bool draw_indirect_count, uint32_t frames_in_flight);
+    ~MeshletCuller();
+    MeshletCuller(MeshletCuller const&) = delete;
+    MeshletCuller& operator=(MeshletCuller const&) = delete;
+
+    // needs multiDrawIndirect and drawIndirectFirstInstance, without them draws stay as they are
+    bool supported() const { return m_supported; }
+
+    // outside the passes, once the instance buffer is written
+    void record_compute(VkCommandBuffer, uint32_t frame, VkBuffer instances, Draw const* draws, uint32_t draw_count);
+    // draws[draw] of record_compute(), inside the pass with the meshes and instances bound,
+    // returns the indirect draws it recorded for the caller to count
+    uint32_t record(VkCommandBuffer, uint32_t frame, uint32_t draw) const;
+    // counts up whenever the frame's command buffers are replaced, what record() recorded into
+    // a command buffer that is kept has to be recorded again then
+    uint64_t version(uint32_t frame) const { return m_frames[frame].version; }
+
+private:
+    // part of a draw's instances, so no indirect draw has more commands than the device allows
+    struct Chunk {
+        uint32_t first_command;
+        uint32_t command_count;
+    };
+
+    struct FrameData {
+        VkBuffer commands = VK_NULL_HANDLE;
+        VkDeviceMemory commands_memory = VK_NULL_HANDLE;
+        uint32_t command_capacity = 0;
+        // one per chunk, for compaction
+        VkBuffer counts = VK_NULL_HANDLE;
+        VkDeviceMemory counts_memory = VK_NULL_HANDLE;
+        uint32_t count_capacity = 0;
+        VkDescriptorSet descriptor_set = VK_NULL_HANDLE;
+        std::vector<Chunk> chunks;
+        // the first chunk of every draw, and one past the last
+        std::vector<uint32_t> draw_chunks;
+        uint64_t version = 0;
+    };
+
+    GpuContext m_gpu;
+    MeshManager const& m_meshes;
+    bool m_supported;
+    PFN_vkCmdDrawIndexedIndirectCountKHR m_draw_indexed_indirect_count = nullptr;
+    uint32_t m_max_commands;
+    VkDescriptorSetLayout m_set_layout;
+    VkDescriptorPool m_descriptor_pool;
+    VkPipelineLayout m_layout;
+    std::unique_ptr<PipelineCache> m_pipelines;
+    VkPipeline m_cull_pipeline = VK_NULL_HANDLE;
+    std::vector<FrameData> m_frames;
+
+    void create_descriptors(uint32_t frames_in_flight);
+    void create_buffers(FrameData&, uint32_t commands, uint32_t counts);
+    void destroy_buffers(FrameData&);
+};
+
+}
+
+#endif
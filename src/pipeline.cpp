@@ -0,0 +1,326 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+#include <utility>
+
+#include "embedded_shaders.hpp"
+#include "pipeline.hpp"
+#include "stats.hpp"
+#include "util.hpp"
+
+namespace HB {
+
+static void hash_combine(size_t& seed, size_t value)
+{
+    seed ^= value + 0x9e3779b97f4a7c15 + (seed << 6) + (seed >> 2);
+}
+
+size_t PipelineDesc::hash() const
+{
+    size_t seed = std::hash<std::string> {}(vertex_shader);
+    hash_combine(seed, std::hash<std::string> {}(fragment_shader));
+    hash_combine(seed, topology);
+    hash_combine(seed, cull_mode);
+    hash_combine(seed, front_face);
+    hash_combine(seed, static_cast<uint32_t>(blend));
+    hash_combine(seed, specialization_count);
+    for (uint32_t i = 0; i < specialization_count; i += 1)
+        hash_combine(seed, specialization[i]);
+    return seed;
+}
+
+PipelineCache::PipelineCache(GpuContext const& gpu, VkPipelineLayout layout, VkRenderPass render_pass,
+    std::vector<VkVertexInputBindingDescription> bindings,
+    std::vector<VkVertexInputAttributeDescription> attributes)
+    : m_gpu(gpu)
+    , m_layout(layout)
+    , m_render_pass(render_pass)
+    , m_bindings(std::move(bindings))
+    , m_attributes(std::move(attributes))
+{
+    VkPipelineCacheCreateInfo cache_info {};
+    cache_info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+
+    if (vkCreatePipelineCache(m_gpu.device, &cache_info, nullptr, &m_vulkan_cache) != VK_SUCCESS)
+        throw std::runtime_error("failed to create pipeline cache!");
+
+    if (char const* directory = std::getenv("HB_SHADER_DIR"))
+        m_shader_directory = directory;
+}
+
+PipelineCache::~PipelineCache()
+{
+    for (auto& [desc, pipeline] : m_pipelines) {
+        vkDestroyPipeline(m_gpu.device, pipeline.get(), nullptr);
+        Stats::count(Counter::OBJECTS_DESTROYED);
+    }
+    for (auto& [name, pipeline] : m_compute_pipelines) {
+        vkDestroyPipeline(m_gpu.device, pipeline, nullptr);
+        Stats::count(Counter::OBJECTS_DESTROYED);
+    }
+    for (auto& [path, module] : m_shader_modules)
+        vkDestroyShaderModule(m_gpu.device, module, nullptr);
+    vkDestroyPipelineCache(m_gpu.device, m_vulkan_cache, nullptr);
+}
+
+VkPipeline PipelineCache::get(PipelineDesc const& desc)
+{
+    m_requests.fetch_add(1, std::memory_order_relaxed);
+
+    {
+        std::shared_lock lock(m_mutex);
+        auto it = m_pipelines.find(desc);
+        if (it != m_pipelines.end()) {
+            m_hits.fetch_add(1, std::memory_order_relaxed);
+            std::shared_future<VkPipeline> pipeline = it->second;
+            lock.unlock();
+            return pipeline.get();
+        }
+    }
+
+    std::promise<VkPipeline> promise;
+    {
+        std::unique_lock lock(m_mutex);
+        // someone else may have started on it between the two locks
+        auto [it, inserted] = m_pipelines.try_emplace(desc, promise.get_future().share());
+        if (!inserted) {
+            m_hits.fetch_add(1, std::memory_order_relaxed);
+            std::shared_future<VkPipeline> pipeline = it->second;
+            lock.unlock();
+            return pipeline.get();
+        }
+    }
+
+    try {
+        VkPipeline pipeline = create(desc);
+        promise.set_value(pipeline);
+        return pipeline;
+    } catch (...) {
+        // waiters get the error, and the next request tries again
+        promise.set_exception(std::current_exception());
+        std::unique_lock lock(m_mutex);
+        m_pipelines.erase(desc);
+        throw;
+    }
+}
+
+VkPipeline PipelineCache::compute(std::string const& shader)
+{
+    m_requests.fetch_add(1, std::memory_order_relaxed);
+
+    std::unique_lock lock(m_mutex);
+    auto it = m_compute_pipelines.find(shader);
+    if (it != m_compute_pipelines.end()) {
+        m_hits.fetch_add(1, std::memory_order_relaxed);
+        return it->second;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    VkComputePipelineCreateInfo pipeline_info {};
+    pipeline_info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipeline_info.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    pipeline_info.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    pipeline_info.stage.module = shader_module(shader);
+    pipeline_info.stage.pName = "main";
+    pipeline_info.layout = m_layout;
+
+    VkPipeline pipeline;
+    if (vkCreateComputePipelines(m_gpu.device, m_vulkan_cache, 1, &pipeline_info, nullptr, &pipeline) != VK_SUCCESS)
+        throw std::runtime_error("failed to create compute pipeline!");
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+    m_creation_ns.fetch_add(elapsed.count(), std::memory_order_relaxed);
+    m_pipelines_created.fetch_add(1, std::memory_order_relaxed);
+    Stats::count(Counter::OBJECTS_CREATED);
+
+    m_compute_pipelines.emplace(shader, pipeline);
+    return pipeline;
+}
+
+size_t PipelineCache::size() const
+{
+    std::shared_lock lock(m_mutex);
+    return m_pipelines.size() + m_compute_pipelines.size();
+}
+
+VkShaderModule PipelineCache::shader_module(std::string const& name)
+{
+    std::lock_guard lock(m_shader_mutex);
+    auto it = m_shader_modules.find(name);
+    if (it != m_shader_modules.end())
+        return it->second;
+
+    auto start = std::chrono::steady_clock::now();
+
+    VkShaderModuleCreateInfo create_info {};
+    create_info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+
+    std::vector<char> source;
+    if (!m_shader_directory.empty()) {
+        source = Util::read_file(m_shader_directory + "/" + name + ".spv");
+        create_info.codeSize = source.size();
+        create_info.pCode = reinterpret_cast<uint32_t const*>(source.data());
+    } else {
+        // used in place, the arrays are uint32_t so they are aligned as Vulkan wants
+        auto embedded = std::find_if(std::begin(EmbeddedShaders::ALL), std::end(EmbeddedShaders::ALL), [&name](EmbeddedShaders::Entry const& entry) {
+            return name == entry.name;
+        });
+        if (embedded == std::end(EmbeddedShaders::ALL))
+            throw std::runtime_error("failed to find embedded shader!");
+        create_info.codeSize = embedded->size;
+        create_info.pCode = embedded->code;
+    }
+
+    VkShaderModule module;
+    if (vkCreateShaderModule(m_gpu.device, &create_info, nullptr, &module) != VK_SUCCESS)
+        throw std::runtime_error("failed to create shader module!");
+
+    m_shader_modules.emplace(name, module);
+    m_shader_modules_created.fetch_add(1, std::memory_order_relaxed);
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+    m_shader_ns.fetch_add(elapsed.count(), std::memory_order_relaxed);
+    return module;
+}
+
+VkPipeline PipelineCache::create(PipelineDesc const& desc)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    std::array<VkSpecializationMapEntry, PipelineDesc::MAX_SPECIALIZATION_CONSTANTS> map_entries;
+    for (uint32_t i = 0; i < desc.specialization_count; i += 1) {
+        map_entries[i].constantID = i;
+        map_entries[i].offset = i * sizeof(uint32_t);
+        map_entries[i].size = sizeof(uint32_t);
+    }
+    VkSpecializationInfo specialization_info {};
+    specialization_info.mapEntryCount = desc.specialization_count;
+    specialization_info.pMapEntries = map_entries.data();
+    specialization_info.dataSize = desc.specialization_count * sizeof(uint32_t);
+    specialization_info.pData = desc.specialization.data();
+
+    std::array<VkPipelineShaderStageCreateInfo, 2> shader_stages {};
+    shader_stages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    shader_stages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+    shader_stages[0].module = shader_module(desc.vertex_shader);
+    shader_stages[0].pName = "main";
+    shader_stages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    shader_stages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+    shader_stages[1].module = shader_module(desc.fragment_shader);
+    shader_stages[1].pName = "main";
+    if (desc.specialization_count > 0) {
+        shader_stages[0].pSpecializationInfo = &specialization_info;
+        shader_stages[1].pSpecializationInfo = &specialization_info;
+    }
+
+    VkPipelineVertexInputStateCreateInfo vertex_input_info {};
+    vertex_input_info.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+    vertex_input_info.vertexBindingDescriptionCount = static_cast<uint32_t>(m_bindings.size());
+    vertex_input_info.pVertexBindingDescriptions = m_bindings.data();
+    vertex_input_info.vertexAttributeDescriptionCount = static_cast<uint32_t>(m_attributes.size());
+    vertex_input_info.pVertexAttributeDescriptions = m_attributes.data();
+
+    VkPipelineInputAssemblyStateCreateInfo input_assembly {};
+    input_assembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+    input_assembly.topology = desc.topology;
+    input_assembly.primitiveRestartEnable = VK_FALSE;
+
+    // viewport and scissor are dynamic, they follow the render scale
+    VkPipelineViewportStateCreateInfo viewport_state {};
+    viewport_state.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+    viewport_state.viewportCount = 1;
+    viewport_state.scissorCount = 1;
+
+    VkPipelineRasterizationStateCreateInfo rasterizer {};
+    rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+    rasterizer.depthClampEnable = VK_FALSE;
+    rasterizer.rasterizerDiscardEnable = VK_FALSE;
+    rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
+    rasterizer.lineWidth = 1.0f;
+    rasterizer.cullMode = desc.cull_mode;
+    rasterizer.frontFace = desc.front_face;
+    rasterizer.depthBiasEnable = VK_FALSE;
+
+    VkPipelineMultisampleStateCreateInfo multisampling {};
+    multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+    multisampling.sampleShadingEnable = VK_FALSE;
+    multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+    VkPipelineColorBlendAttachmentState color_blend_attachment {};
+    color_blend_attachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+    color_blend_attachment.blendEnable = desc.blend == BlendMode::NONE ? VK_FALSE : VK_TRUE;
+    color_blend_attachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+    color_blend_attachment.dstColorBlendFactor = desc.blend == BlendMode::ADDITIVE ? VK_BLEND_FACTOR_ONE : VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+    color_blend_attachment.colorBlendOp = VK_BLEND_OP_ADD;
+    color_blend_attachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+    color_blend_attachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+    color_blend_attachment.alphaBlendOp = VK_BLEND_OP_ADD;
+
+    VkPipelineColorBlendStateCreateInfo color_blending {};
+    color_blending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+    color_blending.logicOpEnable = VK_FALSE;
+    color_blending.attachmentCount = 1;
+    color_blending.pAttachments = &color_blend_attachment;
+
+    std::array<VkDynamicState, 2> dynamic_states = {
+        VK_DYNAMIC_STATE_VIEWPORT,
+        VK_DYNAMIC_STATE_SCISSOR,
+    };
+    VkPipelineDynamicStateCreateInfo dynamic_state {};
+    dynamic_state.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+    dynamic_state.dynamicStateCount = static_cast<uint32_t>(dynamic_states.size());
+    dynamic_state.pDynamicStates = dynamic_states.data();
+
+    VkGraphicsPipelineCreateInfo pipeline_info {};
+    pipeline_info.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+    pipeline_info.stageCount = static_cast<uint32_t>(shader_stages.size());
+    pipeline_info.pStages = shader_stages.data();
+    pipeline_info.pVertexInputState = &vertex_input_info;
+    pipeline_info.pInputAssemblyState = &input_assembly;
+    pipeline_info.pViewportState = &viewport_state;
+    pipeline_info.pRasterizationState = &rasterizer;
+    pipeline_info.pMultisampleState = &multisampling;
+    pipeline_info.pColorBlendState = &color_blending;
+    pipeline_info.pDynamicState = &dynamic_state;
+    pipeline_info.layout = m_layout;
+    pipeline_info.renderPass = m_render_pass;
+    pipeline_info.subpass = 0;
+
+    VkPipeline pipeline;
+    if (vkCreateGraphicsPipelines(m_gpu.device, m_vulkan_cache, 1, &pipeline_info, nullptr, &pipeline) != VK_SUCCESS)
+        throw std::runtime_error("failed to create graphics pipeline!");
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+    m_creation_ns.fetch_add(elapsed.count(), std::memory_order_relaxed);
+    m_pipelines_created.fetch_add(1, std::memory_order_relaxed);
+    Stats::count(Counter::OBJECTS_CREATED);
+
+    return pipeline;
+}
+
+PipelineCacheStats PipelineCache::stats() const
+{
+    PipelineCacheStats stats {};
+    stats.requests = m_requests.load();
+    stats.hits = m_hits.load();
+    stats.pipelines_created = m_pipelines_created.load();
+    stats.shader_modules_created = m_shader_modules_created.load();
+    stats.creation_ms = m_creation_ns.load() / 1e6;
+    stats.shader_ms = m_shader_ns.load() / 1e6;
+    return stats;
+}
+
+void PipelineCache::print_report() const
+{
+    PipelineCacheStats stats = this->stats();
+    std::cout << "pipelines: " << stats.requests << " requests, " << stats.hits << " hits ("
+              << stats.hit_rate() * 100.0 << "%), " << stats.pipelines_created << " created in "
+              << stats.creation_ms << " ms, " << stats.shader_modules_created << " shader modules in "
+              << stats.shader_ms << " ms\n";
+}
+
+}
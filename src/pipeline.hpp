@@ -0,0 +1,118 @@
+#ifndef _HB_PIPELINE
+#define _HB_PIPELINE
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "gpu.hpp"
+
+namespace HB {
+
+enum class BlendMode : uint32_t {
+    NONE,
+    // straight alpha, src * a + dst * (1 - a)
+    ALPHA,
+    ADDITIVE,
+};
+
+// The state that differs between pipelines of one pass. Layout, render pass and vertex input are
+// the same for all of them and belong to the PipelineCache.
+struct PipelineDesc {
+    static uint32_t const MAX_SPECIALIZATION_CONSTANTS = 8;
+
+    // by name, the file stem in src/shaders, e.g. "vert" for vert.glsl
+    std::string vertex_shader = "vert";
+    std::string fragment_shader = "frag";
+    VkPrimitiveTopology topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+    VkCullModeFlags cull_mode = VK_CULL_MODE_BACK_BIT;
+    VkFrontFace front_face = VK_FRONT_FACE_CLOCKWISE;
+    BlendMode blend = BlendMode::NONE;
+    // constant_id i is specialization[i] in both stages, e.g. 0/1 for shader feature toggles,
+    // unused entries have to stay 0 so equal states compare equal
+    uint32_t specialization_count = 0;
+    std::array<uint32_t, MAX_SPECIALIZATION_CONSTANTS> specialization {};
+
+    bool operator==(PipelineDesc const&) const = default;
+    size_t hash() const;
+};
+
+struct PipelineDescHash {
+    size_t operator()(PipelineDesc const& desc) const { return desc.hash(); }
+};
+
+struct PipelineCacheStats {
+    uint64_t requests = 0;
+    uint64_t hits = 0;
+    uint64_t pipelines_created = 0;
+    uint64_t shader_modules_created = 0;
+    // total, shader module creation included
+    double creation_ms = 0.0;
+    double shader_ms = 0.0;
+
+    double hit_rate() const { return requests > 0 ? double(hits) / double(requests) : 0.0; }
+};
+
+// Creates every graphics pipeline of a pass at most once. get() is thread safe: lookups only
+// take a shared lock, and concurrent requests for a state that is still being created wait for
+// that one creation instead of compiling it again. Shader modules are cached by name too, and
+// all creations go through one VkPipelineCache so the driver can reuse compiled stages between
+// variants. Pipelines live as long as the cache. Compute pipelines are rare and made at setup,
+// they are cached by shader name under an exclusive lock.
+//
+// Shaders come from the SPIR-V embedded at build time. If HB_SHADER_DIR is set they are read from
+// <HB_SHADER_DIR>/<name>.spv instead, to try out shader changes without relinking.
+class PipelineCache {
+public:
+    PipelineCache(GpuContext const&, VkPipelineLayout, VkRenderPass,
+        std::vector<VkVertexInputBindingDescription> bindings,
+        std::vector<VkVertexInputAttributeDescription> attributes);
+    ~PipelineCache();
+    PipelineCache(PipelineCache const&) = delete;
+    PipelineCache& operator=(PipelineCache const&) = delete;
+
+    VkPipeline get(PipelineDesc const&);
+    // a compute pipeline of the same layout, by shader name
+    VkPipeline compute(std::string const& shader);
+    VkPipelineLayout layout() const { return m_layout; }
+    size_t size() const;
+
+    PipelineCacheStats stats() const;
+    void print_report() const;
+
+private:
+    GpuContext m_gpu;
+    VkPipelineLayout m_layout;
+    VkRenderPass m_render_pass;
+    std::vector<VkVertexInputBindingDescription> m_bindings;
+    std::vector<VkVertexInputAttributeDescription> m_attributes;
+    VkPipelineCache m_vulkan_cache;
+    std::string m_shader_directory;
+
+    mutable std::shared_mutex m_mutex;
+    std::unordered_map<PipelineDesc, std::shared_future<VkPipeline>, PipelineDescHash> m_pipelines;
+    std::unordered_map<std::string, VkPipeline> m_compute_pipelines;
+    std::mutex m_shader_mutex;
+    std::unordered_map<std::string, VkShaderModule> m_shader_modules;
+
+    std::atomic<uint64_t> m_requests = 0;
+    std::atomic<uint64_t> m_hits = 0;
+    std::atomic<uint64_t> m_pipelines_created = 0;
+    std::atomic<uint64_t> m_shader_modules_created = 0;
+    std::atomic<uint64_t> m_creation_ns = 0;
+    std::atomic<uint64_t> m_shader_ns = 0;
+
+    VkPipeline create(PipelineDesc const&);
+    VkShaderModule shader_module(std::string const& name);
+};
+
+}
+
+#endif
@@ -0,0 +1,465 @@
+#include <algorithm>
+#include <stdexcept>
+
+#include <glm/glm.hpp>
+
+#include "deletion_queue.hpp"
+#include "post.hpp"
+#include "stats.hpp"
+
+namespace HB {
+
+namespace {
+
+    // the same block in every post shader
+    struct PostConstants {
+        glm::ivec2 size;
+        glm::ivec2 extra_size;
+        uint32_t vertical;
+        float radius;
+        float threshold;
+        float intensity;
+        float exposure;
+    };
+
+    // Descriptor sets of a frame, by the images they bind: binding 0 is read, binding 1 written
+    // (or read and written in place) and binding 2 is read alongside it.
+    enum Set : uint32_t {
+        SCENE_TO_TEMP,
+        TEMP_TO_SCENE,
+        SCENE_TO_BLOOM,
+        BLOOM_0_TO_1,
+        BLOOM_1_TO_0,
+        SCENE_WITH_BLOOM,
+    };
+    uint32_t const SET_COUNT = 6;
+    uint32_t const BINDING_COUNT = 3;
+
+    VkFormat const FORMAT = VK_FORMAT_R16G16B16A16_SFLOAT;
+    uint32_t const BLUR_TILE = 128;
+    uint32_t const GROUP_SIZE = 8;
+
+    VkImageView create_storage_image(GpuContext const& gpu, VkExtent2D extent, VkImage& image, VkDeviceMemory& memory)
+    {
+        VkImageCreateInfo image_info {};
+        image_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        image_info.imageType = VK_IMAGE_TYPE_2D;
+        image_info.format = FORMAT;
+        image_info.extent = { extent.width, extent.height, 1 };
+        image_info.mipLevels = 1;
+        image_info.arrayLayers = 1;
+        image_info.samples = VK_SAMPLE_COUNT_1_BIT;
+        image_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+        image_info.usage = VK_IMAGE_USAGE_STORAGE_BIT;
+        image_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        image_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+        Gpu::create_image(gpu, image_info, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, image, memory, MemoryClass::RENDER_TARGET);
+        return Gpu::create_image_view(gpu, image, FORMAT, VK_IMAGE_ASPECT_COLOR_BIT, 1);
+    }
+
+    VkExtent2D half(VkExtent2D extent)
+    {
+        return { std::max((extent.width + 1) / 2, 1u), std::max((extent.height + 1) / 2, 1u) };
+    }
+
+    uint32_t groups(uint32_t size, uint32_t group_size)
+    {
+        return (size + group_size - 1) / group_size;
+    }
+
+}
+
+PostProcessor::PostProcessor(GpuContext const& gpu, uint32_t frames_in_flight)
+    : m_gpu(gpu)
+    , m_recorded(frames_in_flight)
+{
+    create_layout();
+    // compute only, there is no render pass or vertex input
+    m_pipelines = std::make_unique<PipelineCache>(m_gpu, m_layout, VK_NULL_HANDLE, std::vector<VkVertexInputBindingDescription> {}, std::vector<VkVertexInputAttributeDescription> {});
+    create_query_pool(frames_in_flight);
+
+    // recording and reading timings never allocate
+    for (auto& recorded : m_recorded)
+        recorded.reserve(MAX_PASSES);
+    m_timings.reserve(MAX_PASSES);
+    m_passes.reserve(MAX_PASSES);
+}
+
+PostProcessor::~PostProcessor()
+{
+    if (m_query_pool != VK_NULL_HANDLE)
+        vkDestroyQueryPool(m_gpu.device, m_query_pool, nullptr);
+    m_pipelines.reset();
+    vkDestroyPipelineLayout(m_gpu.device, m_layout, nullptr);
+    vkDestroyDescriptorSetLayout(m_gpu.device, m_set_layout, nullptr);
+}
+
+void PostProcessor::create_layout()
+{
+    std::array<VkDescriptorSetLayoutBinding, BINDING_COUNT> bindings {};
+    for (uint32_t i = 0; i < BINDING_COUNT; i += 1) {
+        bindings[i].binding = i;
+        bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+        bindings[i].descriptorCount = 1;
+        bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    }
+
+    VkDescriptorSetLayoutCreateInfo layout_info {};
+    layout_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layout_info.bindingCount = BINDING_COUNT;
+    layout_info.pBindings = bindings.data();
+
+    if (vkCreateDescriptorSetLayout(m_gpu.device, &layout_info, nullptr, &m_set_layout) != VK_SUCCESS)
+        throw std::runtime_error("failed to create post-processing descriptor set layout!");
+
+    VkPushConstantRange push_constant_range {};
+    push_constant_range.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    push_constant_range.offset = 0;
+    push_constant_range.size = sizeof(PostConstants);
+
+    VkPipelineLayoutCreateInfo pipeline_layout_info {};
+    pipeline_layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipeline_layout_info.setLayoutCount = 1;
+    pipeline_layout_info.pSetLayouts = &m_set_layout;
+    pipeline_layout_info.pushConstantRangeCount = 1;
+    pipeline_layout_info.pPushConstantRanges = &push_constant_range;
+
+    if (vkCreatePipelineLayout(m_gpu.device, &pipeline_layout_info, nullptr, &m_layout) != VK_SUCCESS)
+        throw std::runtime_error("failed to create post-processing pipeline layout!");
+}
+
+void PostProcessor::create_query_pool(uint32_t frames_in_flight)
+{
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(m_gpu.physical_device, &properties);
+    if (!properties.limits.timestampComputeAndGraphics)
+        return;
+    m_timestamp_period = properties.limits.timestampPeriod;
+
+    // a timestamp before the first pass and one after every pass
+    VkQueryPoolCreateInfo pool_info {};
+    pool_info.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    pool_info.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    pool_info.queryCount = frames_in_flight * (MAX_PASSES + 1);
+
+    if (vkCreateQueryPool(m_gpu.device, &pool_info, nullptr, &m_query_pool) != VK_SUCCESS)
+        throw std::runtime_error("failed to create post-processing query pool!");
+}
+
+void PostProcessor::add_pass(PassKind kind, char const* name, char const* shader)
+{
+    if (m_passes.size() >= MAX_PASSES)
+        throw std::runtime_error("too many post-processing passes!");
+    m_passes.push_back({ kind, name, m_pipelines->compute(shader) });
+}
+
+void PostProcessor::set_chain(std::vector<PostEffect> const& chain, PostSettings const& settings)
+{
+    m_chain = chain;
+    m_settings = settings;
+    m_passes.clear();
+    for (size_t i = 0; i < chain.size(); i += 1) {
+        switch (chain[i]) {
+        case PostEffect::BLUR:
+            add_pass(PassKind::BLUR_HORIZONTAL, "blur_horizontal", "post_blur");
+            add_pass(PassKind::BLUR_VERTICAL, "blur_vertical", "post_blur");
+            break;
+        case PostEffect::BLOOM:
+            add_pass(PassKind::BLOOM_PREFILTER, "bloom_prefilter", "post_bloom_prefilter");
+            add_pass(PassKind::BLOOM_HORIZONTAL, "bloom_horizontal", "post_blur");
+            add_pass(PassKind::BLOOM_VERTICAL, "bloom_vertical", "post_blur");
+            // the tonemap that follows takes the composite along
+            if (settings.fuse && i + 1 < chain.size() && chain[i + 1] == PostEffect::TONEMAP) {
+                add_pass(PassKind::BLOOM_TONEMAP, "bloom_tonemap", "post_bloom_tonemap");
+                i += 1;
+            } else {
+                add_pass(PassKind::BLOOM_COMPOSITE, "bloom_composite", "post_bloom_composite");
+            }
+            break;
+        case PostEffect::TONEMAP:
+            add_pass(PassKind::TONEMAP, "tonemap", "post_tonemap");
+            break;
+        }
+    }
+}
+
+PostTargets PostProcessor::create_targets(VkExtent2D extent, VkImageView const* scene_views)
+{
+    uint32_t frame_count = static_cast<uint32_t>(m_recorded.size());
+    PostTargets targets;
+    targets.extent = extent;
+    targets.frames.resize(frame_count);
+
+    VkDescriptorPoolSize pool_size {};
+    pool_size.type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    pool_size.descriptorCount = frame_count * SET_COUNT * BINDING_COUNT;
+
+    VkDescriptorPoolCreateInfo pool_info {};
+    pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    pool_info.maxSets = frame_count * SET_COUNT;
+    pool_info.poolSizeCount = 1;
+    pool_info.pPoolSizes = &pool_size;
+
+    if (vkCreateDescriptorPool(m_gpu.device, &pool_info, nullptr, &targets.descriptor_pool) != VK_SUCCESS)
+        throw std::runtime_error("failed to create post-processing descriptor pool!");
+
+    for (uint32_t i = 0; i < frame_count; i += 1) {
+        PostTargets::Frame& frame = targets.frames[i];
+        frame.temp_view = create_storage_image(m_gpu, extent, frame.temp, frame.temp_memory);
+        for (uint32_t j = 0; j < 2; j += 1)
+            frame.bloom_views[j] = create_storage_image(m_gpu, half(extent), frame.bloom[j], frame.bloom_memory[j]);
+
+        std::array<VkDescriptorSetLayout, SET_COUNT> layouts;
+        layouts.fill(m_set_layout);
+
+        VkDescriptorSetAllocateInfo alloc_info {};
+        alloc_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        alloc_info.descriptorPool = targets.descriptor_pool;
+        alloc_info.descriptorSetCount = SET_COUNT;
+        alloc_info.pSetLayouts = layouts.data();
+
+        if (vkAllocateDescriptorSets(m_gpu.device, &alloc_info, frame.sets.data()) != VK_SUCCESS)
+            throw std::runtime_error("failed to allocate post-processing descriptor sets!");
+
+        VkImageView scene = scene_views[i];
+        // clang-format off
+        std::array<std::array<VkImageView, BINDING_COUNT>, SET_COUNT> views = { {
+            { scene, frame.temp_view, VK_NULL_HANDLE },
+            { frame.temp_view, scene, VK_NULL_HANDLE },
+            { scene, frame.bloom_views[0], VK_NULL_HANDLE },
+            { frame.bloom_views[0], frame.bloom_views[1], VK_NULL_HANDLE },
+            { frame.bloom_views[1], frame.bloom_views[0], VK_NULL_HANDLE },
+            { VK_NULL_HANDLE, scene, frame.bloom_views[0] },
+        } };
+        // clang-format on
+
+        std::array<VkDescriptorImageInfo, SET_COUNT * BINDING_COUNT> image_infos {};
+        std::array<VkWriteDescriptorSet, SET_COUNT * BINDING_COUNT> writes {};
+        uint32_t write_count = 0;
+        for (uint32_t set = 0; set < SET_COUNT; set += 1) {
+            for (uint32_t binding = 0; binding < BINDING_COUNT; binding += 1) {
+                // the passes using the set don't declare the binding
+                if (views[set][binding] == VK_NULL_HANDLE)
+                    continue;
+
+                VkDescriptorImageInfo& image_info = image_infos[write_count];
+                image_info.imageView = views[set][binding];
+                image_info.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+                VkWriteDescriptorSet& write = writes[write_count];
+                write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+                write.dstSet = frame.sets[set];
+                write.dstBinding = binding;
+                write.dstArrayElement = 0;
+                write.descriptorCount = 1;
+                write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+                write.pImageInfo = &image_info;
+                write_count += 1;
+            }
+        }
+        vkUpdateDescriptorSets(m_gpu.device, write_count, writes.data(), 0, nullptr);
+    }
+
+    return targets;
+}
+
+void PostProcessor::destroy_targets(PostTargets& targets)
+{
+    for (PostTargets::Frame& frame : targets.frames) {
+        Gpu::destroy_image_view(m_gpu, frame.temp_view);
+        Gpu::destroy_image(m_gpu, frame.temp, frame.temp_memory);
+        for (uint32_t j = 0; j < 2; j += 1) {
+            Gpu::destroy_image_view(m_gpu, frame.bloom_views[j]);
+            Gpu::destroy_image(m_gpu, frame.bloom[j], frame.bloom_memory[j]);
+        }
+    }
+    if (targets.descriptor_pool != VK_NULL_HANDLE)
+        vkDestroyDescriptorPool(m_gpu.device, targets.descriptor_pool, nullptr);
+    targets = {};
+}
+
+void PostProcessor::retire_targets(PostTargets& targets)
+{
+    DeletionQueue& queue = *m_gpu.deletion_queue;
+    for (PostTargets::Frame& frame : targets.frames) {
+        queue.retire_image_view(frame.temp_view);
+        queue.retire_image(frame.temp, frame.temp_memory);
+        for (uint32_t j = 0; j < 2; j += 1) {
+            queue.retire_image_view(frame.bloom_views[j]);
+            queue.retire_image(frame.bloom[j], frame.bloom_memory[j]);
+        }
+    }
+    if (targets.descriptor_pool != VK_NULL_HANDLE) {
+        VkDevice device = m_gpu.device;
+        VkDescriptorPool pool = targets.descriptor_pool;
+        queue.retire([device, pool] { vkDestroyDescriptorPool(device, pool, nullptr); });
+    }
+    targets = {};
+}
+
+void PostProcessor::record(VkCommandBuffer command_buffer, uint32_t frame, View const* views, uint32_t view_count)
+{
+    std::vector<char const*>& recorded = m_recorded[frame];
+    recorded.clear();
+    if (m_passes.empty() || view_count == 0)
+        return;
+
+    uint32_t first_query = frame * (MAX_PASSES + 1);
+    if (m_query_pool != VK_NULL_HANDLE)
+        vkCmdResetQueryPool(command_buffer, m_query_pool, first_query, pass_count() + 1);
+
+    // the scene keeps what was drawn, the scratch images start over every frame
+    for (uint32_t i = 0; i < view_count; i += 1) {
+        PostTargets::Frame const& targets = views[i].targets->frames[frame];
+        std::array<VkImageMemoryBarrier, 4> barriers {};
+        std::array<VkImage, 4> images = { views[i].scene_image, targets.temp, targets.bloom[0], targets.bloom[1] };
+        for (uint32_t j = 0; j < barriers.size(); j += 1) {
+            VkImageMemoryBarrier& barrier = barriers[j];
+            barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+            barrier.srcAccessMask = j == 0 ? VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT : 0;
+            barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+            barrier.oldLayout = j == 0 ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_UNDEFINED;
+            barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+            barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.image = images[j];
+            barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            barrier.subresourceRange.baseMipLevel = 0;
+            barrier.subresourceRange.levelCount = 1;
+            barrier.subresourceRange.baseArrayLayer = 0;
+            barrier.subresourceRange.layerCount = 1;
+        }
+        // the scene pass's dependency out of the pass is to the transfer stage
+        VkPipelineStageFlags source_stages = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT;
+        vkCmdPipelineBarrier(command_buffer, source_stages, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr, static_cast<uint32_t>(barriers.size()), barriers.data());
+    }
+
+    if (m_query_pool != VK_NULL_HANDLE)
+        vkCmdWriteTimestamp(command_buffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_query_pool, first_query);
+
+    VkPipeline bound_pipeline = VK_NULL_HANDLE;
+    for (uint32_t p = 0; p < m_passes.size(); p += 1) {
+        Pass const& pass = m_passes[p];
+        if (pass.pipeline != bound_pipeline) {
+            vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, pass.pipeline);
+            Stats::count(Counter::PIPELINE_BINDS);
+            bound_pipeline = pass.pipeline;
+        }
+
+        for (uint32_t i = 0; i < view_count; i += 1) {
+            VkExtent2D full = views[i].extent;
+            VkExtent2D halved = half(full);
+
+            PostConstants constants {};
+            constants.threshold = m_settings.bloom_threshold;
+            constants.intensity = m_settings.bloom_intensity;
+            constants.exposure = m_settings.exposure;
+            Set set = SCENE_WITH_BLOOM;
+            // the blurs run a workgroup per BLUR_TILE pixels of a line, the rest per 8x8 block
+            bool blur = false;
+            VkExtent2D size = full;
+            VkExtent2D extra_size = halved;
+            switch (pass.kind) {
+            case PassKind::BLUR_HORIZONTAL:
+            case PassKind::BLUR_VERTICAL:
+                set = pass.kind == PassKind::BLUR_HORIZONTAL ? SCENE_TO_TEMP : TEMP_TO_SCENE;
+                constants.vertical = pass.kind == PassKind::BLUR_VERTICAL;
+                constants.radius = m_settings.blur_radius;
+                blur = true;
+                break;
+            case PassKind::BLOOM_PREFILTER:
+                set = SCENE_TO_BLOOM;
+                size = halved;
+                extra_size = full;
+                break;
+            case PassKind::BLOOM_HORIZONTAL:
+            case PassKind::BLOOM_VERTICAL:
+                set = pass.kind == PassKind::BLOOM_HORIZONTAL ? BLOOM_0_TO_1 : BLOOM_1_TO_0;
+                size = halved;
+                constants.vertical = pass.kind == PassKind::BLOOM_VERTICAL;
+                constants.radius = m_settings.bloom_radius;
+                blur = true;
+                break;
+            case PassKind::BLOOM_COMPOSITE:
+            case PassKind::TONEMAP:
+            case PassKind::BLOOM_TONEMAP:
+                break;
+            }
+            constants.size = glm::ivec2(static_cast<int32_t>(size.width), static_cast<int32_t>(size.height));
+            constants.extra_size = glm::ivec2(static_cast<int32_t>(extra_size.width), static_cast<int32_t>(extra_size.height));
+
+            VkDescriptorSet descriptor_set = views[i].targets->frames[frame].sets[set];
+            vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_layout, 0, 1, &descriptor_set, 0, nullptr);
+            Stats::count(Counter::DESCRIPTOR_BINDS);
+            vkCmdPushConstants(command_buffer, m_layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(constants), &constants);
+
+            if (blur && constants.vertical)
+                vkCmdDispatch(command_buffer, groups(size.height, BLUR_TILE), size.width, 1);
+            else if (blur)
+                vkCmdDispatch(command_buffer, groups(size.width, BLUR_TILE), size.height, 1);
+            else
+                vkCmdDispatch(command_buffer, groups(size.width, GROUP_SIZE), groups(size.height, GROUP_SIZE), 1);
+            Stats::count(Counter::DISPATCHES);
+        }
+
+        if (m_query_pool != VK_NULL_HANDLE)
+            vkCmdWriteTimestamp(command_buffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_query_pool, first_query + p + 1);
+        recorded.push_back(pass.name);
+
+        if (p + 1 < m_passes.size()) {
+            VkMemoryBarrier barrier {};
+            barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+            barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+            barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+            vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+        }
+    }
+
+    // back to where the scene pass leaves it, for the blit
+    for (uint32_t i = 0; i < view_count; i += 1) {
+        VkImageMemoryBarrier barrier {};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = views[i].scene_image;
+        barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        barrier.subresourceRange.baseMipLevel = 0;
+        barrier.subresourceRange.levelCount = 1;
+        barrier.subresourceRange.baseArrayLayer = 0;
+        barrier.subresourceRange.layerCount = 1;
+        vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+    }
+}
+
+void PostProcessor::read_timings(uint32_t frame)
+{
+    std::vector<char const*> const& recorded = m_recorded[frame];
+    if (m_query_pool == VK_NULL_HANDLE || recorded.empty()) {
+        m_timings.clear();
+        return;
+    }
+
+    std::array<uint64_t, MAX_PASSES + 1> timestamps;
+    uint32_t count = static_cast<uint32_t>(recorded.size()) + 1;
+    if (vkGetQueryPoolResults(m_gpu.device, m_query_pool, frame * (MAX_PASSES + 1), count, sizeof(uint64_t) * count, timestamps.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT) != VK_SUCCESS)
+        return;
+
+    m_timings.clear();
+    for (uint32_t i = 0; i < recorded.size(); i += 1)
+        m_timings.push_back({ recorded[i], static_cast<float>(timestamps[i + 1] - timestamps[i]) * m_timestamp_period / 1000000.0f });
+}
+
+float PostProcessor::total_ms() const
+{
+    float total = 0.0f;
+    for (PostPassTiming const& timing : m_timings)
+        total += timing.ms;
+    return total;
+}
+
+}
@@ -0,0 +1,141 @@
+#ifndef _HB_POST
+#define _HB_POST
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "gpu.hpp"
+#include "pipeline.hpp"
+
+namespace HB {
+
+enum class PostEffect : uint32_t {
+    // separable gaussian over the whole scene
+    BLUR,
+    // what is brighter than the threshold, blurred at half resolution and added back
+    BLOOM,
+    // exposure and a filmic curve, from HDR down to what the swap chain can show
+    TONEMAP,
+};
+
+struct PostSettings {
+    // in pixels, up to PostProcessor::MAX_RADIUS
+    float blur_radius = 4.0f;
+    float bloom_threshold = 1.0f;
+    float bloom_intensity = 0.5f;
+    // in pixels of the half resolution bloom
+    float bloom_radius = 8.0f;
+    float exposure = 1.0f;
+    // BLOOM followed by TONEMAP composites and tonemaps in one pass instead of two
+    bool fuse = true;
+};
+
+struct PostPassTiming {
+    char const* name;
+    float ms;
+};
+
+// The scratch images of one window and their descriptor sets, for every frame in flight. They
+// don't depend on the chain, a window only needs them once any chain is set.
+struct PostTargets {
+    // the scene target it was made for
+    VkExtent2D extent {};
+    VkDescriptorPool descriptor_pool = VK_NULL_HANDLE;
+    struct Frame {
+        // full resolution, between the two halves of BLUR
+        VkImage temp = VK_NULL_HANDLE;
+        VkDeviceMemory temp_memory = VK_NULL_HANDLE;
+        VkImageView temp_view = VK_NULL_HANDLE;
+        // half resolution, BLOOM ping-pongs between them
+        std::array<VkImage, 2> bloom {};
+        std::array<VkDeviceMemory, 2> bloom_memory {};
+        std::array<VkImageView, 2> bloom_views {};
+        // one per combination of images the passes read and write, see post.cpp
+        std::array<VkDescriptorSet, 6> sets {};
+    };
+    std::vector<Frame> frames;
+};
+
+// Compute passes run on the HDR scene target after the scene pass, in the order of the chain.
+// The scene image goes to GENERAL for them and is left in TRANSFER_SRC for the blit to the swap
+// chain, as the scene pass leaves it. Every pass is timed with timestamps on its own.
+class PostProcessor {
+public:
+    static uint32_t const MAX_RADIUS = 32;
+    static uint32_t const MAX_PASSES = 16;
+
+    // what one window runs the chain on this frame
+    struct View {
+        PostTargets const* targets;
+        VkImage scene_image;
+        // the part of the scene target that was drawn to
+        VkExtent2D extent;
+    };
+
+    PostProcessor(GpuContext const&, uint32_t frames_in_flight);
+    ~PostProcessor();
+    PostProcessor(PostProcessor const&) = delete;
+    PostProcessor& operator=(PostProcessor const&) = delete;
+
+    // made once during setup, an empty chain turns post-processing off
+    void set_chain(std::vector<PostEffect> const&, PostSettings const& = {});
+    std::vector<PostEffect> const& chain() const { return m_chain; }
+    bool empty() const { return m_passes.empty(); }
+    uint32_t pass_count() const { return static_cast<uint32_t>(m_passes.size()); }
+
+    // for a window's scene images, which need VK_IMAGE_USAGE_STORAGE_BIT
+    PostTargets create_targets(VkExtent2D extent, VkImageView const* scene_views);
+    void destroy_targets(PostTargets&);
+    // through the deletion queue, frames in flight may still use them
+    void retire_targets(PostTargets&);
+
+    // outside of any pass, after the scene passes of all views
+    void record(VkCommandBuffer, uint32_t frame, View const* views, uint32_t view_count);
+    // reads the frame's timestamps, once its fence has been waited on
+    void read_timings(uint32_t frame);
+    // per pass of the last frame read, empty without timestamp support
+    std::vector<PostPassTiming> const& timings() const { return m_timings; }
+    float total_ms() const;
+
+private:
+    enum class PassKind : uint32_t {
+        BLUR_HORIZONTAL,
+        BLUR_VERTICAL,
+        BLOOM_PREFILTER,
+        BLOOM_HORIZONTAL,
+        BLOOM_VERTICAL,
+        BLOOM_COMPOSITE,
+        TONEMAP,
+        BLOOM_TONEMAP,
+    };
+
+    struct Pass {
+        PassKind kind;
+        char const* name;
+        VkPipeline pipeline;
+    };
+
+    GpuContext m_gpu;
+    VkDescriptorSetLayout m_set_layout;
+    VkPipelineLayout m_layout;
+    std::unique_ptr<PipelineCache> m_pipelines;
+    std::vector<PostEffect> m_chain;
+    PostSettings m_settings;
+    std::vector<Pass> m_passes;
+
+    float m_timestamp_period = 0.0f;
+    VkQueryPool m_query_pool = VK_NULL_HANDLE;
+    // the names of the passes each frame recorded, empty if none were
+    std::vector<std::vector<char const*>> m_recorded;
+    std::vector<PostPassTiming> m_timings;
+
+    void create_layout();
+    void create_query_pool(uint32_t frames_in_flight);
+    void add_pass(PassKind, char const* name, char const* shader);
+};
+
+}
+
+#endif
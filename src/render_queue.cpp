@@ -0,0 +1,138 @@
+#include <algorithm>
+#include <bit>
+#include <utility>
+
+#include "render_queue.hpp"
+
+namespace HB {
+
+namespace {
+
+    size_t const BLOCK_SIZE = 16384;
+    uint32_t const RADIX = 256;
+    uint32_t const PASSES = 8;
+
+    template<typename F>
+    void for_blocks(ThreadPool* pool, size_t block_count, F&& function)
+    {
+        if (pool != nullptr && block_count > 1) {
+            pool->parallel_for(block_count, 1, [&function](size_t begin, size_t end) {
+                for (size_t block = begin; block < end; block += 1)
+                    function(block);
+            });
+        } else {
+            for (size_t block = 0; block < block_count; block += 1)
+                function(block);
+        }
+    }
+
+}
+
+namespace SortKey {
+
+    uint32_t depth_bucket(float depth)
+    {
+        // negative and NaN go to the front, positive floats order like their bits
+        if (!(depth > 0.0f))
+            return 0;
+        return std::bit_cast<uint32_t>(depth) >> 15;
+    }
+
+    uint64_t make(DrawState const& state, uint32_t depth_bucket)
+    {
+        uint64_t pass = state.pass & 0x3;
+        uint64_t pipeline = state.pipeline & 0xFF;
+        uint64_t material = state.material & 0x3FFF;
+        uint64_t lod = state.lod & 0xFFFFFF;
+        uint64_t depth = depth_bucket & 0xFFFF;
+        if (state.pass == TRANSLUCENT)
+            return pass << 62 | (0xFFFF - depth) << 46 | pipeline << 38 | material << 24 | lod;
+        return pass << 62 | pipeline << 54 | material << 40 | lod << 16 | depth;
+    }
+
+    DrawState state(uint64_t key)
+    {
+        DrawState state {};
+        state.pass = static_cast<uint32_t>(key >> 62);
+        if (state.pass == TRANSLUCENT) {
+            state.pipeline = static_cast<uint32_t>(key >> 38) & 0xFF;
+            state.material = static_cast<uint32_t>(key >> 24) & 0x3FFF;
+            state.lod = static_cast<uint32_t>(key) & 0xFFFFFF;
+        } else {
+            state.pipeline = static_cast<uint32_t>(key >> 54) & 0xFF;
+            state.material = static_cast<uint32_t>(key >> 40) & 0x3FFF;
+            state.lod = static_cast<uint32_t>(key >> 16) & 0xFFFFFF;
+        }
+        return state;
+    }
+
+}
+
+DrawPacket* radix_sort(DrawPacket* packets, size_t count, FrameArena& arena, ThreadPool* pool)
+{
+    if (count < 2)
+        return packets;
+
+    size_t block_count = (count + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    auto block_end = [count](size_t block) { return std::min(count, (block + 1) * BLOCK_SIZE); };
+
+    // bits set in some keys and clear in others, only their digits need a pass
+    uint64_t* set_bits = arena.allocate<uint64_t>(block_count);
+    uint64_t* clear_bits = arena.allocate<uint64_t>(block_count);
+    for_blocks(pool, block_count, [&](size_t block) {
+        uint64_t set = 0;
+        uint64_t clear = 0;
+        for (size_t i = block * BLOCK_SIZE; i < block_end(block); i += 1) {
+            set |= packets[i].key;
+            clear |= ~packets[i].key;
+        }
+        set_bits[block] = set;
+        clear_bits[block] = clear;
+    });
+    uint64_t set = 0;
+    uint64_t clear = 0;
+    for (size_t block = 0; block < block_count; block += 1) {
+        set |= set_bits[block];
+        clear |= clear_bits[block];
+    }
+    uint64_t varying = set & clear;
+
+    DrawPacket* source = packets;
+    DrawPacket* target = arena.allocate<DrawPacket>(count);
+    uint32_t* offsets = arena.allocate<uint32_t>(block_count * RADIX);
+    for (uint32_t pass = 0; pass < PASSES; pass += 1) {
+        uint32_t shift = pass * 8;
+        if (((varying >> shift) & 0xFF) == 0)
+            continue;
+
+        for_blocks(pool, block_count, [&](size_t block) {
+            uint32_t* counts = offsets + block * RADIX;
+            std::fill(counts, counts + RADIX, 0u);
+            for (size_t i = block * BLOCK_SIZE; i < block_end(block); i += 1)
+                counts[(source[i].key >> shift) & 0xFF] += 1;
+        });
+
+        // digit major, so blocks keep their order within a digit and the sort stays stable
+        uint32_t offset = 0;
+        for (uint32_t digit = 0; digit < RADIX; digit += 1) {
+            for (size_t block = 0; block < block_count; block += 1) {
+                uint32_t digit_count = offsets[block * RADIX + digit];
+                offsets[block * RADIX + digit] = offset;
+                offset += digit_count;
+            }
+        }
+
+        for_blocks(pool, block_count, [&](size_t block) {
+            uint32_t* block_offsets = offsets + block * RADIX;
+            for (size_t i = block * BLOCK_SIZE; i < block_end(block); i += 1) {
+                uint32_t& position = block_offsets[(source[i].key >> shift) & 0xFF];
+                target[position] = source[i];
+                position += 1;
+            }
+        });
+        std::swap(source, target);
+    }
+    return source;
+}
+
+}
@@ -0,0 +1,54 @@
+#ifndef _HB_RENDER_QUEUE
+#define _HB_RENDER_QUEUE
+
+#include <cstddef>
+#include <cstdint>
+
+#include "frame_arena.hpp"
+#include "thread_pool.hpp"
+
+namespace HB {
+
+// What one visible instance is drawn with. Fields past their bit widths are cut off.
+struct DrawState {
+    // 0 opaque, 1 translucent
+    uint32_t pass;
+    // index into the scene's pipelines, 8 bits
+    uint32_t pipeline;
+    // 14 bits
+    uint32_t material;
+    // the mesh LOD draw key, 24 bits
+    uint32_t lod;
+};
+
+// One instance in the scene pass: the 64 bit sort key and its slot.
+//
+// Opaque keys are pass | pipeline | material | lod | depth from the top, so sorting groups by
+// state, most expensive change first, and goes front to back within each group. Translucent
+// keys put the depth right after the pass, back to front, since blending needs that order more
+// than it needs few state changes.
+struct DrawPacket {
+    uint64_t key;
+    uint32_t instance;
+};
+
+namespace SortKey {
+
+    uint32_t const TRANSLUCENT = 1;
+
+    // 16 bit bucket of a non-negative depth, the exponent and top 8 mantissa bits of the float,
+    // so 256 steps per doubling of the distance, finer close up where it matters
+    uint32_t depth_bucket(float depth);
+    uint64_t make(DrawState const&, uint32_t depth_bucket);
+    DrawState state(uint64_t key);
+
+}
+
+// Stable LSD radix sort by key, 8 bits per pass, passes where every key has the same digit are
+// skipped. Each pass splits the packets into blocks that are counted and scattered on the pool.
+// Scratch comes from the arena, the result is either `packets` or that scratch.
+DrawPacket* radix_sort(DrawPacket* packets, size_t count, FrameArena&, ThreadPool* = nullptr);
+
+}
+
+#endif
@@ -0,0 +1,116 @@
+#include <algorithm>
+
+#include "residency.hpp"
+
+namespace HB {
+
+ResidencyManager::ResidencyManager(GpuContext const& gpu, PFN_vkGetPhysicalDeviceMemoryProperties2KHR get_memory_properties)
+    : m_gpu(gpu)
+    , m_get_memory_properties(get_memory_properties)
+{
+    VkPhysicalDeviceMemoryProperties properties;
+    vkGetPhysicalDeviceMemoryProperties(m_gpu.physical_device, &properties);
+    m_heaps.resize(properties.memoryHeapCount);
+    for (uint32_t i = 0; i < properties.memoryHeapCount; i += 1) {
+        m_heaps[i].size = properties.memoryHeaps[i].size;
+        m_heaps[i].budget = properties.memoryHeaps[i].size;
+        m_heaps[i].device_local = properties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT;
+    }
+    m_type_heaps.resize(properties.memoryTypeCount);
+    for (uint32_t i = 0; i < properties.memoryTypeCount; i += 1)
+        m_type_heaps[i] = properties.memoryTypes[i].heapIndex;
+
+    update();
+}
+
+void ResidencyManager::allocated(VkDeviceMemory memory, MemoryClass memory_class, uint32_t memory_type, VkDeviceSize size)
+{
+    std::lock_guard lock(m_mutex);
+    uint32_t heap = m_type_heaps[memory_type];
+    m_allocations[memory] = { memory_class, heap, size };
+    m_heaps[heap].tracked += size;
+    m_class_usage[static_cast<uint32_t>(memory_class)] += size;
+    if (!has_memory_budget())
+        m_heaps[heap].usage = m_heaps[heap].tracked;
+}
+
+void ResidencyManager::freed(VkDeviceMemory memory)
+{
+    std::lock_guard lock(m_mutex);
+    auto found = m_allocations.find(memory);
+    if (found == m_allocations.end())
+        return;
+    Allocation const& allocation = found->second;
+    m_heaps[allocation.heap].tracked -= allocation.size;
+    m_class_usage[static_cast<uint32_t>(allocation.memory_class)] -= allocation.size;
+    if (!has_memory_budget())
+        m_heaps[allocation.heap].usage = m_heaps[allocation.heap].tracked;
+    m_allocations.erase(found);
+}
+
+void ResidencyManager::update()
+{
+    VkPhysicalDeviceMemoryBudgetPropertiesEXT budget {};
+    budget.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+    if (has_memory_budget()) {
+        VkPhysicalDeviceMemoryProperties2KHR properties {};
+        properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2_KHR;
+        properties.pNext = &budget;
+        m_get_memory_properties(m_gpu.physical_device, &properties);
+    }
+
+    std::lock_guard lock(m_mutex);
+    for (uint32_t i = 0; i < m_heaps.size(); i += 1) {
+        HeapBudget& heap = m_heaps[i];
+        heap.budget = has_memory_budget() ? budget.heapBudget[i] : heap.size;
+        heap.usage = has_memory_budget() ? budget.heapUsage[i] : heap.tracked;
+        if (heap.device_local)
+            heap.budget = std::min(heap.budget, m_budget_limit);
+    }
+}
+
+HeapBudget ResidencyManager::heap(uint32_t index) const
+{
+    std::lock_guard lock(m_mutex);
+    return m_heaps[index];
+}
+
+VkDeviceSize ResidencyManager::usage(MemoryClass memory_class) const
+{
+    std::lock_guard lock(m_mutex);
+    return m_class_usage[static_cast<uint32_t>(memory_class)];
+}
+
+void ResidencyManager::set_budget_limit(VkDeviceSize bytes)
+{
+    {
+        std::lock_guard lock(m_mutex);
+        m_budget_limit = bytes;
+    }
+    update();
+}
+
+VkDeviceSize ResidencyManager::excess() const
+{
+    std::lock_guard lock(m_mutex);
+    VkDeviceSize excess = 0;
+    for (HeapBudget const& heap : m_heaps) {
+        VkDeviceSize target = static_cast<VkDeviceSize>(static_cast<double>(heap.budget) * m_target);
+        if (heap.device_local && heap.usage > target)
+            excess = std::max(excess, heap.usage - target);
+    }
+    return excess;
+}
+
+int64_t ResidencyManager::headroom() const
+{
+    std::lock_guard lock(m_mutex);
+    int64_t headroom = INT64_MAX;
+    for (HeapBudget const& heap : m_heaps) {
+        if (heap.device_local)
+            headroom = std::min(headroom, static_cast<int64_t>(heap.budget) - static_cast<int64_t>(heap.usage));
+    }
+    return headroom == INT64_MAX ? 0 : headroom;
+}
+
+}
@@ -0,0 +1,78 @@
+#ifndef _HB_RESIDENCY
+#define _HB_RESIDENCY
+
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "gpu.hpp"
+
+namespace HB {
+
+struct HeapBudget {
+    VkDeviceSize size = 0;
+    // What this process may use, with VK_EXT_memory_budget the driver's estimate, which shrinks
+    // as other processes take their share. Without it, the heap's size.
+    VkDeviceSize budget = 0;
+    // this process's usage according to the driver, or what is tracked here without the extension
+    VkDeviceSize usage = 0;
+    // what was allocated through Gpu:: in this heap
+    VkDeviceSize tracked = 0;
+    bool device_local = false;
+};
+
+// Keeps count of every allocation made through Gpu:: per memory class and heap, and of how much
+// of each heap may be used, queried from VK_EXT_memory_budget once per frame where the device has
+// it. Evicting is up to the owners of the memory, excess() says how much they should give up.
+// Thread safe.
+class ResidencyManager {
+public:
+    // the function is null without VK_EXT_memory_budget
+    ResidencyManager(GpuContext const&, PFN_vkGetPhysicalDeviceMemoryProperties2KHR);
+    ResidencyManager(ResidencyManager const&) = delete;
+    ResidencyManager& operator=(ResidencyManager const&) = delete;
+
+    void allocated(VkDeviceMemory, MemoryClass, uint32_t memory_type, VkDeviceSize size);
+    void freed(VkDeviceMemory);
+
+    // refreshes the budgets, once per frame
+    void update();
+    bool has_memory_budget() const { return m_get_memory_properties != nullptr; }
+    uint32_t heap_count() const { return static_cast<uint32_t>(m_heaps.size()); }
+    HeapBudget heap(uint32_t) const;
+    VkDeviceSize usage(MemoryClass) const;
+
+    // Eviction aims to keep every device local heap at this fraction of its budget, the rest is
+    // left for the other processes' allocations to come and ours between two updates.
+    void set_target(float fraction) { m_target = fraction; }
+    // caps the budget of every device local heap, as if other processes took the rest
+    void set_budget_limit(VkDeviceSize bytes);
+    // what the device local heaps need to free to get back to the target, 0 when they are within
+    VkDeviceSize excess() const;
+    // what is left below the budget in the fullest device local heap, negative when over it
+    int64_t headroom() const;
+
+private:
+    struct Allocation {
+        MemoryClass memory_class;
+        uint32_t heap;
+        VkDeviceSize size;
+    };
+
+    GpuContext m_gpu;
+    PFN_vkGetPhysicalDeviceMemoryProperties2KHR m_get_memory_properties;
+    // heap of every memory type
+    std::vector<uint32_t> m_type_heaps;
+    mutable std::mutex m_mutex;
+    std::vector<HeapBudget> m_heaps;
+    std::array<VkDeviceSize, MEMORY_CLASS_COUNT> m_class_usage {};
+    std::unordered_map<VkDeviceMemory, Allocation> m_allocations;
+    VkDeviceSize m_budget_limit = UINT64_MAX;
+    float m_target = 0.9f;
+};
+
+}
+
+#endif
@@ -0,0 +1,44 @@
+#include <algorithm>
+#include <cmath>
+
+#include "resolution.hpp"
+
+namespace HB {
+
+// aim a bit below the target so normal jitter doesn't push every other frame over it
+constexpr float const HEADROOM = 0.9f;
+// within this fraction of the aimed-for time the scale is left alone
+constexpr float const DEAD_BAND = 0.05f;
+constexpr float const SMOOTHING = 0.2f;
+constexpr float const MAX_GROWTH = 0.02f;
+// scales are rounded to this step, so the viewport doesn't change by a pixel every frame
+constexpr float const STEP = 1.0f / 64.0f;
+
+ResolutionController::ResolutionController(float target_ms)
+    : m_target_ms(target_ms)
+{
+}
+
+float ResolutionController::update(float gpu_ms)
+{
+    if (!(gpu_ms > 0.0f))
+        return m_scale;
+
+    m_average_ms = m_average_ms == 0.0f ? gpu_ms : m_average_ms + (gpu_ms - m_average_ms) * SMOOTHING;
+    float aim_ms = m_target_ms * HEADROOM;
+
+    // react to the raw time when it blows the budget, a smoothed one would miss several frames
+    float ms = gpu_ms > m_target_ms ? std::max(gpu_ms, m_average_ms) : m_average_ms;
+    if (std::abs(ms - aim_ms) <= aim_ms * DEAD_BAND)
+        return m_scale;
+
+    float wanted = m_scale * std::sqrt(aim_ms / ms);
+    if (wanted > m_scale)
+        wanted = std::min(wanted, m_scale + MAX_GROWTH);
+
+    wanted = std::round(wanted / STEP) * STEP;
+    m_scale = std::clamp(wanted, MIN_SCALE, MAX_SCALE);
+    return m_scale;
+}
+
+}
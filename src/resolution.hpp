@@ -0,0 +1,34 @@
+#ifndef _HB_RESOLUTION
+#define _HB_RESOLUTION
+
+namespace HB {
+
+// Picks the render scale (fraction of the output resolution per axis) that keeps the measured GPU
+// frame time at the target. GPU cost is treated as proportional to the pixel count, so the scale
+// moves with the square root of the time ratio. It drops right away when over budget and climbs
+// back slowly, so one spike doesn't make it oscillate.
+class ResolutionController {
+public:
+    static constexpr float const MIN_SCALE = 0.5f;
+    static constexpr float const MAX_SCALE = 1.0f;
+
+    explicit ResolutionController(float target_ms = 1000.0f / 60.0f);
+
+    void set_target(float target_ms) { m_target_ms = target_ms; }
+    float target() const { return m_target_ms; }
+    float scale() const { return m_scale; }
+    // smoothed GPU frame time, in milliseconds
+    float frame_time() const { return m_average_ms; }
+
+    // feed one frame's GPU time, returns the scale to render the next frame at
+    float update(float gpu_ms);
+
+private:
+    float m_target_ms;
+    float m_scale = MAX_SCALE;
+    float m_average_ms = 0.0f;
+};
+
+}
+
+#endif
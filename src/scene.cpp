@@ -0,0 +1,161 @@
+#include <mutex>
+#include <stdexcept>
+
+#include "scene.hpp"
+
+namespace HB {
+
+namespace Detail {
+
+static std::mutex component_registry_mutex;
+static std::array<size_t, MAX_COMPONENTS> component_sizes;
+static uint32_t component_count = 0;
+
+uint32_t register_component(size_t size)
+{
+    std::lock_guard lock(component_registry_mutex);
+    if (component_count == MAX_COMPONENTS)
+        throw std::runtime_error("too many component types!");
+
+    component_sizes[component_count] = size;
+    return component_count++;
+}
+
+static size_t component_size(uint32_t component)
+{
+    std::lock_guard lock(component_registry_mutex);
+    return component_sizes[component];
+}
+
+}
+
+Archetype::Archetype(ComponentMask mask)
+    : m_mask(mask)
+{
+    m_column_index.fill(NO_COLUMN);
+
+    for (uint32_t component = 0; component < MAX_COMPONENTS; component += 1) {
+        if (!(mask & (ComponentMask(1) << component)))
+            continue;
+
+        m_column_index[component] = static_cast<uint8_t>(m_columns.size());
+        m_columns.push_back({ component, Detail::component_size(component), {} });
+    }
+}
+
+std::byte* Archetype::element(uint32_t component, uint32_t row)
+{
+    Column& column = m_columns[m_column_index[component]];
+    return column.data.data() + row * column.element_size;
+}
+
+uint32_t Archetype::push_row(Entity entity)
+{
+    uint32_t row = static_cast<uint32_t>(m_entities.size());
+    m_entities.push_back(entity);
+    for (Column& column : m_columns)
+        column.data.resize(column.data.size() + column.element_size);
+
+    return row;
+}
+
+Entity Archetype::remove_row(uint32_t row)
+{
+    uint32_t last = static_cast<uint32_t>(m_entities.size() - 1);
+    Entity moved = NULL_ENTITY;
+
+    if (row != last) {
+        moved = m_entities[last];
+        m_entities[row] = moved;
+        for (Column& column : m_columns)
+            std::memcpy(column.data.data() + row * column.element_size, column.data.data() + last * column.element_size, column.element_size);
+    }
+
+    m_entities.pop_back();
+    for (Column& column : m_columns)
+        column.data.resize(column.data.size() - column.element_size);
+
+    return moved;
+}
+
+uint32_t Scene::find_or_create_archetype(ComponentMask mask)
+{
+    auto found = m_archetype_lookup.find(mask);
+    if (found != m_archetype_lookup.end())
+        return found->second;
+
+    uint32_t index = static_cast<uint32_t>(m_archetypes.size());
+    m_archetypes.emplace_back(mask);
+    m_archetype_lookup.emplace(mask, index);
+    return index;
+}
+
+Entity Scene::allocate_entity(uint32_t archetype)
+{
+    uint32_t index;
+    if (!m_free_indices.empty()) {
+        index = m_free_indices.back();
+        m_free_indices.pop_back();
+    } else {
+        index = static_cast<uint32_t>(m_records.size());
+        m_records.push_back({ 0, 0, 0 });
+    }
+
+    Entity entity = { index, m_records[index].generation };
+    m_records[index].archetype = archetype;
+    m_records[index].row = m_archetypes[archetype].push_row(entity);
+    m_alive_count += 1;
+    m_structure_version += 1;
+
+    return entity;
+}
+
+bool Scene::alive(Entity entity) const
+{
+    return entity.index < m_records.size() && m_records[entity.index].generation == entity.generation;
+}
+
+void Scene::destroy(Entity entity)
+{
+    if (!alive(entity))
+        return;
+
+    Record& record = m_records[entity.index];
+    Entity moved = m_archetypes[record.archetype].remove_row(record.row);
+    if (moved != NULL_ENTITY)
+        m_records[moved.index].row = record.row;
+
+    // a new generation invalidates every handle still pointing at this slot
+    record.generation += 1;
+    m_free_indices.push_back(entity.index);
+    m_alive_count -= 1;
+    m_structure_version += 1;
+}
+
+void Scene::move_to_archetype(Entity entity, ComponentMask mask)
+{
+    Record& record = m_records[entity.index];
+    if (m_archetypes[record.archetype].mask() == mask)
+        return;
+
+    uint32_t target = find_or_create_archetype(mask);
+    Archetype& source = m_archetypes[record.archetype];
+    Archetype& destination = m_archetypes[target];
+
+    uint32_t row = destination.push_row(entity);
+    ComponentMask shared = source.mask() & mask;
+    for (uint32_t component = 0; component < MAX_COMPONENTS; component += 1) {
+        if (shared & (ComponentMask(1) << component))
+            std::memcpy(destination.element(component, row), source.element(component, record.row), Detail::component_size(component));
+    }
+
+    Entity moved = source.remove_row(record.row);
+    if (moved != NULL_ENTITY)
+        m_records[moved.index].row = record.row;
+
+    record.archetype = target;
+    record.row = row;
+    m_structure_version += 1;
+}
+
+}
@@ -0,0 +1,271 @@
+#ifndef _HB_SCENE
+#define _HB_SCENE
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "geometry.hpp"
+#include "thread_pool.hpp"
+
+namespace HB {
+
+struct Entity {
+    uint32_t index;
+    uint32_t generation;
+
+    bool operator==(Entity const&) const = default;
+};
+
+constexpr Entity const NULL_ENTITY = { UINT32_MAX, 0 };
+
+struct Transform {
+    glm::vec3 position;
+    glm::vec3 scale;
+};
+
+// Bounds (world space) doubles as a component, see geometry.hpp
+
+// drawn when the entity also has a Transform and Bounds
+struct Renderable {
+    // index into the renderer's mesh table, 0 is the built-in triangle
+    uint32_t mesh;
+    glm::vec3 color;
+    // from App::create_material(), 0 is the scene pipeline with the white texture
+    uint32_t material = 0;
+};
+
+using ComponentMask = uint64_t;
+constexpr uint32_t const MAX_COMPONENTS = 64;
+
+namespace Detail {
+
+uint32_t register_component(size_t size);
+
+}
+
+// Components are plain data: they get moved around as bytes when entities change archetype.
+// Entity itself can be listed among the iterated types to get the (read only) handles of the
+// visited rows, it matches every archetype.
+template<typename T>
+uint32_t component_id()
+{
+    static_assert(std::is_trivially_copyable_v<T>, "components must be trivially copyable");
+    static_assert(alignof(T) <= alignof(std::max_align_t), "over-aligned components are not supported");
+    static uint32_t const id = Detail::register_component(sizeof(T));
+    return id;
+}
+
+template<typename T>
+ComponentMask component_bit()
+{
+    if constexpr (std::is_same_v<T, Entity>)
+        return 0;
+    else
+        return ComponentMask(1) << component_id<T>();
+}
+
+template<typename... Ts>
+ComponentMask component_mask()
+{
+    return (component_bit<Ts>() | ... | ComponentMask(0));
+}
+
+// what iterating T hands out, entity handles can't be written through
+template<typename T>
+using ColumnElement = std::conditional_t<std::is_same_v<T, Entity>, Entity const, T>;
+
+// All entities with exactly the same set of components live in one archetype, every component
+// type gets its own tightly packed column (SoA), so systems only touch the bytes they read.
+class Archetype {
+public:
+    static uint8_t const NO_COLUMN = UINT8_MAX;
+
+    Archetype(ComponentMask);
+
+    ComponentMask mask() const { return m_mask; }
+    size_t size() const { return m_entities.size(); }
+    Entity const* entities() const { return m_entities.data(); }
+
+    template<typename T>
+    ColumnElement<T>* column()
+    {
+        if constexpr (std::is_same_v<T, Entity>) {
+            return m_entities.data();
+        } else {
+            uint8_t index = m_column_index[component_id<T>()];
+            if (index == NO_COLUMN)
+                return nullptr;
+            return reinterpret_cast<T*>(m_columns[index].data.data());
+        }
+    }
+
+    std::byte* element(uint32_t component, uint32_t row);
+    uint32_t push_row(Entity);
+    // swap-removes the row, returns the entity that got moved into it (or NULL_ENTITY)
+    Entity remove_row(uint32_t row);
+
+private:
+    struct Column {
+        uint32_t component;
+        size_t element_size;
+        std::vector<std::byte> data;
+    };
+
+    ComponentMask m_mask;
+    std::vector<Entity> m_entities;
+    std::vector<Column> m_columns;
+    std::array<uint8_t, MAX_COMPONENTS> m_column_index;
+};
+
+class Scene {
+public:
+    // rows handed to a single chunk callback, large enough that the per-chunk overhead
+    // disappears; archetypes only get spread across threads from several chunks (tens of
+    // thousands of entities) on, smaller ones aren't worth the hand-off
+    static size_t const CHUNK_SIZE = 4096;
+
+    Scene() = default;
+    Scene(Scene const&) = delete;
+    Scene& operator=(Scene const&) = delete;
+
+    template<typename... Ts>
+    Entity create(Ts const&... components)
+    {
+        uint32_t archetype = find_or_create_archetype(component_mask<Ts...>());
+        Entity entity = allocate_entity(archetype);
+        (write<Ts>(entity, components), ...);
+        return entity;
+    }
+
+    void destroy(Entity);
+    bool alive(Entity) const;
+    size_t size() const { return m_alive_count; }
+    // bumped whenever entities are created/destroyed or change archetype
+    uint64_t structure_version() const { return m_structure_version; }
+
+    template<typename T>
+    T* get(Entity entity)
+    {
+        if (!alive(entity))
+            return nullptr;
+        Record const& record = m_records[entity.index];
+        uint32_t component = component_id<T>();
+        if (!(m_archetypes[record.archetype].mask() & (ComponentMask(1) << component)))
+            return nullptr;
+        return reinterpret_cast<T*>(m_archetypes[record.archetype].element(component, record.row));
+    }
+
+    template<typename T>
+    void add(Entity entity, T const& component)
+    {
+        if (!alive(entity))
+            return;
+        ComponentMask mask = m_archetypes[m_records[entity.index].archetype].mask();
+        move_to_archetype(entity, mask | component_mask<T>());
+        write<T>(entity, component);
+    }
+
+    template<typename T>
+    void remove(Entity entity)
+    {
+        if (!alive(entity))
+            return;
+        ComponentMask mask = m_archetypes[m_records[entity.index].archetype].mask();
+        move_to_archetype(entity, mask & ~component_mask<T>());
+    }
+
+    // Number of entities that have at least the components Ts.
+    template<typename... Ts>
+    size_t count()
+    {
+        ComponentMask required = component_mask<Ts...>();
+        size_t total = 0;
+        for (Archetype const& archetype : m_archetypes)
+            if ((archetype.mask() & required) == required)
+                total += archetype.size();
+        return total;
+    }
+
+    // f(Ts&...) for every entity that has at least the components Ts
+    template<typename... Ts, typename F>
+    void each(F&& function)
+    {
+        each_chunk<Ts...>([&function](size_t, size_t count, ColumnElement<Ts>*... columns) {
+            for (size_t i = 0; i < count; i += 1)
+                function(columns[i]...);
+        });
+    }
+
+    // f(size_t base, size_t count, Ts*...) (Entity const* for Entity) per chunk of contiguous rows, where base is the index
+    // of the chunk's first entity among all matched entities in iteration order. The order is
+    // stable as long as structure_version() does not change.
+    template<typename... Ts, typename F>
+    void each_chunk(F&& function)
+    {
+        ComponentMask required = component_mask<Ts...>();
+        size_t base = 0;
+        for (Archetype& archetype : m_archetypes) {
+            if ((archetype.mask() & required) != required || archetype.size() == 0)
+                continue;
+            for (size_t row = 0; row < archetype.size(); row += CHUNK_SIZE) {
+                size_t count = std::min(CHUNK_SIZE, archetype.size() - row);
+                function(base + row, count, (archetype.column<Ts>() + row)...);
+            }
+            base += archetype.size();
+        }
+    }
+
+    // Same as each_chunk(), but chunks are spread across the pool. Chunks never overlap, so
+    // the callback may write to its own rows without synchronization.
+    template<typename... Ts, typename F>
+    void parallel_each_chunk(ThreadPool& pool, F&& function)
+    {
+        ComponentMask required = component_mask<Ts...>();
+        size_t base = 0;
+        for (Archetype& archetype : m_archetypes) {
+            if ((archetype.mask() & required) != required || archetype.size() == 0)
+                continue;
+            pool.parallel_for(archetype.size(), CHUNK_SIZE, [&](size_t begin, size_t end) {
+                function(base + begin, end - begin, (archetype.column<Ts>() + begin)...);
+            });
+            base += archetype.size();
+        }
+    }
+
+private:
+    struct Record {
+        uint32_t generation;
+        uint32_t archetype;
+        uint32_t row;
+    };
+
+    std::vector<Archetype> m_archetypes;
+    std::unordered_map<ComponentMask, uint32_t> m_archetype_lookup;
+    std::vector<Record> m_records;
+    std::vector<uint32_t> m_free_indices;
+    size_t m_alive_count = 0;
+    uint64_t m_structure_version = 0;
+
+    uint32_t find_or_create_archetype(ComponentMask);
+    Entity allocate_entity(uint32_t archetype);
+    void move_to_archetype(Entity, ComponentMask);
+
+    template<typename T>
+    void write(Entity entity, T const& component)
+    {
+        Record const& record = m_records[entity.index];
+        std::memcpy(m_archetypes[record.archetype].element(component_id<T>(), record.row), &component, sizeof(T));
+    }
+};
+
+}
+
+#endif
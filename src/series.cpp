@@ -0,0 +1,456 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+#include "series.hpp"
+#include "stats.hpp"
+
+namespace HB {
+
+namespace {
+
+    struct DecimateConstants {
+        uint32_t ring_start;
+        uint32_t capacity;
+        uint32_t count;
+        uint32_t column_count;
+        uint32_t column_offset;
+    };
+
+    struct PlotConstants {
+        glm::mat4 view_projection;
+        // x, y, width, height
+        glm::vec4 rect;
+        glm::vec2 value_range;
+        uint32_t column_offset;
+        uint32_t column_count;
+        glm::vec4 color;
+        float min_height;
+    };
+
+    VkShaderStageFlags const PUSH_STAGES = VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_VERTEX_BIT;
+    uint32_t const INITIAL_COLUMNS = 1 << 14;
+
+    // in pixels of the target
+    glm::vec2 project(SeriesRenderer::Target const& target, glm::vec2 point)
+    {
+        glm::vec4 clip = target.view_projection * glm::vec4(point, 0.0f, 1.0f);
+        glm::vec2 ndc = glm::vec2(clip.x, clip.y) / (clip.w != 0.0f ? clip.w : 1.0f);
+        return ndc * 0.5f * glm::vec2(float(target.extent.width), float(target.extent.height));
+    }
+
+    void write_storage_descriptor(GpuContext const& gpu, VkDescriptorSet set, VkBuffer buffer)
+    {
+        VkDescriptorBufferInfo buffer_info {};
+        buffer_info.buffer = buffer;
+        buffer_info.offset = 0;
+        buffer_info.range = VK_WHOLE_SIZE;
+
+        VkWriteDescriptorSet write {};
+        write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        write.dstSet = set;
+        write.dstBinding = 0;
+        write.dstArrayElement = 0;
+        write.descriptorCount = 1;
+        write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        write.pBufferInfo = &buffer_info;
+
+        vkUpdateDescriptorSets(gpu.device, 1, &write, 0, nullptr);
+    }
+
+}
+
+SeriesRenderer::SeriesRenderer(GpuContext const& gpu, VkRenderPass render_pass, uint32_t frames_in_flight)
+    : m_gpu(gpu)
+    , m_frames(frames_in_flight)
+{
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(m_gpu.physical_device, &properties);
+    m_max_storage_range = properties.limits.maxStorageBufferRange;
+
+    create_descriptors(frames_in_flight);
+
+    VkDescriptorSetLayout set_layouts[] = { m_samples_layout, m_columns_layout };
+
+    VkPushConstantRange push_constant_range {};
+    push_constant_range.stageFlags = PUSH_STAGES;
+    push_constant_range.offset = 0;
+    push_constant_range.size = sizeof(PlotConstants);
+
+    VkPipelineLayoutCreateInfo pipeline_layout_info {};
+    pipeline_layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipeline_layout_info.setLayoutCount = 2;
+    pipeline_layout_info.pSetLayouts = set_layouts;
+    pipeline_layout_info.pushConstantRangeCount = 1;
+    pipeline_layout_info.pPushConstantRanges = &push_constant_range;
+
+    if (vkCreatePipelineLayout(m_gpu.device, &pipeline_layout_info, nullptr, &m_layout) != VK_SUCCESS)
+        throw std::runtime_error("failed to create series pipeline layout!");
+
+    // the vertex shader pulls the columns itself
+    m_pipelines = std::make_unique<PipelineCache>(m_gpu, m_layout, render_pass, std::vector<VkVertexInputBindingDescription> {}, std::vector<VkVertexInputAttributeDescription> {});
+
+    PipelineDesc desc {};
+    desc.vertex_shader = "series_vert";
+    desc.fragment_shader = "series_frag";
+    desc.cull_mode = VK_CULL_MODE_NONE;
+    m_plot_pipeline = m_pipelines->get(desc);
+    m_decimate_pipeline = m_pipelines->compute("series_decimate");
+
+    for (FrameData& frame : m_frames)
+        create_columns(frame, INITIAL_COLUMNS);
+}
+
+SeriesRenderer::~SeriesRenderer()
+{
+    for (FrameData& frame : m_frames) {
+        destroy_staging(frame);
+        destroy_columns(frame);
+    }
+    for (auto const& series : m_series)
+        Gpu::destroy_buffer(m_gpu, series->buffer, series->memory);
+    m_pipelines.reset();
+    vkDestroyPipelineLayout(m_gpu.device, m_layout, nullptr);
+    vkDestroyDescriptorPool(m_gpu.device, m_descriptor_pool, nullptr);
+    vkDestroyDescriptorSetLayout(m_gpu.device, m_columns_layout, nullptr);
+    vkDestroyDescriptorSetLayout(m_gpu.device, m_samples_layout, nullptr);
+}
+
+void SeriesRenderer::create_descriptors(uint32_t frames_in_flight)
+{
+    VkDescriptorSetLayoutBinding binding {};
+    binding.binding = 0;
+    binding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    binding.descriptorCount = 1;
+
+    VkDescriptorSetLayoutCreateInfo layout_info {};
+    layout_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layout_info.bindingCount = 1;
+    layout_info.pBindings = &binding;
+
+    binding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    if (vkCreateDescriptorSetLayout(m_gpu.device, &layout_info, nullptr, &m_samples_layout) != VK_SUCCESS)
+        throw std::runtime_error("failed to create series descriptor set layout!");
+
+    binding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_VERTEX_BIT;
+    if (vkCreateDescriptorSetLayout(m_gpu.device, &layout_info, nullptr, &m_columns_layout) != VK_SUCCESS)
+        throw std::runtime_error("failed to create series descriptor set layout!");
+
+    VkDescriptorPoolSize pool_size {};
+    pool_size.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    pool_size.descriptorCount = MAX_SERIES + frames_in_flight;
+
+    VkDescriptorPoolCreateInfo pool_info {};
+    pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    pool_info.poolSizeCount = 1;
+    pool_info.pPoolSizes = &pool_size;
+    pool_info.maxSets = MAX_SERIES + frames_in_flight;
+
+    if (vkCreateDescriptorPool(m_gpu.device, &pool_info, nullptr, &m_descriptor_pool) != VK_SUCCESS)
+        throw std::runtime_error("failed to create series descriptor pool!");
+
+    std::vector<VkDescriptorSetLayout> layouts(frames_in_flight, m_columns_layout);
+    std::vector<VkDescriptorSet> sets(frames_in_flight);
+
+    VkDescriptorSetAllocateInfo alloc_info {};
+    alloc_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    alloc_info.descriptorPool = m_descriptor_pool;
+    alloc_info.descriptorSetCount = frames_in_flight;
+    alloc_info.pSetLayouts = layouts.data();
+
+    if (vkAllocateDescriptorSets(m_gpu.device, &alloc_info, sets.data()) != VK_SUCCESS)
+        throw std::runtime_error("failed to allocate series descriptor sets!");
+
+    for (uint32_t i = 0; i < frames_in_flight; i += 1)
+        m_frames[i].descriptor_set = sets[i];
+}
+
+void SeriesRenderer::create_staging(FrameData& frame, size_t capacity)
+{
+    Gpu::create_buffer(m_gpu, capacity, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, frame.staging, frame.staging_memory, MemoryClass::FRAME);
+    vkMapMemory(m_gpu.device, frame.staging_memory, 0, capacity, 0, &frame.staging_mapped);
+    frame.staging_capacity = capacity;
+}
+
+void SeriesRenderer::destroy_staging(FrameData& frame)
+{
+    if (frame.staging == VK_NULL_HANDLE)
+        return;
+
+    vkUnmapMemory(m_gpu.device, frame.staging_memory);
+    Gpu::destroy_buffer(m_gpu, frame.staging, frame.staging_memory);
+    frame.staging = VK_NULL_HANDLE;
+    frame.staging_memory = VK_NULL_HANDLE;
+    frame.staging_mapped = nullptr;
+    frame.staging_capacity = 0;
+}
+
+void SeriesRenderer::create_columns(FrameData& frame, uint32_t capacity)
+{
+    Gpu::create_buffer(m_gpu, sizeof(glm::vec2) * capacity, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, frame.columns, frame.columns_memory, MemoryClass::FRAME);
+    frame.column_capacity = capacity;
+    write_storage_descriptor(m_gpu, frame.descriptor_set, frame.columns);
+}
+
+void SeriesRenderer::destroy_columns(FrameData& frame)
+{
+    if (frame.columns == VK_NULL_HANDLE)
+        return;
+
+    Gpu::destroy_buffer(m_gpu, frame.columns, frame.columns_memory);
+    frame.columns = VK_NULL_HANDLE;
+    frame.columns_memory = VK_NULL_HANDLE;
+    frame.column_capacity = 0;
+}
+
+uint32_t SeriesRenderer::create(uint32_t capacity, SeriesView const& view)
+{
+    if (m_series.size() >= MAX_SERIES)
+        throw std::runtime_error("too many series!");
+    // the shaders index samples with 32 bits, and ring_start + i has to fit too
+    if (capacity == 0 || capacity > (1u << 31) || VkDeviceSize(capacity) * sizeof(float) > m_max_storage_range)
+        throw std::runtime_error("series capacity is out of range!");
+
+    auto series = std::make_unique<Series>();
+    series->capacity = capacity;
+    series->view = view;
+    series->drawn_view = view;
+    Gpu::create_buffer(m_gpu, VkDeviceSize(capacity) * sizeof(float), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, series->buffer, series->memory, MemoryClass::SERIES);
+
+    VkDescriptorSetAllocateInfo alloc_info {};
+    alloc_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    alloc_info.descriptorPool = m_descriptor_pool;
+    alloc_info.descriptorSetCount = 1;
+    alloc_info.pSetLayouts = &m_samples_layout;
+
+    if (vkAllocateDescriptorSets(m_gpu.device, &alloc_info, &series->descriptor_set) != VK_SUCCESS)
+        throw std::runtime_error("failed to allocate series descriptor set!");
+    write_storage_descriptor(m_gpu, series->descriptor_set, series->buffer);
+
+    std::lock_guard lock(m_mutex);
+    m_series.push_back(std::move(series));
+    return static_cast<uint32_t>(m_series.size() - 1);
+}
+
+void SeriesRenderer::append(uint32_t index, float const* values, size_t count)
+{
+    Series& series = *m_series[index];
+    std::lock_guard lock(m_mutex);
+    series.appended += count;
+
+    // only the newest `capacity` samples can still be shown, older ones aren't uploaded at all
+    if (count >= series.capacity) {
+        values += count - series.capacity;
+        count = series.capacity;
+        series.pending.clear();
+        series.pending_first = 0;
+    }
+    series.pending.insert(series.pending.end(), values, values + count);
+    size_t waiting = series.pending.size() - series.pending_first;
+    if (waiting > series.capacity)
+        series.pending_first += waiting - series.capacity;
+}
+
+void SeriesRenderer::set_view(uint32_t index, SeriesView const& view)
+{
+    std::lock_guard lock(m_mutex);
+    m_series[index]->view = view;
+}
+
+uint64_t SeriesRenderer::appended(uint32_t index) const
+{
+    std::lock_guard lock(m_mutex);
+    return m_series[index]->appended;
+}
+
+size_t SeriesRenderer::pending_samples() const
+{
+    std::lock_guard lock(m_mutex);
+    size_t pending = 0;
+    for (auto const& series : m_series)
+        pending += series->pending.size() - series->pending_first;
+    return pending;
+}
+
+void SeriesRenderer::prepare(uint32_t frame_index)
+{
+    FrameData& frame = m_frames[frame_index];
+    frame.copies.clear();
+
+    std::lock_guard lock(m_mutex);
+    size_t waiting_bytes = 0;
+    for (auto const& series : m_series)
+        waiting_bytes += (series->pending.size() - series->pending_first) * sizeof(float);
+    size_t needed = std::min(waiting_bytes, MAX_UPLOAD_BYTES);
+    if (needed > frame.staging_capacity) {
+        destroy_staging(frame);
+        create_staging(frame, std::min(std::max(needed, frame.staging_capacity * 2), MAX_UPLOAD_BYTES));
+    }
+
+    size_t staged = 0;
+    for (uint32_t i = 0; i < m_series.size(); i += 1) {
+        Series& series = *m_series[i];
+        series.drawn_view = series.view;
+
+        size_t waiting = series.pending.size() - series.pending_first;
+        size_t count = std::min(waiting, (frame.staging_capacity - staged) / sizeof(float));
+        if (count == 0)
+            continue;
+
+        // global index of the first sample staged, it goes to that index modulo capacity
+        uint64_t first = series.appended - waiting;
+        std::memcpy(static_cast<char*>(frame.staging_mapped) + staged * sizeof(float), series.pending.data() + series.pending_first, count * sizeof(float));
+
+        uint64_t slot = first % series.capacity;
+        uint64_t before_wrap = std::min<uint64_t>(count, series.capacity - slot);
+        frame.copies.push_back({ i, { staged * sizeof(float), slot * sizeof(float), before_wrap * sizeof(float) } });
+        if (count > before_wrap)
+            frame.copies.push_back({ i, { (staged + before_wrap) * sizeof(float), 0, (count - before_wrap) * sizeof(float) } });
+
+        series.pending_first += count;
+        if (series.pending_first == series.pending.size()) {
+            series.pending.clear();
+            series.pending_first = 0;
+        } else if (series.pending_first > series.pending.size() / 2) {
+            series.pending.erase(series.pending.begin(), series.pending.begin() + series.pending_first);
+            series.pending_first = 0;
+        }
+        series.uploaded = first + count;
+        staged += count;
+    }
+    Stats::count(Counter::BYTES_UPLOADED, staged * sizeof(float));
+}
+
+void SeriesRenderer::record_compute(VkCommandBuffer command_buffer, uint32_t frame_index, Target const* targets, uint32_t target_count)
+{
+    FrameData& frame = m_frames[frame_index];
+    uint32_t series_count = static_cast<uint32_t>(m_series.size());
+    frame.draws.assign(size_t(target_count) * series_count, Draw {});
+    frame.view_projections.resize(target_count);
+
+    if (!frame.copies.empty()) {
+        // the last frame's decimation may still read where the copies go
+        VkMemoryBarrier barrier {};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+        for (Copy const& copy : frame.copies)
+            vkCmdCopyBuffer(command_buffer, frame.staging, m_series[copy.series]->buffer, 1, &copy.region);
+
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+    }
+
+    // one column per pixel the plot is wide, but never more columns than samples
+    uint32_t total_columns = 0;
+    for (uint32_t target = 0; target < target_count; target += 1) {
+        frame.view_projections[target] = targets[target].view_projection;
+        for (uint32_t i = 0; i < series_count; i += 1) {
+            Series const& series = *m_series[i];
+            SeriesView const& view = series.drawn_view;
+            uint64_t count = std::min<uint64_t>(series.uploaded, series.capacity);
+            if (view.visible > 0)
+                count = std::min(count, view.visible);
+            if (count == 0)
+                continue;
+
+            glm::vec2 origin = project(targets[target], view.position);
+            float width = std::abs(project(targets[target], view.position + glm::vec2(view.size.x, 0.0f)).x - origin.x);
+            float height = std::abs(project(targets[target], view.position + glm::vec2(0.0f, view.size.y)).y - origin.y);
+
+            Draw& draw = frame.draws[size_t(target) * series_count + i];
+            draw.sample_count = static_cast<uint32_t>(count);
+            draw.column_offset = total_columns;
+            draw.column_count = static_cast<uint32_t>(std::min<uint64_t>(std::clamp(std::ceil(width), 1.0f, float(MAX_COLUMNS)), count));
+            // at least a pixel tall, so flat stretches don't disappear
+            draw.min_height = std::abs(view.size.y) / std::max(height, 1.0f);
+            total_columns += draw.column_count;
+        }
+    }
+    if (total_columns == 0)
+        return;
+
+    // the columns of the frame in flight before this one use a different buffer
+    if (total_columns > frame.column_capacity) {
+        destroy_columns(frame);
+        create_columns(frame, std::max(total_columns, frame.column_capacity * 2));
+    }
+
+    vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_decimate_pipeline);
+    Stats::count(Counter::PIPELINE_BINDS);
+    vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_layout, 1, 1, &frame.descriptor_set, 0, nullptr);
+    Stats::count(Counter::DESCRIPTOR_BINDS);
+
+    for (uint32_t target = 0; target < target_count; target += 1) {
+        for (uint32_t i = 0; i < series_count; i += 1) {
+            Draw const& draw = frame.draws[size_t(target) * series_count + i];
+            if (draw.column_count == 0)
+                continue;
+
+            Series const& series = *m_series[i];
+            vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_layout, 0, 1, &series.descriptor_set, 0, nullptr);
+            Stats::count(Counter::DESCRIPTOR_BINDS);
+
+            DecimateConstants constants {};
+            constants.ring_start = static_cast<uint32_t>((series.uploaded - draw.sample_count) % series.capacity);
+            constants.capacity = series.capacity;
+            constants.count = draw.sample_count;
+            constants.column_count = draw.column_count;
+            constants.column_offset = draw.column_offset;
+            vkCmdPushConstants(command_buffer, m_layout, PUSH_STAGES, 0, sizeof(constants), &constants);
+
+            vkCmdDispatch(command_buffer, draw.column_count, 1, 1);
+            Stats::count(Counter::DISPATCHES);
+        }
+    }
+
+    VkMemoryBarrier barrier {};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_VERTEX_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+}
+
+void SeriesRenderer::record(VkCommandBuffer command_buffer, uint32_t frame_index, uint32_t target) const
+{
+    FrameData const& frame = m_frames[frame_index];
+    uint32_t series_count = static_cast<uint32_t>(m_series.size());
+    if (size_t(target + 1) * series_count > frame.draws.size())
+        return;
+
+    bool bound = false;
+    for (uint32_t i = 0; i < series_count; i += 1) {
+        Draw const& draw = frame.draws[size_t(target) * series_count + i];
+        if (draw.column_count == 0)
+            continue;
+
+        if (!bound) {
+            vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_plot_pipeline);
+            Stats::count(Counter::PIPELINE_BINDS);
+            vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_layout, 1, 1, &frame.descriptor_set, 0, nullptr);
+            Stats::count(Counter::DESCRIPTOR_BINDS);
+            bound = true;
+        }
+
+        SeriesView const& view = m_series[i]->drawn_view;
+        PlotConstants constants {};
+        constants.view_projection = frame.view_projections[target];
+        constants.rect = glm::vec4(view.position, view.size);
+        constants.value_range = view.value_range;
+        constants.column_offset = draw.column_offset;
+        constants.column_count = draw.column_count;
+        constants.color = view.color;
+        constants.min_height = draw.min_height;
+        vkCmdPushConstants(command_buffer, m_layout, PUSH_STAGES, 0, sizeof(constants), &constants);
+
+        vkCmdDraw(command_buffer, 6 * draw.column_count, 1, 0, 0);
+        Stats::count(Counter::DRAW_CALLS);
+        Stats::count(Counter::VERTICES, 6 * draw.column_count);
+    }
+}
+
+}
@@ -0,0 +1,139 @@
+#ifndef _HB_SERIES
+#define _HB_SERIES
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "gpu.hpp"
+#include "pipeline.hpp"
+
+namespace HB {
+
+// Where and how a series is plotted. Samples are uniformly spaced, sample i is at x = i, so only
+// their values are stored.
+struct SeriesView {
+    // top left and size of the plot, in the same space as the scene
+    glm::vec2 position = glm::vec2(-1.0f);
+    glm::vec2 size = glm::vec2(2.0f);
+    // the values at the bottom and the top of the plot
+    glm::vec2 value_range = glm::vec2(0.0f, 1.0f);
+    // how many of the newest samples are shown, 0 for all that are kept
+    uint64_t visible = 0;
+    glm::vec4 color = glm::vec4(1.0f);
+};
+
+// Plots long streams of samples as line graphs. Every series keeps its newest `capacity` samples
+// in a device-local ring buffer, appending only uploads the new samples and never touches the
+// history. Before the passes a compute shader reduces the visible samples to a min/max range per
+// pixel column, and the vertex shader pulls those from a storage buffer and draws one quad per
+// column, so the cost of a frame depends on the plot's width and not on the sample count.
+//
+// append() and set_view() may be called from any thread, what was appended is uploaded in
+// MAX_UPLOAD_BYTES chunks by the following frames. Series are created during setup.
+class SeriesRenderer {
+public:
+    static uint32_t const MAX_SERIES = 64;
+    // per series and window
+    static uint32_t const MAX_COLUMNS = 8192;
+    static size_t const MAX_UPLOAD_BYTES = 64 << 20;
+
+    // a window the series are drawn to this frame
+    struct Target {
+        glm::mat4 view_projection;
+        VkExtent2D extent;
+    };
+
+    SeriesRenderer(GpuContext const&, VkRenderPass, uint32_t frames_in_flight);
+    ~SeriesRenderer();
+    SeriesRenderer(SeriesRenderer const&) = delete;
+    SeriesRenderer& operator=(SeriesRenderer const&) = delete;
+
+    uint32_t create(uint32_t capacity, SeriesView const& = {});
+    void append(uint32_t series, float const* values, size_t count);
+    void set_view(uint32_t series, SeriesView const&);
+    // in total, and what hasn't reached the GPU yet
+    uint64_t appended(uint32_t series) const;
+    size_t pending_samples() const;
+    uint32_t series_count() const { return static_cast<uint32_t>(m_series.size()); }
+
+    // stages what was appended, once the frame's fence has been waited on
+    void prepare(uint32_t frame);
+    // outside the passes: the uploads, then the columns of every series for every target
+    void record_compute(VkCommandBuffer, uint32_t frame, Target const* targets, uint32_t target_count);
+    // inside the pass of targets[target]
+    void record(VkCommandBuffer, uint32_t frame, uint32_t target) const;
+
+private:
+    struct Series {
+        uint32_t capacity;
+        VkBuffer buffer = VK_NULL_HANDLE;
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        VkDescriptorSet descriptor_set = VK_NULL_HANDLE;
+
+        // guarded by m_mutex; samples from pending_first on are waiting to be staged
+        uint64_t appended = 0;
+        std::vector<float> pending;
+        size_t pending_first = 0;
+        SeriesView view;
+
+        // render side: samples up to here are on the GPU, and the view they are drawn with
+        uint64_t uploaded = 0;
+        SeriesView drawn_view;
+    };
+
+    struct Copy {
+        uint32_t series;
+        VkBufferCopy region;
+    };
+
+    struct Draw {
+        uint32_t sample_count = 0;
+        uint32_t column_offset = 0;
+        uint32_t column_count = 0;
+        float min_height = 0.0f;
+    };
+
+    struct FrameData {
+        VkBuffer staging = VK_NULL_HANDLE;
+        VkDeviceMemory staging_memory = VK_NULL_HANDLE;
+        void* staging_mapped = nullptr;
+        size_t staging_capacity = 0;
+        std::vector<Copy> copies;
+
+        VkBuffer columns = VK_NULL_HANDLE;
+        VkDeviceMemory columns_memory = VK_NULL_HANDLE;
+        uint32_t column_capacity = 0;
+        VkDescriptorSet descriptor_set = VK_NULL_HANDLE;
+        // per target, then per series
+        std::vector<Draw> draws;
+        std::vector<glm::mat4> view_projections;
+    };
+
+    GpuContext m_gpu;
+    VkDeviceSize m_max_storage_range;
+    VkDescriptorSetLayout m_samples_layout;
+    VkDescriptorSetLayout m_columns_layout;
+    VkDescriptorPool m_descriptor_pool;
+    VkPipelineLayout m_layout;
+    std::unique_ptr<PipelineCache> m_pipelines;
+    VkPipeline m_decimate_pipeline;
+    VkPipeline m_plot_pipeline;
+    std::vector<std::unique_ptr<Series>> m_series;
+    std::vector<FrameData> m_frames;
+    mutable std::mutex m_mutex;
+
+    void create_descriptors(uint32_t frames_in_flight);
+    void create_staging(FrameData&, size_t capacity);
+    void destroy_staging(FrameData&);
+    void create_columns(FrameData&, uint32_t capacity);
+    void destroy_columns(FrameData&);
+};
+
+}
+
+#endif
@@ -0,0 +1,115 @@
+#version 450
+
+// One thread per meshlet of every instance of a draw. Visible meshlets get an indexed draw of
+// their triangles for that one instance. Compacted, they are appended and counted for
+// vkCmdDrawIndexedIndirectCount; otherwise every meshlet has its own slot and culled ones draw
+// nothing.
+
+layout(local_size_x = 64) in;
+
+struct Meshlet {
+    uint first_index;
+    uint index_count;
+    float center_x, center_y, center_z;
+    float radius;
+    float axis_x, axis_y, axis_z;
+    float cutoff;
+};
+
+// VkDrawIndexedIndirectCommand
+struct DrawCommand {
+    uint index_count;
+    uint instance_count;
+    uint first_index;
+    int vertex_offset;
+    uint first_instance;
+};
+
+layout(std430, set = 0, binding = 0) readonly buffer Meshlets {
+    Meshlet meshlets[];
+};
+
+// App's instances: position, scale and color
+layout(std430, set = 0, binding = 1) readonly buffer Instances {
+    float instances[];
+};
+
+layout(std430, set = 0, binding = 2) writeonly buffer Commands {
+    DrawCommand commands[];
+};
+
+layout(std430, set = 0, binding = 3) buffer Counts {
+    uint counts[];
+};
+
+layout(push_constant) uniform Cull {
+    mat4 view_projection;
+    // depth increases along xyz - x * w at x, |w| is 1 for perspective and 0 for orthographic
+    // views, see MeshletCuller::record_compute()
+    vec4 depth;
+    uint first_meshlet;
+    uint meshlet_count;
+    uint first_instance;
+    uint instance_count;
+    uint first_command;
+    uint count_index;
+    int vertex_offset;
+    // 1 or -1, turns the normals so back faces point along depth, 0 when they aren't culled
+    float facing;
+    uint compact;
+} cull;
+
+void main() {
+    uint thread = gl_GlobalInvocationID.x;
+    if (thread >= cull.meshlet_count * cull.instance_count)
+        return;
+
+    uint instance = thread / cull.meshlet_count;
+    Meshlet meshlet = meshlets[cull.first_meshlet + thread % cull.meshlet_count];
+
+    uint base = (cull.first_instance + instance) * 9;
+    vec3 position = vec3(instances[base], instances[base + 1], instances[base + 2]);
+    vec3 scale = vec3(instances[base + 3], instances[base + 4], instances[base + 5]);
+    vec3 center = vec3(meshlet.center_x, meshlet.center_y, meshlet.center_z) * scale + position;
+    vec3 extent = abs(scale);
+    float radius = meshlet.radius * max(extent.x, max(extent.y, extent.z));
+
+    // the sphere against the frustum planes, Vulkan depth goes from 0 to 1
+    mat4 m = cull.view_projection;
+    vec4 row_x = vec4(m[0][0], m[1][0], m[2][0], m[3][0]);
+    vec4 row_y = vec4(m[0][1], m[1][1], m[2][1], m[3][1]);
+    vec4 row_z = vec4(m[0][2], m[1][2], m[2][2], m[3][2]);
+    vec4 row_w = vec4(m[0][3], m[1][3], m[2][3], m[3][3]);
+    vec4 planes[6] = vec4[](row_w + row_x, row_w - row_x, row_w + row_y, row_w - row_y, row_z, row_w - row_z);
+    bool visible = true;
+    for (int i = 0; i < 6; i++) {
+        float length_xyz = length(planes[i].xyz);
+        if (dot(planes[i].xyz, center) + planes[i].w < -radius * length_xyz)
+            visible = false;
+    }
+
+    // back facing when every turned normal points along depth, only a uniform scale keeps the
+    // normals where they were
+    bool uniform_scale = scale.x == scale.y && scale.y == scale.z;
+    if (visible && cull.facing != 0.0 && meshlet.cutoff < 1.0 && uniform_scale) {
+        vec3 axis = vec3(meshlet.axis_x, meshlet.axis_y, meshlet.axis_z) * cull.facing;
+        vec3 away = cull.depth.xyz - center * cull.depth.w;
+        if (dot(away, axis) >= meshlet.cutoff * length(away) + radius * abs(cull.depth.w))
+            visible = false;
+    }
+
+    DrawCommand command;
+    command.index_count = visible ? meshlet.index_count : 0;
+    command.instance_count = 1;
+    command.first_index = meshlet.first_index;
+    command.vertex_offset = cull.vertex_offset;
+    command.first_instance = cull.first_instance + instance;
+    if (cull.compact != 0) {
+        if (visible) {
+            uint slot = atomicAdd(counts[cull.count_index], 1);
+            commands[cull.first_command + slot] = command;
+        }
+    } else {
+        commands[cull.first_command + thread] = command;
+    }
+}
@@ -0,0 +1,35 @@
+#version 450
+
+layout(local_size_x = 8, local_size_y = 8) in;
+
+layout(set = 0, binding = 0, rgba16f) uniform readonly image2D source;
+layout(set = 0, binding = 1, rgba16f) uniform writeonly image2D destination;
+
+layout(push_constant) uniform Post {
+    ivec2 size;
+    ivec2 extra_size;
+    uint vertical;
+    float radius;
+    float threshold;
+    float intensity;
+    float exposure;
+} params;
+
+// Halves the scene and keeps what is brighter than the threshold, size is the half resolution
+// and extra_size the scene's.
+void main() {
+    ivec2 pixel = ivec2(gl_GlobalInvocationID.xy);
+    if (pixel.x >= params.size.x || pixel.y >= params.size.y)
+        return;
+
+    ivec2 last = params.extra_size - 1;
+    vec3 color = imageLoad(source, min(pixel * 2, last)).rgb;
+    color += imageLoad(source, min(pixel * 2 + ivec2(1, 0), last)).rgb;
+    color += imageLoad(source, min(pixel * 2 + ivec2(0, 1), last)).rgb;
+    color += imageLoad(source, min(pixel * 2 + ivec2(1, 1), last)).rgb;
+    color *= 0.25;
+
+    float brightness = max(color.r, max(color.g, color.b));
+    color *= max(brightness - params.threshold, 0.0) / max(brightness, 1e-4);
+    imageStore(destination, pixel, vec4(color, 1.0));
+}
@@ -0,0 +1,44 @@
+#version 450
+
+layout(local_size_x = 8, local_size_y = 8) in;
+
+layout(set = 0, binding = 1, rgba16f) uniform image2D scene;
+layout(set = 0, binding = 2, rgba16f) uniform readonly image2D bloom;
+
+layout(push_constant) uniform Post {
+    ivec2 size;
+    ivec2 extra_size;
+    uint vertical;
+    float radius;
+    float threshold;
+    float intensity;
+    float exposure;
+} params;
+
+vec3 sample_bloom(ivec2 pixel) {
+    vec2 position = (vec2(pixel) + 0.5) * 0.5 - 0.5;
+    ivec2 base = ivec2(floor(position));
+    vec2 f = position - vec2(base);
+    ivec2 last = params.extra_size - 1;
+    vec3 a = imageLoad(bloom, clamp(base, ivec2(0), last)).rgb;
+    vec3 b = imageLoad(bloom, clamp(base + ivec2(1, 0), ivec2(0), last)).rgb;
+    vec3 c = imageLoad(bloom, clamp(base + ivec2(0, 1), ivec2(0), last)).rgb;
+    vec3 d = imageLoad(bloom, clamp(base + ivec2(1, 1), ivec2(0), last)).rgb;
+    return mix(mix(a, b, f.x), mix(c, d, f.x), f.y);
+}
+
+vec3 aces(vec3 x) {
+    return clamp((x * (2.51 * x + 0.03)) / (x * (2.43 * x + 0.59) + 0.14), 0.0, 1.0);
+}
+
+// post_bloom_composite and post_tonemap in one pass, the scene is read and written once instead
+// of twice
+void main() {
+    ivec2 pixel = ivec2(gl_GlobalInvocationID.xy);
+    if (pixel.x >= params.size.x || pixel.y >= params.size.y)
+        return;
+
+    vec4 color = imageLoad(scene, pixel);
+    vec3 composite = color.rgb + sample_bloom(pixel) * params.intensity;
+    imageStore(scene, pixel, vec4(aces(composite * params.exposure), color.a));
+}
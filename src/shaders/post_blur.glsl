@@ -0,0 +1,53 @@
+#version 450
+
+layout(local_size_x = 128) in;
+
+layout(set = 0, binding = 0, rgba16f) uniform readonly image2D source;
+layout(set = 0, binding = 1, rgba16f) uniform writeonly image2D destination;
+
+layout(push_constant) uniform Post {
+    ivec2 size;
+    ivec2 extra_size;
+    uint vertical;
+    float radius;
+    float threshold;
+    float intensity;
+    float exposure;
+} params;
+
+const int TILE = 128;
+const int MAX_RADIUS = 32;
+
+shared vec4 tile[TILE + 2 * MAX_RADIUS];
+
+// One pass of a separable gaussian, along rows or along columns. A workgroup takes TILE pixels of
+// one line and loads them and the radius on either side into shared memory once, so the image is
+// read about once per pixel instead of once per tap.
+void main() {
+    int radius = min(int(ceil(params.radius)), MAX_RADIUS);
+    int line_length = params.vertical != 0 ? params.size.y : params.size.x;
+    int line = int(gl_WorkGroupID.y);
+    int start = int(gl_WorkGroupID.x) * TILE;
+    int local = int(gl_LocalInvocationID.x);
+
+    // edges are clamped
+    for (int i = local; i < TILE + 2 * radius; i += TILE) {
+        int position = clamp(start - radius + i, 0, line_length - 1);
+        tile[i] = imageLoad(source, params.vertical != 0 ? ivec2(line, position) : ivec2(position, line));
+    }
+    barrier();
+
+    int position = start + local;
+    if (position >= line_length)
+        return;
+
+    float sigma = max(params.radius * 0.5, 0.5);
+    vec4 sum = vec4(0.0);
+    float total = 0.0;
+    for (int offset = -radius; offset <= radius; offset += 1) {
+        float weight = exp(-float(offset * offset) / (2.0 * sigma * sigma));
+        sum += tile[local + radius + offset] * weight;
+        total += weight;
+    }
+    imageStore(destination, params.vertical != 0 ? ivec2(line, position) : ivec2(position, line), sum / total);
+}
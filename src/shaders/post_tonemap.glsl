@@ -0,0 +1,30 @@
+#version 450
+
+layout(local_size_x = 8, local_size_y = 8) in;
+
+layout(set = 0, binding = 1, rgba16f) uniform image2D scene;
+
+layout(push_constant) uniform Post {
+    ivec2 size;
+    ivec2 extra_size;
+    uint vertical;
+    float radius;
+    float threshold;
+    float intensity;
+    float exposure;
+} params;
+
+// Narkowicz's fit of the ACES filmic curve
+vec3 aces(vec3 x) {
+    return clamp((x * (2.51 * x + 0.03)) / (x * (2.43 * x + 0.59) + 0.14), 0.0, 1.0);
+}
+
+// exposure and the filmic curve, HDR down to what the swap chain can show, in place
+void main() {
+    ivec2 pixel = ivec2(gl_GlobalInvocationID.xy);
+    if (pixel.x >= params.size.x || pixel.y >= params.size.y)
+        return;
+
+    vec4 color = imageLoad(scene, pixel);
+    imageStore(scene, pixel, vec4(aces(color.rgb * params.exposure), color.a));
+}
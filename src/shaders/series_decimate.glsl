@@ -0,0 +1,55 @@
+#version 450
+
+layout(local_size_x = 256) in;
+
+layout(set = 0, binding = 0) readonly buffer Samples {
+    float samples[];
+};
+
+layout(set = 1, binding = 0) writeonly buffer Columns {
+    vec2 columns[];
+};
+
+layout(push_constant) uniform Decimate {
+    uint ring_start;
+    uint capacity;
+    uint count;
+    uint column_count;
+    uint column_offset;
+} params;
+
+shared vec2 ranges[256];
+
+// one workgroup per column, reduces its samples to their min and max
+void main() {
+    uint column = gl_WorkGroupID.x;
+    uint local = gl_LocalInvocationID.x;
+
+    // the first count % column_count columns get one sample more
+    uint base = params.count / params.column_count;
+    uint extra = params.count % params.column_count;
+    uint first = column * base + min(column, extra);
+    uint last = first + base + (column < extra ? 1 : 0);
+
+    vec2 range = vec2(uintBitsToFloat(0x7f800000u), -uintBitsToFloat(0x7f800000u));
+    for (uint i = first + local; i < last; i += 256) {
+        uint slot = params.ring_start + i;
+        if (slot >= params.capacity)
+            slot -= params.capacity;
+        float value = samples[slot];
+        range = vec2(min(range.x, value), max(range.y, value));
+    }
+    ranges[local] = range;
+    barrier();
+
+    for (uint stride = 128; stride > 0; stride >>= 1) {
+        if (local < stride) {
+            vec2 other = ranges[local + stride];
+            ranges[local] = vec2(min(ranges[local].x, other.x), max(ranges[local].y, other.y));
+        }
+        barrier();
+    }
+
+    if (local == 0)
+        columns[params.column_offset + column] = ranges[0];
+}
@@ -0,0 +1,46 @@
+#version 450
+
+layout(set = 1, binding = 0) readonly buffer Columns {
+    vec2 columns[];
+};
+
+layout(push_constant) uniform Plot {
+    mat4 view_projection;
+    // x, y, width, height
+    vec4 rect;
+    vec2 value_range;
+    uint column_offset;
+    uint column_count;
+    vec4 color;
+    // in the plot's space
+    float min_height;
+} plot;
+
+layout(location = 0) out vec4 frag_color;
+
+const vec2 CORNERS[6] = vec2[](
+    vec2(0.0, 0.0), vec2(1.0, 0.0), vec2(0.0, 1.0),
+    vec2(0.0, 1.0), vec2(1.0, 0.0), vec2(1.0, 1.0)
+);
+
+// one quad per column from its min to its max, no vertex buffer
+void main() {
+    uint column = gl_VertexIndex / 6;
+    vec2 corner = CORNERS[gl_VertexIndex % 6];
+
+    // reaching over to the previous column's range keeps the line connected across steps
+    vec2 range = columns[plot.column_offset + column];
+    if (column > 0) {
+        vec2 previous = columns[plot.column_offset + column - 1];
+        range = vec2(min(range.x, previous.y), max(range.y, previous.x));
+    }
+
+    // higher values go up, the plot's y grows downward like the rest of the scene's 2D space
+    vec2 y = plot.rect.y + plot.rect.w * (1.0 - (range - plot.value_range.x) / (plot.value_range.y - plot.value_range.x));
+    float center = 0.5 * (y.x + y.y);
+    float half_height = max(0.5 * abs(y.x - y.y), 0.5 * plot.min_height);
+
+    float x = plot.rect.x + plot.rect.z * (float(column) + corner.x) / float(plot.column_count);
+    gl_Position = plot.view_projection * vec4(x, mix(center - half_height, center + half_height, corner.y), 0.0, 1.0);
+    frag_color = plot.color;
+}
@@ -0,0 +1,16 @@
+#version 450
+
+layout(set = 0, binding = 0) uniform sampler2D atlas;
+
+layout(location = 0) in vec2 frag_uv;
+layout(location = 1) in vec4 frag_color;
+
+layout(location = 0) out vec4 out_color;
+
+void main() {
+    // 0.5 is the outline, the edge is smoothed over about a pixel at whatever scale it is drawn
+    float distance = texture(atlas, frag_uv).r;
+    float width = max(fwidth(distance), 1e-4);
+    float coverage = smoothstep(0.5 - width, 0.5 + width, distance);
+    out_color = vec4(frag_color.rgb, frag_color.a * coverage);
+}
@@ -0,0 +1,26 @@
+#version 450
+
+layout(push_constant) uniform Camera {
+    mat4 view_projection;
+} camera;
+
+layout(location = 0) in vec3 position;
+layout(location = 1) in vec2 extent;
+layout(location = 2) in vec4 uv;
+layout(location = 3) in vec4 color;
+
+layout(location = 0) out vec2 frag_uv;
+layout(location = 1) out vec4 frag_color;
+
+// two triangles per glyph, no vertex buffer
+const vec2 CORNERS[6] = vec2[](
+    vec2(0.0, 0.0), vec2(1.0, 0.0), vec2(0.0, 1.0),
+    vec2(0.0, 1.0), vec2(1.0, 0.0), vec2(1.0, 1.0)
+);
+
+void main() {
+    vec2 corner = CORNERS[gl_VertexIndex];
+    gl_Position = camera.view_projection * vec4(position + vec3(corner * extent, 0.0), 1.0);
+    frag_uv = mix(uv.xy, uv.zw, corner);
+    frag_color = color;
+}
@@ -1,11 +1,24 @@
 #version 450
 
-layout(location = 0) in vec2 position;
+layout(push_constant) uniform Camera {
+    mat4 view_projection;
+} camera;
+
+layout(location = 0) in vec3 position;
 layout(location = 1) in vec3 color;
 
+layout(location = 2) in vec3 instance_position;
+layout(location = 3) in vec3 instance_scale;
+layout(location = 4) in vec3 instance_color;
+
+layout(location = 5) in vec2 uv;
+
 layout(location = 0) out vec3 frag_color;
+layout(location = 1) out vec2 frag_uv;
 
 void main() {
-    gl_Position = vec4(position, 0.0, 1.0);
-    frag_color = color;
+    vec3 world_position = position * instance_scale + instance_position;
+    gl_Position = camera.view_projection * vec4(world_position, 1.0);
+    frag_color = color * instance_color;
+    frag_uv = uv;
 }
@@ -0,0 +1,128 @@
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+
+#include "startup.hpp"
+
+namespace HB {
+
+using Clock = std::chrono::steady_clock;
+
+StartupGraph::Step StartupGraph::add(char const* name, std::initializer_list<Step> dependencies, std::function<void()> function, bool main_thread)
+{
+    Step step = static_cast<Step>(m_steps.size());
+    for (Step dependency : dependencies) {
+        if (dependency >= step)
+            throw std::runtime_error("startup step depends on one that wasn't added before it!");
+    }
+    m_steps.push_back({ name, dependencies, std::move(function), main_thread });
+    return step;
+}
+
+void StartupGraph::run(ThreadPool* pool)
+{
+    Clock::time_point start = Clock::now();
+    m_timings.assign(m_steps.size(), StartupTiming {});
+    // every step writes only its own timing
+    auto time = [this, start](Step step, bool main_thread) {
+        Clock::time_point step_start = Clock::now();
+        m_steps[step].function();
+        Clock::time_point end = Clock::now();
+        m_timings[step] = {
+            m_steps[step].name,
+            std::chrono::duration<double, std::milli>(step_start - start).count(),
+            std::chrono::duration<double, std::milli>(end - step_start).count(),
+            main_thread,
+        };
+    };
+
+    if (pool == nullptr) {
+        for (Step step = 0; step < m_steps.size(); step += 1)
+            time(step, true);
+        return;
+    }
+
+    std::mutex mutex;
+    std::condition_variable changed;
+    // unfinished dependencies per step, and the other way around
+    std::vector<uint32_t> waiting(m_steps.size(), 0);
+    std::vector<std::vector<Step>> dependents(m_steps.size());
+    for (Step step = 0; step < m_steps.size(); step += 1) {
+        waiting[step] = static_cast<uint32_t>(m_steps[step].dependencies.size());
+        for (Step dependency : m_steps[step].dependencies)
+            dependents[dependency].push_back(step);
+    }
+    std::deque<Step> main_ready;
+    uint32_t running = 0;
+    std::exception_ptr error;
+
+    // all of these with the mutex held
+    std::function<void(Step)> finish;
+    auto start_step = [&](Step step) {
+        if (m_steps[step].main_thread) {
+            main_ready.push_back(step);
+            return;
+        }
+        running += 1;
+        pool->submit([&, step] {
+            std::exception_ptr step_error;
+            try {
+                time(step, false);
+            } catch (...) {
+                step_error = std::current_exception();
+            }
+            std::lock_guard lock(mutex);
+            running -= 1;
+            if (step_error && !error)
+                error = step_error;
+            if (!error)
+                finish(step);
+            // still holding the lock, run() may return as soon as it is released
+            changed.notify_all();
+        });
+    };
+    finish = [&](Step step) {
+        for (Step dependent : dependents[step]) {
+            waiting[dependent] -= 1;
+            if (waiting[dependent] == 0)
+                start_step(dependent);
+        }
+    };
+
+    std::unique_lock lock(mutex);
+    for (Step step = 0; step < m_steps.size(); step += 1) {
+        if (waiting[step] == 0)
+            start_step(step);
+    }
+    while (true) {
+        changed.wait(lock, [&] { return error || !main_ready.empty() || running == 0; });
+        if (error) {
+            // the steps already started can't be stopped
+            changed.wait(lock, [&] { return running == 0; });
+            std::rethrow_exception(error);
+        }
+        // nothing running and nothing to run, dependencies only go backwards so all are done
+        if (main_ready.empty())
+            break;
+
+        Step step = main_ready.front();
+        main_ready.pop_front();
+        lock.unlock();
+        std::exception_ptr step_error;
+        try {
+            time(step, true);
+        } catch (...) {
+            step_error = std::current_exception();
+        }
+        lock.lock();
+        if (step_error && !error)
+            error = step_error;
+        if (!error)
+            finish(step);
+    }
+}
+
+}
@@ -0,0 +1,52 @@
+#ifndef _HB_STARTUP
+#define _HB_STARTUP
+
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <vector>
+
+#include "thread_pool.hpp"
+
+namespace HB {
+
+struct StartupTiming {
+    char const* name;
+    // since run() was called
+    double start_ms;
+    double duration_ms;
+    bool main_thread;
+};
+
+// Initialization split into steps, each with the steps it needs done first. run() starts every
+// step as soon as those are, on the pool's workers, or on the calling thread for the ones that
+// have to be there (GLFW windows), and keeps how long each took.
+//
+// Dependencies can only be on steps added before, so the order they were added in always works
+// too, which is what run() does without a pool.
+class StartupGraph {
+public:
+    using Step = uint32_t;
+
+    Step add(char const* name, std::initializer_list<Step> dependencies, std::function<void()> function, bool main_thread = false);
+    // Returns once every step is done. If one throws no new ones are started, and the first
+    // exception is rethrown after the running ones finished.
+    void run(ThreadPool* pool = nullptr);
+    // in the order the steps were added
+    std::vector<StartupTiming> const& timings() const { return m_timings; }
+
+private:
+    struct Node {
+        char const* name;
+        std::vector<Step> dependencies;
+        std::function<void()> function;
+        bool main_thread;
+    };
+
+    std::vector<Node> m_steps;
+    std::vector<StartupTiming> m_timings;
+};
+
+}
+
+#endif
@@ -0,0 +1,104 @@
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+
+#include "stats.hpp"
+
+namespace HB {
+
+namespace Stats {
+
+    static std::array<std::atomic<uint64_t>, COUNTER_COUNT> s_counters {};
+
+    void count(Counter counter, uint64_t amount)
+    {
+        s_counters[static_cast<uint32_t>(counter)].fetch_add(amount, std::memory_order_relaxed);
+    }
+
+    std::array<uint64_t, COUNTER_COUNT> take()
+    {
+        std::array<uint64_t, COUNTER_COUNT> counters;
+        for (uint32_t i = 0; i < COUNTER_COUNT; i += 1)
+            counters[i] = s_counters[i].exchange(0, std::memory_order_relaxed);
+        return counters;
+    }
+
+    char const* name(Counter counter)
+    {
+        static char const* const NAMES[COUNTER_COUNT] = {
+            "draw_calls",
+            "vertices",
+            "instances",
+            "pipeline_binds",
+            "descriptor_binds",
+            "bytes_uploaded",
+            "command_buffers_submitted",
+            "objects_created",
+            "objects_destroyed",
+            "dispatches",
+            "evictions",
+            "restores",
+            "meshlets",
+        };
+        return NAMES[static_cast<uint32_t>(counter)];
+    }
+
+    char const* name(PipelineStatistic statistic)
+    {
+        static char const* const NAMES[PIPELINE_STATISTIC_COUNT] = {
+            "input_vertices",
+            "input_primitives",
+            "vertex_invocations",
+            "clipping_invocations",
+            "clipping_primitives",
+            "fragment_invocations",
+        };
+        return NAMES[static_cast<uint32_t>(statistic)];
+    }
+
+}
+
+StatsLog::StatsLog(std::string const& path, uint32_t interval)
+    : m_file(path)
+    , m_interval(std::max(interval, 1u))
+{
+    if (!m_file.is_open())
+        throw std::runtime_error("failed to open stats log!");
+
+    m_pending.reserve(m_interval);
+
+    m_file << "frame,gpu_ms,render_scale,latency_ms,record_ms,memory_headroom_mb,post_ms";
+    for (uint32_t i = 0; i < COUNTER_COUNT; i += 1)
+        m_file << ',' << Stats::name(static_cast<Counter>(i));
+    for (uint32_t i = 0; i < PIPELINE_STATISTIC_COUNT; i += 1)
+        m_file << ',' << Stats::name(static_cast<PipelineStatistic>(i));
+    m_file << '\n';
+}
+
+StatsLog::~StatsLog()
+{
+    flush();
+}
+
+void StatsLog::add(FrameStats const& stats)
+{
+    m_pending.push_back(stats);
+    if (m_pending.size() >= m_interval)
+        flush();
+}
+
+void StatsLog::flush()
+{
+    for (FrameStats const& stats : m_pending) {
+        m_file << stats.frame << ',' << stats.gpu_ms << ',' << stats.render_scale << ',' << stats.latency_ms << ',' << stats.record_ms << ',' << stats.memory_headroom_mb << ',' << stats.post_ms;
+        for (uint64_t counter : stats.counters)
+            m_file << ',' << counter;
+        for (uint64_t statistic : stats.pipeline)
+            m_file << ',' << statistic;
+        m_file << '\n';
+    }
+    m_file.flush();
+    m_pending.clear();
+}
+
+}
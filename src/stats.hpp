@@ -0,0 +1,94 @@
+#ifndef _HB_STATS
+#define _HB_STATS
+
+#include <array>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace HB {
+
+enum class Counter : uint32_t {
+    DRAW_CALLS,
+    VERTICES,
+    INSTANCES,
+    PIPELINE_BINDS,
+    DESCRIPTOR_BINDS,
+    BYTES_UPLOADED,
+    COMMAND_BUFFERS_SUBMITTED,
+    OBJECTS_CREATED,
+    OBJECTS_DESTROYED,
+    DISPATCHES,
+    // textures moved out of device memory to make room, and brought back when drawn again
+    EVICTIONS,
+    RESTORES,
+    // tested by GPU culling, what they draw only shows in the pipeline statistics
+    MESHLETS,
+};
+constexpr uint32_t const COUNTER_COUNT = 13;
+
+// in the order Vulkan writes them, see App::create_query_pool()
+enum class PipelineStatistic : uint32_t {
+    INPUT_VERTICES,
+    INPUT_PRIMITIVES,
+    VERTEX_INVOCATIONS,
+    CLIPPING_INVOCATIONS,
+    CLIPPING_PRIMITIVES,
+    FRAGMENT_INVOCATIONS,
+};
+constexpr uint32_t const PIPELINE_STATISTIC_COUNT = 6;
+
+struct FrameStats {
+    uint64_t frame = 0;
+    std::array<uint64_t, COUNTER_COUNT> counters {};
+    // GPU side results arrive late, these belong to the frame MAX_FRAMES_IN_FLIGHT earlier, the
+    // pipeline statistics stay zero on devices without pipelineStatisticsQuery
+    std::array<uint64_t, PIPELINE_STATISTIC_COUNT> pipeline {};
+    float gpu_ms = 0.0f;
+    float render_scale = 1.0f;
+    // from the simulation producing the drawn snapshot to the frame's submit
+    float latency_ms = 0.0f;
+    // CPU time spent sorting the scene's draws into the instance buffer and recording them
+    float record_ms = 0.0f;
+    // left in the fullest device local heap's budget at the start of the frame, negative when over
+    float memory_headroom_mb = 0.0f;
+    // GPU time of the post-processing chain, zero without one or without timestamp support
+    float post_ms = 0.0f;
+
+    uint64_t operator[](Counter counter) const { return counters[static_cast<uint32_t>(counter)]; }
+    uint64_t operator[](PipelineStatistic statistic) const { return pipeline[static_cast<uint32_t>(statistic)]; }
+};
+
+namespace Stats {
+
+// thread safe, call it from anything that draws, binds, uploads or creates/destroys GPU objects
+void count(Counter, uint64_t amount = 1);
+// everything counted since the previous call, the counters start over at zero
+std::array<uint64_t, COUNTER_COUNT> take();
+char const* name(Counter);
+char const* name(PipelineStatistic);
+
+}
+
+// Writes FrameStats as CSV, one row per frame. Rows are buffered and written every `interval`
+// frames, so the per-frame cost is a copy.
+class StatsLog {
+public:
+    StatsLog(std::string const& path, uint32_t interval = 60);
+    ~StatsLog();
+    StatsLog(StatsLog const&) = delete;
+    StatsLog& operator=(StatsLog const&) = delete;
+
+    void add(FrameStats const&);
+    void flush();
+
+private:
+    std::ofstream m_file;
+    std::vector<FrameStats> m_pending;
+    uint32_t m_interval;
+};
+
+}
+
+#endif
@@ -0,0 +1,410 @@
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+
+#include "text.hpp"
+
+namespace HB {
+
+// font8x8_basic by Daniel Hepper (public domain), printable ASCII. One byte per row from the top,
+// the lowest bit is the leftmost pixel.
+static uint8_t const FONT[][8] = {
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // U+0020 space
+    { 0x18, 0x3C, 0x3C, 0x18, 0x18, 0x00, 0x18, 0x00 }, // U+0021 !
+    { 0x36, 0x36, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // U+0022 "
+    { 0x36, 0x36, 0x7F, 0x36, 0x7F, 0x36, 0x36, 0x00 }, // U+0023 #
+    { 0x0C, 0x3E, 0x03, 0x1E, 0x30, 0x1F, 0x0C, 0x00 }, // U+0024 $
+    { 0x00, 0x63, 0x33, 0x18, 0x0C, 0x66, 0x63, 0x00 }, // U+0025 %
+    { 0x1C, 0x36, 0x1C, 0x6E, 0x3B, 0x33, 0x6E, 0x00 }, // U+0026 &
+    { 0x06, 0x06, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00 }, // U+0027 '
+    { 0x18, 0x0C, 0x06, 0x06, 0x06, 0x0C, 0x18, 0x00 }, // U+0028 (
+    { 0x06, 0x0C, 0x18, 0x18, 0x18, 0x0C, 0x06, 0x00 }, // U+0029 )
+    { 0x00, 0x66, 0x3C, 0xFF, 0x3C, 0x66, 0x00, 0x00 }, // U+002A *
+    { 0x00, 0x0C, 0x0C, 0x3F, 0x0C, 0x0C, 0x00, 0x00 }, // U+002B +
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C, 0x06 }, // U+002C ,
+    { 0x00, 0x00, 0x00, 0x3F, 0x00, 0x00, 0x00, 0x00 }, // U+002D -
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C, 0x00 }, // U+002E .
+    { 0x60, 0x30, 0x18, 0x0C, 0x06, 0x03, 0x01, 0x00 }, // U+002F /
+    { 0x3E, 0x63, 0x73, 0x7B, 0x6F, 0x67, 0x3E, 0x00 }, // U+0030 0
+    { 0x0C, 0x0E, 0x0C, 0x0C, 0x0C, 0x0C, 0x3F, 0x00 }, // U+0031 1
+    { 0x1E, 0x33, 0x30, 0x1C, 0x06, 0x33, 0x3F, 0x00 }, // U+0032 2
+    { 0x1E, 0x33, 0x30, 0x1C, 0x30, 0x33, 0x1E, 0x00 }, // U+0033 3
+    { 0x38, 0x3C, 0x36, 0x33, 0x7F, 0x30, 0x78, 0x00 }, // U+0034 4
+    { 0x3F, 0x03, 0x1F, 0x30, 0x30, 0x33, 0x1E, 0x00 }, // U+0035 5
+    { 0x1C, 0x06, 0x03, 0x1F, 0x33, 0x33, 0x1E, 0x00 }, // U+0036 6
+    { 0x3F, 0x33, 0x30, 0x18, 0x0C, 0x0C, 0x0C, 0x00 }, // U+0037 7
+    { 0x1E, 0x33, 0x33, 0x1E, 0x33, 0x33, 0x1E, 0x00 }, // U+0038 8
+    { 0x1E, 0x33, 0x33, 0x3E, 0x30, 0x18, 0x0E, 0x00 }, // U+0039 9
+    { 0x00, 0x0C, 0x0C, 0x00, 0x00, 0x0C, 0x0C, 0x00 }, // U+003A :
+    { 0x00, 0x0C, 0x0C, 0x00, 0x00, 0x0C, 0x0C, 0x06 }, // U+003B ;
+    { 0x18, 0x0C, 0x06, 0x03, 0x06, 0x0C, 0x18, 0x00 }, // U+003C <
+    { 0x00, 0x00, 0x3F, 0x00, 0x00, 0x3F, 0x00, 0x00 }, // U+003D =
+    { 0x06, 0x0C, 0x18, 0x30, 0x18, 0x0C, 0x06, 0x00 }, // U+003E >
+    { 0x1E, 0x33, 0x30, 0x18, 0x0C, 0x00, 0x0C, 0x00 }, // U+003F ?
+    { 0x3E, 0x63, 0x7B, 0x7B, 0x7B, 0x03, 0x1E, 0x00 }, // U+0040 @
+    { 0x0C, 0x1E, 0x33, 0x33, 0x3F, 0x33, 0x33, 0x00 }, // U+0041 A
+    { 0x3F, 0x66, 0x66, 0x3E, 0x66, 0x66, 0x3F, 0x00 }, // U+0042 B
+    { 0x3C, 0x66, 0x03, 0x03, 0x03, 0x66, 0x3C, 0x00 }, // U+0043 C
+    { 0x1F, 0x36, 0x66, 0x66, 0x66, 0x36, 0x1F, 0x00 }, // U+0044 D
+    { 0x7F, 0x46, 0x16, 0x1E, 0x16, 0x46, 0x7F, 0x00 }, // U+0045 E
+    { 0x7F, 0x46, 0x16, 0x1E, 0x16, 0x06, 0x0F, 0x00 }, // U+0046 F
+    { 0x3C, 0x66, 0x03, 0x03, 0x73, 0x66, 0x7C, 0x00 }, // U+0047 G
+    { 0x33, 0x33, 0x33, 0x3F, 0x33, 0x33, 0x33, 0x00 }, // U+0048 H
+    { 0x1E, 0x0C, 0x0C, 0x0C, 0x0C, 0x0C, 0x1E, 0x00 }, // U+0049 I
+    { 0x78, 0x30, 0x30, 0x30, 0x33, 0x33, 0x1E, 0x00 }, // U+004A J
+    { 0x67, 0x66, 0x36, 0x1E, 0x36, 0x66, 0x67, 0x00 }, // U+004B K
+    { 0x0F, 0x06, 0x06, 0x06, 0x46, 0x66, 0x7F, 0x00 }, // U+004C L
+    { 0x63, 0x77, 0x7F, 0x7F, 0x6B, 0x63, 0x63, 0x00 }, // U+004D M
+    { 0x63, 0x67, 0x6F, 0x7B, 0x73, 0x63, 0x63, 0x00 }, // U+004E N
+    { 0x1C, 0x36, 0x63, 0x63, 0x63, 0x36, 0x1C, 0x00 }, // U+004F O
+    { 0x3F, 0x66, 0x66, 0x3E, 0x06, 0x06, 0x0F, 0x00 }, // U+0050 P
+    { 0x1E, 0x33, 0x33, 0x33, 0x3B, 0x1E, 0x38, 0x00 }, // U+0051 Q
+    { 0x3F, 0x66, 0x66, 0x3E, 0x36, 0x66, 0x67, 0x00 }, // U+0052 R
+    { 0x1E, 0x33, 0x07, 0x0E, 0x38, 0x33, 0x1E, 0x00 }, // U+0053 S
+    { 0x3F, 0x2D, 0x0C, 0x0C, 0x0C, 0x0C, 0x1E, 0x00 }, // U+0054 T
+    { 0x33, 0x33, 0x33, 0x33, 0x33, 0x33, 0x3F, 0x00 }, // U+0055 U
+    { 0x33, 0x33, 0x33, 0x33, 0x33, 0x1E, 0x0C, 0x00 }, // U+0056 V
+    { 0x63, 0x63, 0x63, 0x6B, 0x7F, 0x77, 0x63, 0x00 }, // U+0057 W
+    { 0x63, 0x63, 0x36, 0x1C, 0x1C, 0x36, 0x63, 0x00 }, // U+0058 X
+    { 0x33, 0x33, 0x33, 0x1E, 0x0C, 0x0C, 0x1E, 0x00 }, // U+0059 Y
+    { 0x7F, 0x63, 0x31, 0x18, 0x4C, 0x66, 0x7F, 0x00 }, // U+005A Z
+    { 0x1E, 0x06, 0x06, 0x06, 0x06, 0x06, 0x1E, 0x00 }, // U+005B [
+    { 0x03, 0x06, 0x0C, 0x18, 0x30, 0x60, 0x40, 0x00 }, // U+005C backslash
+    { 0x1E, 0x18, 0x18, 0x18, 0x18, 0x18, 0x1E, 0x00 }, // U+005D ]
+    { 0x08, 0x1C, 0x36, 0x63, 0x00, 0x00, 0x00, 0x00 }, // U+005E ^
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF }, // U+005F _
+    { 0x0C, 0x0C, 0x18, 0x00, 0x00, 0x00, 0x00, 0x00 }, // U+0060 `
+    { 0x00, 0x00, 0x1E, 0x30, 0x3E, 0x33, 0x6E, 0x00 }, // U+0061 a
+    { 0x07, 0x06, 0x06, 0x3E, 0x66, 0x66, 0x3B, 0x00 }, // U+0062 b
+    { 0x00, 0x00, 0x1E, 0x33, 0x03, 0x33, 0x1E, 0x00 }, // U+0063 c
+    { 0x38, 0x30, 0x30, 0x3E, 0x33, 0x33, 0x6E, 0x00 }, // U+0064 d
+    { 0x00, 0x00, 0x1E, 0x33, 0x3F, 0x03, 0x1E, 0x00 }, // U+0065 e
+    { 0x1C, 0x36, 0x06, 0x0F, 0x06, 0x06, 0x0F, 0x00 }, // U+0066 f
+    { 0x00, 0x00, 0x6E, 0x33, 0x33, 0x3E, 0x30, 0x1F }, // U+0067 g
+    { 0x07, 0x06, 0x36, 0x6E, 0x66, 0x66, 0x67, 0x00 }, // U+0068 h
+    { 0x0C, 0x00, 0x0E, 0x0C, 0x0C, 0x0C, 0x1E, 0x00 }, // U+0069 i
+    { 0x30, 0x00, 0x30, 0x30, 0x30, 0x33, 0x33, 0x1E }, // U+006A j
+    { 0x07, 0x06, 0x66, 0x36, 0x1E, 0x36, 0x67, 0x00 }, // U+006B k
+    { 0x0E, 0x0C, 0x0C, 0x0C, 0x0C, 0x0C, 0x1E, 0x00 }, // U+006C l
+    { 0x00, 0x00, 0x33, 0x7F, 0x7F, 0x6B, 0x63, 0x00 }, // U+006D m
+    { 0x00, 0x00, 0x1F, 0x33, 0x33, 0x33, 0x33, 0x00 }, // U+006E n
+    { 0x00, 0x00, 0x1E, 0x33, 0x33, 0x33, 0x1E, 0x00 }, // U+006F o
+    { 0x00, 0x00, 0x3B, 0x66, 0x66, 0x3E, 0x06, 0x0F }, // U+0070 p
+    { 0x00, 0x00, 0x6E, 0x33, 0x33, 0x3E, 0x30, 0x78 }, // U+0071 q
+    { 0x00, 0x00, 0x3B, 0x6E, 0x66, 0x06, 0x0F, 0x00 }, // U+0072 r
+    { 0x00, 0x00, 0x3E, 0x03, 0x1E, 0x30, 0x1F, 0x00 }, // U+0073 s
+    { 0x08, 0x0C, 0x3E, 0x0C, 0x0C, 0x2C, 0x18, 0x00 }, // U+0074 t
+    { 0x00, 0x00, 0x33, 0x33, 0x33, 0x33, 0x6E, 0x00 }, // U+0075 u
+    { 0x00, 0x00, 0x33, 0x33, 0x33, 0x1E, 0x0C, 0x00 }, // U+0076 v
+    { 0x00, 0x00, 0x63, 0x6B, 0x7F, 0x7F, 0x36, 0x00 }, // U+0077 w
+    { 0x00, 0x00, 0x63, 0x36, 0x1C, 0x36, 0x63, 0x00 }, // U+0078 x
+    { 0x00, 0x00, 0x33, 0x33, 0x33, 0x3E, 0x30, 0x1F }, // U+0079 y
+    { 0x00, 0x00, 0x3F, 0x19, 0x0C, 0x26, 0x3F, 0x00 }, // U+007A z
+    { 0x38, 0x0C, 0x0C, 0x07, 0x0C, 0x0C, 0x38, 0x00 }, // U+007B {
+    { 0x18, 0x18, 0x18, 0x00, 0x18, 0x18, 0x18, 0x00 }, // U+007C |
+    { 0x07, 0x0C, 0x0C, 0x38, 0x0C, 0x0C, 0x07, 0x00 }, // U+007D }
+    { 0x6E, 0x3B, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // U+007E ~
+};
+
+constexpr uint32_t const CACHE_MAGIC = 0x46445348; // "HSDF"
+// bump whenever the font, the cell layout or the distance encoding changes
+constexpr uint32_t const CACHE_VERSION = 1;
+
+struct CacheHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t page_size;
+    uint32_t cell;
+    uint32_t glyph_count;
+    uint32_t page_count;
+};
+
+static uint32_t pack_color(glm::vec4 color)
+{
+    auto byte = [](float value) { return static_cast<uint32_t>(std::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f); };
+    return byte(color.x) | byte(color.y) << 8 | byte(color.z) << 16 | byte(color.w) << 24;
+}
+
+void TextBatch::add(std::string_view text, glm::vec3 position, float size, glm::vec4 color)
+{
+    labels.push_back({ position, size, pack_color(color), static_cast<uint32_t>(characters.size()), static_cast<uint32_t>(text.size()) });
+    characters.insert(characters.end(), text.begin(), text.end());
+}
+
+void TextBatch::clear()
+{
+    characters.clear();
+    labels.clear();
+}
+
+GlyphAtlas::GlyphAtlas(std::string const& cache_path, ThreadPool* pool)
+{
+    if (!cache_path.empty() && load(cache_path)) {
+        m_loaded_from_cache = true;
+        return;
+    }
+
+    generate(pool);
+    if (!cache_path.empty())
+        save(cache_path);
+}
+
+Glyph const& GlyphAtlas::glyph(char c) const
+{
+    if (c < FIRST_CHARACTER || c > LAST_CHARACTER)
+        c = '?';
+    return m_glyphs[c - FIRST_CHARACTER];
+}
+
+void GlyphAtlas::generate(ThreadPool* pool)
+{
+    uint32_t const count = LAST_CHARACTER - FIRST_CHARACTER + 1;
+    uint32_t const per_row = PAGE_SIZE / CELL;
+    uint32_t const per_page = per_row * per_row;
+    uint32_t const page_count = (count + per_page - 1) / per_page;
+    static_assert((LAST_CHARACTER - FIRST_CHARACTER + 1) <= MAX_PAGES * (PAGE_SIZE / CELL) * (PAGE_SIZE / CELL), "the font doesn't fit the atlas");
+
+    m_glyphs.resize(count);
+    m_pages.assign(page_count, std::vector<uint8_t>(PAGE_SIZE * PAGE_SIZE, 0));
+
+    auto build = [this, per_row, per_page](size_t begin, size_t end) {
+        int const spread = PADDING * SCALE;
+        for (size_t i = begin; i < end; i += 1) {
+            uint8_t const* rows = FONT[i];
+            // in texels of the glyph, the font pixels blown up SCALE times
+            auto ink = [rows](int x, int y) {
+                if (x < 0 || y < 0 || x >= int(8 * SCALE) || y >= int(8 * SCALE))
+                    return false;
+                return ((rows[y / SCALE] >> (x / SCALE)) & 1) != 0;
+            };
+
+            int left = 8, right = -1;
+            for (int y = 0; y < 8; y += 1) {
+                for (int x = 0; x < 8; x += 1) {
+                    if ((rows[y] >> x) & 1) {
+                        left = std::min(left, x);
+                        right = std::max(right, x);
+                    }
+                }
+            }
+
+            Glyph& glyph = m_glyphs[i];
+            uint32_t slot = static_cast<uint32_t>(i) % per_page;
+            uint32_t cell_x = slot % per_row * CELL;
+            uint32_t cell_y = slot / per_row * CELL;
+            glyph.page = static_cast<uint32_t>(i) / per_page;
+            glyph.uv = glm::vec4(cell_x, cell_y, cell_x + CELL, cell_y + CELL) / float(PAGE_SIZE);
+            // proportional: the pen advances over the ink plus a pixel of spacing
+            if (right < left) {
+                glyph.bearing = 0.0f;
+                glyph.advance = 0.5f;
+            } else {
+                glyph.bearing = left / 8.0f;
+                glyph.advance = (right - left + 2) / 8.0f;
+            }
+
+            // brute force within the spread, distances are measured between texel centers and
+            // the outline lies half a texel past the last one of a kind
+            std::vector<uint8_t>& page = m_pages[glyph.page];
+            for (int y = 0; y < int(CELL); y += 1) {
+                for (int x = 0; x < int(CELL); x += 1) {
+                    int gx = x - spread;
+                    int gy = y - spread;
+                    bool inside = ink(gx, gy);
+                    int nearest = spread * spread * 2;
+                    for (int dy = -spread; dy <= spread; dy += 1) {
+                        for (int dx = -spread; dx <= spread; dx += 1) {
+                            if (ink(gx + dx, gy + dy) != inside)
+                                nearest = std::min(nearest, dx * dx + dy * dy);
+                        }
+                    }
+                    float distance = std::min(std::sqrt(float(nearest)) - 0.5f, float(spread));
+                    float value = 0.5f + (inside ? distance : -distance) / float(2 * spread);
+                    page[(cell_y + y) * PAGE_SIZE + cell_x + x] = static_cast<uint8_t>(std::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f);
+                }
+            }
+        }
+    };
+
+    if (pool)
+        pool->parallel_for(count, 4, build);
+    else
+        build(0, count);
+}
+
+bool GlyphAtlas::load(std::string const& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open())
+        return false;
+
+    CacheHeader header {};
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    // clang-format off
+    if (!file
+        || header.magic != CACHE_MAGIC
+        || header.version != CACHE_VERSION
+        || header.page_size != PAGE_SIZE
+        || header.cell != CELL
+        || header.glyph_count != uint32_t(LAST_CHARACTER - FIRST_CHARACTER + 1)
+        || header.page_count == 0
+        || header.page_count > MAX_PAGES)
+        return false;
+    // clang-format on
+
+    m_glyphs.resize(header.glyph_count);
+    file.read(reinterpret_cast<char*>(m_glyphs.data()), sizeof(Glyph) * m_glyphs.size());
+    m_pages.assign(header.page_count, std::vector<uint8_t>(PAGE_SIZE * PAGE_SIZE));
+    for (auto& page : m_pages)
+        file.read(reinterpret_cast<char*>(page.data()), page.size());
+
+    // a glyph on a page that isn't there would be read out of bounds when laying out text
+    bool pages_valid = std::all_of(m_glyphs.begin(), m_glyphs.end(), [&header](Glyph const& glyph) { return glyph.page < header.page_count; });
+    if (!file || !pages_valid) {
+        m_glyphs.clear();
+        m_pages.clear();
+        return false;
+    }
+    return true;
+}
+
+void GlyphAtlas::save(std::string const& path) const
+{
+    // the cache is only an optimization, failing to write it is fine; going through a temporary
+    // file means a crash halfway never leaves a broken one behind
+    std::error_code error;
+    std::filesystem::path target(path);
+    if (target.has_parent_path())
+        std::filesystem::create_directories(target.parent_path(), error);
+
+    std::string temporary = path + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::binary);
+        if (!file.is_open())
+            return;
+
+        CacheHeader header { CACHE_MAGIC, CACHE_VERSION, PAGE_SIZE, CELL, static_cast<uint32_t>(m_glyphs.size()), page_count() };
+        file.write(reinterpret_cast<char const*>(&header), sizeof(header));
+        file.write(reinterpret_cast<char const*>(m_glyphs.data()), sizeof(Glyph) * m_glyphs.size());
+        for (auto const& page : m_pages)
+            file.write(reinterpret_cast<char const*>(page.data()), page.size());
+        if (!file)
+            return;
+    }
+    std::filesystem::rename(temporary, target, error);
+}
+
+TextBuilder::TextBuilder(GlyphAtlas const& atlas, size_t max_cached_glyphs)
+    : m_atlas(atlas)
+    , m_max_cached_glyphs(max_cached_glyphs)
+{
+}
+
+uint32_t TextBuilder::layout(std::string_view text)
+{
+    m_lookups += 1;
+    auto found = m_cache.find(text);
+    if (found != m_cache.end()) {
+        m_hits += 1;
+        return found->second;
+    }
+
+    Layout layout {};
+    layout.first = static_cast<uint32_t>(m_glyphs.size());
+    glm::vec2 pen(0.0f);
+    for (char c : text) {
+        if (c == '\n') {
+            pen = glm::vec2(0.0f, pen.y + 1.0f);
+            continue;
+        }
+
+        Glyph const& glyph = m_atlas.glyph(c);
+        if (c != ' ') {
+            m_glyphs.push_back({ pen + glm::vec2(-glyph.bearing, 0.0f) + m_atlas.quad_offset(), glyph.uv, glyph.page });
+            layout.page_counts[glyph.page] += 1;
+        }
+        pen.x += glyph.advance;
+    }
+    layout.count = static_cast<uint32_t>(m_glyphs.size()) - layout.first;
+    std::stable_sort(m_glyphs.begin() + layout.first, m_glyphs.end(), [](PlacedGlyph const& a, PlacedGlyph const& b) {
+        return a.page < b.page;
+    });
+
+    uint32_t index = static_cast<uint32_t>(m_layouts.size());
+    m_layouts.push_back(layout);
+    m_cache.emplace(std::string(text), index);
+    return index;
+}
+
+uint32_t TextBuilder::prepare(TextBatch const& batch)
+{
+    // only ever between batches, the layouts of the last one stay valid for write()
+    if (m_glyphs.size() > m_max_cached_glyphs) {
+        m_cache.clear();
+        m_layouts.clear();
+        m_glyphs.clear();
+        m_evictions += 1;
+    }
+
+    size_t label_count = batch.labels.size();
+    m_label_layouts.resize(label_count);
+    m_label_offsets.resize(label_count);
+    std::array<uint32_t, GlyphAtlas::MAX_PAGES> totals {};
+    for (size_t i = 0; i < label_count; i += 1) {
+        uint32_t index = layout(batch.text(batch.labels[i]));
+        m_label_layouts[i] = index;
+        for (uint32_t page = 0; page < GlyphAtlas::MAX_PAGES; page += 1) {
+            m_label_offsets[i][page] = totals[page];
+            totals[page] += m_layouts[index].page_counts[page];
+        }
+    }
+
+    uint32_t first = 0;
+    for (uint32_t page = 0; page < GlyphAtlas::MAX_PAGES; page += 1) {
+        m_pages[page] = { first, totals[page] };
+        first += totals[page];
+    }
+    return first;
+}
+
+void TextBuilder::write(TextBatch const& batch, GlyphInstance* out, ThreadPool* pool) const
+{
+    auto write_labels = [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i += 1) {
+            TextLabel const& label = batch.labels[i];
+            Layout const& layout = m_layouts[m_label_layouts[i]];
+            glm::vec2 extent = m_atlas.quad_extent() * label.size;
+            uint32_t page = UINT32_MAX;
+            uint32_t next = 0;
+            for (uint32_t j = 0; j < layout.count; j += 1) {
+                PlacedGlyph const& glyph = m_glyphs[layout.first + j];
+                if (glyph.page != page) {
+                    page = glyph.page;
+                    next = m_pages[page].first + m_label_offsets[i][page];
+                }
+                out[next] = { label.position + glm::vec3(glyph.offset * label.size, 0.0f), extent, glyph.uv, label.color };
+                next += 1;
+            }
+        }
+    };
+
+    if (pool)
+        pool->parallel_for(batch.labels.size(), 256, write_labels);
+    else
+        write_labels(0, batch.labels.size());
+}
+
+TextLayoutStats TextBuilder::stats() const
+{
+    TextLayoutStats stats {};
+    stats.lookups = m_lookups;
+    stats.hits = m_hits;
+    stats.layouts = m_lookups - m_hits;
+    stats.evictions = m_evictions;
+    stats.cached_strings = m_cache.size();
+    return stats;
+}
+
+}
@@ -0,0 +1,164 @@
+#ifndef _HB_TEXT
+#define _HB_TEXT
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "thread_pool.hpp"
+
+namespace HB {
+
+struct TextLabel {
+    // top left of the first line, in the same space as the scene
+    glm::vec3 position;
+    // line height
+    float size;
+    // RGBA8, red in the lowest byte
+    uint32_t color;
+    uint32_t first;
+    uint32_t length;
+};
+
+// The text of one frame, the strings packed back to back so refilling it every frame doesn't
+// allocate once it has grown.
+struct TextBatch {
+    std::vector<char> characters;
+    std::vector<TextLabel> labels;
+
+    void add(std::string_view, glm::vec3 position, float size, glm::vec4 color);
+    void clear();
+    std::string_view text(TextLabel const& label) const { return { characters.data() + label.first, label.length }; }
+};
+
+struct Glyph {
+    // min u, min v, max u, max v of the glyph's cell
+    glm::vec4 uv;
+    // where the ink starts and how far the pen moves, in lines
+    float bearing;
+    float advance;
+    uint32_t page;
+};
+
+// Signed distance fields of the built-in 8x8 font (printable ASCII), generated once and cached to
+// disk. Texels are 0.5 on the outline and go up inside, so one atlas gives crisp edges at any
+// scale. Pages are PAGE_SIZE squared, one byte per texel.
+class GlyphAtlas {
+public:
+    static uint32_t const PAGE_SIZE = 512;
+    static uint32_t const MAX_PAGES = 4;
+    static char const FIRST_CHARACTER = ' ';
+    static char const LAST_CHARACTER = '~';
+    // texels per font pixel, and the distance field's reach around the ink in font pixels
+    static uint32_t const SCALE = 4;
+    static uint32_t const PADDING = 2;
+    static uint32_t const CELL = (8 + 2 * PADDING) * SCALE;
+
+    // loads `cache_path` if it holds an atlas of this version, generates and writes it otherwise;
+    // an empty path skips the cache
+    explicit GlyphAtlas(std::string const& cache_path, ThreadPool* pool = nullptr);
+
+    // unknown characters get '?'
+    Glyph const& glyph(char c) const;
+    uint32_t page_count() const { return static_cast<uint32_t>(m_pages.size()); }
+    std::vector<uint8_t> const& page(uint32_t index) const { return m_pages[index]; }
+    bool loaded_from_cache() const { return m_loaded_from_cache; }
+    // of the quad drawn for a glyph, relative to the pen position, in lines
+    glm::vec2 quad_offset() const { return glm::vec2(-float(PADDING) / 8.0f); }
+    glm::vec2 quad_extent() const { return glm::vec2(float(CELL) / float(8 * SCALE)); }
+
+private:
+    std::vector<Glyph> m_glyphs;
+    std::vector<std::vector<uint8_t>> m_pages;
+    bool m_loaded_from_cache = false;
+
+    void generate(ThreadPool*);
+    bool load(std::string const& path);
+    void save(std::string const& path) const;
+};
+
+// a glyph quad as the text shaders read it, one instance per glyph
+struct GlyphInstance {
+    glm::vec3 position;
+    glm::vec2 extent;
+    glm::vec4 uv;
+    uint32_t color;
+};
+
+struct TextLayoutStats {
+    uint64_t lookups = 0;
+    uint64_t hits = 0;
+    uint64_t layouts = 0;
+    uint64_t evictions = 0;
+    size_t cached_strings = 0;
+
+    double hit_rate() const { return lookups > 0 ? double(hits) / double(lookups) : 0.0; }
+};
+
+// Turns TextBatches into glyph quads. Layouts are cached by string, in units of the line height,
+// so a label that shows up again only costs a hash lookup no matter where or how large it is
+// drawn. The cache starts over once it holds more than `max_cached_glyphs`.
+//
+// prepare() runs the layouts and returns the glyph count, write() then fills the quads in
+// parallel, grouped by atlas page so each page is a single draw.
+class TextBuilder {
+public:
+    struct PageRange {
+        uint32_t first = 0;
+        uint32_t count = 0;
+    };
+
+    explicit TextBuilder(GlyphAtlas const&, size_t max_cached_glyphs = 1 << 20);
+
+    uint32_t prepare(TextBatch const&);
+    void write(TextBatch const&, GlyphInstance* out, ThreadPool* pool = nullptr) const;
+    // of the last prepare()
+    std::array<PageRange, GlyphAtlas::MAX_PAGES> const& pages() const { return m_pages; }
+    TextLayoutStats stats() const;
+
+private:
+    struct PlacedGlyph {
+        glm::vec2 offset;
+        glm::vec4 uv;
+        uint32_t page;
+    };
+
+    struct Layout {
+        uint32_t first;
+        uint32_t count;
+        // the glyphs are sorted by page
+        std::array<uint32_t, GlyphAtlas::MAX_PAGES> page_counts;
+    };
+
+    struct StringHash {
+        using is_transparent = void;
+        size_t operator()(std::string_view text) const { return std::hash<std::string_view> {}(text); }
+    };
+
+    GlyphAtlas const& m_atlas;
+    size_t m_max_cached_glyphs;
+    std::unordered_map<std::string, uint32_t, StringHash, std::equal_to<>> m_cache;
+    std::vector<Layout> m_layouts;
+    std::vector<PlacedGlyph> m_glyphs;
+
+    // per label of the last prepare(): its layout and where its glyphs go within every page
+    std::vector<uint32_t> m_label_layouts;
+    std::vector<std::array<uint32_t, GlyphAtlas::MAX_PAGES>> m_label_offsets;
+    std::array<PageRange, GlyphAtlas::MAX_PAGES> m_pages {};
+
+    uint64_t m_lookups = 0;
+    uint64_t m_hits = 0;
+    uint64_t m_evictions = 0;
+
+    uint32_t layout(std::string_view);
+};
+
+}
+
+#endif
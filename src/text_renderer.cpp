@@ -0,0 +1,120 @@
+#include <algorithm>
+#include <cstddef>
+#include <stdexcept>
+
+#include "stats.hpp"
+#include "text_renderer.hpp"
+
+namespace HB {
+
+TextRenderer::TextRenderer(GpuContext const& gpu, TextureManager& textures, ThreadPool& thread_pool, VkPipelineLayout layout, VkRenderPass render_pass,
+    uint32_t frames_in_flight, std::string const& atlas_cache_path)
+    : m_gpu(gpu)
+    , m_thread_pool(thread_pool)
+    , m_atlas(atlas_cache_path, &thread_pool)
+    , m_builder(m_atlas)
+    , m_layout(layout)
+    , m_frames(frames_in_flight)
+{
+    // distances aren't colors, so the pages go up as linear RGBA8 with the distance in red
+    std::vector<uint8_t> texels(GlyphAtlas::PAGE_SIZE * GlyphAtlas::PAGE_SIZE * 4);
+    for (uint32_t page = 0; page < m_atlas.page_count(); page += 1) {
+        std::vector<uint8_t> const& distances = m_atlas.page(page);
+        for (size_t i = 0; i < distances.size(); i += 1) {
+            texels[i * 4 + 0] = distances[i];
+            texels[i * 4 + 1] = distances[i];
+            texels[i * 4 + 2] = distances[i];
+            texels[i * 4 + 3] = 255;
+        }
+        uint32_t texture = textures.create_rgba8(GlyphAtlas::PAGE_SIZE, GlyphAtlas::PAGE_SIZE, texels.data(), false);
+        // the pages are bound straight from here, never through TextureManager::use()
+        textures.pin(texture);
+        m_page_sets.push_back(textures.get(texture).descriptor_set);
+    }
+
+    VkVertexInputBindingDescription binding {};
+    binding.binding = 0;
+    binding.stride = sizeof(GlyphInstance);
+    binding.inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+
+    std::vector<VkVertexInputAttributeDescription> attributes(4);
+    attributes[0] = { 0, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(GlyphInstance, position) };
+    attributes[1] = { 1, 0, VK_FORMAT_R32G32_SFLOAT, offsetof(GlyphInstance, extent) };
+    attributes[2] = { 2, 0, VK_FORMAT_R32G32B32A32_SFLOAT, offsetof(GlyphInstance, uv) };
+    attributes[3] = { 3, 0, VK_FORMAT_R8G8B8A8_UNORM, offsetof(GlyphInstance, color) };
+
+    m_pipelines = std::make_unique<PipelineCache>(m_gpu, layout, render_pass, std::vector { binding }, std::move(attributes));
+
+    PipelineDesc desc {};
+    desc.vertex_shader = "text_vert";
+    desc.fragment_shader = "text_frag";
+    desc.cull_mode = VK_CULL_MODE_NONE;
+    desc.blend = BlendMode::ALPHA;
+    m_pipeline = m_pipelines->get(desc);
+}
+
+TextRenderer::~TextRenderer()
+{
+    for (FrameBuffer& frame : m_frames)
+        destroy_buffer(frame);
+}
+
+void TextRenderer::create_buffer(FrameBuffer& frame, size_t capacity)
+{
+    VkDeviceSize buffer_size = sizeof(GlyphInstance) * capacity;
+    Gpu::create_buffer(m_gpu, buffer_size, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, frame.buffer, frame.memory, MemoryClass::FRAME);
+    vkMapMemory(m_gpu.device, frame.memory, 0, buffer_size, 0, &frame.mapped);
+    frame.capacity = capacity;
+}
+
+void TextRenderer::destroy_buffer(FrameBuffer& frame)
+{
+    if (frame.buffer == VK_NULL_HANDLE)
+        return;
+
+    vkUnmapMemory(m_gpu.device, frame.memory);
+    Gpu::destroy_buffer(m_gpu, frame.buffer, frame.memory);
+    frame = {};
+}
+
+void TextRenderer::prepare(uint32_t frame_index, TextBatch const& batch)
+{
+    FrameBuffer& frame = m_frames[frame_index];
+    uint32_t count = m_builder.prepare(batch);
+    if (count > frame.capacity) {
+        destroy_buffer(frame);
+        create_buffer(frame, std::max<size_t>(count, frame.capacity * 2));
+    }
+
+    m_builder.write(batch, static_cast<GlyphInstance*>(frame.mapped), &m_thread_pool);
+    frame.pages = m_builder.pages();
+    Stats::count(Counter::BYTES_UPLOADED, count * sizeof(GlyphInstance));
+}
+
+void TextRenderer::record(VkCommandBuffer command_buffer, uint32_t frame_index) const
+{
+    FrameBuffer const& frame = m_frames[frame_index];
+    bool bound = false;
+    for (uint32_t page = 0; page < m_atlas.page_count(); page += 1) {
+        TextBuilder::PageRange range = frame.pages[page];
+        if (range.count == 0)
+            continue;
+
+        if (!bound) {
+            vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipeline);
+            Stats::count(Counter::PIPELINE_BINDS);
+            VkDeviceSize offset = 0;
+            vkCmdBindVertexBuffers(command_buffer, 0, 1, &frame.buffer, &offset);
+            bound = true;
+        }
+
+        vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_layout, 0, 1, &m_page_sets[page], 0, nullptr);
+        Stats::count(Counter::DESCRIPTOR_BINDS);
+        vkCmdDraw(command_buffer, 6, range.count, 0, range.first);
+        Stats::count(Counter::DRAW_CALLS);
+        Stats::count(Counter::VERTICES, 6 * range.count);
+        Stats::count(Counter::INSTANCES, range.count);
+    }
+}
+
+}
@@ -0,0 +1,63 @@
+#ifndef _HB_TEXT_RENDERER
+#define _HB_TEXT_RENDERER
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gpu.hpp"
+#include "pipeline.hpp"
+#include "text.hpp"
+#include "texture.hpp"
+#include "thread_pool.hpp"
+
+namespace HB {
+
+// Draws TextBatches as SDF glyph quads, one instanced draw per atlas page. Every page is a
+// texture in the TextureManager, the glyphs of a frame go to a persistently mapped buffer per
+// frame in flight that grows on demand. Shares the scene's pipeline layout, so the camera push
+// constant of the pass applies to text too.
+class TextRenderer {
+public:
+    TextRenderer(GpuContext const&, TextureManager&, ThreadPool&, VkPipelineLayout, VkRenderPass,
+        uint32_t frames_in_flight, std::string const& atlas_cache_path);
+    ~TextRenderer();
+    TextRenderer(TextRenderer const&) = delete;
+    TextRenderer& operator=(TextRenderer const&) = delete;
+
+    // lays out and uploads the batch, once the frame's fence has been waited on
+    void prepare(uint32_t frame, TextBatch const&);
+    // inside the pass, after the camera has been pushed
+    void record(VkCommandBuffer, uint32_t frame) const;
+
+    GlyphAtlas const& atlas() const { return m_atlas; }
+    TextLayoutStats stats() const { return m_builder.stats(); }
+
+private:
+    struct FrameBuffer {
+        VkBuffer buffer = VK_NULL_HANDLE;
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        void* mapped = nullptr;
+        size_t capacity = 0;
+        std::array<TextBuilder::PageRange, GlyphAtlas::MAX_PAGES> pages {};
+    };
+
+    GpuContext m_gpu;
+    ThreadPool& m_thread_pool;
+    GlyphAtlas m_atlas;
+    TextBuilder m_builder;
+    std::vector<VkDescriptorSet> m_page_sets;
+    std::unique_ptr<PipelineCache> m_pipelines;
+    VkPipeline m_pipeline;
+    VkPipelineLayout m_layout;
+    std::vector<FrameBuffer> m_frames;
+
+    void create_buffer(FrameBuffer&, size_t capacity);
+    void destroy_buffer(FrameBuffer&);
+};
+
+}
+
+#endif
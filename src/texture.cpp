@@ -0,0 +1,594 @@
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+#include "capture.hpp"
+#include "deletion_queue.hpp"
+#include "stats.hpp"
+#include "texture.hpp"
+
+namespace HB {
+
+TextureManager::TextureManager(GpuContext const& gpu)
+    : m_gpu(gpu)
+{
+    create_sampler();
+    create_descriptors();
+    m_readbacks.reserve(MAX_TEXTURES);
+    m_uploads.reserve(MAX_TEXTURES);
+    m_reading.reserve(MAX_TEXTURES);
+    m_candidates.reserve(MAX_TEXTURES);
+
+    uint32_t const white = 0xFFFFFFFF;
+    pin(create_rgba8(1, 1, &white, false));
+}
+
+TextureManager::~TextureManager()
+{
+    for (auto const* transfers : { &m_readbacks, &m_uploads, &m_reading }) {
+        for (Transfer const& transfer : *transfers)
+            Gpu::destroy_buffer(m_gpu, transfer.buffer, transfer.memory);
+    }
+    for (Texture const& texture : m_textures) {
+        if (!texture.resident)
+            continue;
+        Gpu::destroy_image_view(m_gpu, texture.view);
+        Gpu::destroy_image(m_gpu, texture.image, texture.memory);
+    }
+    vkDestroyDescriptorPool(m_gpu.device, m_descriptor_pool, nullptr);
+    vkDestroyDescriptorSetLayout(m_gpu.device, m_descriptor_set_layout, nullptr);
+    vkDestroySampler(m_gpu.device, m_sampler, nullptr);
+}
+
+void TextureManager::create_sampler()
+{
+    VkSamplerCreateInfo sampler_info {};
+    sampler_info.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    sampler_info.magFilter = VK_FILTER_LINEAR;
+    sampler_info.minFilter = VK_FILTER_LINEAR;
+    sampler_info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+    sampler_info.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    sampler_info.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    sampler_info.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    sampler_info.mipLodBias = 0.0f;
+    if (m_gpu.enabled_features.samplerAnisotropy) {
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(m_gpu.physical_device, &properties);
+        sampler_info.anisotropyEnable = VK_TRUE;
+        sampler_info.maxAnisotropy = properties.limits.maxSamplerAnisotropy;
+    } else {
+        sampler_info.anisotropyEnable = VK_FALSE;
+        sampler_info.maxAnisotropy = 1.0f;
+    }
+    sampler_info.compareEnable = VK_FALSE;
+    sampler_info.minLod = 0.0f;
+    sampler_info.maxLod = VK_LOD_CLAMP_NONE;
+    sampler_info.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
+    sampler_info.unnormalizedCoordinates = VK_FALSE;
+
+    if (vkCreateSampler(m_gpu.device, &sampler_info, nullptr, &m_sampler) != VK_SUCCESS)
+        throw std::runtime_error("failed to create texture sampler!");
+}
+
+void TextureManager::create_descriptors()
+{
+    VkDescriptorSetLayoutBinding binding {};
+    binding.binding = 0;
+    binding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    binding.descriptorCount = 1;
+    binding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+    binding.pImmutableSamplers = &m_sampler;
+
+    VkDescriptorSetLayoutCreateInfo layout_info {};
+    layout_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layout_info.bindingCount = 1;
+    layout_info.pBindings = &binding;
+
+    if (vkCreateDescriptorSetLayout(m_gpu.device, &layout_info, nullptr, &m_descriptor_set_layout) != VK_SUCCESS)
+        throw std::runtime_error("failed to create texture descriptor set layout!");
+
+    VkDescriptorPoolSize pool_size {};
+    pool_size.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    pool_size.descriptorCount = MAX_TEXTURES;
+
+    VkDescriptorPoolCreateInfo pool_info {};
+    pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    pool_info.maxSets = MAX_TEXTURES;
+    pool_info.poolSizeCount = 1;
+    pool_info.pPoolSizes = &pool_size;
+
+    if (vkCreateDescriptorPool(m_gpu.device, &pool_info, nullptr, &m_descriptor_pool) != VK_SUCCESS)
+        throw std::runtime_error("failed to create texture descriptor pool!");
+}
+
+VkDescriptorSet TextureManager::allocate_descriptor_set(VkImageView view)
+{
+    VkDescriptorSetAllocateInfo alloc_info {};
+    alloc_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    alloc_info.descriptorPool = m_descriptor_pool;
+    alloc_info.descriptorSetCount = 1;
+    alloc_info.pSetLayouts = &m_descriptor_set_layout;
+
+    VkDescriptorSet descriptor_set;
+    if (vkAllocateDescriptorSets(m_gpu.device, &alloc_info, &descriptor_set) != VK_SUCCESS)
+        throw std::runtime_error("failed to allocate texture descriptor set!");
+
+    write_descriptor_set(descriptor_set, view);
+    return descriptor_set;
+}
+
+void TextureManager::write_descriptor_set(VkDescriptorSet descriptor_set, VkImageView view)
+{
+    VkDescriptorImageInfo image_info {};
+    image_info.sampler = m_sampler;
+    image_info.imageView = view;
+    image_info.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+    VkWriteDescriptorSet write {};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet = descriptor_set;
+    write.dstBinding = 0;
+    write.dstArrayElement = 0;
+    write.descriptorCount = 1;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    write.pImageInfo = &image_info;
+
+    vkUpdateDescriptorSets(m_gpu.device, 1, &write, 0, nullptr);
+}
+
+bool TextureManager::supports(VkFormat format) const
+{
+    if (!is_supported_image_format(format))
+        return false;
+    if (is_block_compressed(format) && !m_gpu.enabled_features.textureCompressionBC)
+        return false;
+
+    VkFormatProperties properties;
+    vkGetPhysicalDeviceFormatProperties(m_gpu.physical_device, format, &properties);
+    return properties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT;
+}
+
+bool TextureManager::can_generate_mips(VkFormat format) const
+{
+    if (is_block_compressed(format))
+        return false;
+
+    VkFormatProperties properties;
+    vkGetPhysicalDeviceFormatProperties(m_gpu.physical_device, format, &properties);
+    VkFormatFeatureFlags required = VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+    return (properties.optimalTilingFeatures & required) == required;
+}
+
+uint32_t TextureManager::load(std::string const& path)
+{
+    return create(ImageFile::load(path));
+}
+
+uint32_t TextureManager::create(ImageFile const& image)
+{
+    return upload(image.format, image.width, image.height, image.levels, image.data.data());
+}
+
+uint32_t TextureManager::create_rgba8(uint32_t width, uint32_t height, void const* pixels, bool srgb)
+{
+    std::vector<ImageFile::Level> levels = { { 0, size_t(width) * height * 4, width, height } };
+    return upload(srgb ? VK_FORMAT_R8G8B8A8_SRGB : VK_FORMAT_R8G8B8A8_UNORM, width, height, levels, static_cast<std::byte const*>(pixels));
+}
+
+uint32_t TextureManager::upload(VkFormat format, uint32_t width, uint32_t height, std::vector<ImageFile::Level> const& levels, std::byte const* data)
+{
+    if (m_textures.size() >= MAX_TEXTURES)
+        throw std::runtime_error("too many textures!");
+    if (!supports(format))
+        throw std::runtime_error("texture format not supported by this device!");
+    if (width == 0 || height == 0 || width > MAX_IMAGE_DIMENSION || height > MAX_IMAGE_DIMENSION)
+        throw std::runtime_error("texture size not supported!");
+    if (m_capture)
+        m_capture->texture(format, width, height, levels, data);
+
+    // uncompressed images that come without mips get a full chain blitted on the GPU, compressed
+    // ones keep what the file has, compressing on the fly is an offline job
+    bool generate = levels.size() == 1 && can_generate_mips(format);
+
+    Texture texture {};
+    texture.format = format;
+    texture.width = width;
+    texture.height = height;
+    texture.mip_levels = generate ? full_mip_count(width, height) : static_cast<uint32_t>(levels.size());
+
+    create_image(texture);
+    VkBuffer staging_buffer;
+    VkDeviceMemory staging_buffer_memory;
+    stage(levels, data, staging_buffer, staging_buffer_memory);
+    VkCommandBuffer command_buffer = Gpu::begin_one_time_commands(m_gpu);
+    record_upload(command_buffer, texture, staging_buffer, levels, generate);
+    Gpu::end_one_time_commands(m_gpu, command_buffer);
+    Gpu::destroy_buffer(m_gpu, staging_buffer, staging_buffer_memory);
+
+    for (uint32_t level = 0; level < texture.mip_levels; level += 1)
+        texture.rgba8_size += image_level_size(VK_FORMAT_R8G8B8A8_UNORM, std::max(width >> level, 1u), std::max(height >> level, 1u));
+    texture.descriptor_set = allocate_descriptor_set(texture.view);
+
+    m_textures.push_back(texture);
+    m_evicted.emplace_back();
+    return static_cast<uint32_t>(m_textures.size() - 1);
+}
+
+void TextureManager::stage(std::vector<ImageFile::Level> const& levels, std::byte const* data, VkBuffer& staging_buffer, VkDeviceMemory& staging_buffer_memory)
+{
+    VkDeviceSize staging_size = 0;
+    for (ImageFile::Level const& level : levels)
+        staging_size += level.size;
+
+    Gpu::create_buffer(m_gpu, staging_size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, staging_buffer, staging_buffer_memory, MemoryClass::STAGING);
+
+    void* mapped;
+    vkMapMemory(m_gpu.device, staging_buffer_memory, 0, staging_size, 0, &mapped);
+    VkDeviceSize offset = 0;
+    for (ImageFile::Level const& level : levels) {
+        memcpy(static_cast<std::byte*>(mapped) + offset, data + level.offset, level.size);
+        offset += level.size;
+    }
+    vkUnmapMemory(m_gpu.device, staging_buffer_memory);
+    Stats::count(Counter::BYTES_UPLOADED, staging_size);
+}
+
+void TextureManager::create_image(Texture& texture)
+{
+    VkImageCreateInfo image_info {};
+    image_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    image_info.imageType = VK_IMAGE_TYPE_2D;
+    image_info.format = texture.format;
+    image_info.extent = { texture.width, texture.height, 1 };
+    image_info.mipLevels = texture.mip_levels;
+    image_info.arrayLayers = 1;
+    image_info.samples = VK_SAMPLE_COUNT_1_BIT;
+    image_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+    // a source for generating mips and for reading back on eviction
+    image_info.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+    image_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    image_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    Gpu::create_image(m_gpu, image_info, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, texture.image, texture.memory, MemoryClass::TEXTURE);
+
+    VkMemoryRequirements mem_requirements;
+    vkGetImageMemoryRequirements(m_gpu.device, texture.image, &mem_requirements);
+    texture.memory_size = mem_requirements.size;
+
+    texture.view = Gpu::create_image_view(m_gpu, texture.image, texture.format, VK_IMAGE_ASPECT_COLOR_BIT, texture.mip_levels);
+}
+
+// every level, tightly packed in the buffer in the order they are given
+static std::vector<VkBufferImageCopy> copy_regions(std::vector<ImageFile::Level> const& levels)
+{
+    std::vector<VkBufferImageCopy> regions(levels.size());
+    VkDeviceSize offset = 0;
+    for (uint32_t i = 0; i < levels.size(); i += 1) {
+        regions[i].bufferOffset = offset;
+        regions[i].bufferRowLength = 0;
+        regions[i].bufferImageHeight = 0;
+        regions[i].imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        regions[i].imageSubresource.mipLevel = i;
+        regions[i].imageSubresource.baseArrayLayer = 0;
+        regions[i].imageSubresource.layerCount = 1;
+        regions[i].imageOffset = { 0, 0, 0 };
+        regions[i].imageExtent = { levels[i].width, levels[i].height, 1 };
+        offset += levels[i].size;
+    }
+    return regions;
+}
+
+void TextureManager::record_upload(VkCommandBuffer command_buffer, Texture const& texture, VkBuffer staging_buffer, std::vector<ImageFile::Level> const& levels, bool generate)
+{
+    std::vector<VkBufferImageCopy> regions = copy_regions(levels);
+
+    VkImageMemoryBarrier barrier {};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.srcAccessMask = 0;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = texture.image;
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.baseMipLevel = 0;
+    barrier.subresourceRange.levelCount = texture.mip_levels;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount = 1;
+    vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+    vkCmdCopyBufferToImage(command_buffer, staging_buffer, texture.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, static_cast<uint32_t>(regions.size()), regions.data());
+
+    if (generate) {
+        generate_mips(command_buffer, texture);
+    } else {
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+    }
+}
+
+void TextureManager::record_readback(VkCommandBuffer command_buffer, Texture const& texture, VkBuffer staging_buffer)
+{
+    std::vector<VkBufferImageCopy> regions = copy_regions(levels(texture));
+
+    VkImageMemoryBarrier barrier {};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = texture.image;
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.baseMipLevel = 0;
+    barrier.subresourceRange.levelCount = texture.mip_levels;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount = 1;
+    vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+    vkCmdCopyImageToBuffer(command_buffer, texture.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, staging_buffer, static_cast<uint32_t>(regions.size()), regions.data());
+
+    // back to sampling, the eviction is called off if this frame or a later one draws it
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+}
+
+std::vector<ImageFile::Level> TextureManager::levels(Texture const& texture) const
+{
+    std::vector<ImageFile::Level> levels(texture.mip_levels);
+    size_t offset = 0;
+    for (uint32_t i = 0; i < texture.mip_levels; i += 1) {
+        uint32_t width = std::max(texture.width >> i, 1u);
+        uint32_t height = std::max(texture.height >> i, 1u);
+        levels[i] = { offset, image_level_size(texture.format, width, height), width, height };
+        offset += levels[i].size;
+    }
+    return levels;
+}
+
+void TextureManager::use(uint32_t index, uint64_t frame)
+{
+    Texture& texture = m_textures[index];
+    if (!texture.resident)
+        restore(index);
+    texture.last_used = frame + 1;
+}
+
+VkDeviceSize TextureManager::evict_unused(VkDeviceSize bytes, uint64_t in_use_from)
+{
+    // what is being read back is as good as freed
+    if (bytes <= m_evicting_size)
+        return 0;
+    bytes -= m_evicting_size;
+
+    m_candidates.clear();
+    for (uint32_t i = 0; i < m_textures.size(); i += 1) {
+        Texture const& texture = m_textures[i];
+        // last_used is one ahead, so this is "last drawn before in_use_from"
+        if (texture.resident && !texture.evicting && !texture.pinned && texture.last_used <= in_use_from)
+            m_candidates.push_back(i);
+    }
+    std::sort(m_candidates.begin(), m_candidates.end(), [this](uint32_t a, uint32_t b) {
+        return m_textures[a].last_used < m_textures[b].last_used;
+    });
+
+    VkDeviceSize freed = 0;
+    for (uint32_t index : m_candidates) {
+        if (freed >= bytes)
+            break;
+        freed += m_textures[index].memory_size;
+        evict(index);
+    }
+    return freed;
+}
+
+void TextureManager::evict(uint32_t index)
+{
+    Texture& texture = m_textures[index];
+    std::vector<ImageFile::Level> levels = this->levels(texture);
+    VkDeviceSize size = levels.back().offset + levels.back().size;
+
+    Transfer readback { index, 0, VK_NULL_HANDLE, VK_NULL_HANDLE };
+    Gpu::create_buffer(m_gpu, size, VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, readback.buffer, readback.memory, MemoryClass::STAGING);
+    m_readbacks.push_back(readback);
+    texture.evicting = true;
+    m_evicting_size += texture.memory_size;
+}
+
+void TextureManager::restore(uint32_t index)
+{
+    Texture& texture = m_textures[index];
+    create_image(texture);
+    // the whole chain was read back, nothing to generate
+    Transfer upload { index, 0, VK_NULL_HANDLE, VK_NULL_HANDLE };
+    stage(levels(texture), m_evicted[index].data(), upload.buffer, upload.memory);
+    m_uploads.push_back(upload);
+    // no frame in flight draws it, so the set is free to point at the new view
+    write_descriptor_set(texture.descriptor_set, texture.view);
+    m_version += 1;
+    m_evicted[index] = {};
+    texture.resident = true;
+    Stats::count(Counter::RESTORES);
+}
+
+void TextureManager::record_transfers(VkCommandBuffer command_buffer, uint64_t frame)
+{
+    for (Transfer const& upload : m_uploads) {
+        Texture const& texture = m_textures[upload.index];
+        record_upload(command_buffer, texture, upload.buffer, levels(texture), false);
+        // destroyed once this frame is done
+        m_gpu.deletion_queue->retire_buffer(upload.buffer, upload.memory);
+    }
+    m_uploads.clear();
+
+    if (m_readbacks.empty())
+        return;
+    for (Transfer& readback : m_readbacks) {
+        record_readback(command_buffer, m_textures[readback.index], readback.buffer);
+        readback.frame = frame;
+        m_reading.push_back(readback);
+    }
+    m_readbacks.clear();
+
+    VkMemoryBarrier barrier {};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+    vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+}
+
+void TextureManager::collect(uint64_t frame)
+{
+    size_t kept = 0;
+    for (Transfer const& readback : m_reading) {
+        if (readback.frame > frame) {
+            m_reading[kept] = readback;
+            kept += 1;
+            continue;
+        }
+
+        Texture& texture = m_textures[readback.index];
+        texture.evicting = false;
+        m_evicting_size -= texture.memory_size;
+        // drawn since the readback was recorded, so it stays
+        if (texture.last_used > readback.frame) {
+            m_gpu.deletion_queue->retire_buffer(readback.buffer, readback.memory);
+            continue;
+        }
+
+        VkDeviceSize size = 0;
+        for (ImageFile::Level const& level : levels(texture))
+            size += level.size;
+        void* mapped;
+        vkMapMemory(m_gpu.device, readback.memory, 0, size, 0, &mapped);
+        m_evicted[readback.index].resize(size);
+        memcpy(m_evicted[readback.index].data(), mapped, size);
+        vkUnmapMemory(m_gpu.device, readback.memory);
+        m_gpu.deletion_queue->retire_buffer(readback.buffer, readback.memory);
+
+        // no frame in flight samples it, but the descriptor set still points at the view
+        m_gpu.deletion_queue->retire_image_view(texture.view);
+        m_gpu.deletion_queue->retire_image(texture.image, texture.memory);
+        texture.view = VK_NULL_HANDLE;
+        texture.image = VK_NULL_HANDLE;
+        texture.memory = VK_NULL_HANDLE;
+        texture.resident = false;
+        m_version += 1;
+        Stats::count(Counter::EVICTIONS);
+    }
+    m_reading.resize(kept);
+}
+
+void TextureManager::generate_mips(VkCommandBuffer command_buffer, Texture const& texture)
+{
+    VkImageMemoryBarrier barrier {};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = texture.image;
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.levelCount = 1;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount = 1;
+
+    int32_t width = static_cast<int32_t>(texture.width);
+    int32_t height = static_cast<int32_t>(texture.height);
+
+    // every level is filtered down from the one above it, which by then is done being written
+    for (uint32_t level = 1; level < texture.mip_levels; level += 1) {
+        barrier.subresourceRange.baseMipLevel = level - 1;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+        int32_t next_width = std::max(width / 2, 1);
+        int32_t next_height = std::max(height / 2, 1);
+
+        VkImageBlit blit {};
+        blit.srcOffsets[0] = { 0, 0, 0 };
+        blit.srcOffsets[1] = { width, height, 1 };
+        blit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        blit.srcSubresource.mipLevel = level - 1;
+        blit.srcSubresource.baseArrayLayer = 0;
+        blit.srcSubresource.layerCount = 1;
+        blit.dstOffsets[0] = { 0, 0, 0 };
+        blit.dstOffsets[1] = { next_width, next_height, 1 };
+        blit.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        blit.dstSubresource.mipLevel = level;
+        blit.dstSubresource.baseArrayLayer = 0;
+        blit.dstSubresource.layerCount = 1;
+        vkCmdBlitImage(command_buffer, texture.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, texture.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit, VK_FILTER_LINEAR);
+
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+        width = next_width;
+        height = next_height;
+    }
+
+    // the smallest level was only ever written to
+    barrier.subresourceRange.baseMipLevel = texture.mip_levels - 1;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+}
+
+VkDeviceSize TextureManager::memory_size() const
+{
+    VkDeviceSize total = 0;
+    for (Texture const& texture : m_textures)
+        total += texture.memory_size;
+    return total;
+}
+
+VkDeviceSize TextureManager::resident_size() const
+{
+    VkDeviceSize total = 0;
+    for (Texture const& texture : m_textures)
+        total += texture.resident ? texture.memory_size : 0;
+    return total;
+}
+
+VkDeviceSize TextureManager::rgba8_size() const
+{
+    VkDeviceSize total = 0;
+    for (Texture const& texture : m_textures)
+        total += texture.rgba8_size;
+    return total;
+}
+
+void TextureManager::print_memory_report() const
+{
+    double const MIB = 1024.0 * 1024.0;
+    for (uint32_t i = 0; i < m_textures.size(); i += 1) {
+        Texture const& texture = m_textures[i];
+        std::cout << "texture " << i << ": " << texture.width << 'x' << texture.height
+                  << ", " << texture.mip_levels << " mips, "
+                  << image_bits_per_texel(texture.format) << " bits/texel, "
+                  << texture.memory_size / MIB << " MiB (RGBA8: " << texture.rgba8_size / MIB << " MiB)\n";
+    }
+    VkDeviceSize total = memory_size();
+    VkDeviceSize uncompressed = rgba8_size();
+    std::cout << "textures: " << total / MIB << " MiB, " << uncompressed / MIB << " MiB as RGBA8";
+    if (total > 0)
+        std::cout << " (" << double(uncompressed) / double(total) << "x less memory and sampling bandwidth)";
+    std::cout << '\n';
+}
+
+}
@@ -0,0 +1,150 @@
+#ifndef _HB_TEXTURE
+#define _HB_TEXTURE
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "gpu.hpp"
+#include "image_file.hpp"
+
+namespace HB {
+
+class CaptureWriter;
+
+struct Texture {
+    VkImage image = VK_NULL_HANDLE;
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    VkImageView view = VK_NULL_HANDLE;
+    VkDescriptorSet descriptor_set = VK_NULL_HANDLE;
+    VkFormat format = VK_FORMAT_UNDEFINED;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t mip_levels = 0;
+    // device memory the image actually takes, and what the same mip chain would take as RGBA8
+    VkDeviceSize memory_size = 0;
+    VkDeviceSize rgba8_size = 0;
+    // Evicted textures keep their descriptor set, it is pointed at the new view on restore. Not
+    // resident, image, memory and view are null.
+    bool resident = true;
+    // being read back for eviction, still resident until the frame that copies it is done
+    bool evicting = false;
+    bool pinned = false;
+    // the frame it was last drawn in plus one, 0 if it never was
+    uint64_t last_used = 0;
+};
+
+// Owns every sampled texture. Uploads go through a staging buffer and are waited on, so this is
+// for load time, not the per-frame path. Each texture gets its own descriptor set (set 0,
+// binding 0, combined image sampler) that can be bound as is.
+//
+// When device memory runs short, textures that have not been drawn for a while can be evicted to
+// host memory and are restored the next time they are used (see evict_unused()). Anything bound
+// without going through use() has to be pinned. Evicting and restoring happen during frames, so
+// their copies are recorded into the frame's command buffer (record_transfers()) and finished
+// once its fence has passed (collect()), nothing waits for the queue.
+class TextureManager {
+public:
+    static uint32_t const MAX_TEXTURES = 256;
+    // 1x1 opaque white, what untextured draws sample
+    static uint32_t const WHITE = 0;
+
+    TextureManager(GpuContext const&);
+    ~TextureManager();
+    TextureManager(TextureManager const&) = delete;
+    TextureManager& operator=(TextureManager const&) = delete;
+
+    // whether this device can sample the format, BC formats also need textureCompressionBC
+    bool supports(VkFormat) const;
+    // KTX2 or DDS, returns the texture index
+    uint32_t load(std::string const& path);
+    uint32_t create(ImageFile const&);
+    // tightly packed RGBA8 texels, mips are generated on the GPU
+    uint32_t create_rgba8(uint32_t width, uint32_t height, void const* pixels, bool srgb = true);
+
+    Texture const& get(uint32_t index) const { return m_textures[index]; }
+    size_t size() const { return m_textures.size(); }
+    VkDescriptorSetLayout descriptor_set_layout() const { return m_descriptor_set_layout; }
+
+    // never evicted, for textures whose descriptor sets are kept and bound elsewhere
+    void pin(uint32_t index) { m_textures[index].pinned = true; }
+    // Marks the texture as drawn in `frame`, restoring it first if it was evicted. Call it for
+    // every texture a frame binds before recording it.
+    void use(uint32_t index, uint64_t frame);
+    // Evicts unpinned textures not used since before `in_use_from`, least recently used first,
+    // until `bytes` of device memory are freed or nothing is left to evict. Frames in flight from
+    // `in_use_from` on may still sample what is kept. Evictions still being read back count as
+    // freed already, and one is called off if the texture gets used before it finishes. Returns
+    // the bytes that will be freed.
+    VkDeviceSize evict_unused(VkDeviceSize bytes, uint64_t in_use_from);
+    // Records the readbacks and uploads queued since the last call, before anything in the
+    // command buffer samples. `frame` is the one it belongs to, the deletion queue's current one.
+    void record_transfers(VkCommandBuffer, uint64_t frame);
+    // finishes the evictions recorded up to and including `frame`, once its fence has passed
+    void collect(uint64_t frame);
+    // device memory of the textures that are resident
+    VkDeviceSize resident_size() const;
+
+    // Device memory of everything loaded vs the same textures stored as RGBA8. The ratio is also
+    // the ratio of bytes fetched per sample, BC1 reads 4 bits per texel where RGBA8 reads 32.
+    VkDeviceSize memory_size() const;
+    VkDeviceSize rgba8_size() const;
+    void print_memory_report() const;
+    // every texture created from now on is recorded to it, null stops
+    void set_capture(CaptureWriter* capture) { m_capture = capture; }
+    // counts up whenever an image or descriptor set of an existing texture is replaced, command
+    // buffers that bound it have to be recorded again
+    uint64_t version() const { return m_version; }
+
+private:
+    GpuContext m_gpu;
+    CaptureWriter* m_capture = nullptr;
+    uint64_t m_version = 0;
+    VkSampler m_sampler;
+    VkDescriptorSetLayout m_descriptor_set_layout;
+    VkDescriptorPool m_descriptor_pool;
+    std::vector<Texture> m_textures;
+    // the mip chains of evicted textures, tightly packed, empty for resident ones
+    std::vector<std::vector<std::byte>> m_evicted;
+
+    // a copy between a texture and its staging buffer, for evicting or restoring it
+    struct Transfer {
+        uint32_t index;
+        // the one it was recorded in
+        uint64_t frame;
+        VkBuffer buffer;
+        VkDeviceMemory memory;
+    };
+
+    // all reserved for every texture, so the per-frame path doesn't allocate for them
+    std::vector<Transfer> m_readbacks;
+    std::vector<Transfer> m_uploads;
+    // recorded readbacks waiting for their frame's fence
+    std::vector<Transfer> m_reading;
+    std::vector<uint32_t> m_candidates;
+    // device memory of the textures being evicted
+    VkDeviceSize m_evicting_size = 0;
+
+    void create_sampler();
+    void create_descriptors();
+    uint32_t upload(VkFormat, uint32_t width, uint32_t height, std::vector<ImageFile::Level> const&, std::byte const* data);
+    // creates the texture's image and view, to be filled by an upload
+    void create_image(Texture&);
+    // a staging buffer holding the levels, tightly packed
+    void stage(std::vector<ImageFile::Level> const&, std::byte const* data, VkBuffer&, VkDeviceMemory&);
+    // copies the staged levels into the image, generating the rest, and leaves it ready to sample
+    void record_upload(VkCommandBuffer, Texture const&, VkBuffer staging, std::vector<ImageFile::Level> const&, bool generate);
+    void record_readback(VkCommandBuffer, Texture const&, VkBuffer staging);
+    // every level of the texture's image as they are laid out in m_evicted
+    std::vector<ImageFile::Level> levels(Texture const&) const;
+    void evict(uint32_t index);
+    void restore(uint32_t index);
+    bool can_generate_mips(VkFormat) const;
+    void generate_mips(VkCommandBuffer, Texture const&);
+    VkDescriptorSet allocate_descriptor_set(VkImageView);
+    void write_descriptor_set(VkDescriptorSet, VkImageView);
+};
+
+}
+
+#endif
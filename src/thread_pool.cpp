@@ -0,0 +1,130 @@
+#include <algorithm>
+
+#include "thread_pool.hpp"
+
+namespace HB {
+
+ThreadPool::ThreadPool(uint32_t worker_count)
+{
+    if (worker_count == 0) {
+        uint32_t hardware_threads = std::thread::hardware_concurrency();
+        worker_count = std::max(hardware_threads, 2u) - 1;
+    }
+
+    m_workers.reserve(worker_count);
+    for (uint32_t i = 0; i < worker_count; i += 1)
+        m_workers.emplace_back(&ThreadPool::worker, this);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+
+    for (auto& worker : m_workers)
+        worker.join();
+}
+
+void ThreadPool::enqueue(std::function<void()> task)
+{
+    {
+        std::lock_guard lock(m_mutex);
+        m_tasks.push_back(std::move(task));
+    }
+    m_wake.notify_one();
+}
+
+void ThreadPool::dispatch(size_t count, size_t grain, JobFunction function, void const* context)
+{
+    if (count == 0)
+        return;
+
+    grain = std::max<size_t>(grain, 1);
+    size_t chunk_count = (count + grain - 1) / grain;
+    if (chunk_count == 1) {
+        function(context, 0, count);
+        return;
+    }
+
+    std::lock_guard job_lock(m_job_mutex);
+
+    Job job { function, context, count, grain, chunk_count };
+    {
+        std::unique_lock lock(m_mutex);
+        // a straggler from the previous job may still be reading its copy of m_job
+        m_job_finished.wait(lock, [this] { return m_job_workers == 0; });
+        m_job = job;
+        m_job_next_chunk.store(0);
+        m_job_done_chunks.store(0);
+        m_job_generation += 1;
+    }
+    m_wake.notify_all();
+
+    run_chunks(job);
+
+    std::unique_lock lock(m_mutex);
+    m_job_finished.wait(lock, [this, chunk_count] {
+        return m_job_done_chunks.load() == chunk_count && m_job_workers == 0;
+    });
+}
+
+void ThreadPool::run_chunks(Job const& job)
+{
+    while (true) {
+        size_t chunk = m_job_next_chunk.fetch_add(1);
+        if (chunk >= job.chunk_count)
+            break;
+
+        size_t begin = chunk * job.grain;
+        size_t end = std::min(begin + job.grain, job.count);
+        job.function(job.context, begin, end);
+
+        if (m_job_done_chunks.fetch_add(1) + 1 == job.chunk_count) {
+            std::lock_guard lock(m_mutex);
+            m_job_finished.notify_all();
+        }
+    }
+}
+
+void ThreadPool::worker()
+{
+    uint64_t seen_generation = 0;
+
+    while (true) {
+        std::function<void()> task;
+        Job job {};
+        {
+            std::unique_lock lock(m_mutex);
+            m_wake.wait(lock, [this, seen_generation] {
+                return m_stopping || !m_tasks.empty() || m_job_generation != seen_generation;
+            });
+
+            if (m_job_generation != seen_generation) {
+                seen_generation = m_job_generation;
+                job = m_job;
+                m_job_workers += 1;
+            } else if (!m_tasks.empty()) {
+                task = std::move(m_tasks.front());
+                m_tasks.pop_front();
+            } else {
+                return;
+            }
+        }
+
+        if (task) {
+            task();
+            continue;
+        }
+
+        run_chunks(job);
+
+        std::lock_guard lock(m_mutex);
+        m_job_workers -= 1;
+        m_job_finished.notify_all();
+    }
+}
+
+}
@@ -0,0 +1,88 @@
+#ifndef _HB_THREAD_POOL
+#define _HB_THREAD_POOL
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace HB {
+
+class ThreadPool {
+public:
+    // 0 picks one worker per hardware thread minus the calling thread, but at least one
+    explicit ThreadPool(uint32_t worker_count = 0);
+    ~ThreadPool();
+    ThreadPool(ThreadPool const&) = delete;
+    ThreadPool& operator=(ThreadPool const&) = delete;
+
+    uint32_t worker_count() const { return static_cast<uint32_t>(m_workers.size()); }
+
+    // Splits [0, count) into ranges of at most `grain` elements and runs them on the workers and
+    // the calling thread, returning once every range is done. Does not allocate, so it is safe
+    // to use on the per-frame path. Must not be nested inside another parallel_for().
+    template<typename F>
+    void parallel_for(size_t count, size_t grain, F&& function)
+    {
+        using Function = std::remove_reference_t<F>;
+        dispatch(
+            count, grain,
+            [](void const* context, size_t begin, size_t end) {
+                (*const_cast<Function*>(static_cast<Function const*>(context)))(begin, end);
+            },
+            static_cast<void const*>(&function));
+    }
+
+    // Queues a one-off task, for coarse work like loading or building things in the background.
+    template<typename F>
+    auto submit(F&& function) -> std::future<std::invoke_result_t<F>>
+    {
+        using Result = std::invoke_result_t<F>;
+        auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(function));
+        std::future<Result> future = task->get_future();
+        enqueue([task] { (*task)(); });
+        return future;
+    }
+
+private:
+    using JobFunction = void (*)(void const*, size_t, size_t);
+
+    struct Job {
+        JobFunction function;
+        void const* context;
+        size_t count;
+        size_t grain;
+        size_t chunk_count;
+    };
+
+    std::vector<std::thread> m_workers;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_job_finished;
+    std::deque<std::function<void()>> m_tasks;
+    bool m_stopping = false;
+
+    std::mutex m_job_mutex;
+    Job m_job {};
+    uint64_t m_job_generation = 0;
+    uint32_t m_job_workers = 0;
+    std::atomic<size_t> m_job_next_chunk = 0;
+    std::atomic<size_t> m_job_done_chunks = 0;
+
+    void enqueue(std::function<void()>);
+    void dispatch(size_t, size_t, JobFunction, void const*);
+    void run_chunks(Job const&);
+    void worker();
+};
+
+}
+
+#endif
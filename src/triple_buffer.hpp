@@ -0,0 +1,56 @@
+#ifndef _HB_TRIPLE_BUFFER
+#define _HB_TRIPLE_BUFFER
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace HB {
+
+// Hands whole values from one producer thread to one consumer thread without locks or waiting.
+// The producer fills write_buffer() and publish()es it, the consumer acquire()s the newest
+// published value and reads it until the next acquire(). Neither side ever blocks the other:
+// values the consumer was too slow for are overwritten, so it always gets the latest one.
+//
+// The three buffers rotate and are never freed, a T holding vectors reaches its steady size and
+// stops allocating. A buffer coming back to the producer holds an older value, not the last one.
+template<typename T>
+class TripleBuffer {
+public:
+    TripleBuffer() = default;
+    TripleBuffer(TripleBuffer const&) = delete;
+    TripleBuffer& operator=(TripleBuffer const&) = delete;
+
+    // producer side
+    T& write_buffer() { return m_buffers[m_write]; }
+    void publish()
+    {
+        uint32_t previous = m_middle.exchange(m_write | FRESH, std::memory_order_acq_rel);
+        m_write = previous & INDEX;
+    }
+
+    // consumer side, false (and the same value as before) if nothing was published since
+    bool acquire()
+    {
+        if (!(m_middle.load(std::memory_order_relaxed) & FRESH))
+            return false;
+        uint32_t previous = m_middle.exchange(m_read, std::memory_order_acq_rel);
+        m_read = previous & INDEX;
+        return true;
+    }
+    T const& read_buffer() const { return m_buffers[m_read]; }
+
+private:
+    static uint32_t const INDEX = 3;
+    static uint32_t const FRESH = 4;
+
+    std::array<T, 3> m_buffers {};
+    uint32_t m_write = 0;
+    // index of the buffer in between, with FRESH set while the consumer hasn't taken it yet
+    std::atomic<uint32_t> m_middle = 1;
+    uint32_t m_read = 2;
+};
+
+}
+
+#endif
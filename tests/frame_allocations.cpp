@@ -0,0 +1,164 @@
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <new>
+
+#include "app.hpp"
+
+// Counts every global operator new while enabled and fails if the steady-state frame loop,
+// static or with a moving scene, allocates at all. Exits with 77 (skipped) when no Vulkan
+// device is around.
+
+constexpr uint32_t const ENTITIES = 10000;
+constexpr uint32_t const WARMUP_FRAMES = 20;
+constexpr uint32_t const FRAMES = 100;
+
+static std::atomic<bool> g_counting = false;
+static std::atomic<size_t> g_allocations = 0;
+
+static void* counted_allocate(size_t size, size_t alignment = 0)
+{
+    if (g_counting.load(std::memory_order_relaxed))
+        g_allocations.fetch_add(1, std::memory_order_relaxed);
+
+    size = std::max<size_t>(size, 1);
+    void* pointer = alignment > alignof(std::max_align_t)
+        ? std::aligned_alloc(alignment, (size + alignment - 1) & ~(alignment - 1))
+        : std::malloc(size);
+    return pointer;
+}
+
+void* operator new(size_t size)
+{
+    void* pointer = counted_allocate(size);
+    if (!pointer)
+        throw std::bad_alloc();
+    return pointer;
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void* operator new(size_t size, std::align_val_t alignment)
+{
+    void* pointer = counted_allocate(size, static_cast<size_t>(alignment));
+    if (!pointer)
+        throw std::bad_alloc();
+    return pointer;
+}
+
+void* operator new[](size_t size, std::align_val_t alignment)
+{
+    return operator new(size, alignment);
+}
+
+void* operator new(size_t size, std::nothrow_t const&) noexcept
+{
+    return counted_allocate(size);
+}
+
+void* operator new[](size_t size, std::nothrow_t const&) noexcept
+{
+    return counted_allocate(size);
+}
+
+void operator delete(void* pointer) noexcept { std::free(pointer); }
+void operator delete[](void* pointer) noexcept { std::free(pointer); }
+void operator delete(void* pointer, size_t) noexcept { std::free(pointer); }
+void operator delete[](void* pointer, size_t) noexcept { std::free(pointer); }
+void operator delete(void* pointer, std::align_val_t) noexcept { std::free(pointer); }
+void operator delete[](void* pointer, std::align_val_t) noexcept { std::free(pointer); }
+void operator delete(void* pointer, size_t, std::align_val_t) noexcept { std::free(pointer); }
+void operator delete[](void* pointer, size_t, std::align_val_t) noexcept { std::free(pointer); }
+
+static size_t count_allocations(HB::App& app, uint32_t frames, bool moving)
+{
+    g_allocations.store(0);
+    g_counting.store(true);
+    for (uint32_t i = 0; i < frames; i += 1) {
+        if (moving) {
+            float offset = 0.001f * (i % 2 == 0 ? 1.0f : -1.0f);
+            app.scene().each<HB::Transform, HB::Bounds>([offset](HB::Transform& transform, HB::Bounds& bounds) {
+                transform.position.x += offset;
+                bounds.min.x += offset;
+                bounds.max.x += offset;
+            });
+            app.scene_moved();
+        }
+        app.run_frames(1);
+    }
+    g_counting.store(false);
+    app.wait_idle();
+    return g_allocations.load();
+}
+
+// a throwaway instance, the App is only created if this finds something to run on
+static bool has_vulkan_device()
+{
+    VkApplicationInfo application_info {};
+    application_info.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+    application_info.apiVersion = VK_API_VERSION_1_0;
+    VkInstanceCreateInfo create_info {};
+    create_info.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+    create_info.pApplicationInfo = &application_info;
+
+    VkInstance instance;
+    if (vkCreateInstance(&create_info, nullptr, &instance) != VK_SUCCESS)
+        return false;
+    uint32_t device_count = 0;
+    VkResult result = vkEnumeratePhysicalDevices(instance, &device_count, nullptr);
+    vkDestroyInstance(instance, nullptr);
+    return result == VK_SUCCESS && device_count > 0;
+}
+
+int main()
+{
+    if (!has_vulkan_device()) {
+        std::fprintf(stderr, "skipped: no Vulkan device\n");
+        return 77;
+    }
+
+    HB::AppInfo app_info {};
+    app_info.width = 640;
+    app_info.height = 480;
+    app_info.name = "frame_allocations";
+    app_info.version = "0";
+    app_info.headless = true;
+
+    // only a missing device skips, the App failing to start on one that is there fails
+    try {
+        HB::App app(app_info);
+
+        uint32_t side = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<double>(ENTITIES))));
+        float cell = 1.9f / static_cast<float>(side);
+        float half = cell * 0.4f;
+        for (uint32_t i = 0; i < ENTITIES; i += 1) {
+            float x = -0.95f + (static_cast<float>(i % side) + 0.5f) * cell;
+            float y = -0.95f + (static_cast<float>(i / side) + 0.5f) * cell;
+            HB::Transform transform { { x, y, 0.0f }, { cell * 0.8f, cell * 0.8f, 1.0f } };
+            HB::Bounds bounds { { x - half, y - half, 0.0f }, { x + half, y + half, 0.0f } };
+            HB::Renderable renderable { 0, { 1.0f, 1.0f, 1.0f } };
+            app.scene().create(transform, bounds, renderable);
+        }
+
+        // lets every buffer, arena and cache grow to its steady-state size
+        app.set_target_frame_time(1e9f);
+        app.run_frames(WARMUP_FRAMES);
+        count_allocations(app, WARMUP_FRAMES, true);
+
+        size_t static_allocations = count_allocations(app, FRAMES, false);
+        size_t moving_allocations = count_allocations(app, FRAMES, true);
+        std::printf("static frames: %zu allocations\n", static_allocations);
+        std::printf("moving frames: %zu allocations\n", moving_allocations);
+
+        return static_allocations == 0 && moving_allocations == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    } catch (std::exception const& e) {
+        std::fprintf(stderr, "failed: %s\n", e.what());
+        return EXIT_FAILURE;
+    }
+}
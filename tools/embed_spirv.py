@@ -0,0 +1,80 @@
+#!/usr/bin/env python3
+"""Turns SPIR-V binaries into a C++ header of constexpr uint32_t arrays.
+
+Every input becomes HB::EmbeddedShaders::<STEM>, and ALL lists them by their file stem (vert.spv
+is "vert"), which is the name shaders are asked for by at runtime. The files are read as little
+endian words and written out as numbers, so the arrays are right whatever the target's byte order.
+"""
+
+import argparse
+import os
+import struct
+import sys
+
+SPIRV_MAGIC = 0x07230203
+
+
+def words(path):
+    with open(path, "rb") as file:
+        data = file.read()
+    if len(data) % 4 != 0:
+        raise ValueError(f"{path}: size is not a multiple of 4")
+    values = struct.unpack(f"<{len(data) // 4}I", data)
+    if not values or values[0] != SPIRV_MAGIC:
+        raise ValueError(f"{path}: not little endian SPIR-V")
+    return values
+
+
+def array(name, values):
+    lines = []
+    for i in range(0, len(values), 8):
+        lines.append("    " + ", ".join(f"0x{value:08x}" for value in values[i:i + 8]) + ",")
+    return f"constexpr uint32_t const {name}[] = {{\n" + "\n".join(lines) + "\n};\n"
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("output")
+    parser.add_argument("inputs", nargs="+")
+    args = parser.parse_args()
+
+    shaders = []
+    for path in args.inputs:
+        stem = os.path.basename(path).split(".")[0]
+        shaders.append((stem, stem.upper(), words(path)))
+
+    out = [
+        "// generated by tools/embed_spirv.py, do not edit",
+        "#ifndef _HB_EMBEDDED_SHADERS",
+        "#define _HB_EMBEDDED_SHADERS",
+        "",
+        "#include <cstddef>",
+        "#include <cstdint>",
+        "",
+        "namespace HB::EmbeddedShaders {",
+        "",
+    ]
+    for _, name, values in shaders:
+        out.append(array(name, values))
+    out.append("struct Entry {")
+    out.append("    char const* name;")
+    out.append("    uint32_t const* code;")
+    out.append("    size_t size;")
+    out.append("};")
+    out.append("")
+    out.append("constexpr Entry const ALL[] = {")
+    for stem, name, _ in shaders:
+        out.append(f'    {{ "{stem}", {name}, sizeof({name}) }},')
+    out.append("};")
+    out.append("")
+    out.append("}")
+    out.append("")
+    out.append("#endif")
+
+    with open(args.output, "w") as file:
+        file.write("\n".join(out) + "\n")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,185 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "app.hpp"
+#include "capture.hpp"
+
+// Draws a capture (AppInfo::capture, HB_CAPTURE for the test app) again, headless: its textures,
+// meshes and materials are created in the order they were and every frame gets the scene, views,
+// text and settings it had. As fast as possible by default, --realtime waits for each frame's
+// original time. One CSV row per frame goes to stdout, a summary and errors to stderr.
+//
+//     replay <capture> [--realtime]
+//
+// The GPU columns are the App's FrameStats, they belong to a frame a few rows earlier. Resolution
+// scaling is off so the GPU times don't depend on what came before.
+
+using Clock = std::chrono::steady_clock;
+
+// the drawables of the last SCENE record, in its order; `material_count` is what the App has so far
+static void apply_scene(HB::App& app, std::vector<HB::Entity>& entities, HB::CaptureEvent const& event, uint32_t material_count)
+{
+    for (HB::CapturedEntity const& captured : event.entities) {
+        if (captured.renderable.mesh >= app.meshes().size() || captured.renderable.material >= material_count)
+            throw std::runtime_error("capture draws a mesh or material it didn't create!");
+    }
+
+    HB::Scene& scene = app.scene();
+    if (event.structure_changed) {
+        for (HB::Entity entity : entities)
+            scene.destroy(entity);
+        entities.clear();
+        for (HB::CapturedEntity const& captured : event.entities)
+            entities.push_back(scene.create(captured.transform, captured.bounds, captured.renderable));
+        return;
+    }
+
+    size_t count = std::min(entities.size(), event.entities.size());
+    for (size_t i = 0; i < count; i += 1) {
+        *scene.get<HB::Transform>(entities[i]) = event.entities[i].transform;
+        *scene.get<HB::Bounds>(entities[i]) = event.entities[i].bounds;
+        *scene.get<HB::Renderable>(entities[i]) = event.entities[i].renderable;
+    }
+    app.scene_moved();
+}
+
+// `extents` are the windows' sizes so far, resizing recreates their targets even if nothing changed
+static void apply_frame(HB::App& app, std::vector<VkExtent2D>& extents, HB::CapturedFrame const& frame)
+{
+    app.set_draw_sorting(frame.sort_draws);
+    app.set_meshlet_culling(frame.meshlet_culling);
+    app.set_command_buffer_caching(frame.cache_command_buffers);
+    app.set_max_instances_per_draw(frame.max_instances_per_draw);
+    app.meshes().set_lod_threshold(frame.lod_threshold);
+
+    for (uint32_t window = 0; window < frame.views.size(); window += 1) {
+        HB::CapturedView const& view = frame.views[window];
+        if (view.width == 0 || view.height == 0)
+            continue;
+        if (window >= app.window_count()) {
+            app.add_window(view.width, view.height, "replay");
+            extents.push_back({ view.width, view.height });
+        } else if (extents[window].width != view.width || extents[window].height != view.height) {
+            app.resize(view.width, view.height, window);
+            extents[window] = { view.width, view.height };
+        }
+        app.set_view_projection(view.view_projection, window);
+    }
+
+    for (HB::TextLabel const& label : frame.text.labels) {
+        auto channel = [&label](uint32_t shift) { return static_cast<float>((label.color >> shift) & 0xff) / 255.0f; };
+        glm::vec4 color(channel(0), channel(8), channel(16), channel(24));
+        app.draw_text(frame.text.text(label), label.position, label.size, color);
+    }
+}
+
+static double percentile(std::vector<double> values, double fraction)
+{
+    if (values.empty())
+        return 0.0;
+    std::sort(values.begin(), values.end());
+    size_t index = static_cast<size_t>(fraction * static_cast<double>(values.size() - 1) + 0.5);
+    return values[index];
+}
+
+int main(int argc, char** argv)
+{
+    char const* path = nullptr;
+    bool realtime = false;
+    for (int i = 1; i < argc; i += 1) {
+        if (std::strcmp(argv[i], "--realtime") == 0)
+            realtime = true;
+        else
+            path = argv[i];
+    }
+    if (path == nullptr) {
+        std::fprintf(stderr, "usage: %s <capture> [--realtime]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    try {
+        HB::CaptureReader reader { path };
+        HB::AppInfo app_info {};
+        app_info.width = reader.width();
+        app_info.height = reader.height();
+        app_info.name = "replay";
+        app_info.version = "0";
+        app_info.headless = true;
+        HB::App app { app_info };
+        app.set_target_frame_time(1e9f);
+
+        std::vector<VkExtent2D> extents = { { reader.width(), reader.height() } };
+        std::vector<HB::Entity> entities;
+        // the built-in one, then one per MATERIAL record
+        uint32_t material_count = 1;
+        std::vector<double> cpu_times;
+        std::vector<double> gpu_times;
+        HB::CaptureEvent event;
+        Clock::time_point start = Clock::now();
+        std::printf("frame,cpu_ms,gpu_ms,record_ms,post_ms,draw_calls,pipeline_binds\n");
+        while (reader.next(event)) {
+            switch (event.kind) {
+            case HB::CaptureRecord::TEXTURE:
+                app.textures().create(event.image);
+                break;
+            case HB::CaptureRecord::MESH:
+                app.meshes().create(event.mesh, event.lod_settings);
+                break;
+            case HB::CaptureRecord::MATERIAL:
+                // only the capture's own textures exist here
+                if (event.texture >= app.textures().size())
+                    throw std::runtime_error("capture has a material with a texture it didn't create!");
+                app.create_material(event.pipeline, event.texture);
+                material_count += 1;
+                break;
+            case HB::CaptureRecord::SCENE_PIPELINE:
+                app.set_scene_pipeline(event.pipeline);
+                break;
+            case HB::CaptureRecord::POST_CHAIN:
+                app.set_post_chain(event.post_chain, event.post_settings);
+                break;
+            case HB::CaptureRecord::SCENE:
+                apply_scene(app, entities, event, material_count);
+                break;
+            case HB::CaptureRecord::FRAME: {
+                apply_frame(app, extents, event.frame);
+                if (realtime)
+                    std::this_thread::sleep_until(start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(event.frame.seconds)));
+
+                auto frame_start = Clock::now();
+                app.run_frames(1);
+                double cpu_ms = std::chrono::duration<double, std::milli>(Clock::now() - frame_start).count();
+
+                HB::FrameStats const& stats = app.frame_stats();
+                cpu_times.push_back(cpu_ms);
+                gpu_times.push_back(stats.gpu_ms);
+                std::printf("%zu,%.3f,%.3f,%.3f,%.3f,%llu,%llu\n", cpu_times.size() - 1, cpu_ms, stats.gpu_ms, stats.record_ms, stats.post_ms, static_cast<unsigned long long>(stats[HB::Counter::DRAW_CALLS]), static_cast<unsigned long long>(stats[HB::Counter::PIPELINE_BINDS]));
+                break;
+            }
+            }
+        }
+        app.wait_idle();
+
+        double cpu_total = 0.0;
+        for (double ms : cpu_times)
+            cpu_total += ms;
+        double gpu_total = 0.0;
+        for (double ms : gpu_times)
+            gpu_total += ms;
+        double frames = static_cast<double>(std::max<size_t>(cpu_times.size(), 1));
+        std::fprintf(stderr, "%zu frames, cpu %.3f ms mean %.3f ms p99, gpu %.3f ms mean %.3f ms p99\n", cpu_times.size(), cpu_total / frames, percentile(cpu_times, 0.99), gpu_total / frames, percentile(gpu_times, 0.99));
+    } catch (std::exception const& e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}